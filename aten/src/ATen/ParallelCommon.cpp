@@ -78,6 +78,8 @@ std::string get_parallel_info() {
   ss << "native thread pool";
   #elif AT_PARALLEL_NATIVE_TBB
   ss << "native thread pool and TBB";
+  #elif AT_PARALLEL_NATIVE_WS
+  ss << "native work-stealing thread pool";
   #endif
   ss << std::endl;
 
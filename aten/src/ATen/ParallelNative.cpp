@@ -3,6 +3,7 @@
 #include <ATen/PTThreadPool.h>
 
 #include <atomic>
+#include <vector>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -43,18 +44,93 @@ int _num_pool_threads(int nthreads) {
   // minus one because of the master thread
   return nthreads - 1;
 }
+
+// Intra-op thread pools. Normally there is a single pool; in NUMA mode
+// (c10::IsNUMAEnabled() on a host with more than one node) there is one pool
+// per node, with its threads bound to that node.
+struct IntraopPools {
+  std::vector<std::shared_ptr<TaskThreadPoolBase>> pools;
+  // index into pools of the pool serving each node; a node whose own pool
+  // has no threads is served by the next node that has some
+  std::vector<size_t> node_pool;
+  // pool used for work that is not associated with a node
+  size_t default_pool = 0;
+  size_t num_pool_threads = 0;
+};
+
+IntraopPools _create_intraop_pools(int nthreads) {
+  IntraopPools result;
+  int num_pool_threads = _num_pool_threads(nthreads);
+  result.num_pool_threads = num_pool_threads;
+  int num_nodes = c10::GetNumNUMANodes();
+  if (num_nodes <= 1) {
+    result.pools.push_back(ThreadPoolRegistry()->Create(
+        "C10",
+        /* device_id */ 0,
+        /* pool_size */ num_pool_threads,
+        /* create_new */ true)); // create a separate thread pool for intra-op
+    result.node_pool.push_back(0);
+    return result;
+  }
+
+  // Spread all threads evenly over the nodes. The master thread isn't bound
+  // to any node, so it doesn't run chunks itself and node 0 gets a full share
+  // of pool threads to run the first chunk.
+  int total_threads = num_pool_threads + 1;
+  size_t largest = 0;
+  for (int node = 0; node < num_nodes; ++node) {
+    int node_threads = total_threads / num_nodes +
+        (node < total_threads % num_nodes ? 1 : 0);
+    result.pools.push_back(ThreadPoolRegistry()->Create(
+        "C10_NUMA",
+        /* device_id */ node,
+        /* pool_size */ node_threads,
+        /* create_new */ true));
+    if (result.pools[node]->size() > result.pools[largest]->size()) {
+      largest = node;
+    }
+  }
+  result.default_pool = largest;
+  for (int node = 0; node < num_nodes; ++node) {
+    size_t pool = node;
+    while (result.pools[pool]->size() == 0 && pool != largest) {
+      pool = (pool + 1) % num_nodes;
+    }
+    result.node_pool.push_back(pool);
+  }
+  return result;
+}
+
+const IntraopPools& _get_intraop_pools() {
+  static IntraopPools pools =
+      _create_intraop_pools(num_intraop_threads.exchange(CONSUMED));
+  return pools;
+}
 } // namespace
 
 namespace internal {
 
 TaskThreadPoolBase& _get_intraop_pool() {
-  static std::shared_ptr<TaskThreadPoolBase> pool =
-      ThreadPoolRegistry()->Create(
-          "C10",
-          /* device_id */ 0,
-          /* pool_size */ _num_pool_threads(num_intraop_threads.exchange(CONSUMED)),
-          /* create_new */ true); // create a separate thread pool for intra-op
-  return *pool;
+  const auto& pools = _get_intraop_pools();
+  return *pools.pools[pools.default_pool];
+}
+
+TaskThreadPoolBase& _get_intraop_pool(size_t task_id, size_t num_tasks) {
+  const auto& pools = _get_intraop_pools();
+  // Consecutive chunks map to the same node, so that for a given range size
+  // a chunk is always processed on the node that first touched its data.
+  size_t node = task_id * pools.node_pool.size() / num_tasks;
+  return *pools.pools[pools.node_pool[node]];
+}
+
+int _intraop_task_node(size_t task_id, size_t num_tasks) {
+  const auto& pools = _get_intraop_pools();
+  if (pools.node_pool.size() <= 1) {
+    return -1;
+  }
+  // Pools are indexed by node
+  size_t node = task_id * pools.node_pool.size() / num_tasks;
+  return pools.node_pool[node];
 }
 
 void _set_in_parallel_region(bool in_region) {
@@ -99,7 +175,7 @@ int get_num_threads() {
     return intraop_default_num_threads();
   } else {
     TORCH_INTERNAL_ASSERT(nthreads == CONSUMED);
-    return internal::_get_intraop_pool().size() + 1;
+    return _get_intraop_pools().num_pool_threads + 1;
   }
 }
 
@@ -108,10 +184,18 @@ int get_thread_num() {
 }
 
 bool in_parallel_region() {
-  return in_parallel_region_ || (
-    num_intraop_threads.load() == CONSUMED &&
-    internal::_get_intraop_pool().inThreadPool()
-  );
+  if (in_parallel_region_) {
+    return true;
+  }
+  if (num_intraop_threads.load() != CONSUMED) {
+    return false;
+  }
+  for (const auto& pool : _get_intraop_pools().pools) {
+    if (pool->inThreadPool()) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void intraop_launch(std::function<void()> func) {
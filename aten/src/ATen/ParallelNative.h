@@ -15,6 +15,18 @@ namespace internal {
 // template parallel primitives (parallel_for, parallel_reduce)
 CAFFE2_API TaskThreadPoolBase& _get_intraop_pool();
 
+// internal function to get the intra-op thread pool that runs chunk task_id
+// out of num_tasks; in NUMA mode this is the pool bound to the node that owns
+// that part of the range
+CAFFE2_API TaskThreadPoolBase& _get_intraop_pool(
+    size_t task_id,
+    size_t num_tasks);
+
+// internal function to get the NUMA node whose pool runs chunk task_id out of
+// num_tasks, or -1 when chunks aren't associated with nodes; the master thread
+// only runs chunk 0 itself in the latter case
+CAFFE2_API int _intraop_task_node(size_t task_id, size_t num_tasks);
+
 // internal utility function to mark master thread as in parallel
 // region when executing parallel primitives
 CAFFE2_API void _set_in_parallel_region(bool);
@@ -60,12 +72,16 @@ inline void parallel_for(
       internal::_unset_thread_num();
     };
 
+    // In NUMA mode the first chunk goes to a pool bound to its node, as the
+    // master thread isn't bound to any
+    const size_t first_pool_task =
+        internal::_intraop_task_node(0, num_tasks) < 0 ? 1 : 0;
     std::vector<c10::ivalue::Future> futures(num_tasks);
-    for (size_t task_id = 1; task_id < num_tasks; ++task_id) {
+    for (size_t task_id = first_pool_task; task_id < num_tasks; ++task_id) {
       int64_t local_start = begin + task_id * chunk_size;
       if (local_start < end) {
         int64_t local_end = std::min(end, (int64_t)(chunk_size + local_start));
-        internal::_get_intraop_pool().run(
+        internal::_get_intraop_pool(task_id, num_tasks).run(
           // copy task_id, local_start, local_end
           [&task, &futures, task_id, local_start, local_end]() {
             task(task_id, local_start, local_end);
@@ -77,10 +93,12 @@ inline void parallel_for(
       }
     }
 
-    int64_t first_task_end = std::min(end, (int64_t)(chunk_size + begin));
-    task(0, begin, first_task_end);
+    if (first_pool_task > 0) {
+      int64_t first_task_end = std::min(end, (int64_t)(chunk_size + begin));
+      task(0, begin, first_task_end);
+    }
     // wait for all tasks to finish
-    for (size_t task_id = 1; task_id < num_tasks; ++task_id) {
+    for (size_t task_id = first_pool_task; task_id < num_tasks; ++task_id) {
       futures[task_id].wait();
     }
     if (eptr) {
@@ -128,12 +146,16 @@ inline scalar_t parallel_reduce(
       internal::_unset_thread_num();
     };
 
+    // In NUMA mode the first chunk goes to a pool bound to its node, as the
+    // master thread isn't bound to any
+    const size_t first_pool_task =
+        internal::_intraop_task_node(0, num_tasks) < 0 ? 1 : 0;
     std::vector<c10::ivalue::Future> futures(num_tasks);
-    for (size_t task_id = 1; task_id < num_tasks; ++task_id) {
+    for (size_t task_id = first_pool_task; task_id < num_tasks; ++task_id) {
       int64_t local_start = begin + task_id * chunk_size;
       if (local_start < end) {
         int64_t local_end = std::min(end, (int64_t)(chunk_size + local_start));
-        internal::_get_intraop_pool().run(
+        internal::_get_intraop_pool(task_id, num_tasks).run(
           // copy task_id, local_start, local_end
           [&task, &futures, task_id, local_start, local_end]() {
             task(task_id, local_start, local_end);
@@ -145,9 +167,11 @@ inline scalar_t parallel_reduce(
       }
     }
 
-    int64_t first_task_end = std::min(end, (int64_t)(chunk_size + begin));
-    task(0, begin, first_task_end);
-    for (size_t task_id = 1; task_id < num_tasks; ++task_id) {
+    if (first_pool_task > 0) {
+      int64_t first_task_end = std::min(end, (int64_t)(chunk_size + begin));
+      task(0, begin, first_task_end);
+    }
+    for (size_t task_id = first_pool_task; task_id < num_tasks; ++task_id) {
       futures[task_id].wait();
     }
     if (eptr) {
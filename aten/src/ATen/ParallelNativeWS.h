@@ -0,0 +1,101 @@
+#pragma once
+#include <ATen/ATen.h>
+
+#include <c10/core/work_stealing_pool.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#define INTRA_OP_PARALLEL
+
+namespace at {
+namespace internal {
+// Number of chunks per thread a parallel range is split into. Chunks are
+// handed out by work stealing, so having more chunks than threads lets idle
+// threads take over work from threads that got slower chunks.
+constexpr int64_t CHUNKS_PER_THREAD = 16;
+
+// internal function to get access to the intra-op work-stealing pool
+CAFFE2_API c10::WorkStealingPool& _get_intraop_pool();
+
+// internal function that runs f(chunk_id) for every chunk_id in
+// [0, num_chunks) on the intra-op pool, with the thread number and parallel
+// region markers set up for each chunk
+CAFFE2_API void _parallel_run(
+    int64_t num_chunks,
+    const std::function<void(int64_t)>& f);
+
+inline int64_t _chunk_size(int64_t range, int64_t grain_size) {
+  int64_t chunk_size = divup(range, get_num_threads() * CHUNKS_PER_THREAD);
+  return std::max(std::max(grain_size, chunk_size), (int64_t)1);
+}
+} // namespace internal
+
+template <class F>
+inline void parallel_for(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const F& f) {
+  TORCH_CHECK(grain_size >= 0);
+  if (begin >= end) {
+    return;
+  }
+
+  if (((end - begin) >= grain_size) && !in_parallel_region() &&
+      get_num_threads() > 1) {
+    int64_t chunk_size = internal::_chunk_size(end - begin, grain_size);
+    int64_t num_chunks = divup(end - begin, chunk_size);
+    internal::_parallel_run(
+        num_chunks,
+        [begin, end, chunk_size, &f](int64_t chunk) {
+          int64_t local_start = begin + chunk * chunk_size;
+          f(local_start, std::min(end, local_start + chunk_size));
+        });
+  } else {
+    f(begin, end);
+  }
+}
+
+template <class scalar_t, class F, class SF>
+inline scalar_t parallel_reduce(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const scalar_t ident,
+    const F& f,
+    const SF& sf) {
+  TORCH_CHECK(grain_size >= 0);
+  if (begin >= end) {
+    return ident;
+  }
+
+  if (((end - begin) >= grain_size) && !in_parallel_region() &&
+      get_num_threads() > 1) {
+    // Partial results are kept per chunk rather than per thread, so that the
+    // order of combination does not depend on which thread ran which chunk.
+    int64_t chunk_size = internal::_chunk_size(end - begin, grain_size);
+    int64_t num_chunks = divup(end - begin, chunk_size);
+    std::vector<scalar_t> results(num_chunks, ident);
+    scalar_t* results_data = results.data();
+    internal::_parallel_run(
+        num_chunks,
+        [begin, end, chunk_size, ident, results_data, &f](int64_t chunk) {
+          int64_t local_start = begin + chunk * chunk_size;
+          results_data[chunk] =
+              f(local_start, std::min(end, local_start + chunk_size), ident);
+        });
+
+    scalar_t result = ident;
+    for (auto partial_result : results) {
+      result = sf(result, partial_result);
+    }
+    return result;
+  } else {
+    return f(begin, end, ident);
+  }
+}
+
+} // namespace at
@@ -1,4 +1,5 @@
-#if AT_PARALLEL_OPENMP || AT_PARALLEL_NATIVE || AT_PARALLEL_NATIVE_TBB
+#if AT_PARALLEL_OPENMP || AT_PARALLEL_NATIVE || AT_PARALLEL_NATIVE_TBB || \
+    AT_PARALLEL_NATIVE_WS
 #include <ATen/Parallel.h>
 #include <ATen/PTThreadPool.h>
 #include <ATen/ThreadLocalDebugInfo.h>
@@ -42,9 +43,21 @@ std::shared_ptr<TaskThreadPoolBase> create_c10_threadpool(
   return std::make_shared<PTThreadPool>(pool_size);
 }
 
+// Factory function for ThreadPoolRegistry, creates a pool whose threads are
+// bound to the NUMA node given as device id
+std::shared_ptr<TaskThreadPoolBase> create_c10_numa_threadpool(
+    int numa_node_id,
+    int pool_size,
+    bool create_new) {
+  TORCH_CHECK(numa_node_id >= 0);
+  TORCH_CHECK(create_new);
+  return std::make_shared<PTThreadPool>(pool_size, numa_node_id);
+}
+
 } // namespace
 
 C10_REGISTER_CREATOR(ThreadPoolRegistry, C10, create_c10_threadpool);
+C10_REGISTER_CREATOR(ThreadPoolRegistry, C10_NUMA, create_c10_numa_threadpool);
 
 void set_num_interop_threads(int nthreads) {
   TORCH_CHECK(nthreads > 0, "Expected positive number of threads");
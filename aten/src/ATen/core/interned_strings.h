@@ -84,6 +84,9 @@ namespace c10 {
   _(prim, ConstantChunk)             \
   _(prim, MMTreeReduce)              \
   _(prim, MMBatchSide)               \
+  _(prim, MemoryArena)               \
+  _(prim, ArenaSlice)                \
+  _(prim, OutBuffer)                 \
   _(prim, min)                       \
   _(prim, max)                       \
   _(prim, abs)                       \
@@ -0,0 +1,152 @@
+// Register programs of elementwise operations
+#include <ATen/native/ElementwiseProgram.h>
+
+#include <ATen/ATen.h>
+#include <ATen/native/TensorIterator.h>
+
+namespace at {
+namespace native {
+
+using Op = ElementwiseInstr::Op;
+
+static int num_operands(Op op) {
+  switch (op) {
+    case Op::Constant:
+    case Op::Scalar:
+      return 0;
+    case Op::Add:
+    case Op::Sub:
+    case Op::Mul:
+    case Op::Div:
+    case Op::Min:
+    case Op::Max:
+    case Op::Pow:
+    case Op::Atan2:
+    case Op::SigmoidBackward:
+    case Op::TanhBackward:
+      return 2;
+    case Op::Addcmul:
+    case Op::Lerp:
+    case Op::Clamp:
+    case Op::Threshold:
+      return 3;
+    default:
+      return 1;
+  }
+}
+
+static const char* op_name(Op op) {
+  // Same order as ElementwiseInstr::Op
+  static const char* names[] = {
+      "Constant", "Scalar", "Add", "Sub", "Mul", "Div", "Min", "Max", "Pow",
+      "Atan2", "Addcmul", "Lerp", "Clamp", "Threshold", "SigmoidBackward",
+      "TanhBackward", "Neg", "Abs", "Relu", "Sigmoid", "Exp", "Expm1", "Log",
+      "Log10", "Log1p", "Log2", "Sqrt", "Rsqrt", "Reciprocal", "Sin", "Cos",
+      "Tan", "Asin", "Acos", "Atan", "Sinh", "Cosh", "Tanh", "Erf", "Erfc",
+      "Floor", "Ceil", "Trunc", "Round", "Frac",
+  };
+  static_assert(
+      sizeof(names) / sizeof(names[0]) == static_cast<size_t>(Op::Frac) + 1,
+      "op_name is missing an op");
+  return names[static_cast<size_t>(op)];
+}
+
+void ElementwiseProgram::validate() const {
+  std::vector<bool> is_set(num_registers, false);
+  TORCH_CHECK(
+      num_inputs >= 0 && num_inputs <= num_registers,
+      "ElementwiseProgram: invalid number of inputs");
+  std::fill(is_set.begin(), is_set.begin() + num_inputs, true);
+  auto check_read = [&](int reg) {
+    TORCH_CHECK(
+        reg >= 0 && reg < num_registers && is_set[reg],
+        "ElementwiseProgram: read of unset register ", reg);
+  };
+  for (const auto& instr : instrs) {
+    int n = num_operands(instr.op);
+    if (n > 0) {
+      check_read(instr.a);
+    }
+    if (n > 1) {
+      check_read(instr.b);
+    }
+    if (n > 2) {
+      check_read(instr.c);
+    }
+    TORCH_CHECK(
+        instr.out >= num_inputs && instr.out < num_registers,
+        "ElementwiseProgram: invalid output register ", instr.out);
+    is_set[instr.out] = true;
+  }
+  for (int reg : outputs) {
+    check_read(reg);
+  }
+}
+
+std::ostream& operator<<(
+    std::ostream& out,
+    const ElementwiseProgram& program) {
+  out << "inputs: r0 .. r" << program.num_inputs - 1 << "\n";
+  for (const auto& instr : program.instrs) {
+    out << "r" << instr.out << " = " << op_name(instr.op) << "(";
+    int n = num_operands(instr.op);
+    if (instr.op == Op::Scalar) {
+      out << "s" << instr.a;
+    }
+    for (int i = 0; i < n; i++) {
+      const int16_t reg = i == 0 ? instr.a : (i == 1 ? instr.b : instr.c);
+      out << (i > 0 ? ", " : "") << "r" << reg;
+    }
+    if (instr.op == Op::Constant) {
+      out << instr.alpha;
+    } else if (
+        instr.op == Op::Add || instr.op == Op::Sub ||
+        instr.op == Op::Addcmul) {
+      out << ", alpha=" << instr.alpha;
+    }
+    out << ")\n";
+  }
+  out << "outputs:";
+  for (int reg : program.outputs) {
+    out << " r" << reg;
+  }
+  return out << "\n";
+}
+
+void run_elementwise_program(
+    TensorIterator& iter,
+    const ElementwiseProgram& program,
+    const std::vector<double>& scalars) {
+  TORCH_CHECK(
+      iter.device_type() == DeviceType::CPU,
+      "ElementwiseProgram: expected CPU tensors");
+  TORCH_CHECK(
+      isFloatingType(iter.dtype()),
+      "ElementwiseProgram: expected floating point tensors, but got ",
+      iter.dtype());
+  for (int i = 0; i < iter.ntensors(); i++) {
+    TORCH_CHECK(
+        iter.dtype(i) == iter.dtype(),
+        "ElementwiseProgram: expected all operands to have dtype ",
+        iter.dtype(), ", but got ", iter.dtype(i));
+  }
+  TORCH_CHECK(
+      iter.ninputs() == program.num_inputs &&
+          iter.noutputs() == static_cast<int>(program.outputs.size()),
+      "ElementwiseProgram: the iterator does not match the program");
+  for (const auto& instr : program.instrs) {
+    TORCH_CHECK(
+        instr.op != Op::Scalar ||
+            (instr.a >= 0 && instr.a < static_cast<int>(scalars.size())),
+        "ElementwiseProgram: missing scalar ", instr.a);
+  }
+  if (iter.numel() == 0) {
+    return;
+  }
+  elementwise_program_stub(iter.device_type(), iter, program, scalars);
+}
+
+DEFINE_DISPATCH(elementwise_program_stub);
+
+} // namespace native
+} // namespace at
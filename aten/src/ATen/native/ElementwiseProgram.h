@@ -0,0 +1,115 @@
+// Register programs of elementwise operations
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+#include <ostream>
+#include <vector>
+
+namespace at {
+
+struct TensorIterator;
+
+namespace native {
+
+// One instruction of an ElementwiseProgram. Computes register `out` from the
+// registers `a`, `b` and `c`.
+struct ElementwiseInstr {
+  enum class Op : uint8_t {
+    Constant,        // alpha
+    Scalar,          // the a-th scalar passed to the program
+    Add,             // a + alpha * b
+    Sub,             // a - alpha * b
+    Mul,             // a * b
+    Div,             // a / b
+    Min,             // min(a, b)
+    Max,             // max(a, b)
+    Pow,             // a ^ b
+    Atan2,           // atan2(a, b)
+    Addcmul,         // a + alpha * b * c
+    Lerp,            // a + c * (b - a)
+    Clamp,           // clamp(a, b, c)
+    Threshold,       // a <= b ? c : a
+    SigmoidBackward, // a * b * (1 - b)
+    TanhBackward,    // a * (1 - b * b)
+    Neg,
+    Abs,
+    Relu,
+    Sigmoid,
+    Exp,
+    Expm1,
+    Log,
+    Log10,
+    Log1p,
+    Log2,
+    Sqrt,
+    Rsqrt,
+    Reciprocal,
+    Sin,
+    Cos,
+    Tan,
+    Asin,
+    Acos,
+    Atan,
+    Sinh,
+    Cosh,
+    Tanh,
+    Erf,
+    Erfc,
+    Floor,
+    Ceil,
+    Trunc,
+    Round,
+    Frac,
+  };
+
+  Op op;
+  int16_t out;
+  int16_t a;
+  int16_t b;
+  int16_t c;
+  double alpha;
+};
+
+// A DAG of elementwise operations over a set of registers, run in a single
+// pass over memory. Registers 0 .. num_inputs - 1 hold the inputs of the
+// iterator; the other registers are temporaries written by the instructions,
+// in order. outputs[i] is the register stored to the i-th output.
+//
+// Like PointwiseChain, the program is applied to cache-sized tiles of the
+// iteration space, with every instruction vectorized with Vec256. This is
+// what the in-process CPU backend of the JIT fuser lowers fusion groups to.
+struct CAFFE2_API ElementwiseProgram {
+  int num_inputs = 0;
+  int num_registers = 0;
+  std::vector<ElementwiseInstr> instrs;
+  std::vector<int> outputs;
+
+  // Checks that every instruction only reads registers that are set and
+  // writes a temporary register
+  void validate() const;
+};
+
+// Prints one instruction per line, e.g. "r3 = Add(r0, r2, alpha=1)"
+CAFFE2_API std::ostream& operator<<(
+    std::ostream& out,
+    const ElementwiseProgram& program);
+
+using elementwise_program_fn = void (*)(
+    TensorIterator&,
+    const ElementwiseProgram&,
+    const std::vector<double>&);
+
+DECLARE_DISPATCH(elementwise_program_fn, elementwise_program_stub);
+
+// Runs program on iter, whose inputs and outputs must all be CPU tensors of
+// the same floating point dtype. scalars are the values of the Scalar
+// instructions.
+CAFFE2_API void run_elementwise_program(
+    TensorIterator& iter,
+    const ElementwiseProgram& program,
+    const std::vector<double>& scalars = {});
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,126 @@
+// Fused chains of elementwise operations
+#include <ATen/native/PointwiseChain.h>
+
+#include <ATen/ATen.h>
+#include <ATen/native/TensorIterator.h>
+
+namespace at {
+namespace native {
+
+using Op = PointwiseStep::Op;
+
+PointwiseChain::PointwiseChain(const Tensor& self) : self_(self) {
+  TORCH_CHECK(
+      self.device().type() == DeviceType::CPU,
+      "PointwiseChain: expected a CPU tensor, but got ", self.device());
+  TORCH_CHECK(
+      self.scalar_type() == kFloat || self.scalar_type() == kDouble,
+      "PointwiseChain: expected a float or double tensor, but got ",
+      self.scalar_type());
+}
+
+PointwiseChain& PointwiseChain::push_tensor(
+    Op op,
+    const Tensor& other,
+    double alpha) {
+  TORCH_CHECK(
+      other.scalar_type() == self_.scalar_type(),
+      "PointwiseChain: expected all operands to have dtype ",
+      self_.scalar_type(), ", but got ", other.scalar_type());
+  operands_.push_back(other);
+  // input 0 of the iterator is the source tensor
+  steps_.push_back({op, static_cast<int>(operands_.size()), alpha, 0});
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::push(Op op, double alpha, double beta) {
+  steps_.push_back({op, -1, alpha, beta});
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::add(const Tensor& other, Scalar alpha) {
+  return push_tensor(Op::Add, other, alpha.to<double>());
+}
+
+PointwiseChain& PointwiseChain::add(Scalar other) {
+  return push(Op::Add, other.to<double>());
+}
+
+PointwiseChain& PointwiseChain::sub(const Tensor& other, Scalar alpha) {
+  return push_tensor(Op::Sub, other, alpha.to<double>());
+}
+
+PointwiseChain& PointwiseChain::sub(Scalar other) {
+  return push(Op::Sub, other.to<double>());
+}
+
+PointwiseChain& PointwiseChain::mul(const Tensor& other) {
+  return push_tensor(Op::Mul, other);
+}
+
+PointwiseChain& PointwiseChain::mul(Scalar other) {
+  return push(Op::Mul, other.to<double>());
+}
+
+PointwiseChain& PointwiseChain::div(const Tensor& other) {
+  return push_tensor(Op::Div, other);
+}
+
+PointwiseChain& PointwiseChain::div(Scalar other) {
+  return push(Op::Div, other.to<double>());
+}
+
+PointwiseChain& PointwiseChain::neg() {
+  return push(Op::Neg);
+}
+
+PointwiseChain& PointwiseChain::relu() {
+  return push(Op::Relu);
+}
+
+PointwiseChain& PointwiseChain::sigmoid() {
+  return push(Op::Sigmoid);
+}
+
+PointwiseChain& PointwiseChain::tanh() {
+  return push(Op::Tanh);
+}
+
+PointwiseChain& PointwiseChain::exp() {
+  return push(Op::Exp);
+}
+
+PointwiseChain& PointwiseChain::log() {
+  return push(Op::Log);
+}
+
+PointwiseChain& PointwiseChain::clamp(Scalar min, Scalar max) {
+  return push(Op::Clamp, min.to<double>(), max.to<double>());
+}
+
+Tensor PointwiseChain::run() const {
+  Tensor result = at::empty({0}, self_.options());
+  return run_out(result);
+}
+
+Tensor& PointwiseChain::run_out(Tensor& result) const {
+  auto iter = at::TensorIterator();
+  iter.set_check_mem_overlap(true);
+  iter.add_output(result);
+  iter.add_input(self_);
+  for (const auto& operand : operands_) {
+    iter.add_input(operand);
+  }
+  iter.build();
+  pointwise_chain_stub(iter.device_type(), iter, steps_);
+  return result;
+}
+
+Tensor& PointwiseChain::run_() {
+  return run_out(self_);
+}
+
+DEFINE_DISPATCH(pointwise_chain_stub);
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,102 @@
+// Fused chains of elementwise operations
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+#include <vector>
+
+namespace at {
+
+struct TensorIterator;
+
+namespace native {
+
+// One step of a PointwiseChain, applied to the running value `x`.
+struct PointwiseStep {
+  enum class Op : uint8_t {
+    Add,     // x + alpha * other
+    Sub,     // x - alpha * other
+    Mul,     // x * other
+    Div,     // x / other
+    Neg,
+    Relu,
+    Sigmoid,
+    Tanh,
+    Exp,
+    Log,
+    Clamp,   // clamp(x, alpha, beta)
+  };
+
+  Op op;
+  // Index of the iterator input holding `other`, or -1 if `other` is the
+  // scalar `alpha` (in which case Add/Sub use an alpha of 1).
+  int operand;
+  double alpha;
+  double beta;
+};
+
+using pointwise_chain_fn =
+    void (*)(TensorIterator&, const std::vector<PointwiseStep>&);
+
+DECLARE_DISPATCH(pointwise_chain_fn, pointwise_chain_stub);
+
+// Applies a chain of elementwise operations in a single pass over memory.
+//
+// In eager mode, `x.mul(a).add_(b).sigmoid_()` builds one TensorIterator per
+// op and streams every operand through memory once per op. A PointwiseChain
+// records the ops instead and runs them as one TensorIterator kernel that
+// processes cache-sized tiles of the iteration space, applying every recorded
+// op to a tile with Vec256 before moving on:
+//
+//   Tensor y = PointwiseChain(x).mul(a).add(b).sigmoid().run();
+//
+// Tensor operands broadcast against each other like in the unfused ops, but
+// must have the same dtype as the source tensor, which must be float or
+// double; no type promotion is done. Only CPU is supported.
+class CAFFE2_API PointwiseChain {
+ public:
+  explicit PointwiseChain(const Tensor& self);
+
+  PointwiseChain& add(const Tensor& other, Scalar alpha = 1);
+  PointwiseChain& add(Scalar other);
+  PointwiseChain& sub(const Tensor& other, Scalar alpha = 1);
+  PointwiseChain& sub(Scalar other);
+  PointwiseChain& mul(const Tensor& other);
+  PointwiseChain& mul(Scalar other);
+  PointwiseChain& div(const Tensor& other);
+  PointwiseChain& div(Scalar other);
+  PointwiseChain& neg();
+  PointwiseChain& relu();
+  PointwiseChain& sigmoid();
+  PointwiseChain& tanh();
+  PointwiseChain& exp();
+  PointwiseChain& log();
+  PointwiseChain& clamp(Scalar min, Scalar max);
+
+  // Number of recorded ops
+  size_t size() const {
+    return steps_.size();
+  }
+
+  // Runs the chain into a newly allocated tensor
+  Tensor run() const;
+  // Runs the chain into `result`, resizing it if necessary
+  Tensor& run_out(Tensor& result) const;
+  // Runs the chain in place on the source tensor
+  Tensor& run_();
+
+ private:
+  PointwiseChain& push_tensor(
+      PointwiseStep::Op op,
+      const Tensor& other,
+      double alpha = 1);
+  PointwiseChain& push(PointwiseStep::Op op, double alpha = 0, double beta = 0);
+
+  Tensor self_;
+  std::vector<Tensor> operands_;
+  std::vector<PointwiseStep> steps_;
+};
+
+} // namespace native
+} // namespace at
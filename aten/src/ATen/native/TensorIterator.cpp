@@ -1,6 +1,10 @@
 #include <ATen/native/TensorIterator.h>
 
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <ATen/ExpandUtils.h>
 #include <ATen/Parallel.h>
 
@@ -223,6 +227,9 @@ void TensorIterator::compute_types() {
 
       validate_dtype(op, common_dtype, ninputs());
       maybe_promote_common_dtype(op, common_dtype);
+      if (op.original_tensor.defined()) {
+        plan_cacheable_ = false;
+      }
 
       if (op.tensor.defined() && op.device != op.tensor.device()) {
         if (op.is_output) {
@@ -230,6 +237,7 @@ void TensorIterator::compute_types() {
                    " doesn't match the desired device ", op.device);
         } else if (op.tensor.dim() == 0) {
           op.tensor = op.tensor.to(op.options());
+          plan_cacheable_ = false;
         } else {
           AT_ERROR("expected device ", op.device,
                    " but got device ", op.tensor.device());
@@ -739,6 +747,7 @@ void TensorIterator::compute_shape() {
         // Preserve legacy resizing behavior of out=... arguments
         // TODO: issue warning
         tensor.resize_(shape_);
+        plan_cacheable_ = false;
         continue;
       }
       if (!is_reduction_) {
@@ -819,32 +828,304 @@ int TensorIterator::get_dim_to_split() const {
   return dim_to_split;
 }
 
+struct TensorIterator::PlanKey {
+  // Flags of the iterator followed by a description of each operand, see
+  // compute_plan_key().
+  SmallVector<int64_t, 32> data;
+  size_t hash = 0;
+
+  bool operator==(const PlanKey& other) const {
+    return hash == other.hash && data.size() == other.data.size() &&
+        std::equal(data.begin(), data.end(), other.data.begin());
+  }
+};
+
+struct TensorIterator::Plan {
+  struct Operand {
+    DimVector stride_bytes;
+    Device device = kCPU;
+    ScalarType dtype = ScalarType::Undefined;
+    // Outputs allocated by build() are created with this shape and stride.
+    bool allocate = false;
+    DimVector tensor_shape;
+    DimVector tensor_stride;
+  };
+
+  DimVector shape;
+  DimVector perm;
+  bool has_coalesced_dimensions = false;
+  SmallVector<Operand, 4> operands;
+};
+
+namespace {
+
+// Plans are kept per thread, so lookups need no synchronization. A thread
+// that sees more distinct geometries than this starts over with an empty
+// cache.
+constexpr size_t kMaxCachedPlans = 256;
+
+struct PlanKeyHash {
+  size_t operator()(const TensorIterator::PlanKey& key) const {
+    return key.hash;
+  }
+};
+
+using PlanCache = std::unordered_map<
+    TensorIterator::PlanKey, TensorIterator::Plan, PlanKeyHash>;
+
+PlanCache& get_plan_cache() {
+  static thread_local PlanCache cache;
+  return cache;
+}
+
+std::atomic<bool> plan_cache_enabled_{true};
+
+// Hits and misses are counted per thread, so that concurrent builds don't
+// contend on a shared cache line, and summed when the stats are read. Only
+// the owning thread writes its counters; the atomics only make the reads of
+// other threads well-defined.
+struct PlanCacheCounters {
+  PlanCacheCounters();
+  ~PlanCacheCounters();
+  std::atomic<int64_t> hits{0};
+  std::atomic<int64_t> misses{0};
+};
+
+struct PlanCacheCounterRegistry {
+  std::mutex mutex;
+  std::unordered_set<PlanCacheCounters*> counters;
+  // counts of threads that have exited
+  int64_t retired_hits = 0;
+  int64_t retired_misses = 0;
+  // totals at the last reset_plan_cache_stats()
+  int64_t base_hits = 0;
+  int64_t base_misses = 0;
+};
+
+// Leaked, since thread-local counters may be destroyed after static objects
+PlanCacheCounterRegistry& plan_cache_counter_registry() {
+  static auto registry = new PlanCacheCounterRegistry();
+  return *registry;
+}
+
+PlanCacheCounters::PlanCacheCounters() {
+  auto& registry = plan_cache_counter_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.counters.insert(this);
+}
+
+PlanCacheCounters::~PlanCacheCounters() {
+  auto& registry = plan_cache_counter_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.counters.erase(this);
+  registry.retired_hits += hits.load(std::memory_order_relaxed);
+  registry.retired_misses += misses.load(std::memory_order_relaxed);
+}
+
+PlanCacheCounters& get_plan_cache_counters() {
+  static thread_local PlanCacheCounters counters;
+  return counters;
+}
+
+void increment(std::atomic<int64_t>& counter) {
+  counter.store(
+      counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// Sums the counters of all threads; requires the registry lock
+TensorIterator::PlanCacheStats total_plan_cache_stats(
+    const PlanCacheCounterRegistry& registry) {
+  TensorIterator::PlanCacheStats stats;
+  stats.hits = registry.retired_hits;
+  stats.misses = registry.retired_misses;
+  for (auto counters : registry.counters) {
+    stats.hits += counters->hits.load(std::memory_order_relaxed);
+    stats.misses += counters->misses.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+int64_t encode_device(Device device) {
+  return static_cast<int64_t>(device.type()) |
+      (static_cast<int64_t>(device.index()) + 1) << 16;
+}
+
+} // namespace
+
+void TensorIterator::set_plan_cache_enabled(bool enabled) {
+  plan_cache_enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool TensorIterator::plan_cache_enabled() {
+  return plan_cache_enabled_.load(std::memory_order_relaxed);
+}
+
+TensorIterator::PlanCacheStats TensorIterator::plan_cache_stats() {
+  auto& registry = plan_cache_counter_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto stats = total_plan_cache_stats(registry);
+  stats.hits -= registry.base_hits;
+  stats.misses -= registry.base_misses;
+  return stats;
+}
+
+void TensorIterator::reset_plan_cache_stats() {
+  auto& registry = plan_cache_counter_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto stats = total_plan_cache_stats(registry);
+  registry.base_hits = stats.hits;
+  registry.base_misses = stats.misses;
+}
+
+void TensorIterator::clear_plan_cache() {
+  get_plan_cache().clear();
+}
+
+bool TensorIterator::compute_plan_key(PlanKey* key) const {
+  if (!plan_cache_enabled() || ntensors() > 64) {
+    return false;
+  }
+  auto& data = key->data;
+  data.push_back(
+      num_outputs_ |
+      static_cast<int64_t>(resize_outputs_) << 32 |
+      static_cast<int64_t>(is_reduction_) << 33 |
+      static_cast<int64_t>(compute_common_dtype_) << 34 |
+      static_cast<int64_t>(allow_cpu_scalars_) << 35 |
+      static_cast<int64_t>(promote_gpu_output_dtypes_) << 36);
+  for (auto& op : operands_) {
+    // requested dtype and device, and the flags set by mark_outputs()
+    data.push_back(
+        static_cast<int64_t>(op.dtype) |
+        encode_device(op.device) << 8 |
+        static_cast<int64_t>(op.is_output) << 40 |
+        static_cast<int64_t>(op.is_read_write) << 41 |
+        static_cast<int64_t>(op.tensor.defined()) << 42);
+    if (!op.tensor.defined()) {
+      continue;
+    }
+    auto& tensor = op.tensor;
+#ifdef BUILD_NAMEDTENSOR
+    if (tensor.has_names()) {
+      return false;
+    }
+#endif
+    auto sizes = tensor.sizes();
+    auto strides = tensor.strides();
+    data.push_back(
+        static_cast<int64_t>(tensor.scalar_type()) |
+        encode_device(tensor.device()) << 8 |
+        static_cast<int64_t>(
+            tensor.unsafeGetTensorImpl()->is_wrapped_number()) << 40);
+    data.push_back(sizes.size());
+    data.append(sizes.begin(), sizes.end());
+    data.append(strides.begin(), strides.end());
+  }
+
+  size_t hash = data.size();
+  for (int64_t value : data) {
+    hash ^= std::hash<int64_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  key->hash = hash;
+  return true;
+}
+
+bool TensorIterator::apply_cached_plan(const PlanKey& key) {
+  auto& cache = get_plan_cache();
+  auto it = cache.find(key);
+  if (it == cache.end()) {
+    increment(get_plan_cache_counters().misses);
+    return false;
+  }
+  increment(get_plan_cache_counters().hits);
+
+  const Plan& plan = it->second;
+  shape_ = plan.shape;
+  perm_ = plan.perm;
+  has_coalesced_dimensions_ = plan.has_coalesced_dimensions;
+  for (int i = 0; i < ntensors(); i++) {
+    auto& op = operands_[i];
+    auto& plan_op = plan.operands[i];
+    op.stride_bytes = plan_op.stride_bytes;
+    op.device = plan_op.device;
+    op.dtype = plan_op.dtype;
+    if (plan_op.allocate) {
+      op.tensor = at::empty_strided(
+          plan_op.tensor_shape, plan_op.tensor_stride, op.options());
+    }
+  }
+  return true;
+}
+
+void TensorIterator::save_plan(
+    PlanKey&& key,
+    const DimMask& allocated_outputs) {
+  Plan plan;
+  plan.shape = shape_;
+  plan.perm = perm_;
+  plan.has_coalesced_dimensions = has_coalesced_dimensions_;
+  for (int i = 0; i < ntensors(); i++) {
+    auto& op = operands_[i];
+    Plan::Operand plan_op;
+    plan_op.stride_bytes = op.stride_bytes;
+    plan_op.device = op.device;
+    plan_op.dtype = op.dtype;
+    if (allocated_outputs[i]) {
+      plan_op.allocate = true;
+      plan_op.tensor_shape = DimVector(op.tensor.sizes());
+      plan_op.tensor_stride = DimVector(op.tensor.strides());
+    }
+    plan.operands.push_back(std::move(plan_op));
+  }
+
+  auto& cache = get_plan_cache();
+  if (cache.size() >= kMaxCachedPlans) {
+    cache.clear();
+  }
+  cache.emplace(std::move(key), std::move(plan));
+}
+
 void TensorIterator::build() {
   // set is_output and is_read_write flags on appropriate tensors
   mark_outputs();
   // Check that the outputs have no internal overlap
   // and do not share memory with inputs.
   check_mem_overlaps();
+
+  // Reuse the result of the steps below from an earlier build() with the same
+  // operand geometry, if there is one.
+  PlanKey key;
+  bool use_plan_cache = compute_plan_key(&key);
+  if (!use_plan_cache || !apply_cached_plan(key)) {
+    DimMask allocated_outputs;
+    for (int i = 0; i < num_outputs_; i++) {
+      allocated_outputs[i] = !operands_[i].tensor.defined();
+    }
 #ifdef BUILD_NAMEDTENSOR
-  // Check that input dimensions are aligned correctly & compute outnames.
-  compute_names();
+    // Check that input dimensions are aligned correctly & compute outnames.
+    compute_names();
 #endif
-  // compute the broadcasted shape
-  compute_shape();
-  // compute each tensor's stride after broadcasting
-  compute_strides();
-  // re-order dimensions to improve coalescing
-  reorder_dimensions();
-  // compute the result dtype and device
-  compute_types();
-  // allocate the output tensor if it's not provided
-  allocate_outputs();
+    // compute the broadcasted shape
+    compute_shape();
+    // compute each tensor's stride after broadcasting
+    compute_strides();
+    // re-order dimensions to improve coalescing
+    reorder_dimensions();
+    // compute the result dtype and device
+    compute_types();
+    // allocate the output tensor if it's not provided
+    allocate_outputs();
 #ifdef BUILD_NAMEDTENSOR
-  // perform name inference
-  propagate_names_to_outputs();
+    // perform name inference
+    propagate_names_to_outputs();
 #endif
-  // coalesce adjacent dimensions when possible
-  coalesce_dimensions();
+    // coalesce adjacent dimensions when possible
+    coalesce_dimensions();
+
+    if (use_plan_cache && plan_cacheable_) {
+      save_plan(std::move(key), allocated_outputs);
+    }
+  }
 
   for (auto& op : operands_) {
     TORCH_INTERNAL_ASSERT(op.tensor.defined());
@@ -304,7 +304,35 @@ struct CAFFE2_API TensorIterator {
 
   void build();
 
+  /// Plan cache. build() remembers the shape, strides, dimension order and
+  /// types it computed for a given operand geometry (sizes, strides, dtypes,
+  /// devices and flags of all operands) in a per-thread cache. A later build()
+  /// with the same geometry reuses them instead of running compute_shape,
+  /// compute_strides, reorder_dimensions, compute_types and
+  /// coalesce_dimensions again. Iterators that convert or resize operands, or
+  /// that involve named tensors, are never cached.
+  struct PlanCacheStats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+  };
+  static void set_plan_cache_enabled(bool enabled);
+  static bool plan_cache_enabled();
+  /// Hits and misses summed over all threads.
+  static PlanCacheStats plan_cache_stats();
+  static void reset_plan_cache_stats();
+  /// Drops the cached plans of the calling thread.
+  static void clear_plan_cache();
+
+  // Defined in TensorIterator.cpp
+  struct PlanKey;
+  struct Plan;
+
 protected:
+  // Returns false if this iterator cannot use the plan cache.
+  bool compute_plan_key(PlanKey* key) const;
+  bool apply_cached_plan(const PlanKey& key);
+  void save_plan(PlanKey&& key, const DimMask& allocated_outputs);
+
   void mark_outputs();
   void check_mem_overlaps();
   void compute_shape();
@@ -337,6 +365,8 @@ protected:
   bool promote_gpu_output_dtypes_ = false;
   bool final_output_ = true;
   bool check_mem_overlap_ = false;
+  // cleared by build() steps that modify the operands
+  bool plan_cacheable_ = true;
 };
 /// A container-like struct that acts as if it contains splits of a
 /// TensorIterator that can use 32-bit indexing. Taken together the splits cover
@@ -0,0 +1,202 @@
+// Register programs of elementwise operations
+#include <ATen/ATen.h>
+
+#include <ATen/Dispatch.h>
+#include <ATen/cpu/vec256/functional.h>
+#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/native/ElementwiseProgram.h>
+#include <ATen/native/TensorIterator.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace at {
+namespace native {
+namespace {
+
+using namespace vec256;
+using Op = ElementwiseInstr::Op;
+
+// Number of elements processed by every instruction before moving on to the
+// next tile. Small enough for the registers of typical fusion groups to stay
+// in L1/L2.
+constexpr int64_t kTileSize = 256;
+
+// Returns a pointer to `size` contiguous elements of an operand starting at
+// `ptr`, gathering them into `buffer` if the operand is not contiguous.
+template <typename scalar_t>
+scalar_t* load_tile(char* ptr, int64_t stride, int64_t size, scalar_t* buffer) {
+  if (stride == sizeof(scalar_t)) {
+    return reinterpret_cast<scalar_t*>(ptr);
+  }
+  if (stride == 0) {
+    std::fill(buffer, buffer + size, *reinterpret_cast<scalar_t*>(ptr));
+  } else {
+    for (int64_t i = 0; i < size; i++) {
+      buffer[i] = *reinterpret_cast<scalar_t*>(ptr + i * stride);
+    }
+  }
+  return buffer;
+}
+
+// Returns `size` elements owned by the calling thread, which every run of a
+// program on that thread reuses.
+template <typename T>
+T* thread_buffer(size_t size) {
+  static thread_local std::vector<T> buffer;
+  if (buffer.size() < size) {
+    buffer.resize(size);
+  }
+  return buffer.data();
+}
+
+template <typename scalar_t, typename F>
+void map3(
+    const F& vec_fun,
+    scalar_t* out,
+    const scalar_t* a,
+    const scalar_t* b,
+    const scalar_t* c,
+    int64_t size) {
+  using Vec = Vec256<scalar_t>;
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    vec_fun(Vec::loadu(a + d), Vec::loadu(b + d), Vec::loadu(c + d))
+        .store(out + d);
+  }
+  if (size - d > 0) {
+    int64_t rest = size - d;
+    vec_fun(
+        Vec::loadu(a + d, rest), Vec::loadu(b + d, rest), Vec::loadu(c + d, rest))
+        .store(out + d, rest);
+  }
+}
+
+template <typename scalar_t>
+void run_instr(
+    const ElementwiseInstr& instr,
+    scalar_t** regs,
+    const std::vector<double>& scalars,
+    int64_t size) {
+  using Vec = Vec256<scalar_t>;
+  scalar_t* out = regs[instr.out];
+  scalar_t* a = instr.a >= 0 ? regs[instr.a] : nullptr;
+  scalar_t* b = instr.b >= 0 ? regs[instr.b] : nullptr;
+  scalar_t* c = instr.c >= 0 ? regs[instr.c] : nullptr;
+  Vec alpha(static_cast<scalar_t>(instr.alpha));
+  Vec zero(static_cast<scalar_t>(0));
+  Vec one(static_cast<scalar_t>(1));
+
+#define UNARY(fn) vec256::map([](Vec x) { return fn; }, out, a, size)
+#define BINARY(fn) vec256::map2([=](Vec x, Vec y) { return fn; }, out, a, b, size)
+#define TERNARY(fn) map3([=](Vec x, Vec y, Vec z) { return fn; }, out, a, b, c, size)
+  switch (instr.op) {
+    case Op::Constant:
+      std::fill(out, out + size, static_cast<scalar_t>(instr.alpha));
+      break;
+    case Op::Scalar:
+      std::fill(out, out + size, static_cast<scalar_t>(scalars[instr.a]));
+      break;
+    case Op::Add: BINARY(vec256::fmadd(y, alpha, x)); break;
+    case Op::Sub: BINARY(x - y * alpha); break;
+    case Op::Mul: BINARY(x * y); break;
+    case Op::Div: BINARY(x / y); break;
+    case Op::Min: BINARY(vec256::minimum(x, y)); break;
+    case Op::Max: BINARY(vec256::maximum(x, y)); break;
+    case Op::Pow: BINARY(x.pow(y)); break;
+    case Op::Atan2: BINARY(x.atan2(y)); break;
+    case Op::SigmoidBackward: BINARY(x * y * (one - y)); break;
+    case Op::TanhBackward: BINARY(x * (one - y * y)); break;
+    case Op::Addcmul: TERNARY(x + alpha * y * z); break;
+    case Op::Lerp: TERNARY(x + z * (y - x)); break;
+    case Op::Clamp: TERNARY(vec256::clamp(x, y, z)); break;
+    case Op::Threshold: TERNARY(Vec::blendv(x, z, x <= y)); break;
+    case Op::Neg: UNARY(x.neg()); break;
+    case Op::Abs: UNARY(x.abs()); break;
+    case Op::Relu:
+      vec256::map([=](Vec x) { return vec256::clamp_min(x, zero); }, out, a, size);
+      break;
+    case Op::Sigmoid:
+      vec256::map(
+          [=](Vec x) { return (one + x.neg().exp()).reciprocal(); }, out, a, size);
+      break;
+    case Op::Exp: UNARY(x.exp()); break;
+    case Op::Expm1: UNARY(x.expm1()); break;
+    case Op::Log: UNARY(x.log()); break;
+    case Op::Log10: UNARY(x.log10()); break;
+    case Op::Log1p: UNARY(x.log1p()); break;
+    case Op::Log2: UNARY(x.log2()); break;
+    case Op::Sqrt: UNARY(x.sqrt()); break;
+    case Op::Rsqrt: UNARY(x.rsqrt()); break;
+    case Op::Reciprocal: UNARY(x.reciprocal()); break;
+    case Op::Sin: UNARY(x.sin()); break;
+    case Op::Cos: UNARY(x.cos()); break;
+    case Op::Tan: UNARY(x.tan()); break;
+    case Op::Asin: UNARY(x.asin()); break;
+    case Op::Acos: UNARY(x.acos()); break;
+    case Op::Atan: UNARY(x.atan()); break;
+    case Op::Sinh: UNARY(x.sinh()); break;
+    case Op::Cosh: UNARY(x.cosh()); break;
+    case Op::Tanh: UNARY(x.tanh()); break;
+    case Op::Erf: UNARY(x.erf()); break;
+    case Op::Erfc: UNARY(x.erfc()); break;
+    case Op::Floor: UNARY(x.floor()); break;
+    case Op::Ceil: UNARY(x.ceil()); break;
+    case Op::Trunc: UNARY(x.trunc()); break;
+    case Op::Round: UNARY(x.round()); break;
+    case Op::Frac: UNARY(x.frac()); break;
+  }
+#undef UNARY
+#undef BINARY
+#undef TERNARY
+}
+
+static void elementwise_program_kernel(
+    TensorIterator& iter,
+    const ElementwiseProgram& program,
+    const std::vector<double>& scalars) {
+  const int noutputs = iter.noutputs();
+  const int ninputs = program.num_inputs;
+  const int nregs = program.num_registers;
+  AT_DISPATCH_FLOATING_TYPES(iter.dtype(), "elementwise_program_cpu", [&] {
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      // Every register gets a tile; input registers only use theirs when the
+      // input has to be gathered.
+      scalar_t* storage = thread_buffer<scalar_t>(nregs * kTileSize);
+      scalar_t** regs = thread_buffer<scalar_t*>(nregs);
+      for (int64_t begin = 0; begin < n; begin += kTileSize) {
+        int64_t size = std::min(kTileSize, n - begin);
+        for (int r = 0; r < nregs; r++) {
+          regs[r] = storage + r * kTileSize;
+        }
+        for (int i = 0; i < ninputs; i++) {
+          int arg = noutputs + i;
+          regs[i] = load_tile<scalar_t>(
+              data[arg] + begin * strides[arg], strides[arg], size, regs[i]);
+        }
+        for (const auto& instr : program.instrs) {
+          run_instr<scalar_t>(instr, regs, scalars, size);
+        }
+        for (int o = 0; o < noutputs; o++) {
+          const scalar_t* src = regs[program.outputs[o]];
+          char* dst = data[o] + begin * strides[o];
+          if (strides[o] == sizeof(scalar_t)) {
+            std::memcpy(dst, src, size * sizeof(scalar_t));
+          } else {
+            for (int64_t i = 0; i < size; i++) {
+              *reinterpret_cast<scalar_t*>(dst + i * strides[o]) = src[i];
+            }
+          }
+        }
+      }
+    });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(elementwise_program_stub, &elementwise_program_kernel);
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,158 @@
+// Fused chains of elementwise operations
+#include <ATen/ATen.h>
+
+#include <ATen/Dispatch.h>
+#include <ATen/cpu/vec256/functional.h>
+#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/native/PointwiseChain.h>
+#include <ATen/native/TensorIterator.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace at {
+namespace native {
+namespace {
+
+using namespace vec256;
+using Op = PointwiseStep::Op;
+
+// Number of elements processed by every op of the chain before moving on to
+// the next tile. Two tiles of doubles fit comfortably in L1.
+constexpr int64_t kTileSize = 512;
+
+// Returns a pointer to `size` contiguous elements of an operand starting at
+// `ptr`, gathering them into `buffer` if the operand is not contiguous.
+template <typename scalar_t>
+scalar_t* load_tile(char* ptr, int64_t stride, int64_t size, scalar_t* buffer) {
+  if (stride == sizeof(scalar_t)) {
+    return reinterpret_cast<scalar_t*>(ptr);
+  }
+  if (stride == 0) {
+    std::fill(buffer, buffer + size, *reinterpret_cast<scalar_t*>(ptr));
+  } else {
+    for (int64_t i = 0; i < size; i++) {
+      buffer[i] = *reinterpret_cast<scalar_t*>(ptr + i * stride);
+    }
+  }
+  return buffer;
+}
+
+template <typename scalar_t>
+void apply_step(
+    const PointwiseStep& step,
+    scalar_t* acc,
+    scalar_t* other,
+    int64_t size) {
+  using Vec = Vec256<scalar_t>;
+  Vec alpha(static_cast<scalar_t>(step.alpha));
+  Vec beta(static_cast<scalar_t>(step.beta));
+  Vec zero(static_cast<scalar_t>(0));
+  Vec one(static_cast<scalar_t>(1));
+  if (step.operand >= 0) {
+    switch (step.op) {
+      case Op::Add:
+        vec256::map2(
+            [=](Vec a, Vec b) { return vec256::fmadd(b, alpha, a); },
+            acc, acc, other, size);
+        break;
+      case Op::Sub:
+        vec256::map2([=](Vec a, Vec b) { return a - b * alpha; },
+            acc, acc, other, size);
+        break;
+      case Op::Mul:
+        vec256::map2([](Vec a, Vec b) { return a * b; },
+            acc, acc, other, size);
+        break;
+      case Op::Div:
+        vec256::map2([](Vec a, Vec b) { return a / b; },
+            acc, acc, other, size);
+        break;
+      default:
+        TORCH_INTERNAL_ASSERT(false, "PointwiseChain: op takes no operand");
+    }
+    return;
+  }
+  switch (step.op) {
+    case Op::Add:
+      vec256::map([=](Vec a) { return a + alpha; }, acc, acc, size);
+      break;
+    case Op::Sub:
+      vec256::map([=](Vec a) { return a - alpha; }, acc, acc, size);
+      break;
+    case Op::Mul:
+      vec256::map([=](Vec a) { return a * alpha; }, acc, acc, size);
+      break;
+    case Op::Div:
+      vec256::map([=](Vec a) { return a / alpha; }, acc, acc, size);
+      break;
+    case Op::Neg:
+      vec256::map([](Vec a) { return a.neg(); }, acc, acc, size);
+      break;
+    case Op::Relu:
+      vec256::map([=](Vec a) { return vec256::clamp_min(a, zero); },
+          acc, acc, size);
+      break;
+    case Op::Sigmoid:
+      vec256::map([=](Vec a) { return (one + a.neg().exp()).reciprocal(); },
+          acc, acc, size);
+      break;
+    case Op::Tanh:
+      vec256::map([](Vec a) { return a.tanh(); }, acc, acc, size);
+      break;
+    case Op::Exp:
+      vec256::map([](Vec a) { return a.exp(); }, acc, acc, size);
+      break;
+    case Op::Log:
+      vec256::map([](Vec a) { return a.log(); }, acc, acc, size);
+      break;
+    case Op::Clamp:
+      vec256::map([=](Vec a) { return vec256::clamp(a, alpha, beta); },
+          acc, acc, size);
+      break;
+  }
+}
+
+static void pointwise_chain_kernel(
+    TensorIterator& iter,
+    const std::vector<PointwiseStep>& steps) {
+  AT_DISPATCH_FLOATING_TYPES(iter.dtype(), "pointwise_chain_cpu", [&] {
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      // operand 0 is the output, 1 the source and 2.. the step operands
+      scalar_t acc[kTileSize];
+      scalar_t buffer[kTileSize];
+      for (int64_t begin = 0; begin < n; begin += kTileSize) {
+        int64_t size = std::min(kTileSize, n - begin);
+        scalar_t* src = load_tile<scalar_t>(
+            data[1] + begin * strides[1], strides[1], size, acc);
+        if (src != acc) {
+          std::memcpy(acc, src, size * sizeof(scalar_t));
+        }
+        for (const auto& step : steps) {
+          scalar_t* other = nullptr;
+          if (step.operand >= 0) {
+            int arg = step.operand + 1;
+            other = load_tile<scalar_t>(
+                data[arg] + begin * strides[arg], strides[arg], size, buffer);
+          }
+          apply_step<scalar_t>(step, acc, other, size);
+        }
+        char* out = data[0] + begin * strides[0];
+        if (strides[0] == sizeof(scalar_t)) {
+          std::memcpy(out, acc, size * sizeof(scalar_t));
+        } else {
+          for (int64_t i = 0; i < size; i++) {
+            *reinterpret_cast<scalar_t*>(out + i * strides[0]) = acc[i];
+          }
+        }
+      }
+    });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(pointwise_chain_stub, &pointwise_chain_kernel);
+
+} // namespace native
+} // namespace at
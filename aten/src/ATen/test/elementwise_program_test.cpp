@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <ATen/ATen.h>
+#include <ATen/native/ElementwiseProgram.h>
+#include <ATen/native/TensorIterator.h>
+
+using namespace at;
+using at::native::ElementwiseInstr;
+using at::native::ElementwiseProgram;
+using Op = ElementwiseInstr::Op;
+
+static void run(
+    const ElementwiseProgram& program,
+    std::vector<Tensor> outputs,
+    std::vector<Tensor> inputs,
+    const std::vector<double>& scalars = {}) {
+  auto iter = at::TensorIterator();
+  for (auto& output : outputs) {
+    iter.add_output(output);
+  }
+  for (auto& input : inputs) {
+    iter.add_input(input);
+  }
+  iter.build();
+  at::native::run_elementwise_program(iter, program, scalars);
+}
+
+TEST(ElementwiseProgramTest, LSTMCell) {
+  // hy = sigmoid(o) * tanh(cy), cy = sigmoid(f) * cx + sigmoid(i) * tanh(g)
+  ElementwiseProgram program;
+  program.num_inputs = 5; // i, f, g, o, cx
+  program.num_registers = 9;
+  program.instrs = {
+      {Op::Sigmoid, 5, 0, -1, -1, 0.},
+      {Op::Sigmoid, 6, 1, -1, -1, 0.},
+      {Op::Tanh, 7, 2, -1, -1, 0.},
+      {Op::Mul, 5, 5, 7, -1, 0.},
+      {Op::Mul, 6, 6, 4, -1, 0.},
+      {Op::Add, 7, 6, 5, -1, 1.},
+      {Op::Tanh, 8, 7, -1, -1, 0.},
+      {Op::Sigmoid, 6, 3, -1, -1, 0.},
+      {Op::Mul, 8, 6, 8, -1, 0.},
+  };
+  program.outputs = {8, 7};
+  program.validate();
+
+  for (auto dtype : {kFloat, kDouble}) {
+    // large enough to span several tiles and a vectorization tail
+    std::vector<Tensor> inputs;
+    for (int i = 0; i < 5; i++) {
+      inputs.push_back(at::randn({37, 129}, dtype));
+    }
+    // non-contiguous and broadcast operands
+    inputs[1] = at::randn({129, 37}, dtype).t();
+    inputs[4] = at::randn({129}, dtype);
+    auto cy = inputs[1].sigmoid() * inputs[4] +
+        inputs[0].sigmoid() * inputs[2].tanh();
+    auto hy = inputs[3].sigmoid() * cy.tanh();
+
+    auto hy_out = at::empty({37, 129}, dtype);
+    auto cy_out = at::empty({37, 129}, dtype);
+    run(program, {hy_out, cy_out}, inputs);
+    ASSERT_TRUE(hy_out.allclose(hy, 1e-5, 1e-6));
+    ASSERT_TRUE(cy_out.allclose(cy, 1e-5, 1e-6));
+  }
+}
+
+TEST(ElementwiseProgramTest, ConstantsAndScalars) {
+  // clamp(x * s0 - 2, -1, 1), threshold(x, 0.5, 3)
+  ElementwiseProgram program;
+  program.num_inputs = 1;
+  program.num_registers = 5;
+  program.instrs = {
+      {Op::Scalar, 1, 0, -1, -1, 0.},
+      {Op::Mul, 1, 0, 1, -1, 0.},
+      {Op::Constant, 2, -1, -1, -1, 2.},
+      {Op::Sub, 1, 1, 2, -1, 1.},
+      {Op::Constant, 2, -1, -1, -1, -1.},
+      {Op::Constant, 3, -1, -1, -1, 1.},
+      {Op::Clamp, 1, 1, 2, 3, 0.},
+      {Op::Constant, 2, -1, -1, -1, 0.5},
+      {Op::Constant, 3, -1, -1, -1, 3.},
+      {Op::Threshold, 4, 0, 2, 3, 0.},
+  };
+  program.outputs = {1, 4};
+  program.validate();
+
+  auto x = at::rand({1000}, kDouble);
+  auto out0 = at::empty({1000}, kDouble);
+  auto out1 = at::empty({1000}, kDouble);
+  run(program, {out0, out1}, {x}, {4.});
+  ASSERT_TRUE(out0.allclose(x.mul(4).sub(2).clamp(-1, 1)));
+  ASSERT_TRUE(out1.allclose(at::threshold(x, 0.5, 3)));
+}
+
+TEST(ElementwiseProgramTest, Validate) {
+  ElementwiseProgram program;
+  program.num_inputs = 1;
+  program.num_registers = 2;
+  // reads a register that is never written
+  program.instrs = {{Op::Exp, 1, 1, -1, -1, 0.}};
+  program.outputs = {1};
+  ASSERT_ANY_THROW(program.validate());
+
+  // writes an input register
+  program.instrs = {{Op::Exp, 0, 0, -1, -1, 0.}};
+  program.outputs = {0};
+  ASSERT_ANY_THROW(program.validate());
+
+  program.instrs = {{Op::Exp, 1, 0, -1, -1, 0.}};
+  program.outputs = {1};
+  program.validate();
+
+  // missing scalar
+  program.instrs = {{Op::Scalar, 1, 0, -1, -1, 0.}};
+  auto x = at::randn({10});
+  auto out = at::empty({10});
+  ASSERT_ANY_THROW(run(program, {out}, {x}));
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <c10/util/numa.h>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+C10_DECLARE_bool(caffe2_cpu_numa_enabled);
+
+// The intra-op pools are created once per process, so NUMA mode is enabled
+// before any parallel work in this file.
+#if AT_PARALLEL_NATIVE
+
+using namespace at;
+
+namespace {
+
+const int kNumThreads = 8;
+
+struct ParallelNUMATest : public ::testing::Test {
+  static void SetUpTestCase() {
+    FLAGS_caffe2_cpu_numa_enabled = true;
+    set_num_threads(kNumThreads);
+  }
+};
+
+// Runs a parallel_for with one chunk per thread and records the NUMA node
+// and thread each chunk ran on.
+void runChunks(
+    std::vector<int>& nodes,
+    std::vector<std::thread::id>& threads) {
+  nodes.assign(kNumThreads, -2);
+  threads.assign(kNumThreads, std::thread::id());
+  std::mutex mutex;
+  parallel_for(0, kNumThreads, 1, [&](int64_t begin, int64_t end) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int64_t i = begin; i < end; i++) {
+      nodes[i] = c10::GetCurrentNUMANode();
+      threads[i] = std::this_thread::get_id();
+    }
+  });
+}
+
+} // namespace
+
+TEST_F(ParallelNUMATest, TaskToNodeMapping) {
+  const int num_nodes = c10::GetNumNUMANodes();
+  if (num_nodes < 2) {
+    return; // needs a host with several NUMA nodes
+  }
+  std::vector<int> nodes;
+  std::vector<std::thread::id> threads;
+  runChunks(nodes, threads);
+  int previous = 0;
+  for (int task_id = 0; task_id < kNumThreads; task_id++) {
+    const int node = internal::_intraop_task_node(task_id, kNumThreads);
+    // Consecutive chunks belong to the same node, in order of the nodes
+    ASSERT_GE(node, previous);
+    previous = node;
+    // Including the first chunk, which doesn't run on the master thread
+    ASSERT_EQ(nodes[task_id], node);
+    ASSERT_NE(threads[task_id], std::this_thread::get_id());
+  }
+  ASSERT_EQ(internal::_intraop_task_node(0, kNumThreads), 0);
+  ASSERT_EQ(
+      internal::_intraop_task_node(kNumThreads - 1, kNumThreads),
+      num_nodes - 1);
+}
+
+TEST_F(ParallelNUMATest, SingleNodeFallback) {
+  if (c10::GetNumNUMANodes() >= 2) {
+    return; // covered by TaskToNodeMapping
+  }
+  std::vector<int> nodes;
+  std::vector<std::thread::id> threads;
+  runChunks(nodes, threads);
+  for (int task_id = 0; task_id < kNumThreads; task_id++) {
+    ASSERT_EQ(internal::_intraop_task_node(task_id, kNumThreads), -1);
+    ASSERT_NE(nodes[task_id], -2);
+  }
+  // Without nodes the master thread runs the first chunk itself
+  ASSERT_EQ(threads[0], std::this_thread::get_id());
+  ASSERT_EQ(get_num_threads(), kNumThreads);
+}
+
+#endif // AT_PARALLEL_NATIVE
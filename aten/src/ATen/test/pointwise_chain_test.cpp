@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <ATen/ATen.h>
+#include <ATen/native/PointwiseChain.h>
+
+using namespace at;
+using at::native::PointwiseChain;
+
+TEST(PointwiseChainTest, MatchesUnfusedOps) {
+  for (auto dtype : {kFloat, kDouble}) {
+    // large enough to span several tiles and a vectorization tail
+    auto x = at::randn({37, 129}, dtype);
+    auto a = at::randn({37, 129}, dtype);
+    auto b = at::randn({129}, dtype);
+    auto expected = x.mul(a).add(b, 0.5).sigmoid();
+    auto result = PointwiseChain(x).mul(a).add(b, 0.5).sigmoid().run();
+    ASSERT_TRUE(result.allclose(expected, 1e-5, 1e-6));
+  }
+}
+
+TEST(PointwiseChainTest, ScalarsAndUnaryOps) {
+  auto x = at::rand({1000}, kDouble).add(0.1);
+  auto expected = x.mul(3).sub(1).relu().add(1).log().exp().tanh().neg()
+                      .clamp(-0.5, 0.5).div(2);
+  auto result = PointwiseChain(x)
+                    .mul(3)
+                    .sub(1)
+                    .relu()
+                    .add(1)
+                    .log()
+                    .exp()
+                    .tanh()
+                    .neg()
+                    .clamp(-0.5, 0.5)
+                    .div(2)
+                    .run();
+  ASSERT_TRUE(result.allclose(expected));
+}
+
+TEST(PointwiseChainTest, NonContiguousOperands) {
+  auto x = at::randn({64, 48}).t();
+  auto a = at::randn({48, 64});
+  auto b = at::randn({48, 1});
+  auto expected = x.div(a.abs().add(1)).sub(b);
+  auto result = PointwiseChain(x).div(a.abs().add(1)).sub(b).run();
+  ASSERT_TRUE(result.allclose(expected));
+}
+
+TEST(PointwiseChainTest, InPlaceAndOut) {
+  auto x = at::randn({10, 10});
+  auto y = at::randn({10, 10});
+  auto expected = x.add(y).relu();
+
+  auto out = at::empty({0});
+  PointwiseChain(x).add(y).relu().run_out(out);
+  ASSERT_TRUE(out.allclose(expected));
+
+  auto x_clone = x.clone();
+  PointwiseChain(x_clone).add(y).relu().run_();
+  ASSERT_TRUE(x_clone.allclose(expected));
+}
+
+TEST(PointwiseChainTest, DtypeMismatch) {
+  auto x = at::randn({4});
+  auto y = at::randn({4}, kDouble);
+  ASSERT_ANY_THROW(PointwiseChain(x).add(y));
+  ASSERT_ANY_THROW(PointwiseChain(at::ones({4}, kLong)));
+  ASSERT_ANY_THROW(PointwiseChain(at::empty({4}, kHalf)));
+  ASSERT_ANY_THROW(PointwiseChain(at::empty({4}, kBFloat16)));
+}
@@ -105,3 +105,86 @@ TEST(TensorIteratorTest, SerialLoopSingleThread) {
   });
 }
 
+TEST(TensorIteratorTest, PlanCacheHit) {
+  TensorIterator::clear_plan_cache();
+  TensorIterator::reset_plan_cache_stats();
+  auto x = at::randn({4, 3}, kCPU).t();
+  auto y = at::randn({3, 4}, kCPU);
+  Tensor first;
+  for (int i = 0; i < 3; i++) {
+    Tensor out;
+    auto iter = TensorIterator::binary_op(out, x, y);
+    ASSERT_EQ(iter.ndim(), 2);
+    // the output gets the same layout whether or not the plan came from the
+    // cache
+    auto result = iter.output();
+    ASSERT_TRUE(result.sizes().equals({3, 4}));
+    if (i == 0) {
+      first = result;
+    } else {
+      ASSERT_TRUE(result.strides().equals(first.strides()));
+    }
+  }
+  auto stats = TensorIterator::plan_cache_stats();
+  ASSERT_EQ(stats.misses, 1);
+  ASSERT_EQ(stats.hits, 2);
+
+  // different strides, different plan
+  Tensor out;
+  TensorIterator::binary_op(out, x.contiguous(), y);
+  ASSERT_EQ(TensorIterator::plan_cache_stats().misses, 2);
+}
+
+TEST(TensorIteratorTest, PlanCacheResult) {
+  TensorIterator::clear_plan_cache();
+  auto x = at::randn({8, 1, 5}, kCPU);
+  auto y = at::randn({6, 5}, kCPU);
+  auto expected = at::add(x, y);
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(at::add(x, y).equal(expected));
+  }
+  auto out = at::empty({8, 6, 5}, kCPU);
+  at::add_out(out, x, y);
+  ASSERT_TRUE(out.equal(expected));
+}
+
+TEST(TensorIteratorTest, PlanCacheSkipsConversions) {
+  TensorIterator::clear_plan_cache();
+  TensorIterator::reset_plan_cache_stats();
+  auto x = at::ones({5}, kCPU);
+  // the output has to be resized, so this iterator is never cached
+  for (int i = 0; i < 2; i++) {
+    auto out = at::empty({0}, kCPU);
+    auto iter = TensorIterator::unary_op(out, x);
+    ASSERT_TRUE(out.sizes().equals({5}));
+  }
+  ASSERT_EQ(TensorIterator::plan_cache_stats().hits, 0);
+
+  TensorIterator::set_plan_cache_enabled(false);
+  Tensor out;
+  TensorIterator::unary_op(out, x);
+  auto stats = TensorIterator::plan_cache_stats();
+  ASSERT_EQ(stats.hits, 0);
+  ASSERT_EQ(stats.misses, 2);
+  TensorIterator::set_plan_cache_enabled(true);
+}
+
+TEST(TensorIteratorTest, PlanCacheStatsAcrossThreads) {
+  TensorIterator::reset_plan_cache_stats();
+  auto x = at::randn({7, 2}, kCPU);
+  auto build = [&x]() {
+    for (int i = 0; i < 3; i++) {
+      Tensor out;
+      TensorIterator::unary_op(out, x);
+    }
+  };
+  // each thread has its own cache, and the counts of threads that have
+  // exited are kept
+  std::thread t1(build);
+  t1.join();
+  std::thread t2(build);
+  t2.join();
+  auto stats = TensorIterator::plan_cache_stats();
+  ASSERT_EQ(stats.misses, 2);
+  ASSERT_EQ(stats.hits, 4);
+}
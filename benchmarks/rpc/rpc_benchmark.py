@@ -0,0 +1,69 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+import argparse
+import os
+import time
+
+import torch
+import torch.distributed as dist
+import torch.multiprocessing as mp
+
+""" RPC throughput benchmark.
+Measures how many messages per second, and how many GB/s of tensor data,
+ProcessGroupAgent moves between two workers over loopback. worker0 sends
+torch.add calls on tensors of each size to worker1, which sends the result
+back, keeping --window calls in flight. Both directions are counted.
+Example run:
+python rpc_benchmark.py --sizes 1,1024,1048576 --iters 2000
+"""
+
+
+def bench(worker, numel, iters, window):
+    tensor = torch.ones(numel)
+    futures = []
+    start = time.time()
+    for _ in range(iters):
+        futures.append(
+            dist.rpc(worker, torch.add, args=(tensor, 1), async_call=True))
+        if len(futures) >= window:
+            futures.pop(0).wait()
+    for future in futures:
+        future.wait()
+    elapsed = time.time() - start
+    messages = 2 * iters
+    gb = messages * tensor.numel() * tensor.element_size() / 1e9
+    print("{:>10} floats: {:>10.0f} messages/s, {:>8.3f} GB/s".format(
+        numel, messages / elapsed, gb / elapsed))
+
+
+def run(rank, args):
+    os.environ["MASTER_ADDR"] = "127.0.0.1"
+    os.environ["MASTER_PORT"] = str(args.port)
+    dist.init_process_group(backend="gloo", rank=rank, world_size=2)
+    dist.init_model_parallel("worker{}".format(rank))
+    if rank == 0:
+        worker = dist.get_worker_id("worker1")
+        for numel in args.sizes:
+            # warm up
+            bench(worker, numel, min(args.iters, 100), args.window)
+            bench(worker, numel, args.iters, args.window)
+    dist.join_rpc()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RPC throughput benchmark")
+    parser.add_argument(
+        "--sizes", type=lambda s: [int(x) for x in s.split(",")],
+        default=[1, 1024, 1024 * 1024],
+        help="comma separated numbers of floats per tensor")
+    parser.add_argument("--iters", type=int, default=1000,
+                        help="number of calls per size")
+    parser.add_argument("--window", type=int, default=16,
+                        help="number of calls in flight")
+    parser.add_argument("--port", type=int, default=29500)
+    args = parser.parse_args()
+    mp.spawn(run, args=(args,), nprocs=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+
+#include "c10/util/Flags.h"
+#include "caffe2/core/init.h"
+#include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Measures the overhead of the autograd engine on backward passes over graphs
+// made of thousands of tiny nodes, where the cost of scheduling dominates the
+// cost of the nodes themselves. Optionally runs several backward passes
+// concurrently (as in Hogwild-style training) to expose contention in the
+// engine.
+
+C10_DEFINE_int(iter, 50, "Number of timed backward passes per thread");
+C10_DEFINE_int(nodes, 4000, "Number of nodes in each graph");
+C10_DEFINE_int(width, 16, "Number of branches of the wide graph");
+C10_DEFINE_int(threads, 1, "Number of threads running backward concurrently");
+C10_DEFINE_int(
+    cpu_backward_threads,
+    0,
+    "Size of the pool running CPU nodes in parallel (0 = off)");
+
+namespace {
+
+using torch::autograd::Variable;
+
+// y = x * c * c * ... : a single chain of nodes
+Variable make_chain(const Variable& x) {
+  Variable y = x;
+  for (int i = 0; i < FLAGS_nodes; ++i) {
+    y = y * 1.0001;
+  }
+  return y.sum();
+}
+
+// FLAGS_width independent chains that are summed at the end
+Variable make_wide(const Variable& x) {
+  int depth = std::max(1, FLAGS_nodes / FLAGS_width);
+  Variable total;
+  for (int b = 0; b < FLAGS_width; ++b) {
+    Variable y = x;
+    for (int i = 0; i < depth; ++i) {
+      y = y * 1.0001;
+    }
+    total = total.defined() ? total + y : y;
+  }
+  return total.sum();
+}
+
+template <typename F>
+double run_us(const F& make_graph) {
+  auto x = torch::autograd::make_variable(at::ones({1}), true);
+  // warm up
+  make_graph(x).backward(at::Tensor(), false, false);
+
+  double total_us = 0;
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    auto loss = make_graph(x);
+    auto start = std::chrono::steady_clock::now();
+    loss.backward(at::Tensor(), false, false);
+    auto end = std::chrono::steady_clock::now();
+    total_us += std::chrono::duration<double, std::micro>(end - start).count();
+  }
+  return total_us / FLAGS_iter;
+}
+
+template <typename F>
+void bench(const char* name, const F& make_graph) {
+  std::vector<double> us(FLAGS_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < FLAGS_threads; ++t) {
+    threads.emplace_back([&, t]() { us[t] = run_us(make_graph); });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  double avg = 0;
+  for (double u : us) {
+    avg += u / FLAGS_threads;
+  }
+  std::cout << name << ": " << avg << " us per backward, "
+            << avg * 1000 / FLAGS_nodes << " ns per node ("
+            << FLAGS_threads << " concurrent backward calls)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  caffe2::unsafeRunCaffe2InitFunction("registerThreadPools");
+  at::init_num_threads();
+  at::set_num_threads(1);
+  torch::autograd::Engine::get_default_engine().set_num_cpu_backward_threads(
+      FLAGS_cpu_backward_threads);
+
+  bench("chain", make_chain);
+  bench("wide", make_wide);
+  return 0;
+}
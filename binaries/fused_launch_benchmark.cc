@@ -0,0 +1,138 @@
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+
+#include "c10/util/Flags.h"
+#include "caffe2/core/init.h"
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/jit/fuser/interface.h"
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/irparser.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Measures the host-side overhead of launching fused CPU kernels on tiny
+// tensors, where the cost of finding the KernelSpec and the compiled kernel
+// dominates the cost of the kernel itself. Launches run on many threads at
+// once, as in a server running concurrent inference requests, to expose
+// contention in the fuser's caches. Also measures registering an already
+// registered fusion group, which looks the graph up in the KernelSpec cache.
+
+C10_DEFINE_int(iter, 100000, "Number of timed launches per thread");
+C10_DEFINE_int(threads, 32, "Number of threads launching kernels concurrently");
+C10_DEFINE_int(tensor_size, 4, "Number of elements of the tensor operands");
+C10_DEFINE_int(register_iter, 10000, "Number of timed re-registrations");
+
+namespace {
+
+using namespace torch::jit;
+
+// An LSTM-cell-like pointwise graph
+const char* kGraph = R"IR(
+graph(%i : Tensor,
+      %f : Tensor,
+      %g : Tensor,
+      %o : Tensor,
+      %cx : Tensor):
+  %one : int = prim::Constant[value=1]()
+  %ig : Tensor = aten::sigmoid(%i)
+  %fg : Tensor = aten::sigmoid(%f)
+  %cg : Tensor = aten::tanh(%g)
+  %og : Tensor = aten::sigmoid(%o)
+  %a : Tensor = aten::mul(%fg, %cx)
+  %b : Tensor = aten::mul(%ig, %cg)
+  %cy : Tensor = aten::add(%a, %b, %one)
+  %t : Tensor = aten::tanh(%cy)
+  %hy : Tensor = aten::mul(%og, %t)
+  return (%hy, %cy))IR";
+
+// Wraps the graph in a fusion group, as debugLaunchGraph does
+Node* makeFusionGroup(Graph& wrapper, const std::shared_ptr<Graph>& graph) {
+  Node* fusion_group =
+      wrapper.insertNode(wrapper.createWithSubgraph(prim::FusionGroup));
+  fusion_group->g_(attr::Subgraph, graph->copy());
+  for (size_t i = 0; i < graph->inputs().size(); ++i) {
+    fusion_group->addInput(wrapper.addInput());
+  }
+  for (size_t i = 0; i < graph->outputs().size(); ++i) {
+    wrapper.registerOutput(fusion_group->addOutput());
+  }
+  return fusion_group;
+}
+
+double launch_ns(int64_t key) {
+  std::vector<IValue> inputs;
+  for (int i = 0; i < 5; ++i) {
+    inputs.emplace_back(at::randn({FLAGS_tensor_size}));
+  }
+  Stack stack;
+  auto run = [&] {
+    stack.assign(inputs.begin(), inputs.end());
+    runFusion(key, stack);
+  };
+  // warm up, compiling the kernel on the first thread to get there
+  run();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    run();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+      FLAGS_iter;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  caffe2::unsafeRunCaffe2InitFunction("registerThreadPools");
+  at::init_num_threads();
+  at::set_num_threads(1);
+  at::NoGradGuard no_grad;
+  overrideCanFuseOnCPU(true);
+
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(kGraph, graph.get());
+  Graph wrapper;
+  Node* fusion_group = makeFusionGroup(wrapper, graph);
+  const int64_t key = registerFusion(fusion_group);
+
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FLAGS_register_iter; ++i) {
+      registerFusion(fusion_group);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+    std::cout << "register (cache hit): " << us / FLAGS_register_iter
+              << " us" << std::endl;
+  }
+
+  for (int threads : {1, FLAGS_threads}) {
+    std::vector<double> ns(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t]() {
+        at::NoGradGuard no_grad;
+        ns[t] = launch_ns(key);
+      });
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+    double avg = 0;
+    for (double n : ns) {
+      avg += n / threads;
+    }
+    std::cout << "launch: " << avg << " ns per launch (" << threads
+              << " concurrent threads)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+
+#include "c10/util/Flags.h"
+#include "caffe2/core/init.h"
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/irparser.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Measures the dispatch overhead of the TorchScript interpreter on loops made
+// of many cheap nodes, with and without superinstructions (see
+// torch::jit::getInterpreterSuperinstructions). Reports the time per loop
+// iteration and per node of the loop body.
+
+C10_DEFINE_int(iter, 20, "Number of timed runs of each graph");
+C10_DEFINE_int(trip_count, 100000, "Number of loop iterations per run");
+C10_DEFINE_int(tensor_size, 4, "Number of elements of the tensor operands");
+
+namespace {
+
+// Scalar loop: index arithmetic and comparisons only.
+const char* kIntGraph = R"IR(
+graph(%n : int):
+  %true : bool = prim::Constant[value=1]()
+  %zero : int = prim::Constant[value=0]()
+  %two : int = prim::Constant[value=2]()
+  %three : int = prim::Constant[value=3]()
+  %acc : int = prim::Loop(%n, %true, %zero)
+    block0(%i : int, %acc.1 : int):
+      %a : int = aten::mul(%i, %two)
+      %b : int = aten::add(%a, %acc.1)
+      %c : int = aten::sub(%b, %i)
+      %d : int = aten::mul(%c, %three)
+      %e : int = aten::sub(%d, %c)
+      %f : int = aten::sub(%e, %b)
+      %cond : bool = aten::lt(%i, %n)
+      -> (%cond, %f)
+  return (%acc)
+)IR";
+constexpr int kIntGraphNodes = 7;
+
+// Small-tensor loop, dominated by per-op overhead rather than compute.
+const char* kTensorGraph = R"IR(
+graph(%x : Tensor, %w : Tensor, %n : int):
+  %true : bool = prim::Constant[value=1]()
+  %one : int = prim::Constant[value=1]()
+  %h : Tensor = prim::Loop(%n, %true, %x)
+    block0(%i : int, %h.1 : Tensor):
+      %a : Tensor = aten::mul(%h.1, %w)
+      %b : Tensor = aten::add(%a, %x, %one)
+      %c : Tensor = aten::tanh(%b)
+      %d : Tensor = aten::mul(%c, %a)
+      %e : Tensor = aten::sub(%d, %c, %one)
+      -> (%true, %e)
+  return (%h)
+)IR";
+constexpr int kTensorGraphNodes = 5;
+
+double run_ns(
+    const std::shared_ptr<torch::jit::Graph>& graph,
+    const torch::jit::Stack& inputs) {
+  torch::jit::Code code(graph);
+  // warm up
+  {
+    torch::jit::Stack stack = inputs;
+    torch::jit::InterpreterState(code).run(stack);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    torch::jit::Stack stack = inputs;
+    torch::jit::InterpreterState(code).run(stack);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+      FLAGS_iter;
+}
+
+void bench(
+    const std::string& name,
+    const char* ir,
+    int body_nodes,
+    const torch::jit::Stack& inputs) {
+  auto graph = std::make_shared<torch::jit::Graph>();
+  torch::jit::script::parseIR(ir, graph.get());
+
+  double ns[2];
+  for (bool enabled : {false, true}) {
+    torch::jit::getInterpreterSuperinstructions() = enabled;
+    ns[enabled] = run_ns(graph, inputs) / FLAGS_trip_count;
+  }
+  std::cout << name << ": baseline " << ns[0] << " ns/iter ("
+            << ns[0] / body_nodes << " ns/node), superinstructions " << ns[1]
+            << " ns/iter (" << ns[1] / body_nodes << " ns/node), speedup "
+            << ns[0] / ns[1] << "x" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  caffe2::unsafeRunCaffe2InitFunction("registerThreadPools");
+  at::init_num_threads();
+  at::set_num_threads(1);
+  torch::autograd::AutoGradMode no_grad(false);
+
+  bench("int loop", kIntGraph, kIntGraphNodes, {FLAGS_trip_count});
+  auto x = at::rand({FLAGS_tensor_size});
+  auto w = at::rand({FLAGS_tensor_size});
+  bench(
+      "tensor loop", kTensorGraph, kTensorGraphNodes, {x, w, FLAGS_trip_count});
+  return 0;
+}
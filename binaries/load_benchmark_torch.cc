@@ -0,0 +1,132 @@
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+
+#include "c10/util/Flags.h"
+#include "caffe2/core/init.h"
+#include "caffe2/serialize/mmap_file_adapter.h"
+#include "torch/csrc/autograd/variable.h"
+#include "torch/csrc/jit/export.h"
+#include "torch/csrc/jit/import.h"
+#include "torch/csrc/jit/script/module.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Measures how fast torch::jit::load reads the tensors of a module, with one
+// and with all intra-op threads extracting records, and through a memory
+// mapping, from a file saved as is and from one saved with compressed
+// tensors. Throughput is reported both in bytes of tensor data and in bytes
+// of the file. The files are read once before timing, so this measures
+// loading from the page cache rather than from disk.
+
+C10_DEFINE_string(model, "", "Module to load; a generated one if empty");
+C10_DEFINE_bool(
+    round_weights,
+    true,
+    "Round generated weights to a few bits of mantissa, like quantized and "
+    "pruned weights, which makes them compressible");
+C10_DEFINE_int(num_tensors, 64, "Number of parameters of the generated module");
+C10_DEFINE_int(tensor_mb, 16, "Size in MB of each generated parameter");
+C10_DEFINE_int(iter, 5, "Number of timed loads of each configuration");
+
+namespace {
+
+size_t module_bytes(const torch::jit::script::Module& module) {
+  size_t bytes = 0;
+  for (const auto& param : module.get_parameters()) {
+    bytes += param.value().toTensor().nbytes();
+  }
+  for (const auto& attr : module.get_attributes()) {
+    if (attr.value().isTensor()) {
+      bytes += attr.value().toTensor().nbytes();
+    }
+  }
+  for (const auto& submodule : module.get_modules()) {
+    bytes += module_bytes(submodule);
+  }
+  return bytes;
+}
+
+size_t file_bytes(const std::string& path) {
+  std::ifstream file(path, std::ifstream::binary | std::ifstream::ate);
+  return file.tellg();
+}
+
+template <typename Load>
+void bench(const std::string& name, const std::string& path, Load load) {
+  // warm up, which also brings the file into the page cache
+  size_t bytes = module_bytes(load(path));
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iter; ++i) {
+    load(path);
+  }
+  auto end = std::chrono::steady_clock::now();
+  double seconds =
+      std::chrono::duration<double>(end - start).count() / FLAGS_iter;
+  std::cout << name << ": " << seconds * 1e3 << " ms/load, "
+            << bytes / seconds / 1e9 << " GB/s of tensors, "
+            << file_bytes(path) / seconds / 1e9 << " GB/s of file"
+            << std::endl;
+}
+
+void bench_file(const std::string& name, const std::string& path) {
+  const int num_threads = at::get_num_threads();
+  for (int threads : {1, num_threads}) {
+    at::set_num_threads(threads);
+    bench(
+        name + ", " + std::to_string(threads) + " thread(s)",
+        path,
+        [](const std::string& path) { return torch::jit::load(path); });
+  }
+  bench(name + ", mmap", path, [](const std::string& path) {
+    return torch::jit::load(
+        caffe2::make_unique<caffe2::serialize::MmapFileAdapter>(path));
+  });
+  at::set_num_threads(num_threads);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  caffe2::unsafeRunCaffe2InitFunction("registerThreadPools");
+  at::init_num_threads();
+
+  torch::jit::script::Module module;
+  if (FLAGS_model.empty()) {
+    module = torch::jit::script::Module(c10::QualifiedName("m"));
+    for (int i = 0; i < FLAGS_num_tensors; ++i) {
+      auto weight = at::randn({FLAGS_tensor_mb * (1 << 20) / 4});
+      if (FLAGS_round_weights) {
+        weight = (weight * 16).round() / 16;
+      }
+      module.register_parameter(
+          "p" + std::to_string(i),
+          torch::autograd::make_variable(weight, /*requires_grad=*/false),
+          /*is_buffer=*/false);
+    }
+  } else {
+    module = torch::jit::load(FLAGS_model);
+  }
+
+  const std::string path = "load_benchmark_model.pt";
+  const std::string compressed_path = "load_benchmark_model_compressed.pt";
+  module.save(path);
+  torch::jit::SetExportModuleTensorCompression(true);
+  module.save(compressed_path);
+  torch::jit::SetExportModuleTensorCompression(false);
+
+  bench_file("uncompressed", path);
+  bench_file("compressed", compressed_path);
+
+  std::remove(path.c_str());
+  std::remove(compressed_path.c_str());
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+
+#include "c10/util/Flags.h"
+#include "caffe2/core/init.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Measures the latency distribution of at::parallel_for over loops whose
+// iterations have very different costs (e.g. embedding bags with skewed bag
+// sizes). Build with different ATEN_THREADING values to compare backends.
+
+C10_DEFINE_int(iter, 1000, "Number of parallel_for calls");
+C10_DEFINE_int(warmup_iter, 50, "Number of warmup calls");
+C10_DEFINE_int(intra_op_threads, 0, "Number of intra-op threads");
+C10_DEFINE_int(range, 4096, "Number of iterations per parallel_for");
+C10_DEFINE_int(grain_size, 1, "Grain size passed to parallel_for");
+C10_DEFINE_int(base_work, 200, "Work units of the cheapest iteration");
+C10_DEFINE_string(
+    workload,
+    "zipf",
+    "Cost distribution of iterations: uniform, zipf or straggler");
+
+namespace {
+
+std::vector<int64_t> make_costs() {
+  std::vector<int64_t> costs(FLAGS_range, FLAGS_base_work);
+  std::mt19937 gen(42);
+  if (FLAGS_workload == "zipf") {
+    // cost of iteration i ~ 1 / rank, shuffled over the range
+    for (int64_t i = 0; i < FLAGS_range; ++i) {
+      costs[i] =
+          FLAGS_base_work * FLAGS_range / (4 * (i + 1)) + FLAGS_base_work;
+    }
+    std::shuffle(costs.begin(), costs.end(), gen);
+  } else if (FLAGS_workload == "straggler") {
+    // one contiguous block of iterations is 100x more expensive
+    int64_t block = std::max<int64_t>(FLAGS_range / 64, 1);
+    int64_t start = FLAGS_range / 3;
+    int64_t stop = std::min<int64_t>(start + block, FLAGS_range);
+    for (int64_t i = start; i < stop; ++i) {
+      costs[i] *= 100;
+    }
+  } else {
+    TORCH_CHECK(
+        FLAGS_workload == "uniform", "Unknown workload ", FLAGS_workload);
+  }
+  return costs;
+}
+
+// keeps the compiler from optimizing the work away
+std::atomic<int64_t> checksum{0};
+
+double work(int64_t units) {
+  double acc = 0;
+  for (int64_t k = 0; k < units; ++k) {
+    acc += std::sqrt(static_cast<double>(k) + acc);
+  }
+  return acc;
+}
+
+double run_once(const std::vector<int64_t>& costs) {
+  typedef std::chrono::high_resolution_clock clock;
+  auto start = clock::now();
+  at::parallel_for(0, FLAGS_range, FLAGS_grain_size,
+      [&costs](int64_t begin, int64_t end) {
+    double acc = 0;
+    for (auto i = begin; i < end; ++i) {
+      acc += work(costs[i]);
+    }
+    checksum += static_cast<int64_t>(acc) & 1;
+  });
+  return std::chrono::duration<double, std::micro>(clock::now() - start)
+      .count();
+}
+
+double percentile(std::vector<double>& sorted, double p) {
+  size_t idx = std::min(
+      sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()));
+  return sorted[idx];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  caffe2::unsafeRunCaffe2InitFunction("registerThreadPools");
+  at::init_num_threads();
+
+  if (FLAGS_intra_op_threads > 0) {
+    at::set_num_threads(FLAGS_intra_op_threads);
+  }
+
+  std::cout << at::get_parallel_info() << std::endl;
+
+  auto costs = make_costs();
+  for (auto i = 0; i < FLAGS_warmup_iter; ++i) {
+    run_once(costs);
+  }
+
+  std::vector<double> latencies;
+  latencies.reserve(FLAGS_iter);
+  for (auto i = 0; i < FLAGS_iter; ++i) {
+    latencies.push_back(run_once(costs));
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  double total = 0;
+  for (auto l : latencies) {
+    total += l;
+  }
+  std::cout << "Workload: " << FLAGS_workload << ", range " << FLAGS_range
+            << ", " << at::get_num_threads() << " threads" << std::endl;
+  std::cout << "Latency (us): mean " << total / latencies.size()
+            << ", p50 " << percentile(latencies, 50)
+            << ", p90 " << percentile(latencies, 90)
+            << ", p99 " << percentile(latencies, 99)
+            << ", max " << latencies.back() << std::endl;
+  std::cout << "Checksum: " << checksum.load() << std::endl;
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/TensorIterator.h"
+
+#include "c10/util/Flags.h"
+#include "caffe2/core/init.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+C10_DEFINE_int(iter, 10e4, "Number of small ops run by each thread");
+C10_DEFINE_int(warmup_iter, 100, "Number of warmup ops run by each thread");
+C10_DEFINE_int(threads, 1, "Number of threads running ops concurrently");
+C10_DEFINE_int(numel, 64, "Number of elements of the operands");
+C10_DEFINE_int(benchmark_iter, 3, "Number of times to run benchmark")
+
+namespace {
+
+// Runs FLAGS_iter broadcasting adds of small tensors on each thread, which
+// is dominated by TensorIterator::build() rather than by the kernel.
+void run_ops(int iter) {
+  auto x = at::randn({FLAGS_numel / 4, 4});
+  auto y = at::randn({4});
+  auto out = at::empty({FLAGS_numel / 4, 4});
+  for (auto i = 0; i < iter; ++i) {
+    at::add_out(out, x, y);
+  }
+}
+
+void run_threads(int iter) {
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < FLAGS_threads; ++i) {
+    threads.emplace_back([iter]() { run_ops(iter); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+  caffe2::unsafeRunCaffe2InitFunction("registerThreadPools");
+  at::init_num_threads();
+  // keep the ops themselves single threaded
+  at::set_num_threads(1);
+
+  typedef std::chrono::high_resolution_clock clock;
+  typedef std::chrono::nanoseconds ns;
+
+  for (bool enabled : {false, true}) {
+    at::TensorIterator::set_plan_cache_enabled(enabled);
+    run_threads(FLAGS_warmup_iter);
+    at::TensorIterator::reset_plan_cache_stats();
+
+    std::cout << "Running " << FLAGS_iter << " ops of " << FLAGS_numel
+              << " elements on each of " << FLAGS_threads << " threads, plan "
+              << "cache " << (enabled ? "enabled" : "disabled") << std::endl;
+    for (auto bench_iter = 0; bench_iter < FLAGS_benchmark_iter; ++bench_iter) {
+      auto start_time = clock::now();
+      run_threads(FLAGS_iter);
+      auto duration = static_cast<float>(
+          std::chrono::duration_cast<ns>(clock::now() - start_time).count());
+      std::cout << "Time per op: " << (duration / FLAGS_iter) << " ns."
+                << std::endl;
+    }
+    auto stats = at::TensorIterator::plan_cache_stats();
+    std::cout << "Plan cache hits: " << stats.hits
+              << ", misses: " << stats.misses << std::endl;
+  }
+
+  return 0;
+}
@@ -17,6 +17,13 @@ C10_DEFINE_bool(
     false,
     "If set, fill memory with deterministic junk when allocating on CPU");
 
+C10_DEFINE_bool(
+    caffe2_cpu_numa_first_touch,
+    false,
+    "If set (together with --caffe2_cpu_numa_enabled), do not move CPU "
+    "allocations to the NUMA node of the allocating thread; pages are placed "
+    "on the node of the thread that first touches them instead");
+
 namespace c10 {
 
 void memset_junk(void* data, size_t num) {
@@ -71,8 +78,11 @@ void* alloc_cpu(size_t nbytes) {
       nbytes,
       " bytes. Buy new RAM!");
 
-  // move data to a thread's NUMA node
-  NUMAMove(data, nbytes, GetCurrentNUMANode());
+  // move data to a thread's NUMA node, unless placement is left to the
+  // kernel's first-touch policy
+  if (!FLAGS_caffe2_cpu_numa_first_touch) {
+    NUMAMove(data, nbytes, GetCurrentNUMANode());
+  }
   CHECK(
       !FLAGS_caffe2_cpu_allocator_do_zero_fill ||
       !FLAGS_caffe2_cpu_allocator_do_junk_fill)
@@ -94,27 +104,13 @@ void free_cpu(void* data) {
 #endif
 }
 
-// A virtual struct that is used to report C10's memory allocation and
-// deallocation status
-class C10_API MemoryAllocationReporter {
- public:
-  MemoryAllocationReporter() : allocated_(0) {}
-  void New(void* ptr, size_t nbytes);
-  void Delete(void* ptr);
-
- private:
-  std::mutex mutex_;
-  std::unordered_map<void*, size_t> size_table_;
-  size_t allocated_;
-};
-
 struct C10_API DefaultCPUAllocator final : at::Allocator {
   DefaultCPUAllocator() {}
   ~DefaultCPUAllocator() override {}
   at::DataPtr allocate(size_t nbytes) const override {
     void* data = alloc_cpu(nbytes);
-    if (FLAGS_caffe2_report_cpu_memory_usage && nbytes > 0) {
-      getMemoryAllocationReporter().New(data, nbytes);
+    if (nbytes > 0 && GetMemoryAllocationReporter().ShouldReport()) {
+      GetMemoryAllocationReporter().New(data, nbytes);
       return {data, data, &ReportAndDelete, at::Device(at::DeviceType::CPU)};
     }
     return {data, data, &free_cpu, at::Device(at::DeviceType::CPU)};
@@ -124,23 +120,16 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
     if (!ptr) {
       return;
     }
-    getMemoryAllocationReporter().Delete(ptr);
+    GetMemoryAllocationReporter().Delete(ptr);
     free_cpu(ptr);
   }
 
   at::DeleterFnPtr raw_deleter() const override {
-    if (FLAGS_caffe2_report_cpu_memory_usage) {
+    if (GetMemoryAllocationReporter().ShouldReport()) {
       return &ReportAndDelete;
     }
     return &free_cpu;
   }
-
- protected:
-  static MemoryAllocationReporter& getMemoryAllocationReporter() {
-    static MemoryAllocationReporter reporter_;
-    return reporter_;
-  }
-
 };
 
 void NoDelete(void*) {}
@@ -162,22 +151,75 @@ at::Allocator* GetDefaultCPUAllocator() {
 
 REGISTER_ALLOCATOR(DeviceType::CPU, &g_cpu_alloc);
 
+MemoryAllocationReporter& GetMemoryAllocationReporter() {
+  static MemoryAllocationReporter reporter_;
+  return reporter_;
+}
+
+bool MemoryAllocationReporter::ShouldReport() const {
+  return FLAGS_caffe2_report_cpu_memory_usage || observer_.load() != nullptr;
+}
+
 void MemoryAllocationReporter::New(void* ptr, size_t nbytes) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  size_table_[ptr] = nbytes;
-  allocated_ += nbytes;
-  LOG(INFO) << "C10 alloc " << nbytes << " bytes, total alloc " << allocated_
-            << " bytes.";
+  {
+    auto& shard = GetShard(ptr);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.size_table[ptr] = nbytes;
+  }
+  size_t allocated = allocated_.fetch_add(nbytes) + nbytes;
+  if (FLAGS_caffe2_report_cpu_memory_usage) {
+    LOG(INFO) << "C10 alloc " << nbytes << " bytes, total alloc " << allocated
+              << " bytes.";
+  }
+  if (auto* observer = observer_.load()) {
+    observer->OnAlloc(ptr, nbytes);
+  }
 }
 
 void MemoryAllocationReporter::Delete(void* ptr) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  auto it = size_table_.find(ptr);
-  CHECK(it != size_table_.end());
-  allocated_ -= it->second;
-  LOG(INFO) << "C10 deleted " << it->second << " bytes, total alloc "
-            << allocated_ << " bytes.";
-  size_table_.erase(it);
+  size_t nbytes;
+  {
+    auto& shard = GetShard(ptr);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto it = shard.size_table.find(ptr);
+    CHECK(it != shard.size_table.end());
+    nbytes = it->second;
+    shard.size_table.erase(it);
+  }
+  size_t allocated = allocated_.fetch_sub(nbytes) - nbytes;
+  if (FLAGS_caffe2_report_cpu_memory_usage) {
+    LOG(INFO) << "C10 deleted " << nbytes << " bytes, total alloc "
+              << allocated << " bytes.";
+  }
+  if (auto* observer = observer_.load()) {
+    observer->OnFree(ptr, nbytes);
+  }
+}
+
+void MemoryAllocationReporter::IncreaseCached(size_t nbytes) {
+  uint64_t cached =
+      cached_bytes_.fetch_add(nbytes, std::memory_order_relaxed) + nbytes;
+  uint64_t max_cached = max_cached_bytes_.load(std::memory_order_relaxed);
+  while (cached > max_cached &&
+         !max_cached_bytes_.compare_exchange_weak(
+             max_cached, cached, std::memory_order_relaxed)) {
+  }
+}
+
+MemoryCacheStats MemoryAllocationReporter::GetCacheStats() const {
+  MemoryCacheStats stats;
+  stats.hits = cache_hits_.load(std::memory_order_relaxed);
+  stats.misses = cache_misses_.load(std::memory_order_relaxed);
+  stats.cached_bytes = cached_bytes_.load(std::memory_order_relaxed);
+  stats.max_cached_bytes = max_cached_bytes_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void MemoryAllocationReporter::ResetCacheStats() {
+  cache_hits_.store(0, std::memory_order_relaxed);
+  cache_misses_.store(0, std::memory_order_relaxed);
+  max_cached_bytes_.store(
+      cached_bytes_.load(std::memory_order_relaxed), std::memory_order_relaxed);
 }
 
 } // namespace c10
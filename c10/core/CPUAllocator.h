@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <cstring>
+#include <mutex>
 #include <unordered_map>
 
 #include <c10/core/Allocator.h>
@@ -11,6 +13,7 @@
 C10_DECLARE_bool(caffe2_report_cpu_memory_usage);
 C10_DECLARE_bool(caffe2_cpu_allocator_do_zero_fill);
 C10_DECLARE_bool(caffe2_cpu_allocator_do_junk_fill);
+C10_DECLARE_bool(caffe2_cpu_numa_first_touch);
 
 namespace c10 {
 
@@ -39,4 +42,85 @@ C10_API void SetCPUAllocator(at::Allocator* alloc);
 // Get the Default CPU Allocator
 C10_API at::Allocator* GetDefaultCPUAllocator();
 
+// Counters maintained by caching CPU allocators (see CPUCachingAllocator.h).
+struct C10_API MemoryCacheStats {
+  uint64_t hits;          // allocations served from the cache
+  uint64_t misses;        // allocations that fell through to alloc_cpu
+  uint64_t cached_bytes;  // bytes currently held in the cache
+  uint64_t max_cached_bytes; // high-water mark of cached_bytes
+};
+
+// Receives the allocations and frees of the CPU allocators while it is
+// installed with MemoryAllocationReporter::SetObserver, e.g. to record memory
+// events in a profiler. Called on the allocating / freeing thread.
+class C10_API MemoryObserver {
+ public:
+  virtual ~MemoryObserver() = default;
+  virtual void OnAlloc(void* ptr, size_t nbytes) = 0;
+  virtual void OnFree(void* ptr, size_t nbytes) = 0;
+};
+
+// A virtual struct that is used to report C10's memory allocation and
+// deallocation status
+class C10_API MemoryAllocationReporter {
+ public:
+  MemoryAllocationReporter()
+      : allocated_(0),
+        cache_hits_(0),
+        cache_misses_(0),
+        cached_bytes_(0),
+        max_cached_bytes_(0) {}
+  void New(void* ptr, size_t nbytes);
+  void Delete(void* ptr);
+
+  // Whether allocators should report allocations through New / Delete: true
+  // if FLAGS_caffe2_report_cpu_memory_usage is set or an observer is
+  // installed.
+  bool ShouldReport() const;
+  // Installs an observer (nullptr removes it). Frees of blocks allocated
+  // before the observer was installed are not observed.
+  void SetObserver(MemoryObserver* observer) {
+    observer_.store(observer);
+  }
+
+  // Cache statistics. These are lock-free and always maintained, independent
+  // of FLAGS_caffe2_report_cpu_memory_usage.
+  void CacheHit() {
+    cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void CacheMiss() {
+    cache_misses_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void IncreaseCached(size_t nbytes);
+  void DecreaseCached(size_t nbytes) {
+    cached_bytes_.fetch_sub(nbytes, std::memory_order_relaxed);
+  }
+  MemoryCacheStats GetCacheStats() const;
+  void ResetCacheStats();
+
+ private:
+  // The sizes of the reported allocations, sharded by address so that
+  // threads allocating concurrently rarely contend on the same mutex.
+  struct alignas(64) SizeTableShard {
+    std::mutex mutex;
+    std::unordered_map<void*, size_t> size_table;
+  };
+  static constexpr size_t kNumSizeTableShards = 64;
+  SizeTableShard& GetShard(void* ptr) {
+    return size_table_shards_
+        [reinterpret_cast<uintptr_t>(ptr) / gAlignment % kNumSizeTableShards];
+  }
+
+  SizeTableShard size_table_shards_[kNumSizeTableShards];
+  std::atomic<size_t> allocated_;
+  std::atomic<uint64_t> cache_hits_;
+  std::atomic<uint64_t> cache_misses_;
+  std::atomic<uint64_t> cached_bytes_;
+  std::atomic<uint64_t> max_cached_bytes_;
+  std::atomic<MemoryObserver*> observer_{nullptr};
+};
+
+// Get the process-wide memory allocation reporter
+C10_API MemoryAllocationReporter& GetMemoryAllocationReporter();
+
 } // namespace c10
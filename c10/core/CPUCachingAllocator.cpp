@@ -0,0 +1,334 @@
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+C10_DEFINE_int64(
+    caffe2_cpu_caching_allocator_max_cached_bytes,
+    1024 * 1024 * 1024,
+    "Maximum number of bytes kept in the cache of the CPU caching allocator");
+
+namespace c10 {
+namespace CPUCachingAllocator {
+
+namespace {
+
+constexpr size_t kMinBlockSize = gAlignment;     // smallest size class
+constexpr size_t kHeaderSize = gAlignment;       // keeps user pointers aligned
+constexpr size_t kSubBins = 4;                   // size classes per power of two
+constexpr size_t kLog2SubBins = 2;
+constexpr size_t kLog2MinBlockSize = 6;
+constexpr size_t kNumBins = 64 * kSubBins;
+constexpr size_t kMaxThreadCachedBlock = 262144; // 256 KiB
+constexpr size_t kThreadCacheBytes = 4194304;    // 4 MiB per thread
+
+static_assert(
+    (1 << kLog2MinBlockSize) == kMinBlockSize,
+    "kLog2MinBlockSize does not match kMinBlockSize");
+
+// Stored right in front of the pointer handed out to the user, so that the
+// deleter (which only gets the data pointer) can find the size class.
+struct BlockHeader {
+  size_t bin;
+};
+
+static_assert(
+    sizeof(BlockHeader) <= kHeaderSize,
+    "BlockHeader must fit in the space reserved for it");
+
+inline size_t floorLog2(size_t n) {
+  size_t r = 0;
+  while (n >>= 1) {
+    r++;
+  }
+  return r;
+}
+
+// Bin 0 holds blocks of kMinBlockSize bytes. Above that, the range
+// (2^p, 2^(p+1)] is split into kSubBins classes of 2^(p - kLog2SubBins) bytes.
+size_t sizeToBin(size_t nbytes) {
+  if (nbytes <= kMinBlockSize) {
+    return 0;
+  }
+  size_t p = floorLog2(nbytes - 1);
+  size_t step = static_cast<size_t>(1) << (p - kLog2SubBins);
+  size_t k = (nbytes - (static_cast<size_t>(1) << p) + step - 1) / step;
+  return (p - kLog2MinBlockSize) * kSubBins + k;
+}
+
+size_t binToSize(size_t bin) {
+  if (bin == 0) {
+    return kMinBlockSize;
+  }
+  size_t p = (bin - 1) / kSubBins + kLog2MinBlockSize;
+  size_t k = (bin - 1) % kSubBins + 1;
+  size_t step = static_cast<size_t>(1) << (p - kLog2SubBins);
+  return (static_cast<size_t>(1) << p) + k * step;
+}
+
+inline BlockHeader* getHeader(void* ptr) {
+  return reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - kHeaderSize);
+}
+
+struct ThreadCache;
+
+class CachingAllocatorImpl {
+ public:
+  CachingAllocatorImpl() : cached_bytes_(0) {}
+
+  void* malloc(size_t nbytes);
+  void free(void* ptr);
+  void emptyCache();
+
+  void registerThreadCache(ThreadCache* cache);
+  void unregisterThreadCache(ThreadCache* cache);
+
+ private:
+  // Reserve room for a block of `size` bytes in the cache. Returns false if
+  // that would exceed the cap, in which case the block should be released.
+  bool reserveCached(size_t size);
+  void releaseCached(size_t size);
+
+  std::mutex mutex_;
+  std::vector<void*> bins_[kNumBins];
+  std::unordered_set<ThreadCache*> thread_caches_;
+  // total bytes held in the shared pool and all thread caches
+  std::atomic<size_t> cached_bytes_;
+};
+
+CachingAllocatorImpl& getImpl() {
+  // Intentionally leaked: tensors with static storage duration may be freed
+  // after all static destructors have run.
+  static CachingAllocatorImpl* impl = new CachingAllocatorImpl();
+  return *impl;
+}
+
+// Per-thread free lists for small blocks. The mutex is only ever contended by
+// emptyCache(), which drains the lists of all threads.
+struct ThreadCache {
+  ThreadCache() : cached_bytes(0) {
+    getImpl().registerThreadCache(this);
+  }
+  ~ThreadCache();
+
+  std::mutex mutex;
+  std::vector<void*> bins[kNumBins];
+  size_t cached_bytes;
+};
+
+// Set once the thread cache of this thread has been destroyed, so that frees
+// issued by later thread_local destructors bypass it.
+thread_local bool tls_cache_destroyed = false;
+
+ThreadCache::~ThreadCache() {
+  getImpl().unregisterThreadCache(this);
+  tls_cache_destroyed = true;
+}
+
+ThreadCache* getThreadCache() {
+  if (tls_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+void fillBlock(void* data, size_t nbytes) {
+  if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+    memset(data, 0, nbytes);
+  } else if (FLAGS_caffe2_cpu_allocator_do_junk_fill) {
+    memset_junk(data, nbytes);
+  }
+}
+
+void* CachingAllocatorImpl::malloc(size_t nbytes) {
+  CAFFE_ENFORCE(
+      ((ptrdiff_t)nbytes) >= 0,
+      "CPUCachingAllocator called with negative number: ",
+      nbytes);
+  size_t bin = sizeToBin(nbytes);
+  size_t size = binToSize(bin);
+  void* ptr = nullptr;
+
+  if (size <= kMaxThreadCachedBlock) {
+    if (ThreadCache* cache = getThreadCache()) {
+      std::lock_guard<std::mutex> guard(cache->mutex);
+      auto& blocks = cache->bins[bin];
+      if (!blocks.empty()) {
+        ptr = blocks.back();
+        blocks.pop_back();
+        cache->cached_bytes -= size;
+      }
+    }
+  }
+  if (!ptr) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto& blocks = bins_[bin];
+    if (!blocks.empty()) {
+      ptr = blocks.back();
+      blocks.pop_back();
+    }
+  }
+
+  auto& reporter = GetMemoryAllocationReporter();
+  if (ptr) {
+    releaseCached(size);
+    reporter.CacheHit();
+    fillBlock(ptr, nbytes);
+    return ptr;
+  }
+
+  reporter.CacheMiss();
+  void* raw = alloc_cpu(kHeaderSize + size);
+  getHeader(static_cast<char*>(raw) + kHeaderSize)->bin = bin;
+  return static_cast<char*>(raw) + kHeaderSize;
+}
+
+void CachingAllocatorImpl::free(void* ptr) {
+  size_t bin = getHeader(ptr)->bin;
+  size_t size = binToSize(bin);
+
+  if (!reserveCached(size)) {
+    free_cpu(getHeader(ptr));
+    return;
+  }
+
+  if (size <= kMaxThreadCachedBlock) {
+    if (ThreadCache* cache = getThreadCache()) {
+      std::lock_guard<std::mutex> guard(cache->mutex);
+      if (cache->cached_bytes + size <= kThreadCacheBytes) {
+        cache->bins[bin].push_back(ptr);
+        cache->cached_bytes += size;
+        return;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  bins_[bin].push_back(ptr);
+}
+
+bool CachingAllocatorImpl::reserveCached(size_t size) {
+  size_t limit = static_cast<size_t>(
+      std::max<int64_t>(FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes, 0));
+  size_t cached = cached_bytes_.load(std::memory_order_relaxed);
+  do {
+    if (cached + size > limit) {
+      return false;
+    }
+  } while (!cached_bytes_.compare_exchange_weak(
+      cached, cached + size, std::memory_order_relaxed));
+  GetMemoryAllocationReporter().IncreaseCached(size);
+  return true;
+}
+
+void CachingAllocatorImpl::releaseCached(size_t size) {
+  cached_bytes_.fetch_sub(size, std::memory_order_relaxed);
+  GetMemoryAllocationReporter().DecreaseCached(size);
+}
+
+void CachingAllocatorImpl::emptyCache() {
+  std::vector<void*> blocks;
+  size_t freed_bytes = 0;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (ThreadCache* cache : thread_caches_) {
+      std::lock_guard<std::mutex> cache_guard(cache->mutex);
+      for (auto& bin : cache->bins) {
+        blocks.insert(blocks.end(), bin.begin(), bin.end());
+        bin.clear();
+      }
+      cache->cached_bytes = 0;
+    }
+    for (auto& bin : bins_) {
+      blocks.insert(blocks.end(), bin.begin(), bin.end());
+      bin.clear();
+    }
+  }
+  for (void* ptr : blocks) {
+    freed_bytes += binToSize(getHeader(ptr)->bin);
+    free_cpu(getHeader(ptr));
+  }
+  releaseCached(freed_bytes);
+  if (FLAGS_caffe2_report_cpu_memory_usage) {
+    LOG(INFO) << "C10 caching allocator released " << freed_bytes
+              << " cached bytes in " << blocks.size() << " blocks.";
+  }
+}
+
+void CachingAllocatorImpl::registerThreadCache(ThreadCache* cache) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  thread_caches_.insert(cache);
+}
+
+void CachingAllocatorImpl::unregisterThreadCache(ThreadCache* cache) {
+  // Hand the blocks of an exiting thread over to the shared pool; they stay
+  // accounted for in cached_bytes_.
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::lock_guard<std::mutex> cache_guard(cache->mutex);
+  for (size_t bin = 0; bin < kNumBins; bin++) {
+    auto& blocks = cache->bins[bin];
+    bins_[bin].insert(bins_[bin].end(), blocks.begin(), blocks.end());
+    blocks.clear();
+  }
+  cache->cached_bytes = 0;
+  thread_caches_.erase(cache);
+}
+
+void Delete(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  getImpl().free(ptr);
+}
+
+void ReportAndDelete(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  GetMemoryAllocationReporter().Delete(ptr);
+  getImpl().free(ptr);
+}
+
+struct CPUCachingAllocator final : public at::Allocator {
+  at::DataPtr allocate(size_t nbytes) const override {
+    if (nbytes == 0) {
+      return {nullptr, nullptr, &Delete, at::Device(at::DeviceType::CPU)};
+    }
+    void* data = getImpl().malloc(nbytes);
+    if (GetMemoryAllocationReporter().ShouldReport()) {
+      GetMemoryAllocationReporter().New(data, nbytes);
+      return {data, data, &ReportAndDelete, at::Device(at::DeviceType::CPU)};
+    }
+    return {data, data, &Delete, at::Device(at::DeviceType::CPU)};
+  }
+
+  at::DeleterFnPtr raw_deleter() const override {
+    if (GetMemoryAllocationReporter().ShouldReport()) {
+      return &ReportAndDelete;
+    }
+    return &Delete;
+  }
+};
+
+CPUCachingAllocator g_caching_alloc;
+
+} // namespace
+
+Allocator* get() {
+  return &g_caching_alloc;
+}
+
+void emptyCache() {
+  getImpl().emptyCache();
+}
+
+size_t roundSize(size_t nbytes) {
+  return binToSize(sizeToBin(nbytes));
+}
+
+} // namespace CPUCachingAllocator
+} // namespace c10
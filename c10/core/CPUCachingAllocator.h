@@ -0,0 +1,48 @@
+#pragma once
+
+#include <c10/core/Allocator.h>
+#include <c10/core/CPUAllocator.h>
+#include <c10/util/Flags.h>
+
+C10_DECLARE_int64(caffe2_cpu_caching_allocator_max_cached_bytes);
+
+namespace c10 {
+
+// Size-class caching allocator for CPU memory.
+//
+// The default CPU allocator goes to posix_memalign / free on every tensor
+// creation, which means every large allocation is a fresh mmap that has to be
+// page-faulted in again. This allocator sits on top of alloc_cpu / free_cpu and
+// keeps freed blocks around for reuse:
+//
+// - Requests are rounded up to size classes: four classes per power of two,
+//   so at most 25% of a block is wasted.
+// - Freed blocks up to 256 KiB go to a per-thread free list first (bounded to
+//   4 MiB per thread); larger blocks, and overflow from full thread lists, go
+//   to a shared pool protected by a mutex.
+// - The total number of bytes held in the cache is capped by
+//   --caffe2_cpu_caching_allocator_max_cached_bytes. Blocks freed while the
+//   cache is full are returned to the system immediately.
+// - Hits, misses and cached bytes are reported through the
+//   MemoryAllocationReporter (see GetMemoryAllocationReporter()).
+//
+// The allocator is opt-in. To use it for all CPU tensors, install it with
+//
+//   c10::SetCPUAllocator(c10::CPUCachingAllocator::get());
+//
+// before any CPU memory is allocated. Memory that was allocated by a
+// different allocator is still freed by the deleter it was created with, so
+// switching at a later point is safe as well.
+
+namespace CPUCachingAllocator {
+
+C10_API Allocator* get();
+// Release all cached blocks, including the ones held in the free lists of
+// other threads, back to the system.
+C10_API void emptyCache();
+// Size in bytes of the block that serves a request of nbytes.
+C10_API size_t roundSize(size_t nbytes);
+
+} // namespace CPUCachingAllocator
+
+} // namespace c10
@@ -0,0 +1,411 @@
+#include <c10/core/work_stealing_pool.h>
+
+#include <exception>
+
+namespace c10 {
+
+constexpr size_t WorkStealingPool::kMaxCallers;
+
+namespace {
+
+// Number of unsuccessful attempts to find work before a pool thread goes to
+// sleep.
+constexpr int kSpinCount = 64;
+
+// Pool and worker index of the current thread, if it is a pool thread.
+thread_local const WorkStealingPool* tls_pool = nullptr;
+thread_local size_t tls_worker_index = 0;
+
+inline uint32_t nextRandom(uint32_t* seed) {
+  // xorshift32
+  uint32_t x = *seed;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *seed = x;
+  return x;
+}
+
+} // namespace
+
+struct WorkStealingPool::Job {
+  explicit Job(const std::function<void(int64_t, size_t)>* fn, int64_t n)
+      : fn(fn), remaining(n), done(false) {}
+
+  const std::function<void(int64_t, size_t)>* fn;
+  // number of chunks that have not completed yet
+  std::atomic<int64_t> remaining;
+  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
+  std::exception_ptr eptr;
+
+  // Set by the thread that completes the last chunk. The caller always waits
+  // for it under the mutex, so that the job outlives that thread's accesses.
+  std::mutex mutex;
+  std::condition_variable completed;
+  bool done;
+};
+
+struct WorkStealingPool::Task {
+  int64_t begin;
+  int64_t end;
+  Job* job;
+};
+
+// Fixed-capacity Chase-Lev deque, following "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (Le et al., PPoPP 2013). Only the
+// owner pushes and pops at the bottom; any thread may steal from the top.
+// Slots are made of atomics so that a thief racing with the owner reads a
+// stale but well-defined value, which it then discards when its CAS on top_
+// fails.
+class WorkStealingPool::TaskDeque {
+ public:
+  // Recursive splitting keeps at most log2(num_chunks) tasks per call on a
+  // deque, so this is never reached in practice; a full deque just stops
+  // splitting.
+  static constexpr int64_t kCapacity = 256;
+
+  TaskDeque() : top_(0), bottom_(0) {}
+
+  bool push(const Task& task) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= kCapacity) {
+      return false;
+    }
+    Slot& slot = slots_[b & (kCapacity - 1)];
+    slot.begin.store(task.begin, std::memory_order_relaxed);
+    slot.end.store(task.end, std::memory_order_relaxed);
+    slot.job.store(task.job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool pop(Task* task) {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    read(b, task);
+    if (t == b) {
+      // last task, race against thieves
+      bool won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // If only_job is not null, only a task belonging to that job is taken.
+  bool steal(Task* task, const Job* only_job) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    read(t, task);
+    if (only_job && task->job != only_job) {
+      return false;
+    }
+    return top_.compare_exchange_strong(
+        t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<int64_t> begin;
+    std::atomic<int64_t> end;
+    std::atomic<Job*> job;
+  };
+
+  void read(int64_t index, Task* task) const {
+    const Slot& slot = slots_[index & (kCapacity - 1)];
+    task->begin = slot.begin.load(std::memory_order_relaxed);
+    task->end = slot.end.load(std::memory_order_relaxed);
+    task->job = slot.job.load(std::memory_order_relaxed);
+  }
+
+  std::atomic<int64_t> top_;
+  // keep the owner's and the thieves' ends on separate cache lines
+  char padding_[64];
+  std::atomic<int64_t> bottom_;
+  Slot slots_[kCapacity];
+};
+
+WorkStealingPool::WorkStealingPool(
+    int pool_size,
+    std::function<void()> init_thread)
+    : threads_(pool_size < 0 ? defaultNumThreads() : pool_size),
+      caller_slots_(new std::atomic<bool>[kMaxCallers]),
+      num_caller_slots_used_(0),
+      num_injected_(0),
+      epoch_(0),
+      num_sleeping_(0),
+      running_(true) {
+  for (size_t i = 0; i < threads_.size() + kMaxCallers; ++i) {
+    deques_.emplace_back(new TaskDeque());
+  }
+  for (size_t i = 0; i < kMaxCallers; ++i) {
+    caller_slots_[i] = false;
+  }
+  for (std::size_t i = 0; i < threads_.size(); ++i) {
+    threads_[i] = std::thread([this, i, init_thread](){
+      if (init_thread) {
+        init_thread();
+      }
+      this->main_loop(i);
+    });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    running_ = false;
+    condition_.notify_all();
+  }
+
+  for (auto& t : threads_) {
+    try {
+      t.join();
+    } catch (const std::exception&) {
+    }
+  }
+}
+
+size_t WorkStealingPool::size() const {
+  return threads_.size();
+}
+
+size_t WorkStealingPool::numAvailable() const {
+  return num_sleeping_.load();
+}
+
+bool WorkStealingPool::inThreadPool() const {
+  return tls_pool == this;
+}
+
+void WorkStealingPool::run(const std::function<void()>& func) {
+  if (threads_.size() == 0) {
+    throw std::runtime_error("No threads to run a task");
+  }
+  {
+    std::lock_guard<std::mutex> guard(injected_mutex_);
+    injected_.push(func);
+    num_injected_++;
+  }
+  notify();
+}
+
+void WorkStealingPool::notify() {
+  // Pairs with the check of epoch_ in main_loop: either the sleeping thread
+  // sees the new epoch, or we see it in num_sleeping_ and wake it up.
+  epoch_.fetch_add(1);
+  if (num_sleeping_.load() > 0) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    condition_.notify_one();
+  }
+}
+
+bool WorkStealingPool::runInjected() {
+  if (num_injected_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  std::function<void()> func;
+  {
+    std::lock_guard<std::mutex> guard(injected_mutex_);
+    if (injected_.empty()) {
+      return false;
+    }
+    func = std::move(injected_.front());
+    injected_.pop();
+    num_injected_--;
+  }
+  try {
+    func();
+  } catch (const std::exception&) {
+  }
+  return true;
+}
+
+bool WorkStealingPool::trySteal(
+    size_t self,
+    uint32_t* seed,
+    Task* task,
+    const Job* only_job) {
+  // caller deques are stored after the worker deques
+  size_t n = threads_.size() +
+      num_caller_slots_used_.load(std::memory_order_acquire);
+  if (n == 0) {
+    return false;
+  }
+  size_t start = nextRandom(seed) % n;
+  for (size_t i = 0; i < n; ++i) {
+    size_t victim = (start + i) % n;
+    if (victim != self && deques_[victim]->steal(task, only_job)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::execute(
+    Task task,
+    size_t deque_index,
+    size_t thread_id) {
+  Job* job = task.job;
+  while (task.end - task.begin > 1) {
+    int64_t mid = task.begin + (task.end - task.begin) / 2;
+    if (!deques_[deque_index]->push(Task{mid, task.end, job})) {
+      break;
+    }
+    notify();
+    task.end = mid;
+  }
+
+  for (int64_t chunk = task.begin; chunk < task.end; ++chunk) {
+    try {
+      (*job->fn)(chunk, thread_id);
+    } catch (...) {
+      if (!job->err_flag.test_and_set()) {
+        job->eptr = std::current_exception();
+      }
+    }
+  }
+
+  int64_t n = task.end - task.begin;
+  if (job->remaining.fetch_sub(n, std::memory_order_acq_rel) == n) {
+    std::lock_guard<std::mutex> guard(job->mutex);
+    job->done = true;
+    job->completed.notify_all();
+  }
+}
+
+void WorkStealingPool::parallelRun(
+    int64_t num_chunks,
+    const std::function<void(int64_t, size_t)>& fn) {
+  if (num_chunks <= 0) {
+    return;
+  }
+
+  // Find a deque for this call. Nested calls from pool threads, and callers
+  // beyond kMaxCallers, run serially.
+  size_t thread_id = 0;
+  size_t slot = kMaxCallers;
+  if (tls_pool == this) {
+    thread_id = tls_worker_index + 1;
+  } else if (threads_.size() > 0) {
+    for (size_t i = 0; i < kMaxCallers; ++i) {
+      bool expected = false;
+      if (!caller_slots_[i].load(std::memory_order_relaxed) &&
+          caller_slots_[i].compare_exchange_strong(expected, true)) {
+        slot = i;
+        break;
+      }
+    }
+  }
+  if (slot == kMaxCallers) {
+    std::exception_ptr eptr;
+    for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+      try {
+        fn(chunk, thread_id);
+      } catch (...) {
+        if (!eptr) {
+          eptr = std::current_exception();
+        }
+      }
+    }
+    if (eptr) {
+      std::rethrow_exception(eptr);
+    }
+    return;
+  }
+
+  size_t used = num_caller_slots_used_.load();
+  while (used < slot + 1 &&
+         !num_caller_slots_used_.compare_exchange_weak(used, slot + 1)) {
+  }
+
+  Job job(&fn, num_chunks);
+  size_t deque_index = threads_.size() + slot;
+  uint32_t seed = static_cast<uint32_t>(deque_index) * 2654435761u + 1;
+  execute(Task{0, num_chunks, &job}, deque_index, thread_id);
+
+  // Help with the remaining chunks of this job until none are left. The
+  // caller's deque only ever holds tasks of this job.
+  Task task;
+  int spins = 0;
+  while (job.remaining.load(std::memory_order_acquire) > 0) {
+    if (deques_[deque_index]->pop(&task) ||
+        trySteal(deque_index, &seed, &task, &job)) {
+      execute(task, deque_index, thread_id);
+      spins = 0;
+    } else if (++spins < kSpinCount) {
+      std::this_thread::yield();
+    } else {
+      // Everything is taken; wait for the stragglers.
+      break;
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lock(job.mutex);
+    while (!job.done) {
+      job.completed.wait(lock);
+    }
+  }
+
+  caller_slots_[slot].store(false, std::memory_order_release);
+  if (job.eptr) {
+    std::rethrow_exception(job.eptr);
+  }
+}
+
+void WorkStealingPool::main_loop(std::size_t index) {
+  tls_pool = this;
+  tls_worker_index = index;
+  uint32_t seed = static_cast<uint32_t>(index) * 2654435761u + 1;
+  int spins = 0;
+  Task task;
+  while (running_) {
+    if (deques_[index]->pop(&task) ||
+        trySteal(index, &seed, &task, nullptr)) {
+      execute(task, index, index + 1);
+      spins = 0;
+      continue;
+    }
+    if (runInjected()) {
+      spins = 0;
+      continue;
+    }
+    if (++spins < kSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+    spins = 0;
+
+    // Take a snapshot of the epoch and look for work one more time; any push
+    // after the snapshot bumps the epoch and keeps us from sleeping.
+    uint64_t epoch = epoch_.load();
+    if (trySteal(index, &seed, &task, nullptr)) {
+      execute(task, index, index + 1);
+      continue;
+    }
+    if (num_injected_.load() > 0) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    num_sleeping_++;
+    while (running_ && epoch_.load() == epoch) {
+      condition_.wait(lock);
+    }
+    num_sleeping_--;
+  }
+}
+
+} // namespace c10
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <c10/core/thread_pool.h>
+
+namespace c10 {
+
+/**
+ * Thread pool with a work-stealing scheduler for fork-join style loops.
+ *
+ * parallelRun() hands out a range of chunk ids by recursive binary splitting:
+ * a thread that owns the range [begin, end) pushes the upper half onto its own
+ * deque and keeps splitting the lower half until a single chunk is left,
+ * which it then runs. Owners pop from the bottom of their deque (the most
+ * recently split, smallest ranges) while idle threads steal from the top of
+ * other threads' deques (the oldest, largest ranges). Load balancing therefore
+ * happens on demand: when chunks take very different amounts of time, threads
+ * that finish early steal the remaining work of a straggler instead of
+ * waiting for it.
+ *
+ * Each pool thread and each concurrent caller of parallelRun() owns a
+ * fixed-size lock-free deque (Chase-Lev). Idle pool threads spin briefly and
+ * then sleep until new work is pushed.
+ */
+class C10_API WorkStealingPool : public c10::TaskThreadPoolBase {
+ public:
+  explicit WorkStealingPool(
+      int pool_size,
+      std::function<void()> init_thread = nullptr);
+
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  void run(const std::function<void()>& func) override;
+
+  size_t size() const override;
+
+  size_t numAvailable() const override;
+
+  bool inThreadPool() const override;
+
+  /**
+   * Calls fn(chunk_id, thread_id) for every chunk_id in [0, num_chunks) and
+   * returns once all calls completed. The calling thread takes part in the
+   * work. thread_id is 0 for the calling thread and 1 + the worker index for
+   * pool threads, so it is unique among the threads working on one call and
+   * smaller than size() + 1. If fn throws, the remaining chunks still run and
+   * the first exception is rethrown to the caller.
+   */
+  void parallelRun(
+      int64_t num_chunks,
+      const std::function<void(int64_t, size_t)>& fn);
+
+  // Maximum number of threads that can call parallelRun() concurrently and
+  // still get parallelism; further concurrent callers run serially.
+  static constexpr size_t kMaxCallers = 32;
+
+ private:
+  struct Job;
+  struct Task;
+  class TaskDeque;
+
+  void main_loop(std::size_t index);
+  // Split task down to a single chunk, pushing the split-off halves onto
+  // deques_[deque_index], then run it.
+  void execute(Task task, size_t deque_index, size_t thread_id);
+  bool trySteal(size_t self, uint32_t* seed, Task* task, const Job* only_job);
+  bool runInjected();
+  void notify();
+
+  std::vector<std::thread> threads_;
+  // deques_[i] for i < threads_.size() belongs to worker i, the rest are
+  // claimed by callers of parallelRun() for the duration of the call
+  std::vector<std::unique_ptr<TaskDeque>> deques_;
+  std::unique_ptr<std::atomic<bool>[]> caller_slots_;
+  std::atomic<size_t> num_caller_slots_used_;
+
+  std::mutex injected_mutex_;
+  std::queue<std::function<void()>> injected_;
+  std::atomic<size_t> num_injected_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<uint64_t> epoch_;
+  std::atomic<size_t> num_sleeping_;
+  std::atomic_bool running_;
+};
+
+} // namespace c10
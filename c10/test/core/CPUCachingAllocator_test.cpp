@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <thread>
+#include <vector>
+
+using namespace c10;
+
+TEST(CPUCachingAllocator, RoundSize) {
+  ASSERT_EQ(CPUCachingAllocator::roundSize(1), gAlignment);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(64), 64);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(65), 80);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(1000), 1024);
+  ASSERT_EQ(CPUCachingAllocator::roundSize(1025), 1280);
+  for (size_t n = 1; n < 100000; n += 7) {
+    size_t rounded = CPUCachingAllocator::roundSize(n);
+    ASSERT_GE(rounded, n);
+    ASSERT_LE(rounded, std::max<size_t>(gAlignment, n + n / 4 + 1));
+  }
+}
+
+TEST(CPUCachingAllocator, ReusesFreedBlocks) {
+  auto* allocator = CPUCachingAllocator::get();
+  auto& reporter = GetMemoryAllocationReporter();
+  CPUCachingAllocator::emptyCache();
+  reporter.ResetCacheStats();
+
+  void* first;
+  {
+    auto ptr = allocator->allocate(1000);
+    first = ptr.get();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(first) % gAlignment, 0);
+  }
+  ASSERT_EQ(reporter.GetCacheStats().cached_bytes, 1024);
+  {
+    // Same size class, so this should be served from the cache
+    auto ptr = allocator->allocate(1010);
+    ASSERT_EQ(ptr.get(), first);
+  }
+  auto stats = reporter.GetCacheStats();
+  ASSERT_EQ(stats.hits, 1);
+  ASSERT_EQ(stats.misses, 1);
+  ASSERT_EQ(stats.max_cached_bytes, 1024);
+
+  CPUCachingAllocator::emptyCache();
+  ASSERT_EQ(reporter.GetCacheStats().cached_bytes, 0);
+}
+
+TEST(CPUCachingAllocator, RawAllocate) {
+  auto* allocator = CPUCachingAllocator::get();
+  CPUCachingAllocator::emptyCache();
+  void* ptr = allocator->raw_allocate(1 << 20);
+  allocator->raw_deallocate(ptr);
+  ASSERT_EQ(
+      GetMemoryAllocationReporter().GetCacheStats().cached_bytes, 1 << 20);
+  ASSERT_EQ(allocator->raw_allocate(1 << 20), ptr);
+  allocator->raw_deallocate(ptr);
+  CPUCachingAllocator::emptyCache();
+}
+
+TEST(CPUCachingAllocator, RespectsCacheLimit) {
+  auto* allocator = CPUCachingAllocator::get();
+  auto& reporter = GetMemoryAllocationReporter();
+  CPUCachingAllocator::emptyCache();
+  auto old_limit = FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes;
+  FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes = 4096;
+  {
+    auto small = allocator->allocate(4096);
+    auto large = allocator->allocate(8192);
+  }
+  ASSERT_LE(reporter.GetCacheStats().cached_bytes, 4096);
+  FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes = old_limit;
+  CPUCachingAllocator::emptyCache();
+}
+
+TEST(CPUCachingAllocator, CrossThreadFree) {
+  auto* allocator = CPUCachingAllocator::get();
+  auto& reporter = GetMemoryAllocationReporter();
+  CPUCachingAllocator::emptyCache();
+
+  auto ptr = allocator->allocate(256);
+  void* data = ptr.get();
+  std::thread t([&]() {
+    // Frees into the thread-local cache of t, which is handed over to the
+    // shared pool when t exits.
+    ptr.clear();
+  });
+  t.join();
+  ASSERT_EQ(reporter.GetCacheStats().cached_bytes, 256);
+  auto again = allocator->allocate(256);
+  ASSERT_EQ(again.get(), data);
+  again.clear();
+  CPUCachingAllocator::emptyCache();
+  ASSERT_EQ(reporter.GetCacheStats().cached_bytes, 0);
+}
+
+namespace {
+struct CountingObserver final : public MemoryObserver {
+  void OnAlloc(void*, size_t nbytes) override {
+    allocated += nbytes;
+  }
+  void OnFree(void*, size_t nbytes) override {
+    freed += nbytes;
+  }
+  std::atomic<size_t> allocated{0};
+  std::atomic<size_t> freed{0};
+};
+} // namespace
+
+TEST(MemoryAllocationReporter, ObservesConcurrentAllocations) {
+  auto* allocator = GetDefaultCPUAllocator();
+  auto& reporter = GetMemoryAllocationReporter();
+  CountingObserver observer;
+  reporter.SetObserver(&observer);
+
+  constexpr int kThreads = 8;
+  constexpr int kAllocations = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<DataPtr> ptrs;
+      for (int i = 1; i <= kAllocations; i++) {
+        ptrs.push_back(allocator->allocate(t + i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  reporter.SetObserver(nullptr);
+
+  size_t expected = 0;
+  for (int t = 0; t < kThreads; t++) {
+    for (int i = 1; i <= kAllocations; i++) {
+      expected += t + i;
+    }
+  }
+  ASSERT_EQ(observer.allocated, expected);
+  ASSERT_EQ(observer.freed, expected);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/work_stealing_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace c10;
+
+TEST(WorkStealingPool, RunsEveryChunkOnce) {
+  WorkStealingPool pool(3);
+  for (int64_t n : {1, 2, 7, 100, 10000}) {
+    std::vector<std::atomic<int>> counts(n);
+    for (auto& c : counts) {
+      c = 0;
+    }
+    pool.parallelRun(n, [&](int64_t chunk, size_t thread_id) {
+      ASSERT_LT(thread_id, pool.size() + 1);
+      counts[chunk]++;
+    });
+    for (auto& c : counts) {
+      ASSERT_EQ(c.load(), 1);
+    }
+  }
+}
+
+TEST(WorkStealingPool, BalancesImbalancedChunks) {
+  WorkStealingPool pool(3);
+  std::mutex mutex;
+  std::set<size_t> thread_ids;
+  // The first chunk is far more expensive than the rest; the other threads
+  // must pick up the remaining chunks in the meantime.
+  pool.parallelRun(64, [&](int64_t chunk, size_t thread_id) {
+    if (chunk == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::lock_guard<std::mutex> guard(mutex);
+    thread_ids.insert(thread_id);
+  });
+  ASSERT_GT(thread_ids.size(), 1);
+}
+
+TEST(WorkStealingPool, ConcurrentCallers) {
+  WorkStealingPool pool(2);
+  std::atomic<int64_t> total{0};
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i) {
+    callers.emplace_back([&]() {
+      for (int iter = 0; iter < 100; ++iter) {
+        pool.parallelRun(50, [&](int64_t chunk, size_t) { total += chunk; });
+      }
+    });
+  }
+  for (auto& t : callers) {
+    t.join();
+  }
+  ASSERT_EQ(total.load(), 4 * 100 * (49 * 50 / 2));
+}
+
+TEST(WorkStealingPool, Exceptions) {
+  WorkStealingPool pool(2);
+  std::atomic<int> ran{0};
+  ASSERT_THROW(
+      pool.parallelRun(
+          16,
+          [&](int64_t chunk, size_t) {
+            ran++;
+            if (chunk == 5) {
+              throw std::runtime_error("exception");
+            }
+          }),
+      std::runtime_error);
+  ASSERT_EQ(ran.load(), 16);
+}
+
+TEST(WorkStealingPool, Run) {
+  WorkStealingPool pool(2);
+  std::atomic<int> counter{0};
+  for (int i = 0; i < 10; ++i) {
+    pool.run([&]() { counter++; });
+  }
+  while (counter.load() < 10) {
+    std::this_thread::yield();
+  }
+  ASSERT_FALSE(pool.inThreadPool());
+}
+
+TEST(WorkStealingPool, EmptyPool) {
+  WorkStealingPool pool(0);
+  int64_t sum = 0;
+  pool.parallelRun(10, [&](int64_t chunk, size_t thread_id) {
+    ASSERT_EQ(thread_id, 0);
+    sum += chunk;
+  });
+  ASSERT_EQ(sum, 45);
+}
@@ -0,0 +1,175 @@
+#include "caffe2/serialize/block_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <ATen/Parallel.h>
+#include <c10/util/Exception.h>
+
+#include "miniz.h"
+
+namespace caffe2 {
+namespace serialize {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'T', 'B', 'L', 'O', 'C', 'K', '1'};
+constexpr size_t kHeaderSize = sizeof(kMagic) + 3 * sizeof(uint64_t);
+
+void writeLE64(char* out, uint64_t value) {
+  for (size_t i = 0; i < sizeof(value); ++i) {
+    out[i] = static_cast<char>(value >> (8 * i));
+  }
+}
+
+uint64_t readLE64(const char* in) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < sizeof(value); ++i) {
+    value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+  }
+  return value;
+}
+
+// trailing bytes that don't make up a whole element are not shuffled
+void shuffle(const char* in, size_t size, size_t element_size, char* out) {
+  size_t n = size / element_size;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < element_size; ++b) {
+      out[b * n + i] = in[i * element_size + b];
+    }
+  }
+  std::memcpy(out + n * element_size, in + n * element_size, size % element_size);
+}
+
+void unshuffle(const char* in, size_t size, size_t element_size, char* out) {
+  size_t n = size / element_size;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < element_size; ++b) {
+      out[i * element_size + b] = in[b * n + i];
+    }
+  }
+  std::memcpy(out + n * element_size, in + n * element_size, size % element_size);
+}
+
+struct Header {
+  size_t element_size;
+  size_t size;
+  size_t num_blocks;
+  const char* block_ends;
+  const char* blocks;
+};
+
+Header readHeader(const void* encoded, size_t encoded_size) {
+  const char* in = static_cast<const char*>(encoded);
+  TORCH_CHECK(
+      encoded_size >= kHeaderSize && std::memcmp(in, kMagic, sizeof(kMagic)) == 0,
+      "invalid block encoded record");
+  Header header;
+  header.element_size = readLE64(in + sizeof(kMagic));
+  header.size = readLE64(in + sizeof(kMagic) + sizeof(uint64_t));
+  header.num_blocks = readLE64(in + sizeof(kMagic) + 2 * sizeof(uint64_t));
+  // the number of blocks is rounded up, which must not wrap around
+  TORCH_CHECK(
+      header.element_size > 0 &&
+          header.size <= std::numeric_limits<size_t>::max() - kCodecBlockSize &&
+          header.num_blocks ==
+              (header.size + kCodecBlockSize - 1) / kCodecBlockSize &&
+          encoded_size >= kHeaderSize + header.num_blocks * sizeof(uint64_t),
+      "invalid block encoded record");
+  header.block_ends = in + kHeaderSize;
+  header.blocks = header.block_ends + header.num_blocks * sizeof(uint64_t);
+  return header;
+}
+
+} // namespace
+
+std::string encodeBlocks(
+    const void* data,
+    size_t size,
+    size_t element_size) {
+  TORCH_CHECK(element_size > 0, "element size must be positive");
+  const char* in = static_cast<const char*>(data);
+  size_t num_blocks = (size + kCodecBlockSize - 1) / kCodecBlockSize;
+  std::vector<std::string> blocks(num_blocks);
+  const int flags = tdefl_create_comp_flags_from_zip_params(
+      MZ_BEST_SPEED, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+  at::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    std::vector<char> shuffled;
+    for (int64_t i = begin; i < end; ++i) {
+      size_t block_size = std::min(kCodecBlockSize, size - i * kCodecBlockSize);
+      const char* block = in + i * kCodecBlockSize;
+      shuffled.resize(block_size);
+      shuffle(block, block_size, element_size, shuffled.data());
+      std::string& out = blocks[i];
+      out.resize(block_size);
+      size_t compressed_size = tdefl_compress_mem_to_mem(
+          &out[0], block_size, shuffled.data(), block_size, flags);
+      if (compressed_size == 0 || compressed_size >= block_size) {
+        out.assign(block, block_size);
+      } else {
+        out.resize(compressed_size);
+      }
+    }
+  });
+
+  std::string encoded(kHeaderSize + num_blocks * sizeof(uint64_t), '\0');
+  std::memcpy(&encoded[0], kMagic, sizeof(kMagic));
+  writeLE64(&encoded[sizeof(kMagic)], element_size);
+  writeLE64(&encoded[sizeof(kMagic) + sizeof(uint64_t)], size);
+  writeLE64(&encoded[sizeof(kMagic) + 2 * sizeof(uint64_t)], num_blocks);
+  size_t end = 0;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    end += blocks[i].size();
+    writeLE64(&encoded[kHeaderSize + i * sizeof(uint64_t)], end);
+  }
+  encoded.reserve(encoded.size() + end);
+  for (const auto& block : blocks) {
+    encoded += block;
+  }
+  return encoded;
+}
+
+size_t decodedSize(const void* encoded, size_t encoded_size) {
+  return readHeader(encoded, encoded_size).size;
+}
+
+void decodeBlocks(const void* encoded, size_t encoded_size, void* out) {
+  Header header = readHeader(encoded, encoded_size);
+  const size_t blocks_size = encoded_size - (header.blocks -
+      static_cast<const char*>(encoded));
+  char* decoded = static_cast<char*>(out);
+  at::parallel_for(0, header.num_blocks, 1, [&](int64_t begin, int64_t end) {
+    std::vector<char> shuffled;
+    for (int64_t i = begin; i < end; ++i) {
+      size_t block_begin =
+          i == 0 ? 0 : readLE64(header.block_ends + (i - 1) * sizeof(uint64_t));
+      size_t block_end = readLE64(header.block_ends + i * sizeof(uint64_t));
+      TORCH_CHECK(
+          block_begin <= block_end && block_end <= blocks_size,
+          "invalid block encoded record");
+      const char* block = header.blocks + block_begin;
+      size_t encoded_block_size = block_end - block_begin;
+      size_t block_size =
+          std::min(kCodecBlockSize, header.size - i * kCodecBlockSize);
+      char* block_out = decoded + i * kCodecBlockSize;
+      if (encoded_block_size == block_size) {
+        std::memcpy(block_out, block, block_size);
+        continue;
+      }
+      shuffled.resize(block_size);
+      size_t decompressed_size = tinfl_decompress_mem_to_mem(
+          shuffled.data(), block_size, block, encoded_block_size, 0);
+      TORCH_CHECK(
+          decompressed_size == block_size,
+          "failed to decompress block ",
+          i,
+          " of block encoded record");
+      unshuffle(shuffled.data(), block_size, header.element_size, block_out);
+    }
+  });
+}
+
+} // namespace serialize
+} // namespace caffe2
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "c10/macros/Macros.h"
+
+namespace caffe2 {
+namespace serialize {
+
+// Block codec for the compressed records of PyTorchStreamWriter.
+//
+// The data is split into blocks of kCodecBlockSize bytes which are compressed
+// independently, so that they can be compressed and decompressed in
+// parallel. Before a block is compressed, the bytes of its elements are
+// shuffled so that the first bytes of all the elements come first, then
+// their second bytes and so on. For floating point data this groups the
+// sign and exponent bytes, which are very repetitive, apart from the
+// mantissa bytes, which compresses much better than the elements do. Blocks
+// that don't get smaller are kept as they are.
+//
+// An encoded record is laid out as follows, with all integers little endian:
+//   char[8] magic "PTBLOCK1"
+//   uint64 element size
+//   uint64 decoded size
+//   uint64 number of blocks
+//   uint64 end of each block, relative to the end of this header
+//   the blocks, raw deflate streams or the original bytes
+
+constexpr size_t kCodecBlockSize = 1 << 20;
+
+// Returns data of size bytes made of elements of element_size bytes
+// encoded as described above.
+CAFFE2_API std::string encodeBlocks(
+    const void* data,
+    size_t size,
+    size_t element_size);
+
+// Returns the size of the data that was encoded into encoded.
+CAFFE2_API size_t decodedSize(const void* encoded, size_t encoded_size);
+
+// Decodes encoded into out, which must be decodedSize() bytes long.
+CAFFE2_API void decodeBlocks(
+    const void* encoded,
+    size_t encoded_size,
+    void* out);
+
+} // namespace serialize
+} // namespace caffe2
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <cerrno>
@@ -10,6 +11,7 @@
 
 #include "caffe2/core/common.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/serialize/block_codec.h"
 #include "caffe2/serialize/file_adapter.h"
 #include "caffe2/serialize/inline_container.h"
 #include "caffe2/serialize/istream_adapter.h"
@@ -166,6 +168,7 @@ static std::string getPadding(size_t cursor, const std::string& filename, size_t
 }
 
 bool PyTorchStreamReader::hasRecord(const std::string& name) {
+  std::lock_guard<std::mutex> guard(reader_lock_);
   std::stringstream ss;
   ss << archive_name_ << "/" << name;
   mz_zip_reader_locate_file(ar_.get(), ss.str().c_str(), nullptr, 0);
@@ -188,27 +191,142 @@ size_t PyTorchStreamReader::getRecordID(const std::string& name) {
   return result;
 }
 
+// the file comment that marks records written by writeBlockEncodedRecord
+static const char kBlockEncodedComment[] = "block_codec";
+
+static bool isBlockEncoded(const mz_zip_archive_file_stat& stat) {
+  return stat.m_comment_size == sizeof(kBlockEncodedComment) - 1 &&
+      memcmp(stat.m_comment, kBlockEncodedComment, stat.m_comment_size) == 0;
+}
+
+static void deleteMappedRecord(void* ctx) {
+  delete static_cast<std::shared_ptr<ReadAdapterInterface>*>(ctx);
+}
+
 // return dataptr, size
 std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getRecord(const std::string& name) {
+  std::unique_lock<std::mutex> guard(reader_lock_);
   size_t key = getRecordID(name);
   mz_zip_archive_file_stat stat;
   mz_zip_reader_file_stat(ar_.get(), key, &stat);
   valid("retrieving file meta-data");
-  void * ptr = malloc(stat.m_uncomp_size);
-  mz_zip_reader_extract_to_mem(ar_.get(), key, ptr, stat.m_uncomp_size, 0);
-  valid("reading file");
-
+  bool stored = stat.m_method == 0 && stat.m_comp_size == stat.m_uncomp_size;
+  if (stored && isBlockEncoded(stat)) {
+    return getBlockEncodedRecord(
+        name, key, stat.m_comp_size, stat.m_crc32, std::move(guard));
+  }
+  if (!stored) {
+    void* ptr = malloc(stat.m_uncomp_size);
+    mz_zip_reader_extract_to_mem(ar_.get(), key, ptr, stat.m_uncomp_size, 0);
+    valid("reading file");
+    at::DataPtr retval(ptr, ptr, free, at::kCPU);
+    return std::make_tuple(std::move(retval), stat.m_uncomp_size);
+  }
+  size_t offset = getRecordDataOffset(key);
+  if (in_->data()) {
+    // stored records of an input that stays in memory are returned in place,
+    // keeping the input alive for as long as they are. this skips the crc
+    // check, which would touch every page, so at least make sure that the
+    // record lies within the input: miniz doesn't check that the local
+    // header, whose size getRecordDataOffset adds, fits.
+    TORCH_CHECK(
+        offset <= in_->size() && stat.m_uncomp_size <= in_->size() - offset,
+        "PytorchStreamReader failed reading file: ", name,
+        " extends past the end of the archive");
+    char* ptr =
+        const_cast<char*>(static_cast<const char*>(in_->data())) + offset;
+    // records that weren't written by PyTorchStreamWriter may not be aligned
+    // well enough to hold tensor data, so those are still copied
+    if (reinterpret_cast<uintptr_t>(ptr) % kFieldAlignment == 0) {
+      at::DataPtr retval(
+          ptr,
+          new std::shared_ptr<ReadAdapterInterface>(in_),
+          deleteMappedRecord,
+          at::kCPU);
+      return std::make_tuple(std::move(retval), stat.m_uncomp_size);
+    }
+  }
+  // stored records are read directly rather than through
+  // mz_zip_reader_extract_to_mem, so that only the read itself is done under
+  // the lock and the crc of records read from several threads is checked
+  // concurrently
+  void* ptr = malloc(stat.m_uncomp_size);
   at::DataPtr retval(ptr, ptr, free, at::kCPU);
+  in_->read(offset, ptr, stat.m_uncomp_size, "reading file");
+  guard.unlock();
+  mz_ulong crc = mz_crc32(
+      MZ_CRC32_INIT, static_cast<const unsigned char*>(ptr), stat.m_uncomp_size);
+  if (crc != stat.m_crc32) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: crc check failed for ", name);
+  }
   return std::make_tuple(std::move(retval), stat.m_uncomp_size);
 }
 
+std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getBlockEncodedRecord(
+    const std::string& name,
+    size_t key,
+    size_t encoded_size,
+    uint32_t crc32,
+    std::unique_lock<std::mutex> guard) {
+  size_t offset = getRecordDataOffset(key);
+  const char* encoded = nullptr;
+  std::vector<char> buffer;
+  if (in_->data()) {
+    TORCH_CHECK(
+        offset <= in_->size() && encoded_size <= in_->size() - offset,
+        "PytorchStreamReader failed reading file: ", name,
+        " extends past the end of the archive");
+    encoded = static_cast<const char*>(in_->data()) + offset;
+  } else {
+    buffer.resize(encoded_size);
+    in_->read(offset, buffer.data(), buffer.size(), "reading file");
+    encoded = buffer.data();
+  }
+  guard.unlock();
+  // the whole record is read to decode it anyway, so the crc is always
+  // checked, also for records read in place
+  mz_ulong crc = mz_crc32(
+      MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(encoded), encoded_size);
+  if (crc != crc32) {
+    CAFFE_THROW("PytorchStreamReader failed reading file: crc check failed for ", name);
+  }
+  size_t size = decodedSize(encoded, encoded_size);
+  void* ptr = malloc(size);
+  at::DataPtr retval(ptr, ptr, free, at::kCPU);
+  decodeBlocks(encoded, encoded_size, ptr);
+  return std::make_tuple(std::move(retval), size);
+}
+
+std::vector<std::string> PyTorchStreamReader::getAllRecords() {
+  std::lock_guard<std::mutex> guard(reader_lock_);
+  mz_uint num_files = mz_zip_reader_get_num_files(ar_.get());
+  std::vector<std::string> out;
+  out.reserve(num_files);
+  const std::string prefix = archive_name_ + "/";
+  char buf[MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE];
+  for (mz_uint i = 0; i < num_files; i++) {
+    mz_zip_reader_get_filename(ar_.get(), i, buf, MZ_ZIP_MAX_ARCHIVE_FILENAME_SIZE);
+    valid("getting filename");
+    std::string name(buf);
+    if (name.compare(0, prefix.size(), prefix) == 0) {
+      out.push_back(name.substr(prefix.size()));
+    }
+  }
+  return out;
+}
+
 static int64_t read_le_16(uint8_t* buf) {
   return buf[0] + (buf[1] << 8);
 }
 
 size_t PyTorchStreamReader::getRecordOffset(const std::string& name) {
+  std::lock_guard<std::mutex> guard(reader_lock_);
+  return getRecordDataOffset(getRecordID(name));
+}
+
+size_t PyTorchStreamReader::getRecordDataOffset(size_t key) {
   mz_zip_archive_file_stat stat;
-  mz_zip_reader_file_stat(ar_.get(), getRecordID(name), &stat);
+  mz_zip_reader_file_stat(ar_.get(), key, &stat);
   valid("retriving file meta-data");
   uint8_t local_header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
   in_->read(
@@ -268,13 +386,18 @@ PyTorchStreamWriter::PyTorchStreamWriter(
 
   mz_zip_writer_init_v2(ar_.get(), 0, MZ_ZIP_FLAG_WRITE_ZIP64);
   valid("initializing archive");
-
-  std::stringstream version;
-  version << kMaxSupportedFileFormatVersion << "\n";
-  writeRecord("version", version.str().c_str(), version.str().size());
 }
 
 void PyTorchStreamWriter::writeRecord(const std::string& name, const void* data, size_t size, bool compress) {
+  writeRecord(name, data, size, compress, /*comment=*/nullptr);
+}
+
+void PyTorchStreamWriter::writeRecord(
+    const std::string& name,
+    const void* data,
+    size_t size,
+    bool compress,
+    const char* comment) {
   AT_ASSERT(!finalized_);
   std::stringstream ss;
   ss << archive_name_ << "/" << name;
@@ -286,8 +409,8 @@ void PyTorchStreamWriter::writeRecord(const std::string& name, const void* data,
       full_name.c_str(),
       data,
       size,
-      nullptr,
-      0,
+      comment,
+      comment ? strlen(comment) : 0,
       flags,
       0,
       0,
@@ -299,8 +422,24 @@ void PyTorchStreamWriter::writeRecord(const std::string& name, const void* data,
   valid("writing file");
 }
 
-void PyTorchStreamWriter::writeEndOfFile() {
+void PyTorchStreamWriter::writeBlockEncodedRecord(
+    const std::string& name,
+    const void* data,
+    size_t size,
+    size_t element_size) {
   AT_ASSERT(!finalized_);
+  std::string encoded = encodeBlocks(data, size, element_size);
+  writeRecord(
+      name, encoded.data(), encoded.size(), /*compress=*/false,
+      kBlockEncodedComment);
+  version_ = std::max(version_, kBlockEncodedFileFormatVersion);
+}
+
+void PyTorchStreamWriter::writeEndOfFile() {
+  // written last, once we know which records the archive holds
+  std::stringstream version;
+  version << version_ << "\n";
+  writeRecord("version", version.str().c_str(), version.str().size());
   finalized_ = true;
   mz_zip_writer_finalize_archive(ar_.get());
   mz_zip_writer_end(ar_.get());
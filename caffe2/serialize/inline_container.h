@@ -6,6 +6,8 @@
 #include <istream>
 #include <ostream>
 #include <fstream>
+#include <mutex>
+#include <vector>
 
 #include <c10/core/Allocator.h>
 #include <c10/core/Backend.h>
@@ -22,7 +24,8 @@ typedef struct mz_zip_archive mz_zip_archive;
 // archive_name.zip contains:
 //    archive_name/
 //        version # a file with a single decimal number written in ascii,
-//                # used to establish the version of the archive format
+//                # used to establish the version of the archive format.
+//                # written last, since it depends on the other records
 //        model.json # overall model description, this is a json output of
 //                   # ModelDef from torch.proto
 //        # the following names are by convention only, model.json will
@@ -38,7 +41,9 @@ typedef struct mz_zip_archive mz_zip_archive;
 //          archive_name_my_submodule.py # submodules have separate files
 //
 // The PyTorchStreamWriter also ensures additional useful properties for these files
-// 1. All files are stored uncompressed.
+// 1. All files are stored uncompressed, except for records written with
+//    writeBlockEncodedRecord, which are stored encoded with the block codec
+//    of block_codec.h and flagged by their file comment.
 // 2. All files in the archive are aligned to 64 byte boundaries such that
 //    it is possible to mmap the entire file and get an aligned pointer to
 //    tensor data.
@@ -51,6 +56,10 @@ typedef struct mz_zip_archive mz_zip_archive;
 // 2. It provides a getRecordOffset function which returns the offset into the
 //    raw file where file data lives. If the file was written with PyTorchStreamWriter
 //    it is guarenteed to be 64 byte aligned.
+// 3. When it reads through an adapter that keeps the whole file in memory,
+//    such as MmapFileAdapter, getRecord returns uncompressed records in place
+//    instead of copying them, so tensors loaded from a memory-mapped file
+//    share their data with the page cache.
 
 // PyTorchReader/Writer handle checking the version number on the archive format
 // and ensure that all files are written to a archive_name directory so they
@@ -90,7 +99,13 @@ namespace caffe2 {
 namespace serialize {
 
 constexpr uint64_t kMinSupportedFileFormatVersion = 0x1L;
-constexpr uint64_t kMaxSupportedFileFormatVersion = 0x1L;
+constexpr uint64_t kMaxSupportedFileFormatVersion = 0x2L;
+
+// Versions written by PyTorchStreamWriter. Files holding block-encoded
+// records get the newer one, so that older readers reject them instead of
+// returning the encoded bytes.
+constexpr uint64_t kProducedFileFormatVersion = 0x1L;
+constexpr uint64_t kBlockEncodedFileFormatVersion = 0x2L;
 
 // Writer-specific constants
 constexpr uint64_t kFieldAlignment = 64;
@@ -101,10 +116,12 @@ class CAFFE2_API PyTorchStreamReader final {
   explicit PyTorchStreamReader(std::istream* in);
   explicit PyTorchStreamReader(std::unique_ptr<ReadAdapterInterface> in);
 
-  // return dataptr, size
+  // return dataptr, size. records can be read from several threads at once.
   std::tuple<at::DataPtr, size_t> getRecord(const std::string& name);
   size_t getRecordOffset(const std::string& name);
   bool hasRecord(const std::string& name);
+  // the names of all the records in the archive, in the order they appear
+  std::vector<std::string> getAllRecords();
 
   ~PyTorchStreamReader();
 
@@ -113,12 +130,22 @@ class CAFFE2_API PyTorchStreamReader final {
   size_t read(uint64_t pos, char* buf, size_t n);
   void valid(const char* what);
   size_t getRecordID(const std::string& name);
+  size_t getRecordDataOffset(size_t key);
+  std::tuple<at::DataPtr, size_t> getBlockEncodedRecord(
+      const std::string& name,
+      size_t key,
+      size_t encoded_size,
+      uint32_t crc32,
+      std::unique_lock<std::mutex> guard);
 
   friend size_t
   istream_read_func(void* pOpaque, uint64_t file_ofs, void* pBuf, size_t n);
   std::unique_ptr<mz_zip_archive> ar_;
   std::string archive_name_;
-  std::unique_ptr<ReadAdapterInterface> in_;
+  // guards ar_ and reads from in_
+  std::mutex reader_lock_;
+  // shared with the records that are returned without copying them
+  std::shared_ptr<ReadAdapterInterface> in_;
 };
 
 class CAFFE2_API PyTorchStreamWriter final {
@@ -128,6 +155,18 @@ class CAFFE2_API PyTorchStreamWriter final {
   : PyTorchStreamWriter("archive", out) {}
 
   void writeRecord(const std::string& name, const void* data, size_t size, bool compress = false);
+  // writes data, made of elements of element_size bytes, compressed with the
+  // block codec of block_codec.h. unlike records compressed by writeRecord,
+  // these can be decompressed in parallel, and compress better when they
+  // hold floating point numbers. PyTorchStreamReader decodes them
+  // transparently, and other zip tools see them as stored files. the archive
+  // gets version kBlockEncodedFileFormatVersion.
+  void writeBlockEncodedRecord(
+      const std::string& name,
+      const void* data,
+      size_t size,
+      size_t element_size);
+  // writes the version record and the central directory
   void writeEndOfFile();
 
   bool finalized() const {
@@ -141,8 +180,15 @@ class CAFFE2_API PyTorchStreamWriter final {
   ~PyTorchStreamWriter();
 
  private:
+   void writeRecord(
+       const std::string& name,
+       const void* data,
+       size_t size,
+       bool compress,
+       const char* comment);
    void valid(const char* what);
    size_t current_pos_ = 0;
+   uint64_t version_ = kProducedFileFormatVersion;
    std::unique_ptr<mz_zip_archive> ar_;
    std::string archive_name_;
    std::ostream* out_;
@@ -1,10 +1,16 @@
 #include <cstdio>
 #include <string>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "caffe2/serialize/block_codec.h"
 #include "caffe2/serialize/inline_container.h"
+#include "caffe2/serialize/mmap_file_adapter.h"
 
 namespace caffe2 {
 namespace serialize {
@@ -42,8 +48,15 @@ TEST(PyTorchStreamWriterAndReader, SaveAndLoad) {
   ASSERT_TRUE(reader.hasRecord("key1"));
   ASSERT_TRUE(reader.hasRecord("key2"));
   ASSERT_FALSE(reader.hasRecord("key2000"));
+  ASSERT_EQ(
+      reader.getAllRecords(),
+      std::vector<std::string>({"key1", "key2", "version"}));
   at::DataPtr data_ptr;
   int64_t size;
+  std::tie(data_ptr, size) = reader.getRecord("version");
+  ASSERT_EQ(
+      std::string(static_cast<const char*>(data_ptr.get()), size),
+      std::to_string(kProducedFileFormatVersion) + "\n");
   std::tie(data_ptr, size) = reader.getRecord("key1");
   size_t off1 = reader.getRecordOffset("key1");
   ASSERT_EQ(size, data1.size());
@@ -60,6 +73,242 @@ TEST(PyTorchStreamWriterAndReader, SaveAndLoad) {
   ASSERT_EQ(memcmp(the_file.c_str() + off2, data2.data(), data2.size()), 0);
 }
 
+TEST(PyTorchStreamWriterAndReader, ConcurrentReads) {
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  std::vector<std::string> records;
+  for (int i = 0; i < 16; ++i) {
+    records.emplace_back(1000 + i, 'a' + i);
+    writer.writeRecord(std::to_string(i), records[i].data(), records[i].size());
+  }
+  writer.writeEndOfFile();
+
+  std::istringstream iss(oss.str());
+  PyTorchStreamReader reader(&iss);
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches(0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 16; ++i) {
+        at::DataPtr data_ptr;
+        size_t size;
+        std::tie(data_ptr, size) = reader.getRecord(std::to_string(i));
+        if (size != records[i].size() ||
+            memcmp(data_ptr.get(), records[i].data(), size) != 0) {
+          ++mismatches;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(mismatches, 0);
+}
+
+TEST(PyTorchStreamWriterAndReader, BlockEncodedRecords) {
+  // several blocks of floats, which compress well once shuffled
+  std::vector<float> floats(3 * kCodecBlockSize / sizeof(float) + 5);
+  for (size_t i = 0; i < floats.size(); ++i) {
+    floats[i] = static_cast<float>(i % 1000) / 8;
+  }
+  // bytes that don't compress and don't make up whole elements
+  std::vector<char> noise(kCodecBlockSize + 3);
+  uint32_t state = 1;
+  for (auto& c : noise) {
+    state = state * 1664525 + 1013904223;
+    c = static_cast<char>(state >> 24);
+  }
+
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  size_t floats_size = floats.size() * sizeof(float);
+  writer.writeBlockEncodedRecord("floats", floats.data(), floats_size, sizeof(float));
+  writer.writeBlockEncodedRecord("noise", noise.data(), noise.size(), 4);
+  writer.writeBlockEncodedRecord("empty", nullptr, 0, 4);
+  writer.writeEndOfFile();
+  std::string the_file = oss.str();
+  ASSERT_LT(the_file.size(), floats_size / 2 + noise.size() + 4096);
+
+  std::ofstream foo("output_encoded.zip", std::ofstream::binary);
+  foo.write(the_file.c_str(), the_file.size());
+  foo.close();
+
+  std::istringstream iss(the_file);
+  PyTorchStreamReader stream_reader(&iss);
+  PyTorchStreamReader mapped_reader(
+      caffe2::make_unique<MmapFileAdapter>("output_encoded.zip"));
+  for (PyTorchStreamReader* reader : {&stream_reader, &mapped_reader}) {
+    at::DataPtr data_ptr;
+    size_t size;
+    std::tie(data_ptr, size) = reader->getRecord("floats");
+    ASSERT_EQ(size, floats_size);
+    ASSERT_EQ(memcmp(data_ptr.get(), floats.data(), size), 0);
+    std::tie(data_ptr, size) = reader->getRecord("noise");
+    ASSERT_EQ(size, noise.size());
+    ASSERT_EQ(memcmp(data_ptr.get(), noise.data(), size), 0);
+    std::tie(data_ptr, size) = reader->getRecord("empty");
+    ASSERT_EQ(size, 0);
+    // so that readers that don't know the block codec reject the file
+    std::tie(data_ptr, size) = reader->getRecord("version");
+    ASSERT_EQ(
+        std::string(static_cast<const char*>(data_ptr.get()), size),
+        std::to_string(kBlockEncodedFileFormatVersion) + "\n");
+  }
+  std::remove("output_encoded.zip");
+}
+
+TEST(PyTorchStreamWriterAndReader, LoadMapped) {
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  std::array<char, 127> data1;
+  for (int i = 0; i < data1.size(); ++i) {
+    data1[i] = data1.size() - i;
+  }
+  writer.writeRecord("key1", data1.data(), data1.size());
+  writer.writeEndOfFile();
+
+  std::string the_file = oss.str();
+  std::ofstream foo("output_mapped.zip", std::ofstream::binary);
+  foo.write(the_file.c_str(), the_file.size());
+  foo.close();
+
+  at::DataPtr data_ptr;
+  int64_t size;
+  {
+    auto adapter = caffe2::make_unique<MmapFileAdapter>("output_mapped.zip");
+    const char* mapped = static_cast<const char*>(adapter->data());
+    ASSERT_EQ(adapter->size(), the_file.size());
+    PyTorchStreamReader reader(std::move(adapter));
+    std::tie(data_ptr, size) = reader.getRecord("key1");
+    // the record points into the mapping instead of a copy of it
+    ASSERT_EQ(
+        static_cast<const char*>(data_ptr.get()),
+        mapped + reader.getRecordOffset("key1"));
+  }
+  // and keeps the mapping alive after the reader is gone
+  ASSERT_EQ(size, data1.size());
+  ASSERT_EQ(memcmp(data_ptr.get(), data1.data(), data1.size()), 0);
+  data_ptr.clear();
+  std::remove("output_mapped.zip");
+}
+
+// Grows the extra field of the local header of the record whose data starts
+// at data_offset, so that the data moves past the end of the file while
+// keeping its alignment. Only the central directory is checked when opening
+// the archive, so this is only noticed when the record is read.
+void moveRecordPastEnd(std::string& the_file, size_t data_offset) {
+  const std::string signature("PK\x03\x04", 4);
+  size_t header = the_file.rfind(signature, data_offset);
+  ASSERT_NE(header, std::string::npos);
+  unsigned char* extra_size =
+      reinterpret_cast<unsigned char*>(&the_file[header + 28]);
+  size_t extra = extra_size[0] | (extra_size[1] << 8);
+  extra += (0xffff - extra) / kFieldAlignment * kFieldAlignment;
+  ASSERT_GT(header + 30 + extra, the_file.size());
+  extra_size[0] = extra & 0xff;
+  extra_size[1] = extra >> 8;
+}
+
+TEST(PyTorchStreamWriterAndReader, LoadMappedTruncated) {
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  std::array<char, 127> data1;
+  data1.fill(1);
+  writer.writeRecord("key1", data1.data(), data1.size());
+  writer.writeEndOfFile();
+
+  std::string the_file = oss.str();
+  {
+    std::istringstream iss(the_file);
+    PyTorchStreamReader reader(&iss);
+    moveRecordPastEnd(the_file, reader.getRecordOffset("key1"));
+  }
+  std::ofstream foo("output_truncated.zip", std::ofstream::binary);
+  foo.write(the_file.c_str(), the_file.size());
+  foo.close();
+
+  PyTorchStreamReader reader(
+      caffe2::make_unique<MmapFileAdapter>("output_truncated.zip"));
+  ASSERT_THROW(reader.getRecord("key1"), c10::Error);
+  std::remove("output_truncated.zip");
+}
+
+TEST(PyTorchStreamWriterAndReader, LoadMappedBlockEncodedCorrupted) {
+  // bytes that don't compress, so that the block is stored as is
+  std::vector<char> noise(4096);
+  uint32_t state = 1;
+  for (auto& c : noise) {
+    state = state * 1664525 + 1013904223;
+    c = static_cast<char>(state >> 24);
+  }
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(&oss);
+  writer.writeBlockEncodedRecord("noise", noise.data(), noise.size(), 1);
+  writer.writeEndOfFile();
+  const std::string the_file = oss.str();
+  size_t offset;
+  {
+    std::istringstream iss(the_file);
+    PyTorchStreamReader reader(&iss);
+    offset = reader.getRecordOffset("noise");
+  }
+
+  // a flipped bit in the block, which decodes fine, and a record past the
+  // end of the file
+  std::string flipped = the_file;
+  flipped[offset + 100] ^= 1;
+  std::string moved = the_file;
+  moveRecordPastEnd(moved, offset);
+  for (const std::string& corrupted : {flipped, moved}) {
+    std::ofstream foo("output_corrupted.zip", std::ofstream::binary);
+    foo.write(corrupted.c_str(), corrupted.size());
+    foo.close();
+    PyTorchStreamReader reader(
+        caffe2::make_unique<MmapFileAdapter>("output_corrupted.zip"));
+    ASSERT_THROW(reader.getRecord("noise"), c10::Error);
+  }
+  std::remove("output_corrupted.zip");
+}
+
+TEST(BlockCodec, HugeDecodedSize) {
+  // a header whose number of blocks wraps around to 0
+  std::string encoded("PTBLOCK1", 8);
+  for (uint64_t value : {uint64_t(1), ~uint64_t(0), uint64_t(0)}) {
+    for (int i = 0; i < 8; ++i) {
+      encoded.push_back(static_cast<char>(value >> (8 * i)));
+    }
+  }
+  ASSERT_THROW(decodedSize(encoded.data(), encoded.size()), c10::Error);
+}
+
+#ifdef __linux__
+TEST(MmapFileAdapter, ResidentBytes) {
+  std::string contents(1 << 24, 'a');
+  std::ofstream foo("output_resident", std::ofstream::binary);
+  foo.write(contents.c_str(), contents.size());
+  foo.close();
+
+  MmapFileAdapter adapter("output_resident");
+  // nothing is read when the file is mapped
+  ASSERT_EQ(adapter.residentBytes(), 0u);
+  const volatile char* data = static_cast<const char*>(adapter.data());
+  ASSERT_EQ(data[contents.size() / 2], 'a');
+  // only the pages around the accessed byte are read
+  const size_t resident = adapter.residentBytes();
+  ASSERT_GT(resident, 0u);
+  ASSERT_LT(resident, contents.size() / 4);
+  size_t count = 0;
+  for (size_t i = 0; i < contents.size(); ++i) {
+    count += data[i] == 'a';
+  }
+  ASSERT_EQ(count, contents.size());
+  // every page has been accessed now
+  ASSERT_EQ(adapter.residentBytes(), contents.size());
+  std::remove("output_resident");
+}
+#endif
+
 } // namespace
 } // namespace serialize
 } // namespace caffe2
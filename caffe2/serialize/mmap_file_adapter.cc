@@ -0,0 +1,83 @@
+#include "caffe2/serialize/mmap_file_adapter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <TH/THAllocator.h>
+#include <c10/util/Exception.h>
+
+namespace caffe2 {
+namespace serialize {
+
+MmapFileAdapter::MmapFileAdapter(const std::string& file_name) {
+  std::ifstream file_stream(
+      file_name, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+  if (!file_stream) {
+    AT_ERROR("open file failed, file path: ", file_name);
+  }
+  size_ = file_stream.tellg();
+  if (size_ == 0) {
+    AT_ERROR("cannot mmap an empty file, file path: ", file_name);
+  }
+  // with no flags the file is opened read-only and mapped copy-on-write
+  data_ptr_ = THMapAllocator::makeDataPtr(
+      file_name.c_str(), /*flags=*/0, size_, /*actual_size_out=*/nullptr);
+  if (!data_ptr_.get()) {
+    AT_ERROR("mmap file failed, file path: ", file_name);
+  }
+}
+
+size_t MmapFileAdapter::size() const {
+  return size_;
+}
+
+size_t MmapFileAdapter::read(uint64_t pos, void* buf, size_t n, const char* what)
+    const {
+  if (pos > size_ || n > size_ - pos) {
+    AT_ERROR("mmap file reader failed: ", what, ".");
+  }
+  std::memcpy(buf, static_cast<const char*>(data_ptr_.get()) + pos, n);
+  return n;
+}
+
+const void* MmapFileAdapter::data() const {
+  return data_ptr_.get();
+}
+
+size_t MmapFileAdapter::residentBytes() const {
+#ifdef __linux__
+  // the Rss of the mapping, which we find by its start address
+  const auto start = reinterpret_cast<uintptr_t>(data_ptr_.get());
+  std::ifstream smaps("/proc/self/smaps");
+  if (!smaps) {
+    AT_ERROR("open /proc/self/smaps failed");
+  }
+  std::string line;
+  bool in_mapping = false;
+  while (std::getline(smaps, line)) {
+    unsigned long begin = 0, end = 0;
+    if (std::sscanf(line.c_str(), "%lx-%lx ", &begin, &end) == 2) {
+      in_mapping = begin == start;
+      continue;
+    }
+    size_t rss_kb = 0;
+    if (in_mapping && std::sscanf(line.c_str(), "Rss: %zu kB", &rss_kb) == 1) {
+      // the last page counts as a whole
+      return std::min(rss_kb * 1024, size_);
+    }
+  }
+  AT_ERROR("mapped file not found in /proc/self/smaps");
+  return 0;
+#else
+  AT_ERROR("MmapFileAdapter::residentBytes() is only supported on Linux");
+#endif
+}
+
+MmapFileAdapter::~MmapFileAdapter() {}
+
+} // namespace serialize
+} // namespace caffe2
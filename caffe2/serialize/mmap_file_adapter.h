@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+
+#include <c10/core/Allocator.h>
+#include "c10/macros/Macros.h"
+#include "caffe2/serialize/read_adapter_interface.h"
+
+namespace caffe2 {
+namespace serialize {
+
+// this is a reader that maps the whole file into memory. the mapping is
+// private and copy-on-write, so pages that are only read are shared with the
+// page cache (and with every other process that maps the same file), while
+// writes to them never reach the file.
+//
+// nothing is read from the file until its pages are first accessed, so
+// loading a module through this adapter only reads the records it parses,
+// and the data of a tensor is read the first time the tensor is used.
+// residentBytes() tells how much of the file has been read so far.
+//
+// PyTorchStreamReader returns the uncompressed records of a mapped file
+// without copying them, so the file must not be truncated or rewritten while
+// any of those records are alive.
+class CAFFE2_API MmapFileAdapter final : public ReadAdapterInterface {
+ public:
+  C10_DISABLE_COPY_AND_ASSIGN(MmapFileAdapter);
+  explicit MmapFileAdapter(const std::string& file_name);
+  size_t size() const override;
+  size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
+      const override;
+  const void* data() const override;
+  // the number of bytes of the file that this mapping has in memory, i.e. its
+  // Rss. pages count once they are accessed through the mapping, or mapped
+  // along with an accessed page by the kernel's fault-around. only supported
+  // on Linux.
+  size_t residentBytes() const;
+  ~MmapFileAdapter();
+
+ private:
+  at::DataPtr data_ptr_;
+  size_t size_;
+};
+
+} // namespace serialize
+} // namespace caffe2
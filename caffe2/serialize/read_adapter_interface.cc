@@ -3,6 +3,10 @@
 namespace caffe2 {
 namespace serialize {
 
+const void* ReadAdapterInterface::data() const {
+  return nullptr;
+}
+
 ReadAdapterInterface::~ReadAdapterInterface() {}
 
 } // namespace serialize
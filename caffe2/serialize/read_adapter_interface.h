@@ -16,6 +16,9 @@ class CAFFE2_API ReadAdapterInterface {
   virtual size_t size() const = 0;
   virtual size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
       const = 0;
+  // the whole input, if it stays in memory for as long as the adapter is
+  // alive, which lets its records be used without copying them
+  virtual const void* data() const;
   virtual ~ReadAdapterInterface();
 };
 
@@ -1,10 +1,18 @@
 #include <gtest/gtest.h>
 
 #include <torch/autograd.h>
+#include <torch/csrc/autograd/engine.h>
 
 #include <torch/utils.h>
 #include <test/cpp/api/support.h>
 
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+#include <cmath>
+#include <thread>
+
 using namespace torch::autograd;
 
 #define ASSERT_VARIABLE_EQ(a,b) ASSERT_TRUE(torch::allclose((a),(b)))
@@ -124,6 +132,106 @@ TEST(AutogradAPITests, GradUnreachableTest) {
   ASSERT_FALSE(grad_res[1].defined());
 }
 
+TEST(AutogradAPITests, DiamondTest) {
+  // x feeds two branches that are joined again, so the join's gradient
+  // accumulates inputs from both before x's node becomes ready
+  Variable x = torch::randn({3, 3}, torch::requires_grad());
+  auto a = x * 2;
+  auto b = x * 3;
+  auto c = a * b;
+  backward({c.sum()}, {});
+
+  ASSERT_VARIABLE_EQ(x.grad(), x * 12);
+}
+
+TEST(AutogradAPITests, SharedSubgraphTest) {
+  // s is used by several consumers, a long chain and a wide fan-out
+  Variable x = torch::randn({4}, torch::requires_grad());
+  Variable y = torch::randn({4}, torch::requires_grad());
+  auto s = x.exp();
+  auto chain = s;
+  for (int i = 0; i < 200; i++) {
+    chain = chain * 1.01;
+  }
+  auto fan = torch::zeros({4});
+  for (int i = 1; i <= 10; i++) {
+    fan = fan + s * y * i;
+  }
+  auto out = chain + fan + s.sin();
+  backward({out.sum()}, {});
+
+  auto ds = std::pow(1.01, 200) + y * 55 + s.cos();
+  ASSERT_VARIABLE_EQ(x.grad(), ds * s);
+  ASSERT_VARIABLE_EQ(y.grad(), s * 55);
+}
+
+TEST(AutogradAPITests, ConcurrentBackwardTest) {
+  // Independent graphs run backward from several threads at once
+  const int num_threads = 4;
+  std::vector<Variable> xs;
+  for (int i = 0; i < num_threads; i++) {
+    xs.push_back(torch::randn({8}, torch::requires_grad()));
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&xs, i] {
+      for (int j = 0; j < 20; j++) {
+        auto a = xs[i] * 2;
+        auto b = xs[i] * 3;
+        backward({(a * b + a).sum()}, {});
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_threads; i++) {
+    ASSERT_VARIABLE_EQ(xs[i].grad(), (xs[i] * 12 + 2) * 20);
+  }
+}
+
+#ifdef __linux__
+size_t num_process_threads() {
+  size_t count = 0;
+  DIR* dir = opendir("/proc/self/task");
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      count++;
+    }
+  }
+  closedir(dir);
+  return count;
+}
+
+TEST(AutogradAPITests, SetNumCpuBackwardThreadsTest) {
+  // Replaced CPU backward pools must not leave their threads behind
+  auto& engine = Engine::get_default_engine();
+  Variable x = torch::randn({3, 3}, torch::requires_grad());
+  auto check_grad = [&x] {
+    auto a = x * 2;
+    auto b = x * 3;
+    auto dx = grad({(a * b).sum()}, {x});
+    ASSERT_VARIABLE_EQ(dx[0], x * 12);
+  };
+  engine.set_num_cpu_backward_threads(2);
+  check_grad();
+  const auto num_threads = num_process_threads();
+  for (int i = 0; i < 20; i++) {
+    engine.set_num_cpu_backward_threads(3);
+    check_grad();
+    ASSERT_EQ(num_process_threads(), num_threads + 1);
+    engine.set_num_cpu_backward_threads(2);
+    check_grad();
+    engine.set_num_cpu_backward_threads(2);
+    check_grad();
+    ASSERT_EQ(num_process_threads(), num_threads);
+  }
+  engine.set_num_cpu_backward_threads(0);
+  check_grad();
+  ASSERT_EQ(num_process_threads(), num_threads - 2);
+}
+#endif
+
 TEST(CustomAutogradTest, CustomFunction) {
   struct MyFunction : public Function<MyFunction> {
     static Variable forward(AutogradContext *ctx, Variable var1, int mul, Variable var2) {
@@ -12,6 +12,7 @@
 #include "torch/csrc/jit/fuser/interface.h"
 #include "torch/csrc/jit/import.h"
 #include "torch/csrc/jit/irparser.h"
+#include "torch/csrc/jit/node_hashing.h"
 #include "torch/csrc/jit/interpreter.h"
 #include "torch/csrc/jit/passes/alias_analysis.h"
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
@@ -227,6 +228,60 @@ void testRegisterFusionCachesKernel() {
   // Because the graphs are alpha-equivalent, they should return the same key
   // and therefore share a KernelSpec to share kernels for specializations
   ASSERT_EQ(second_key, expected_key);
+
+  // Graphs that only differ in a constant must not share a KernelSpec
+  const auto graph2_string = R"IR(
+    graph(%0 : Float(2, 3, 4)):
+      %1 : float = prim::Constant[value=2.]()
+      %2 : Float(2, 3, 4) = aten::mul(%0, %1)
+      return (%2))IR";
+  const auto graph3_string = R"IR(
+    graph(%0 : Float(2, 3, 4)):
+      %1 : float = prim::Constant[value=3.]()
+      %2 : Float(2, 3, 4) = aten::mul(%0, %1)
+      return (%2))IR";
+  auto g2 = std::make_shared<Graph>();
+  torch::jit::script::parseIR(graph2_string, g2.get());
+  auto g3 = std::make_shared<Graph>();
+  torch::jit::script::parseIR(graph3_string, g3.get());
+  ASSERT_EQ(HashGraph()(g2.get()), HashGraph()(g2->copy().get()));
+  ASSERT_TRUE(EqualGraph()(g2.get(), g2->copy().get()));
+  ASSERT_FALSE(EqualGraph()(g2.get(), g3.get()));
+}
+
+void testCPUFusionInProcess() {
+  const auto graph_string = R"IR(
+    graph(%0 : Tensor,
+          %1 : Tensor,
+          %2 : Tensor):
+      %3 : int = prim::Constant[value=1]()
+      %4 : Tensor = aten::sigmoid(%0)
+      %5 : Tensor = aten::mul(%4, %1)
+      %6 : Tensor = aten::tanh(%2)
+      %7 : Tensor = aten::add(%5, %6, %3)
+      %8 : float = prim::Constant[value=0.5]()
+      %9 : Tensor = aten::mul(%7, %8)
+      return (%9, %7))IR";
+  Graph graph;
+  torch::jit::script::parseIR(graph_string, &graph);
+
+  // Mixes contiguous, transposed and broadcast inputs so that the operands
+  // are compressed differently
+  auto a = at::rand({3, 17, 40});
+  auto b = at::rand({40, 17, 3}).transpose(0, 2);
+  auto c = at::rand({17, 1}).expand({3, 17, 40});
+
+  torch::jit::overrideCanFuseOnCPU(true);
+  auto code = debugGetFusedKernelCode(graph, {a, b, c});
+  auto outputs = debugLaunchGraph(graph, {a, b, c});
+  torch::jit::overrideCanFuseOnCPU(false);
+
+  // Kernels built in-process print their ElementwiseProgram instead of C++
+  testing::FileCheck().check("Sigmoid")->check("outputs:")->run(code);
+  auto expected = a.sigmoid() * b + c.tanh();
+  ASSERT_EQ(outputs.size(), 2);
+  ASSERT_TRUE(outputs[0].allclose(expected * 0.5));
+  ASSERT_TRUE(outputs[1].allclose(expected));
 }
 } // namespace jit
 } // namespace torch
@@ -1,6 +1,11 @@
 #include "test/cpp/jit/test_base.h"
 #include "test/cpp/jit/test_utils.h"
 
+#include "torch/csrc/jit/irparser.h"
+#include "torch/csrc/jit/testing/file_check.h"
+
+#include <sstream>
+
 namespace torch {
 namespace jit {
 
@@ -27,5 +32,58 @@ void testInterp() {
   ASSERT_TRUE(exactlyEqual(outputs[0], hx));
   ASSERT_TRUE(exactlyEqual(outputs[1], cx));
 }
+
+void testInterpSuperinstructions() {
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(
+      R"IR(
+graph(%a : Tensor, %b : Tensor, %n : int):
+  %true : bool = prim::Constant[value=1]()
+  %one : int = prim::Constant[value=1]()
+  %zero : int = prim::Constant[value=0]()
+  %x : Tensor, %count : int = prim::Loop(%n, %true, %a, %zero)
+    block0(%i : int, %x.1 : Tensor, %c.1 : int):
+      %y : Tensor = aten::mul(%x.1, %b)
+      %s : Tensor = aten::add(%y, %a, %one)
+      %x.2 : Tensor = aten::mul(%s, %y)
+      %c.2 : int = aten::add(%c.1, %i)
+      %cond : bool = aten::lt(%i, %n)
+      -> (%cond, %x.2, %c.2)
+  return (%x, %count)
+)IR",
+      graph.get());
+
+  auto a = at::rand({3, 4});
+  auto b = at::rand({3, 4});
+  auto expected = a;
+  for (int i = 0; i < 3; i++) {
+    auto y = expected * b;
+    expected = (y + a) * y;
+  }
+
+  bool old_mode = getInterpreterSuperinstructions();
+  for (bool enabled : {false, true}) {
+    getInterpreterSuperinstructions() = enabled;
+    Code code(graph);
+    std::stringstream ss;
+    ss << code;
+    // %y is used twice, so it is stored to a register
+    if (enabled) {
+      testing::FileCheck().check("OP_STORE")->run(ss.str());
+      testing::FileCheck().check("INT_OP")->run(ss.str());
+    } else {
+      testing::FileCheck().check_not("OP_STORE")->run(ss.str());
+      testing::FileCheck().check_not("INT_OP")->run(ss.str());
+    }
+
+    InterpreterState interp(code);
+    Stack stack = {a, b, 3};
+    interp.run(stack);
+    ASSERT_EQ(stack.size(), 2);
+    ASSERT_TRUE(almostEqual(stack[0].toTensor(), expected));
+    ASSERT_EQ(stack[1].toInt(), 0 + 1 + 2);
+  }
+  getInterpreterSuperinstructions() = old_mode;
+}
 } // namespace jit
 } // namespace torch
@@ -0,0 +1,65 @@
+#include <test/cpp/jit/test_base.h>
+#include <test/cpp/jit/test_utils.h>
+
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+namespace torch {
+namespace jit {
+
+void testMemoryPlanning() {
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(
+      R"IR(
+graph(%x : Tensor, %y : Tensor):
+  %one : int = prim::Constant[value=1]()
+  %a : Tensor = aten::mul(%x, %y)
+  %b : Tensor = aten::sigmoid(%a)
+  %c : Tensor = aten::mul(%b, %x)
+  %d : Tensor = aten::tanh(%c)
+  %e : Tensor = aten::add(%d, %a, %one)
+  return (%e))IR",
+      graph.get());
+  // as if the sizes had been profiled
+  auto type = TensorType::createContiguous(at::kFloat, at::kCPU, {16, 16})
+                  ->withRequiresGrad(false);
+  for (Value* input : graph->inputs()) {
+    input->setType(type);
+  }
+  for (Node* n : graph->nodes()) {
+    if (n->kind() != prim::Constant) {
+      n->output()->setType(type);
+    }
+  }
+  PlanMemory(graph);
+
+  // %e is an output, and %b and %d are never live at the same time
+  std::unordered_map<std::string, int64_t> offsets;
+  int64_t arena_bytes = 0;
+  for (Node* n : graph->nodes()) {
+    if (n->kind() == prim::MemoryArena) {
+      arena_bytes = n->i(attr::size);
+    } else if (n->kind() == prim::ArenaSlice) {
+      ASSERT_EQ(n->output()->uses().size(), 1);
+      const auto& name = n->output()->uses()[0].user->output()->debugName();
+      offsets[name] = n->i(Symbol::attr("offset"));
+    }
+  }
+  ASSERT_EQ(offsets.size(), 4);
+  ASSERT_EQ(offsets.count("e"), 0);
+  ASSERT_EQ(offsets.at("b"), offsets.at("d"));
+  ASSERT_EQ(arena_bytes, 3 * 16 * 16 * sizeof(float));
+
+  // the second run reuses the arena of the first one
+  Code code(graph);
+  for (int i = 0; i < 2; i++) {
+    InterpreterState interp(code);
+    auto x = autograd::make_variable(at::randn({16, 16}), false);
+    auto y = autograd::make_variable(at::randn({16, 16}), false);
+    auto outputs = run(interp, {x, y});
+    auto a = x * y;
+    ASSERT_TRUE(outputs[0].allclose(((a.sigmoid() * x).tanh() + a)));
+  }
+}
+
+} // namespace jit
+} // namespace torch
@@ -41,6 +41,8 @@
 #include "torch/csrc/utils/memory.h"
 
 #include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/profiler.h"
+#include "torch/csrc/autograd/sampling_profiler.h"
 #include "torch/csrc/autograd/variable.h"
 
 #include <torch/csrc/jit/testing/file_check.h>
@@ -52,9 +54,11 @@
 #include "onnx/onnx_pb.h"
 
 #include <c10/util/Exception.h>
+#include <c10/util/tempfile.h>
 
 #include <algorithm>
 #include <cstddef>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -811,6 +815,64 @@ void testRecordFunction() {
   autograd::profiler::popCallback();
 }
 
+void testSamplingProfiler() {
+  auto t = torch::randn({1, 2, 3}, at::kCPU);
+  auto run_test_function = [&t](int n) {
+    for (auto k = 0; k < n; k++) {
+      RECORD_FUNCTION("sampled", std::vector<c10::IValue>({t}));
+    }
+  };
+  auto find_stats = [](const std::string& name) {
+    for (const auto& stats : autograd::profiler::getSampledOpStats()) {
+      if (stats.name == name) {
+        return stats;
+      }
+    }
+    return autograd::profiler::SampledOpStats();
+  };
+
+  autograd::profiler::SamplingProfilerConfig config;
+  config.every_n_calls = 10;
+  autograd::profiler::enableSamplingProfiler(config);
+  TORCH_CHECK(autograd::profiler::isSamplingProfilerEnabled());
+  run_test_function(1000);
+  auto stats = find_stats("sampled");
+  // the first sample of this thread may come anywhere in the first period
+  TORCH_CHECK(stats.count >= 99 && stats.count <= 100);
+  TORCH_CHECK(stats.shapes.size() == 1);
+  TORCH_CHECK(stats.shapes[0] == std::vector<int64_t>({1, 2, 3}));
+  int64_t histogram_count = 0;
+  for (auto c : stats.histogram) {
+    histogram_count += c;
+  }
+  TORCH_CHECK(histogram_count == stats.count);
+  TORCH_CHECK(stats.max_ns * stats.count >= stats.total_ns);
+  autograd::profiler::disableSamplingProfiler();
+  TORCH_CHECK(!autograd::profiler::isSamplingProfilerEnabled());
+
+  // calls made while the profiler is off are not sampled
+  autograd::profiler::resetSampledOpStats();
+  run_test_function(1000);
+  TORCH_CHECK(find_stats("sampled").count == 0);
+
+  // with a timer, a thread is sampled at most once per tick
+  config.tick_period = std::chrono::microseconds(1000);
+  config.aggregation_period = std::chrono::milliseconds(10);
+  config.record_shapes = false;
+  autograd::profiler::enableSamplingProfiler(config);
+  auto start = std::chrono::steady_clock::now();
+  while (find_stats("sampled").count == 0) {
+    run_test_function(100);
+    TORCH_CHECK(
+        std::chrono::steady_clock::now() - start < std::chrono::seconds(10),
+        "no sample was taken");
+  }
+  stats = find_stats("sampled");
+  TORCH_CHECK(stats.shapes.empty());
+  autograd::profiler::disableSamplingProfiler();
+  autograd::profiler::resetSampledOpStats();
+}
+
 class TestThreadLocalDebugInfo
   : public at::ThreadLocalDebugInfoBase {
  public:
@@ -901,6 +963,40 @@ void testAutogradProfiler() {
   TORCH_CHECK(count == 200);
 }
 
+void testStreamingAutogradProfiler() {
+  auto input = torch::randn({4, 256}, at::kCPU);
+  auto hx = torch::randn({4, 512}, at::kCPU);
+  auto cx = torch::randn({4, 512}, at::kCPU);
+  auto w_ih = t_def(torch::randn({4 * 512, 256}, at::kCPU));
+  auto w_hh = t_def(torch::randn({4 * 512, 512}, at::kCPU));
+
+  auto tempfile = c10::make_tempfile();
+  {
+    autograd::profiler::StreamingRecordProfile guard(
+        tempfile.name, /* profile_memory */ true);
+    for (size_t i = 0; i < 100; ++i) {
+      std::tie(hx, cx) = lstm(input, hx, cx, w_ih, w_hh);
+    }
+  }
+
+  std::ifstream in(tempfile.name);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::string result = ss.str();
+  TORCH_CHECK(result.front() == '[');
+  TORCH_CHECK(result.substr(result.size() - 2) == "]\n");
+  auto count = [&result](const std::string& s) {
+    size_t count = 0;
+    for (size_t pos = 0; (pos = result.find(s, pos)) != std::string::npos;
+         count++, pos++) {
+    }
+    return count;
+  };
+  TORCH_CHECK(count("\"name\": \"tanh\"") == 200);
+  TORCH_CHECK(count("\"ph\": \"B\"") == count("\"ph\": \"E\""));
+  TORCH_CHECK(count("\"name\": \"[memory]\"") > 0);
+}
+
 void testNoneSchemaMatch() {
   RegisterOperators reg({
       Operator(
@@ -0,0 +1,80 @@
+#include <test/cpp/jit/test_base.h>
+#include <test/cpp/jit/test_utils.h>
+
+#include <torch/csrc/jit/passes/out_variants.h>
+
+namespace torch {
+namespace jit {
+
+void testOutVariants() {
+  auto graph = std::make_shared<Graph>();
+  script::parseIR(
+      R"IR(
+graph(%x : Tensor, %y : Tensor):
+  %one : int = prim::Constant[value=1]()
+  %a : Tensor = aten::mul(%x, %y)
+  %b : Tensor = aten::sigmoid(%a)
+  %c : Tensor = aten::add(%b, %a, %one)
+  %d : Tensor = aten::relu(%c)
+  return (%d, %a))IR",
+      graph.get());
+  auto type = TensorType::create(
+      at::kFloat,
+      at::kCPU,
+      c10::VaryingShape(2),
+      c10::VaryingShape(2),
+      /*requires_grad=*/false);
+  for (Value* input : graph->inputs()) {
+    input->setType(type);
+  }
+  for (Node* n : graph->nodes()) {
+    if (n->kind() != prim::Constant) {
+      n->output()->setType(type);
+    }
+  }
+  UseOutVariants(graph);
+  // relu has no out= overload
+  testing::FileCheck()
+      .check_count("prim::OutBuffer", 3, /*exactly*/ true)
+      ->check("aten::relu")
+      ->run(*graph);
+
+  // %a is returned, so its buffer can't be reused while the result of the
+  // previous run is alive
+  Code code(graph);
+  std::vector<at::Tensor> previous;
+  at::Tensor previous_a;
+  for (int64_t size : {8, 8, 16}) {
+    InterpreterState interp(code);
+    auto x = autograd::make_variable(at::randn({size, size}), false);
+    auto y = autograd::make_variable(at::randn({size, size}), false);
+    auto outputs = run(interp, {x, y});
+    auto a = x * y;
+    ASSERT_TRUE(outputs[0].allclose((a.sigmoid() + a).relu()));
+    ASSERT_TRUE(outputs[1].allclose(a));
+    if (!previous.empty()) {
+      ASSERT_TRUE(previous[1].allclose(previous_a));
+    }
+    previous = outputs;
+    previous_a = a;
+  }
+  previous.clear();
+
+  // Once the caller drops the results of a run, the next run of the same
+  // size writes %a into the same buffer again
+  auto run_once = [&code]() {
+    InterpreterState interp(code);
+    auto x = autograd::make_variable(at::randn({8, 8}), false);
+    auto y = autograd::make_variable(at::randn({8, 8}), false);
+    return run(interp, {x, y});
+  };
+  void* a_ptr = run_once()[1].data_ptr();
+  auto outputs = run_once();
+  ASSERT_EQ(outputs[1].data_ptr(), a_ptr);
+  // but not while the caller still holds the previous result
+  auto next_outputs = run_once();
+  ASSERT_NE(next_outputs[1].data_ptr(), outputs[1].data_ptr());
+}
+
+} // namespace jit
+} // namespace torch
@@ -27,6 +27,7 @@ namespace jit {
   _(PassManagement)                    \
   _(Proto)                             \
   _(RegisterFusionCachesKernel)        \
+  _(CPUFusionInProcess)                \
   _(SchemaParser)                      \
   _(TopologicalIndex)                  \
   _(TopologicalMove)                   \
@@ -48,8 +49,12 @@ namespace jit {
   _(Profiler)                          \
   _(InsertAndEliminateRedundantGuards) \
   _(InsertBailOuts)                    \
+  _(MemoryPlanning)                    \
+  _(OutVariants)                       \
   _(PeepholeOptimize)                  \
   _(RecordFunction)                    \
+  _(SamplingProfiler)                  \
+  _(StreamingAutogradProfiler)         \
   _(ThreadLocalDebugInfo)              \
   _(SubgraphMatching)                  \
   _(ModuleDefine)                      \
@@ -62,7 +67,8 @@ namespace jit {
   _(CustomFusionNestedBlocks)          \
   _(ImportTooNew)                      \
   _(ClassDerive)                       \
-  _(Inliner)
+  _(Inliner)                           \
+  _(InterpSuperinstructions)
 
 #define TH_FORALL_TESTS_CUDA(_) \
   _(ArgumentSpec)               \
@@ -2408,6 +2408,44 @@ class TestAutograd(TestCase):
         out.sum().backward()
         self.assertEqual(x.grad.data, y_data)
 
+    def test_parallel_cpu_backward(self):
+        y_data = torch.randn(4, 4)
+
+        class Reenter(Function):
+            @staticmethod
+            def forward(ctx, x):
+                with torch.enable_grad():
+                    ctx.x = Variable(x.data, requires_grad=True)
+                    ctx.output_var = ctx.x * y_data
+                return ctx.output_var.detach()
+
+            @staticmethod
+            def backward(ctx, grad_output):
+                with torch.enable_grad():
+                    ctx.output_var.sum().backward()
+                return ctx.x.grad * grad_output
+
+        def run():
+            x = torch.randn(4, 4, requires_grad=True)
+            w = torch.randn(4, 4, requires_grad=True)
+            # independent branches that meet in the sum
+            branches = [(x * w).sin() * i for i in range(16)]
+            branches.append(Reenter.apply(x))
+            sum(branches).sum().backward()
+            return x, w
+
+        torch.manual_seed(0)
+        x_ref, w_ref = run()
+        torch.autograd._set_num_cpu_backward_threads(4)
+        try:
+            for _ in range(5):
+                torch.manual_seed(0)
+                x, w = run()
+                self.assertEqual(x.grad, x_ref.grad)
+                self.assertEqual(w.grad, w_ref.grad)
+        finally:
+            torch.autograd._set_num_cpu_backward_threads(0)
+
     def test_broadcast_tensors(self):
         f_args_variable = (torch.randn(3, requires_grad=True),
                            torch.randn(1, 2, 1, requires_grad=True),
@@ -2857,6 +2895,21 @@ class TestAutograd(TestCase):
         print(prof.table())
         print(prof.key_averages(group_by_input_shape=True).table())
 
+    def test_profiler_memory(self):
+        x = torch.randn(1000)
+        with profile(profile_memory=True) as p:
+            y = torch.ones(1000)
+            z = x + y
+            del z
+
+        # y and z were allocated inside ops; z was freed outside of any op
+        total = sum(evt.cpu_memory_usage for evt in p.function_events)
+        self.assertGreaterEqual(total, 2 * 1000 * 4)
+
+        with profile() as p:
+            y = torch.ones(1000)
+        self.assertTrue(all(evt.cpu_memory_usage == 0 for evt in p.function_events))
+
     def test_profiler_aggregation_lstm(self):
         print("")
         rnn = torch.nn.LSTM(10, 20, 2)
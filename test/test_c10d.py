@@ -209,6 +209,29 @@ class StoreTestBase(object):
     def test_set_get(self):
         self._test_set_get(self._create_store())
 
+    def _test_multi_set_get(self, fs):
+        fs.multi_set(["key0", "key1", "key2"], ["value0", "value1", "value2"])
+        fs.set("key3", "value3")
+        self.assertEqual(
+            [b"value2", b"value3", b"value0"],
+            fs.multi_get(["key2", "key3", "key0"]))
+        self.assertEqual(b"value1", fs.get("key1"))
+        self.assertEqual([], fs.multi_get([]))
+
+    def test_multi_set_get(self):
+        self._test_multi_set_get(self._create_store())
+
+    def _test_compare_set(self, fs):
+        # A missing key is only set if no value is expected
+        self.assertEqual(b"value0", fs.compare_set("key", "value0", "value1"))
+        self.assertEqual(b"value0", fs.compare_set("key", "", "value0"))
+        self.assertEqual(b"value0", fs.compare_set("key", "value1", "value2"))
+        self.assertEqual(b"value2", fs.compare_set("key", "value0", "value2"))
+        self.assertEqual(b"value2", fs.get("key"))
+
+    def test_compare_set(self):
+        self._test_compare_set(self._create_store())
+
 
 class FileStoreTest(TestCase, StoreTestBase):
     def setUp(self):
@@ -1750,8 +1773,9 @@ class DistributedDataParallelTest(MultiProcessTestCase):
     def world_size(self):
         return 2
 
-    def _prepare_single_device_module(self, process_group, devices, device_ids, global_batch_size):
-        model = Net()
+    def _prepare_single_device_module(self, process_group, devices, device_ids, global_batch_size, model=None):
+        if model is None:
+            model = Net()
         ddp_model = DistributedDataParallel(
             copy.deepcopy(model).to(devices[0]),
             device_ids=device_ids,
@@ -1876,6 +1900,82 @@ class DistributedDataParallelTest(MultiProcessTestCase):
         devices = list([torch.device('cuda:' + str(i)) for i in int_devices])
         self._test_gloo_backend(devices, [], multi_device=True)
 
+    def _test_gloo_comm_hook(self, create_hook, prec=None, model=None):
+        """
+        Trains a model (`Net` by default) with DDP and the specified
+        communication hook, and checks that the gradients are identical across
+        processes. If `prec` is specified, also checks that the parameters are
+        within `prec` of those of a model trained on the global batch without
+        DDP.
+        """
+        store = c10d.FileStore(self.file.name, self.world_size)
+        options = c10d.ProcessGroupGloo.Options()
+        options.devices = [c10d.ProcessGroupGloo.create_device(interface=LOOPBACK)]
+        process_group = c10d.ProcessGroupGloo(store, self.rank, self.world_size, options)
+
+        torch.manual_seed(1337)
+        model, ddp_model, input, target = self._prepare_single_device_module(
+            process_group, [torch.device('cpu')], [], self.world_size, model)
+        ddp_model.register_comm_hook(create_hook(process_group))
+
+        for _ in range(3):
+            F.mse_loss(model(input), target).backward()
+            F.mse_loss(
+                ddp_model(input[self.rank:self.rank + 1]),
+                target[self.rank:self.rank + 1]).backward()
+
+            for param in ddp_model.parameters():
+                gathered = [torch.empty_like(param.grad) for _ in range(self.world_size)]
+                process_group.allgather([gathered], [param.grad]).wait()
+                self.assertEqual(gathered[0], gathered[1], prec=0)
+
+            for param in model.parameters():
+                param.data -= param.grad
+                param.grad = None
+            for param in ddp_model.parameters():
+                param.data -= param.grad
+                param.grad = None
+
+            if prec is not None:
+                for i, j in zip(model.parameters(), ddp_model.parameters()):
+                    self.assertEqual(i, j, prec=prec)
+
+    @requires_gloo()
+    def test_gloo_fp16_compression_hook(self):
+        self._test_gloo_comm_hook(
+            lambda pg: c10d.FP16CompressionHook(pg), prec=1e-3)
+
+    @requires_gloo()
+    def test_gloo_top_k_sparsification_hook(self):
+        self._test_gloo_comm_hook(
+            lambda pg: c10d.TopKSparsificationHook(pg, ratio=0.1))
+
+    @requires_gloo()
+    def test_gloo_top_k_sparsification_hook_send_all(self):
+        # Sending everything is the same as not sparsifying
+        self._test_gloo_comm_hook(
+            lambda pg: c10d.TopKSparsificationHook(pg, ratio=1.0), prec=1e-5)
+
+    @requires_gloo()
+    def test_gloo_powersgd_hook(self):
+        self._test_gloo_comm_hook(lambda pg: c10d.PowerSGDHook(pg, rank=1))
+
+    @requires_gloo()
+    def test_gloo_powersgd_hook_exact(self):
+        # The gradient of a single weight is approximated exactly, so training
+        # only matches the model without DDP if the residuals of the processes
+        # add up to zero.
+        class ScaleNet(nn.Module):
+            def __init__(self):
+                super(ScaleNet, self).__init__()
+                self.weight = nn.Parameter(torch.ones(1))
+
+            def forward(self, x):
+                return x.sum(dim=1, keepdim=True).expand(-1, 4) * self.weight * 0.1
+
+        self._test_gloo_comm_hook(
+            lambda pg: c10d.PowerSGDHook(pg, rank=1), prec=1e-5, model=ScaleNet())
+
     def _test_nccl_backend(self, devices, device_ids, multi_device=False):
         store = c10d.FileStore(self.file.name, self.world_size)
         process_group = c10d.ProcessGroupNCCL(store, self.rank, self.world_size)
@@ -2854,6 +2954,56 @@ class ReducerTest(TestCase):
             output.backward()
             optimizer.step()
 
+    def test_rebuild_buckets(self):
+        batch_size = 10
+        model = ReducerModule()
+        reference = copy.deepcopy(model)
+        parameters = list(model.parameters())
+
+        # Record the order in which gradients become ready, which is the
+        # reverse of the order of these buckets.
+        ready_order = []
+        for i, parameter in enumerate(parameters):
+            parameter.register_hook(lambda grad, i=i: ready_order.append(i))
+        reducer = dist.Reducer(
+            [parameters],
+            [[i] for i in range(len(parameters))],
+            self.process_group)
+        reducer.enable_bucket_rebuilding([1, 1024])
+        loss = nn.CrossEntropyLoss()
+        for iteration in range(3):
+            input = torch.rand([batch_size, 2])
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            model.zero_grad()
+            reference.zero_grad()
+            output = loss(model(input), target)
+            reducer.prepare_for_backward(output)
+
+            # The buckets are rebuilt by the first prepare_for_backward
+            # after a backward pass, in the order of that pass.
+            bucket_indices = reducer.get_bucket_indices()
+            if iteration == 0:
+                self.assertEqual(
+                    bucket_indices, [[i] for i in range(len(parameters))])
+            else:
+                self.assertEqual(
+                    [i for bucket in bucket_indices for i in bucket],
+                    ready_order[:len(parameters)])
+                self.assertEqual(bucket_indices[0], [ready_order[0]])
+            output.backward()
+            loss(reference(input), target).backward()
+
+            # A single process reduces gradients to themselves.
+            for i, j in zip(model.parameters(), reference.parameters()):
+                self.assertEqual(i.grad, j.grad)
+
+            stats = reducer.get_bucket_wait_stats()
+            self.assertEqual(len(stats), len(bucket_indices))
+            for ready_wait_time, work_wait_time in stats:
+                self.assertGreaterEqual(ready_wait_time, 0)
+                self.assertGreaterEqual(work_wait_time, 0)
+        self.assertEqual(ready_order[:len(parameters)], [2, 1, 0])
+
 
 class ComputeBucketAssignmentTest(TestCase):
     def test_single_limit_single_dtype(self):
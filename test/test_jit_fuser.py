@@ -3,6 +3,11 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
 import unittest
 import torch
 import torch.nn as nn
@@ -524,6 +529,76 @@ class TestFuser(JitTestCase):
         # check that a, b share storage, i.e. were generated as a single output in the fuser
         self.assertEqual(ga.data_ptr(), gb.data_ptr())
 
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser CPU support for Windows or Sandcastle")
+    def test_cpu_kernel_disk_cache(self):
+        script = dedent('''
+            import torch
+            torch._C._jit_override_can_fuse_on_cpu(True)
+
+            @torch.jit.script
+            def f(x, y):
+                return (x * y + x).sigmoid()
+
+            x = torch.randn(4, 4)
+            y = torch.randn(4, 4)
+            for _ in range(3):
+                out = f(x, y)
+            assert torch.allclose(out, (x * y + x).sigmoid())
+        ''')
+        cache_dir = tempfile.mkdtemp()
+        try:
+            env = dict(os.environ)
+            env['PYTORCH_FUSION_CACHE_DIR'] = cache_dir
+            env['PYTORCH_FUSION_CPU_CODEGEN'] = '1'
+
+            def run_and_list_cache():
+                subprocess.check_call([sys.executable, '-c', script], env=env)
+                return {name: os.path.getmtime(os.path.join(cache_dir, name))
+                        for name in os.listdir(cache_dir) if not name.endswith('.lock')}
+
+            first = run_and_list_cache()
+            self.assertEqual(sorted(os.path.splitext(name)[1] for name in first), ['.key', '.so'])
+            # The second process loads the kernel instead of compiling it again
+            self.assertEqual(run_and_list_cache(), first)
+        finally:
+            shutil.rmtree(cache_dir)
+
+    @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser CPU support for Windows or Sandcastle")
+    @enable_cpu_fuser
+    def test_reductions_cpu(self):
+        def layer_norm(x, w, b):
+            mu = x.mean(-1, keepdim=True)
+            xc = x - mu
+            var = (xc * xc).mean(-1, keepdim=True)
+            return xc * torch.rsqrt(var + 1e-5) * w + b
+
+        def softmax(x, m):
+            e = (x - m).exp()
+            return e / e.sum(-1, keepdim=True)
+
+        def dot(x, y):
+            return (x * y).sum(dim=1)
+
+        def sum_and_map(x, y):
+            z = x * y
+            return z.sigmoid(), z.sum(-1, keepdim=True) * 2
+
+        # rows that are not a multiple of the accumulation lanes, and inputs
+        # that are transposed or broadcast
+        x = torch.randn(37, 129)
+        y = torch.randn(129, 37).t()
+        w = torch.randn(129)
+        m = torch.randn(37, 1)
+        for fn, args in [(layer_norm, (x, w, w)),
+                         (softmax, (x, m)),
+                         (dot, (x, y)),
+                         (sum_and_map, (x, y))]:
+            s = self.checkScript(fn, args)
+            graph = s.graph_for(*args)
+            self.assertAllFused(graph)
+            subgraph = next(n for n in graph.nodes() if n.kind() == 'prim::FusionGroup').g('Subgraph')
+            self.assertTrue(any(n.kind() in ('aten::sum', 'aten::mean') for n in subgraph.nodes()))
+
     @unittest.skipIf(IS_WINDOWS or IS_SANDCASTLE, "NYI: fuser CPU support for Windows or Sandcastle")
     @enable_cpu_fuser
     @unittest.skip("temporarily disabled because fusion was restricted in fixing #22833")
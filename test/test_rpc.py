@@ -7,6 +7,7 @@ import unittest
 import torch
 import torch.distributed as dist
 
+from common_cuda import TEST_CUDA
 from common_distributed import MultiProcessTestCase
 from common_utils import load_tests, run_tests
 
@@ -203,6 +204,23 @@ class RpcTest(MultiProcessTestCase):
         ret = dist.rpc("worker{}".format(dst_rank), torch.nonzero, args=(x,))
         self.assertEqual(ret, x.nonzero())
 
+    @_wrap_with_rpc
+    def test_sparse_tensor_rejected(self):
+        dst_rank = (self.rank + 1) % self.world_size
+        x = torch.eye(2).to_sparse()
+        with self.assertRaisesRegex(RuntimeError, "can only send dense tensors"):
+            dist.rpc("worker{}".format(dst_rank), torch.add, args=(x, x))
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA not available")
+    @_wrap_with_rpc
+    def test_cuda_add(self):
+        n = self.rank + 1
+        dst_rank = n % self.world_size
+        x = torch.ones(n, n, device="cuda")
+        ret = dist.rpc("worker{}".format(dst_rank), torch.add, args=(x, x))
+        self.assertEqual(ret.device, x.device)
+        self.assertEqual(ret, x * 2)
+
     @_wrap_with_rpc
     def test_multi_rpc(self):
         dst_rank = (self.rank + 1) % self.world_size
@@ -175,6 +175,14 @@ def _is_checkpoint_valid():
     return Variable._execution_engine.is_checkpoint_valid()
 
 
+# Opt-in parallel execution of CPU nodes during backward. By default the CPU
+# nodes of a backward pass run one after another on a single engine thread.
+# With num_threads > 0, nodes of independent branches of the graph run
+# concurrently on a pool of num_threads threads. Passing 0 turns it off again.
+def _set_num_cpu_backward_threads(num_threads):
+    Variable._execution_engine.set_num_cpu_backward_threads(num_threads)
+
+
 def variable(*args, **kwargs):
     warnings.warn("torch.autograd.variable(...) is deprecated, use torch.tensor(...) instead")
     return torch.tensor(*args, **kwargs)
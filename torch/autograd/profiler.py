@@ -212,6 +212,11 @@ class profile(object):
             self cpu time might be artificially increased because of the shape
             collection.
 
+        profile_memory (bool, optional): Track the memory allocated and freed by
+            the CPU allocator. Each function event reports the memory its own
+            code allocated minus the memory it freed as ``cpu_memory_usage``
+            (excluding its children). Default: ``False``.
+
     .. warning:
         This context managers should not be called recursively, i.e. at most one
         instance should be enabled at any given time.
@@ -235,7 +240,8 @@ class profile(object):
         -----------------------------------  ---------------  ---------------  ---------------
 
     """
-    def __init__(self, enabled=True, use_cuda=False, record_shapes=False):
+    def __init__(self, enabled=True, use_cuda=False, record_shapes=False,
+                 profile_memory=False):
         self.enabled = enabled
         self.use_cuda = use_cuda
         self.function_events = None
@@ -243,6 +249,7 @@ class profile(object):
             return
         self.entered = False
         self.record_shapes = record_shapes
+        self.profile_memory = profile_memory
 
     def __enter__(self):
         if not self.enabled:
@@ -253,7 +260,8 @@ class profile(object):
         profiler_kind = torch.autograd.ProfilerState.CUDA if self.use_cuda \
             else torch.autograd.ProfilerState.CPU
         torch.autograd._enable_profiler(
-            torch.autograd.ProfilerConfig(profiler_kind, self.record_shapes))
+            torch.autograd.ProfilerConfig(
+                profiler_kind, self.record_shapes, self.profile_memory))
         return self
 
     def __exit__(self, exc_type, exc_val, exc_tb):
@@ -537,6 +545,7 @@ class FunctionEvent(FormattedTimesMixin):
         self.count = 1
         self.cpu_children = []
         self.input_shapes = input_shapes
+        self.cpu_memory_usage = 0
 
     def append_kernel(self, name, device, start, end):
         self.kernels.append(Kernel(name, device, Interval(start, end)))
@@ -593,6 +602,7 @@ class FunctionEventAvg(FormattedTimesMixin):
         self.cpu_time_total = 0
         self.cuda_time_total = 0
         self.self_cpu_time_total = 0
+        self.cpu_memory_usage = 0
         self.input_shapes = None
 
     def add(self, other, group_by_input_shapes=False):
@@ -610,6 +620,7 @@ class FunctionEventAvg(FormattedTimesMixin):
         self.cpu_time_total += other.cpu_time
         self.cuda_time_total += other.cuda_time
         self.self_cpu_time_total += other.self_cpu_time_total
+        self.cpu_memory_usage += other.cpu_memory_usage
         self.count += 1
         return self
 
@@ -669,10 +680,14 @@ def parse_cpu_trace(thread_records):
         if record.kind() == 'mark':
             continue
         elif record.kind() == 'push':
-            record_stack.append((next_id, record))
+            record_stack.append((next_id, record, [0]))
             next_id += 1
+        elif record.kind() == 'memory_alloc':
+            # attributed to the innermost function running on this thread
+            if record_stack and record_stack[-1][1].thread_id() == record.thread_id():
+                record_stack[-1][2][0] += record.cpu_memory_usage()
         elif record.kind() == 'pop':
-            function_id, start = record_stack.pop()
+            function_id, start, memory_usage = record_stack.pop()
             fe = FunctionEvent(
                 id=function_id,
                 name=string_table[start.name()],
@@ -680,6 +695,7 @@ def parse_cpu_trace(thread_records):
                 cpu_start=start_record.cpu_elapsed_us(start),
                 cpu_end=start_record.cpu_elapsed_us(record),
                 input_shapes=start.shapes())
+            fe.cpu_memory_usage = memory_usage[0]
             if start.has_cuda():
                 cuda_start = adjusted_time(start)
                 cuda_end = adjusted_time(record)
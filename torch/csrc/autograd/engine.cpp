@@ -1,6 +1,7 @@
 #include <torch/csrc/autograd/engine.h>
 
 #include <torch/csrc/autograd/function.h>
+#include <torch/csrc/autograd/functions/accumulate_grad.h>
 #include <torch/csrc/autograd/functions/basic_ops.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/autograd/anomaly_mode.h>
@@ -57,6 +58,10 @@ static thread_local int current_depth = 0;
 // Total nested reentrant backwards calls over all threads for workder_device
 static thread_local int total_depth = 0;
 
+// True on the threads of the pool set up by
+// Engine::set_num_cpu_backward_threads
+static thread_local bool in_cpu_backward_pool = false;
+
 struct NodeTask {
   GraphTask* base_;
   std::shared_ptr<Node> fn_;
@@ -101,10 +106,16 @@ struct ReadyQueue {
   std::condition_variable not_empty_;
   // To protect read and writes to heap_
   std::mutex mutex_;
+  // Number of tasks in heap_. Written under mutex_, but can be read without
+  // it to check whether the queue is empty.
+  std::atomic<size_t> size_{0};
 
   void push(NodeTask item);
   void pushShutdownTask();
   NodeTask pop();
+  bool empty() const {
+    return size_.load(std::memory_order_relaxed) == 0;
+  }
 };
 
 // Note [Reentrant backwards]
@@ -148,14 +159,24 @@ struct GraphTask {
   bool keep_graph_;
   bool grad_mode_;
 
-  // To protect reads/writes to no_ready_, dependencies_ , captured_vars_ and
-  // exception_
+  // To protect reads/writes to not_ready_, captured_vars_ and exception_
   std::mutex mutex_;
   // Notified when a task finishes executing.  Check outstanding_tasks_ to see
   // if all tasks are done.
   std::condition_variable not_done_;
   std::unordered_map<Node*, InputBuffer> not_ready_;
-  std::unordered_map<Node*, int> dependencies_;
+
+  struct Dependencies {
+    // Number of edges leading to the node
+    int total_ = 0;
+    // Number of those edges that have not delivered a gradient yet
+    std::atomic<int> remaining_{0};
+  };
+  // Filled in by compute_dependencies before execution starts. Afterwards
+  // only the remaining_ counts change, so lookups need no lock. Nodes with a
+  // single incoming edge never touch not_ready_, and their inputs are handed
+  // over without taking mutex_.
+  std::unordered_map<Node*, Dependencies> dependencies_;
 
   struct ExecInfo {
     struct Capture {
@@ -190,6 +211,11 @@ struct GraphTask {
   int owner_;
   // The number of parent graph tasks for this graph task
   const int reentrant_depth_;
+  // The CPU backward pool CPU nodes may run on, if any. Holding it keeps a
+  // pool that has since been replaced alive until this task is done. Unset
+  // for backward calls made from the pool itself: those block a pool thread,
+  // so their own nodes must not wait for one.
+  std::shared_ptr<c10::ThreadPool> cpu_pool_;
 
   bool can_checkpoint() {
     return exec_info_.empty();
@@ -214,6 +240,7 @@ auto ReadyQueue::push(NodeTask item) -> void {
     std::lock_guard<std::mutex> lock(mutex_);
     ++item.base_->outstanding_tasks_;
     heap_.push(std::move(item));
+    size_.store(heap_.size(), std::memory_order_relaxed);
   }
   not_empty_.notify_one();
 }
@@ -222,6 +249,7 @@ auto ReadyQueue::pushShutdownTask() -> void {
   {
     std::lock_guard<std::mutex> lock(mutex_);
     heap_.push(NodeTask(nullptr, nullptr, InputBuffer(0), true));
+    size_.store(heap_.size(), std::memory_order_relaxed);
   }
   not_empty_.notify_one();
 }
@@ -232,6 +260,7 @@ auto ReadyQueue::pop() -> NodeTask {
   not_empty_.wait(lock, [this]{ return !heap_.empty(); });
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
   auto task = std::move(const_cast<NodeTask&>(heap_.top())); heap_.pop();
+  size_.store(heap_.size(), std::memory_order_relaxed);
   return task;
 }
 
@@ -324,42 +353,7 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
       C10_LOG_API_USAGE_ONCE("torch.autograd.thread_shutdown");
       break;
     }
-    if (task.fn_ && !task.base_->has_error_.load()) {
-      GradMode::set_enabled(task.base_->grad_mode_);
-      try {
-        evaluate_function(task);
-      } catch (std::exception& e) {
-        thread_on_exception(task, e);
-      }
-    }
-    // Notify downstream about the completion of tasks depending
-    // on both where the task was executed, and who owned the overall
-    // graph (in case of reentrant execution.)  See Note [Reentrant backwards].
-    auto base_owner = task.base_->owner_;
-    // Task from a non-worker thread. Easy case.
-    if (base_owner == NO_DEVICE) {
-      if (--task.base_->outstanding_tasks_ == 0) {
-        // Lock mutex to notify the GraphTask waiting on not_done_
-        std::lock_guard<std::mutex> lock(task.base_->mutex_);
-        task.base_->not_done_.notify_all();
-      }
-    } else {
-      // If it's a task initiated from this thread, decrease the counter, but
-      // don't do anything - loop condition will do all checks for us next.
-      if (base_owner == worker_device) {
-        --task.base_->outstanding_tasks_;
-      // Otherwise send a dummy function task to the owning thread just to
-      // ensure that it's not sleeping. If it has work, it might see that
-      // graph_task->outstanding_tasks_ == 0 before it gets to the task, but
-      // it's a no-op anyway.
-      } else if (base_owner != worker_device) {
-        if (--task.base_->outstanding_tasks_ == 0) {
-          // Synchronize outstanding_tasks_ with queue mutex
-          std::atomic_thread_fence(std::memory_order_release);
-          ready_queue_by_index(base_owner).push(NodeTask(task.base_, nullptr, InputBuffer(0)));
-        }
-      }
-    }
+    run_task(std::move(task));
   }
 
   // When current_depth is 0 this worker thread is done and we need to notify
@@ -373,6 +367,93 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
   }
 }
 
+void Engine::run_task(NodeTask task) {
+  // evaluate_function may hand back a child that became ready so that we run
+  // it right away instead of going through the queue; it is accounted for in
+  // outstanding_tasks_ like a queued task.
+  while (true) {
+    c10::optional<NodeTask> next;
+    if (task.fn_ && !task.base_->has_error_.load()) {
+      GradMode::set_enabled(task.base_->grad_mode_);
+      try {
+        evaluate_function(task, &next);
+      } catch (std::exception& e) {
+        thread_on_exception(task, e);
+      }
+    }
+    finish_task(task);
+    if (!next) {
+      break;
+    }
+    task = std::move(*next);
+  }
+}
+
+void Engine::run_on_cpu_pool(c10::ThreadPool& pool, NodeTask task) {
+  // counted like a task pushed to a ReadyQueue
+  ++task.base_->outstanding_tasks_;
+  // std::function needs a copyable callable
+  auto shared_task = std::make_shared<NodeTask>(std::move(task));
+  pool.run([this, shared_task]() { run_task(std::move(*shared_task)); });
+}
+
+void Engine::set_num_cpu_backward_threads(size_t num_threads) {
+  std::shared_ptr<c10::ThreadPool> old_pool;
+  {
+    std::lock_guard<std::mutex> lock(cpu_pool_mutex_);
+    size_t current = cpu_pool_ ? cpu_pool_->size() : 0;
+    if (num_threads == current) {
+      return;
+    }
+    old_pool = std::move(cpu_pool_);
+    if (num_threads > 0) {
+      cpu_pool_ = std::make_shared<c10::ThreadPool>(
+          static_cast<int>(num_threads), -1, []() {
+            at::init_num_threads();
+            in_cpu_backward_pool = true;
+          });
+    }
+  }
+  // The old pool is joined here, or by the last graph task still using it
+  // once that is done, outside of cpu_pool_mutex_.
+}
+
+std::shared_ptr<c10::ThreadPool> Engine::cpu_pool() {
+  std::lock_guard<std::mutex> lock(cpu_pool_mutex_);
+  return cpu_pool_;
+}
+
+void Engine::finish_task(NodeTask& task) {
+  // Notify downstream about the completion of tasks depending
+  // on both where the task was executed, and who owned the overall
+  // graph (in case of reentrant execution.)  See Note [Reentrant backwards].
+  auto base_owner = task.base_->owner_;
+  // Task from a non-worker thread. Easy case.
+  if (base_owner == NO_DEVICE) {
+    if (--task.base_->outstanding_tasks_ == 0) {
+      // Lock mutex to notify the GraphTask waiting on not_done_
+      std::lock_guard<std::mutex> lock(task.base_->mutex_);
+      task.base_->not_done_.notify_all();
+    }
+  } else {
+    // If it's a task initiated from this thread, decrease the counter, but
+    // don't do anything - loop condition will do all checks for us next.
+    if (base_owner == worker_device) {
+      --task.base_->outstanding_tasks_;
+    // Otherwise send a dummy function task to the owning thread just to
+    // ensure that it's not sleeping. If it has work, it might see that
+    // graph_task->outstanding_tasks_ == 0 before it gets to the task, but
+    // it's a no-op anyway.
+    } else if (base_owner != worker_device) {
+      if (--task.base_->outstanding_tasks_ == 0) {
+        // Synchronize outstanding_tasks_ with queue mutex
+        std::atomic_thread_fence(std::memory_order_release);
+        ready_queue_by_index(base_owner).push(NodeTask(task.base_, nullptr, InputBuffer(0)));
+      }
+    }
+  }
+}
+
 void Engine::reentrant_thread_init() {
   at::init_num_threads();
   auto tp_shared= thread_pool_shared_;
@@ -526,7 +607,7 @@ static variable_list call_function(NodeTask& task) {
   return outputs;
 }
 
-auto Engine::evaluate_function(NodeTask& task) -> void {
+auto Engine::evaluate_function(NodeTask& task, c10::optional<NodeTask>* next_task) -> void {
   // If exec_info_ is not empty, we have to instrument the execution
   auto & exec_info_ = task.base_->exec_info_;
   if (!exec_info_.empty()) {
@@ -564,42 +645,109 @@ auto Engine::evaluate_function(NodeTask& task) -> void {
     }
   }
 
-  // Lock mutex for the accesses to GraphTask dependencies_ and not_ready_ below
-  std::lock_guard<std::mutex> lock(task.base_->mutex_);
+  // A child that is ready and belongs on this thread's own queue is returned
+  // through next_task instead of being queued, as long as that queue is empty
+  // (so no other work is overtaken). If several children qualify, the one the
+  // queue would have picked first is kept.
+  //
+  // With the CPU backward pool enabled, other ready CPU children go to the
+  // pool instead of the CPU queue. Pool threads don't serve the CPU queue, so
+  // they keep any child they may run, but leave AccumulateGrad to the CPU
+  // engine thread.
+  ReadyQueue* cpu_queue = &ready_queue(at::kCPU);
+  ReadyQueue* own_queue = nullptr;
+  if (next_task && in_cpu_backward_pool) {
+    own_queue = cpu_queue;
+  } else if (next_task && worker_device != NO_DEVICE) {
+    own_queue = &ready_queue_by_index(worker_device);
+  }
+  c10::ThreadPool* cpu_pool = task.base_->cpu_pool_.get();
+  auto can_use_pool = [&](const ReadyQueue& queue, const NodeTask& t) {
+    return cpu_pool && &queue == cpu_queue &&
+        !dynamic_cast<AccumulateGrad*>(t.fn_.get());
+  };
+  auto schedule = [&](std::shared_ptr<Node> next_fn, InputBuffer input_buffer) {
+    auto& queue = ready_queue(input_buffer.device());
+    NodeTask next(task.base_, std::move(next_fn), std::move(input_buffer));
+    bool may_run_here = in_cpu_backward_pool ? can_use_pool(queue, next)
+                                             : queue.empty();
+    if (&queue == own_queue && may_run_here) {
+      if (!*next_task) {
+        // counted like a task pushed to a ReadyQueue
+        ++task.base_->outstanding_tasks_;
+        next_task->emplace(std::move(next));
+        return;
+      }
+      if ((*next_task)->fn_->sequence_nr() < next.fn_->sequence_nr()) {
+        // the new task takes over the count of the one we queue instead
+        std::swap(**next_task, next);
+      }
+    }
+    if (can_use_pool(queue, next)) {
+      run_on_cpu_pool(*cpu_pool, std::move(next));
+      return;
+    }
+    queue.push(std::move(next));
+  };
+
+  // Only taken for nodes with more than one incoming edge, which have to
+  // accumulate their inputs in not_ready_
+  std::unique_lock<std::mutex> lock(task.base_->mutex_, std::defer_lock);
+  auto& dependencies = task.base_->dependencies_;
+  auto& not_ready = task.base_->not_ready_;
   for (int i = 0; i < num_outputs; ++i) {
     auto& output = outputs[i];
     const auto& next = fn.next_edge(i);
 
     if (!next.is_valid()) continue;
 
-    // Check if the next function is ready to be computed
-    bool is_ready = false;
-    auto& dependencies = task.base_->dependencies_;
     auto it = dependencies.find(next.function.get());
     if (it == dependencies.end()) {
       auto name = next.function->name();
       throw std::runtime_error(std::string("dependency not found for ") + name);
-    } else if (--it->second == 0) {
-      dependencies.erase(it);
-      is_ready = true;
     }
+    auto& deps = it->second;
 
-    auto& not_ready = task.base_->not_ready_;
-    auto not_ready_it = not_ready.find(next.function.get());
-    if (not_ready_it == not_ready.end()) {
+    bool should_execute = true;
+    if (!exec_info_.empty()) {
       // Skip functions that aren't supposed to be executed
-      if (!exec_info_.empty()) {
-        auto it = exec_info_.find(next.function.get());
-        if (it == exec_info_.end() || !it->second.should_execute()) {
-          continue;
-        }
+      auto it = exec_info_.find(next.function.get());
+      should_execute = it != exec_info_.end() && it->second.should_execute();
+    }
+
+    if (deps.total_ == 1) {
+      // This is the only edge into the next function, so no other thread
+      // can be delivering inputs to it.
+      if (deps.remaining_.fetch_sub(1, std::memory_order_relaxed) != 1) {
+        auto name = next.function->name();
+        throw std::runtime_error(std::string("dependency not found for ") + name);
       }
+      if (!should_execute) continue;
+      InputBuffer input_buffer(next.function->num_inputs());
+      input_buffer.add(next.input_nr, std::move(output));
+      schedule(next.function, std::move(input_buffer));
+      continue;
+    }
+
+    if (!lock.owns_lock()) {
+      lock.lock();
+    }
+    // Check if the next function is ready to be computed
+    int remaining = deps.remaining_.fetch_sub(1, std::memory_order_relaxed);
+    if (remaining <= 0) {
+      auto name = next.function->name();
+      throw std::runtime_error(std::string("dependency not found for ") + name);
+    }
+    bool is_ready = remaining == 1;
+
+    auto not_ready_it = not_ready.find(next.function.get());
+    if (not_ready_it == not_ready.end()) {
+      if (!should_execute) continue;
       // No buffers have been allocated for the function
       InputBuffer input_buffer(next.function->num_inputs());
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
-        queue.push(NodeTask(task.base_, next.function, std::move(input_buffer)));
+        schedule(next.function, std::move(input_buffer));
       } else {
         not_ready.emplace(next.function.get(), std::move(input_buffer));
       }
@@ -608,8 +756,7 @@ auto Engine::evaluate_function(NodeTask& task) -> void {
       auto &input_buffer = not_ready_it->second;
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
-        queue.push(NodeTask(task.base_, next.function, std::move(input_buffer)));
+        schedule(next.function, std::move(input_buffer));
         not_ready.erase(not_ready_it);
       }
     }
@@ -629,7 +776,9 @@ auto Engine::compute_dependencies(Node* root, GraphTask& task) -> void {
     auto fn = queue.back(); queue.pop_back();
     for (const auto& edge : fn->next_edges()) {
       if (auto next_ptr = edge.function.get()) {
-        dependencies[next_ptr] += 1;
+        auto& deps = dependencies[next_ptr];
+        deps.total_ += 1;
+        deps.remaining_.store(deps.total_, std::memory_order_relaxed);
         const bool was_inserted = seen.insert(next_ptr).second;
         if (was_inserted) queue.push_back(next_ptr);
       }
@@ -670,6 +819,9 @@ auto Engine::execute(const edge_list& roots,
   ClearCallbacks _cb_guard(final_callbacks_, post_callbacks_lock_);
 
   GraphTask graph_task(keep_graph, create_graph, worker_device == NO_DEVICE ? 0 : total_depth+1);
+  if (!in_cpu_backward_pool) {
+    graph_task.cpu_pool_ = cpu_pool();
+  }
   // Lock mutex while GraphTask is being set up
   std::unique_lock<std::mutex> lock(graph_task.mutex_);
 
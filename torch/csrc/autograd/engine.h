@@ -7,11 +7,15 @@
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/input_buffer.h>
 #include <torch/csrc/autograd/anomaly_mode.h>
+#include <c10/core/thread_pool.h>
+#include <c10/util/Optional.h>
 
+#include <atomic>
 #include <deque>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <unordered_map>
 #include <utility>
@@ -35,7 +39,6 @@ struct TORCH_API Engine {
   virtual ~Engine();
 
   using ready_queue_type = std::deque<std::pair<std::shared_ptr<Node>, InputBuffer>>;
-  using dependencies_type = std::unordered_map<Node*, int>;
 
   // Given a list of (Node, input number) pairs computes the value of the graph
   // by following next_edge references.
@@ -53,9 +56,25 @@ struct TORCH_API Engine {
 
   bool is_checkpoint_valid();
 
+  // Opt-in parallel execution of CPU nodes. By default all CPU nodes of a
+  // backward pass run one after another on the CPU engine thread. With
+  // num_threads > 0, CPU nodes that become ready while that thread is busy
+  // run concurrently on a pool of num_threads threads instead, so backward
+  // over graphs with independent branches can use several cores.
+  // AccumulateGrad nodes still always run on the CPU engine thread. Note that
+  // a node may be applied concurrently with itself if several backward passes
+  // over the same graph (retain_graph=True) run at the same time.
+  // Passing 0 turns this off again. Passing the current number of threads
+  // keeps the current pool.
+  void set_num_cpu_backward_threads(size_t num_threads);
+
 protected:
   void compute_dependencies(Node* root, GraphTask& task);
-  void evaluate_function(NodeTask& task);
+  // If next_task is given, a child of task that became ready may be returned
+  // through it to run next on the calling thread, instead of being queued.
+  void evaluate_function(NodeTask& task, c10::optional<NodeTask>* next_task = nullptr);
+  // Updates the outstanding task count of the GraphTask of task once it ran
+  void finish_task(NodeTask& task);
   ReadyQueue& ready_queue(at::Device device);
   ReadyQueue& ready_queue_by_index(int device_index);
   void start_threads();
@@ -63,6 +82,13 @@ protected:
   virtual void thread_main(GraphTask *graph_task);
   virtual void thread_on_exception(NodeTask& task, std::exception& e);
   void reentrant_thread_init();
+  // Runs task, and any children that evaluate_function hands back to run next
+  // on the same thread.
+  void run_task(NodeTask task);
+  // The current CPU backward pool, or null if it is turned off
+  std::shared_ptr<c10::ThreadPool> cpu_pool();
+  // Runs task on the given CPU backward pool
+  void run_on_cpu_pool(c10::ThreadPool& pool, NodeTask task);
   void add_thread_pool_task(GraphTask *graph_task);
   void set_device(int device);
 
@@ -75,6 +101,10 @@ protected:
   std::mutex post_callbacks_lock_;
   // How many nested reentrant calls are allowed until a new thread is used
   int max_recursion_depth_;
+  // See set_num_cpu_backward_threads. Every GraphTask holds on to the pool
+  // it started with, so a replaced pool goes away with its last GraphTask.
+  std::shared_ptr<c10::ThreadPool> cpu_pool_;
+  std::mutex cpu_pool_mutex_;
 
   struct ThreadPoolShared {
     // Data structures used by the threads for executing reentrant backwards
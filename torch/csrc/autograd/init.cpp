@@ -4,6 +4,7 @@
 #include <torch/csrc/utils/pybind.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/autograd/profiler.h>
+#include <torch/csrc/autograd/sampling_profiler.h>
 #include <torch/csrc/autograd/python_function.h>
 #include <torch/csrc/autograd/function.h>
 
@@ -36,7 +37,8 @@ PyObject* THPAutograd_initExtension(PyObject* _unused) {
       .value("NVTX", ProfilerState::NVTX);
 
   py::class_<ProfilerConfig>(m, "ProfilerConfig")
-      .def(py::init<ProfilerState, bool>());
+      .def(py::init<ProfilerState, bool>())
+      .def(py::init<ProfilerState, bool, bool>());
 
   py::class_<Event>(m, "ProfilerEvent")
       .def("kind", &Event::kind)
@@ -46,7 +48,8 @@ PyObject* THPAutograd_initExtension(PyObject* _unused) {
       .def("cpu_elapsed_us", &Event::cpu_elapsed_us)
       .def("cuda_elapsed_us", &Event::cuda_elapsed_us)
       .def("has_cuda", &Event::has_cuda)
-      .def("shapes", &Event::shapes);
+      .def("shapes", &Event::shapes)
+      .def("cpu_memory_usage", &Event::cpu_memory_usage);
 
   m.def("_enable_profiler", enableProfiler);
   m.def("_disable_profiler", disableProfiler);
@@ -54,6 +57,32 @@ PyObject* THPAutograd_initExtension(PyObject* _unused) {
   m.def("_push_range", [](std::string name) { pushRange(std::move(name)); });
   m.def("_pop_range", []() { popRange(); });
 
+  py::class_<SampledOpStats>(m, "SampledOpStats")
+      .def_readonly("name", &SampledOpStats::name)
+      .def_readonly("shapes", &SampledOpStats::shapes)
+      .def_readonly("count", &SampledOpStats::count)
+      .def_readonly("total_ns", &SampledOpStats::total_ns)
+      .def_readonly("max_ns", &SampledOpStats::max_ns)
+      .def_readonly("histogram", &SampledOpStats::histogram);
+
+  m.def(
+      "_enable_sampling_profiler",
+      [](int64_t every_n_calls,
+         int64_t tick_period_us,
+         int64_t aggregation_period_ms,
+         bool record_shapes) {
+        SamplingProfilerConfig config;
+        config.every_n_calls = every_n_calls;
+        config.tick_period = std::chrono::microseconds(tick_period_us);
+        config.aggregation_period =
+            std::chrono::milliseconds(aggregation_period_ms);
+        config.record_shapes = record_shapes;
+        enableSamplingProfiler(config);
+      });
+  m.def("_disable_sampling_profiler", disableSamplingProfiler);
+  m.def("_sampled_op_stats", getSampledOpStats);
+  m.def("_reset_sampled_op_stats", resetSampledOpStats);
+
   Py_RETURN_TRUE;
 }
 
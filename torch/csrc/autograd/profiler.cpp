@@ -1,6 +1,9 @@
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/jit/code_template.h>
 
+#include <c10/core/CPUAllocator.h>
+
+#include <atomic>
 #include <fstream>
 #include <list>
 #include <mutex>
@@ -27,8 +30,28 @@ std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 thread_local std::shared_ptr<RangeEventList> event_list;
 thread_local uint16_t thread_id;
 
+// Whether full event blocks are handed over to a StreamingRecordProfile
+std::atomic<bool> stream_full_blocks{false};
+
 ProfilerConfig::~ProfilerConfig() = default;
 
+void RangeEventList::allocBlock() {
+  if (!blocks.empty() && stream_full_blocks.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> guard(full_blocks_mutex);
+    full_blocks.push_back(std::move(blocks.front()));
+    blocks.pop_front();
+  }
+  blocks.emplace_front();
+  auto & new_block = blocks.front();
+  new_block.reserve(num_block_elements);
+  // Materialize all pages in the new block to release jitter when recording events.
+  const char * const end_ptr = reinterpret_cast<char*>(new_block.data() + num_block_elements);
+  for (volatile const char * ptr = reinterpret_cast<char*>(new_block.data());
+       ptr < end_ptr; ptr += 4 * 1024) {
+    (*ptr);
+  }
+}
+
 RangeEventList& getEventList() {
   if (!event_list) {
     std::lock_guard<std::mutex> guard(all_event_lists_mutex);
@@ -100,6 +123,31 @@ void pushRangeImpl(
   }
 }
 
+void reportMemoryUsage(int64_t nbytes) {
+  if (state != ProfilerState::CPU && state != ProfilerState::CUDA) {
+    return;
+  }
+  const RecordFunction* fn = currentRecordFunction();
+  getEventList().record(
+      EventKind::MemoryAlloc,
+      fn ? fn->name() : StringView(""),
+      thread_id,
+      false,
+      std::vector<std::vector<int64_t>>(),
+      nbytes);
+}
+
+struct ProfilerMemoryObserver final : public c10::MemoryObserver {
+  void OnAlloc(void* /* unused */, size_t nbytes) override {
+    reportMemoryUsage(static_cast<int64_t>(nbytes));
+  }
+  void OnFree(void* /* unused */, size_t nbytes) override {
+    reportMemoryUsage(-static_cast<int64_t>(nbytes));
+  }
+};
+
+ProfilerMemoryObserver memory_observer;
+
 void pushRange(std::string name) {
   pushRangeImpl(StringView(std::move(name)));
 }
@@ -154,6 +202,9 @@ void enableProfiler(ProfilerConfig config) {
       [](const RecordFunction& /* unused */) { popRange(); },
       config.report_input_shapes);
   state = new_state;
+  if (config.profile_memory) {
+    c10::GetMemoryAllocationReporter().SetObserver(&memory_observer);
+  }
 
   if(state == ProfilerState::CUDA) {
     // event recording appears to have some startup overhead, so we need to
@@ -183,6 +234,7 @@ thread_event_lists disableProfiler() {
   mark("__stop_profile");
 
   popCallback();
+  c10::GetMemoryAllocationReporter().SetObserver(nullptr);
   state = ProfilerState::Disabled;
 
   if (old_state == ProfilerState::NVTX) {
@@ -301,4 +353,90 @@ void RecordProfile::processEvents(const std::vector<Event*>& events) {
   out_ << "]\n";
 }
 
+StreamingRecordProfile::StreamingRecordProfile(
+    const std::string& filename,
+    bool profile_memory,
+    std::chrono::milliseconds flush_period)
+: out_(filename), start_ns_(getTime()) {
+  TORCH_CHECK(out_, "could not open file ", filename);
+  out_ << "[\n";
+  stream_full_blocks = true;
+  enableProfiler(ProfilerConfig(ProfilerState::CPU, false, profile_memory));
+  flush_thread_ = std::thread([this, flush_period] {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, flush_period, [this] { return stop_; })) {
+      flushFullBlocks();
+    }
+  });
+}
+
+StreamingRecordProfile::~StreamingRecordProfile() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  flush_thread_.join();
+  // Includes the full blocks that were not flushed yet
+  thread_event_lists event_lists = disableProfiler();
+  stream_full_blocks = false;
+  for (auto& events : event_lists) {
+    writeEvents(events);
+  }
+  out_ << "]\n";
+  out_.close();
+}
+
+void StreamingRecordProfile::flushFullBlocks() {
+  std::vector<std::shared_ptr<RangeEventList>> lists;
+  {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    lists.assign(all_event_lists.begin(), all_event_lists.end());
+  }
+  for (auto& list : lists) {
+    for (auto& block : list->takeFullBlocks()) {
+      writeEvents(block);
+    }
+  }
+  out_.flush();
+}
+
+void StreamingRecordProfile::writeEvents(const std::vector<Event>& events) {
+  for (const Event& e : events) {
+    const std::string kind = e.kind();
+    if (kind == "mark" && strncmp(e.name(), "__", 2) == 0) {
+      // profiler bookkeeping
+      continue;
+    }
+    if (!first_event_) {
+      out_ << ",\n";
+    }
+    first_event_ = false;
+    double ts = (e.cpu_ns() - start_ns_) / 1000.0;
+    if (kind == "push") {
+      out_ << "{\"name\": \"" << e.name() << "\", \"ph\": \"B\", \"ts\": " << ts
+           << ", \"tid\": " << e.thread_id()
+           << ", \"pid\": \"CPU Functions\", \"args\": {}}";
+    } else if (kind == "pop") {
+      out_ << "{\"ph\": \"E\", \"ts\": " << ts << ", \"tid\": "
+           << e.thread_id() << ", \"pid\": \"CPU Functions\"}";
+    } else if (kind == "memory_alloc") {
+      // memory_allocated_ is the sum of the memory events written so far,
+      // which only approximates the true total between flushes
+      memory_allocated_ += e.cpu_memory_usage();
+      out_ << "{\"name\": \"[memory]\", \"ph\": \"i\", \"s\": \"t\", \"ts\": "
+           << ts << ", \"tid\": " << e.thread_id()
+           << ", \"pid\": \"CPU Functions\", \"args\": {\"Bytes\": "
+           << e.cpu_memory_usage() << ", \"Op\": \"" << e.name() << "\"}},\n"
+           << "{\"name\": \"CPU memory\", \"ph\": \"C\", \"ts\": " << ts
+           << ", \"pid\": \"CPU Functions\", \"args\": {\"Bytes\": "
+           << memory_allocated_ << "}}";
+    } else {
+      out_ << "{\"name\": \"" << e.name() << "\", \"ph\": \"i\", \"s\": \"t\", \"ts\": "
+           << ts << ", \"tid\": " << e.thread_id()
+           << ", \"pid\": \"CPU Functions\", \"args\": {}}";
+    }
+  }
+}
+
 }}}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
 #include <mutex>
 #include <memory>
@@ -8,6 +11,7 @@
 #include <string>
 #include <sstream>
 #include <forward_list>
+#include <thread>
 #include <tuple>
 #include <ATen/ATen.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
@@ -102,17 +106,26 @@ enum class TORCH_API ProfilerState {
 };
 
 struct TORCH_API ProfilerConfig {
-  ProfilerConfig(ProfilerState state, bool report_input_shapes)
-      : state(state), report_input_shapes(report_input_shapes) {}
+  ProfilerConfig(
+      ProfilerState state,
+      bool report_input_shapes,
+      bool profile_memory = false)
+      : state(state),
+        report_input_shapes(report_input_shapes),
+        profile_memory(profile_memory) {}
   ~ProfilerConfig();
   ProfilerState state;
   bool report_input_shapes;
+  // Record an event for every allocation and free of the CPU allocator,
+  // tagged with the innermost RecordFunction of the allocating thread
+  bool profile_memory;
 };
 
 enum class TORCH_API EventKind : uint16_t {
   Mark,
   PushRange,
-  PopRange
+  PopRange,
+  MemoryAlloc
 };
 #ifndef _MSC_VER
 #  pragma GCC diagnostic pop
@@ -124,11 +137,13 @@ struct TORCH_API Event final {
       StringView name,
       uint16_t thread_id,
       bool record_cuda,
-      std::vector<std::vector<int64_t>>&& shapes = {})
+      std::vector<std::vector<int64_t>>&& shapes = {},
+      int64_t cpu_memory_usage = 0)
       : name_(std::move(name)),
         kind_(kind),
         thread_id_(thread_id),
-        shapes_(shapes) {
+        shapes_(shapes),
+        cpu_memory_usage_(cpu_memory_usage) {
     record(record_cuda);
   }
 
@@ -138,6 +153,7 @@ struct TORCH_API Event final {
       case EventKind::Mark: return "mark";
       case EventKind::PushRange: return "push";
       case EventKind::PopRange: return "pop";
+      case EventKind::MemoryAlloc: return "memory_alloc";
     }
     throw std::runtime_error("unknown EventKind");
   }
@@ -150,6 +166,15 @@ struct TORCH_API Event final {
   std::vector<std::vector<int64_t>> shapes() const {
     return shapes_;
   }
+  // For memory_alloc events: the number of bytes allocated (negative for
+  // frees). The name of these events is the name of the RecordFunction they
+  // happened in.
+  int64_t cpu_memory_usage() const {
+    return cpu_memory_usage_;
+  }
+  int64_t cpu_ns() const {
+    return cpu_ns_;
+  }
   double cpu_elapsed_us(const Event & e) {
     return (e.cpu_ns_ - cpu_ns_)/(1000.0);
   }
@@ -167,6 +192,7 @@ private:
   EventKind kind_;
   uint16_t thread_id_;
   std::vector<std::vector<int64_t>> shapes_;
+  int64_t cpu_memory_usage_ = 0;
   int device_ = -1;
   struct CUevent_st* event = nullptr;
 };
@@ -183,17 +209,9 @@ struct RangeEventList {
                 "num_block_elements is calculated incorrectly");
   using block_type = std::vector<Event>;
 
-  void allocBlock() {
-    blocks.emplace_front();
-    auto & new_block = blocks.front();
-    new_block.reserve(num_block_elements);
-    // Materialize all pages in the new block to release jitter when recording events.
-    const char * const end_ptr = reinterpret_cast<char*>(new_block.data() + num_block_elements);
-    for (volatile const char * ptr = reinterpret_cast<char*>(new_block.data());
-         ptr < end_ptr; ptr += 4 * 1024) {
-      (*ptr);
-    }
-  }
+  // Starts a new block. While events are streamed (see
+  // StreamingRecordProfile), the full block is moved to full_blocks first.
+  void allocBlock();
 
   template<typename... Args>
   void record(Args&&... args) {
@@ -205,8 +223,15 @@ struct RangeEventList {
 
   std::vector<Event> consolidate() {
     std::vector<Event> result;
+    // Blocks that were handed over for streaming are older than the others
+    for (auto & block : takeFullBlocks()) {
+      result.insert(result.end(),
+                    std::make_move_iterator(block.begin()),
+                    std::make_move_iterator(block.end()));
+    }
+    const size_t num_streamed = result.size();
     for (auto & block : blocks) {
-      result.insert(result.begin(),
+      result.insert(result.begin() + num_streamed,
                     std::make_move_iterator(block.begin()),
                     std::make_move_iterator(block.end()));
     }
@@ -214,7 +239,17 @@ struct RangeEventList {
     return result;
   }
 
+  // Full blocks waiting to be streamed, oldest first
+  std::vector<block_type> takeFullBlocks() {
+    std::vector<block_type> result;
+    std::lock_guard<std::mutex> guard(full_blocks_mutex);
+    std::swap(result, full_blocks);
+    return result;
+  }
+
   std::forward_list<block_type> blocks;
+  std::mutex full_blocks_mutex;
+  std::vector<block_type> full_blocks;
 };
 
 TORCH_API RangeEventList& getEventList();
@@ -247,6 +282,43 @@ private:
   void processEvents(const std::vector<Event*>& events);
 };
 
+// Like RecordProfile, but writes the events to the trace while profiling is
+// running, so that long runs don't have to keep every event in memory.
+// Whenever a thread fills a block of its RangeEventList, the block is handed
+// over to a background thread that appends it to the trace every
+// flush_period. Ranges are written as begin/end pairs, and with
+// profile_memory set, allocations and frees as instant events tagged with the
+// op they happened in, plus a counter of the CPU memory allocated since
+// profiling started.
+//
+// Usage:
+//   {
+//     StreamingRecordProfile guard("filename.trace");
+//     // code you want to profile
+//   }
+// Then open filename.trace in chrome://tracing or perfetto
+struct TORCH_API StreamingRecordProfile {
+  StreamingRecordProfile(
+      const std::string& filename,
+      bool profile_memory = false,
+      std::chrono::milliseconds flush_period = std::chrono::seconds(1));
+
+  ~StreamingRecordProfile();
+private:
+  void flushFullBlocks();
+  void writeEvents(const std::vector<Event>& events);
+
+  std::ofstream out_;
+  int64_t start_ns_;
+  bool first_event_ = true;
+  int64_t memory_allocated_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread flush_thread_;
+};
+
 
 } // namespace profiler
 }} // namespace torch::autograd
@@ -222,6 +222,17 @@ PyObject* THPEngine_is_checkpoint_valid(PyObject *self) {
   END_HANDLE_TH_ERRORS
 }
 
+PyObject* THPEngine_set_num_cpu_backward_threads(PyObject *self, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "expected an int, but got %s",
+      THPUtils_typename(arg));
+  int64_t num_threads = THPUtils_unpackLong(arg);
+  THPUtils_assert(num_threads >= 0, "number of threads must be non-negative");
+  engine.set_num_cpu_backward_threads(num_threads);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject *THPEngine_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
   return type->tp_alloc(type, 0);
@@ -231,6 +242,7 @@ static struct PyMethodDef THPEngine_methods[] = {
   {(char*)"run_backward", (PyCFunction)THPEngine_run_backward, METH_VARARGS | METH_KEYWORDS, nullptr},
   {(char*)"queue_callback", (PyCFunction)THPEngine_queue_callback, METH_O, nullptr},
   {(char*)"is_checkpoint_valid", (PyCFunction)THPEngine_is_checkpoint_valid, METH_NOARGS, nullptr},
+  {(char*)"set_num_cpu_backward_threads", (PyCFunction)THPEngine_set_num_cpu_backward_threads, METH_O, nullptr},
   {nullptr}
 };
 
@@ -2,6 +2,7 @@
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/utils/memory.h>
 
+#include <atomic>
 #include <cstdlib>
 #include <random>
 
@@ -9,6 +10,12 @@ namespace torch { namespace autograd { namespace profiler {
 
 namespace {
 
+enum class SamplingMode {
+  Probability,
+  EveryNCalls,
+  OnTick,
+};
+
 class CallbackManager {
  public:
   void setSamplingProbability(double prob) {
@@ -19,6 +26,21 @@ class CallbackManager {
       sampling_prop_set = true;
     }
     sampling_prob = prob;
+    sampling_mode = SamplingMode::Probability;
+  }
+
+  void setSamplingEveryNCalls(int64_t n) {
+    TORCH_CHECK(n > 0, "sampling period must be positive, got ", n);
+    sampling_period = n;
+    sampling_mode = SamplingMode::EveryNCalls;
+  }
+
+  void setSamplingOnTick() {
+    sampling_mode = SamplingMode::OnTick;
+  }
+
+  void samplingTick() {
+    sampling_tick.fetch_add(1, std::memory_order_relaxed);
   }
 
   double getSamplingProbability() {
@@ -26,9 +48,28 @@ class CallbackManager {
   }
 
   bool shouldRunSampledCallbacks() {
-    return (num_sampled_callbacks > 0) &&
-        (!sampling_prop_set ||
-        (sample_zero_one() < sampling_prob));
+    if (num_sampled_callbacks == 0) {
+      return false;
+    }
+    switch (sampling_mode) {
+      case SamplingMode::EveryNCalls:
+        if (--calls_until_sample > 0) {
+          return false;
+        }
+        calls_until_sample = sampling_period;
+        return true;
+      case SamplingMode::OnTick: {
+        auto tick = sampling_tick.load(std::memory_order_relaxed);
+        if (tick == last_sampled_tick) {
+          return false;
+        }
+        last_sampled_tick = tick;
+        return true;
+      }
+      case SamplingMode::Probability:
+      default:
+        return !sampling_prop_set || (sample_zero_one() < sampling_prob);
+    }
   }
 
   void pushCallback(
@@ -81,6 +122,13 @@ class CallbackManager {
   size_t callback_needs_inputs = 0;
   bool sampling_prop_set = false;
   double sampling_prob = 1.0;
+  SamplingMode sampling_mode = SamplingMode::Probability;
+  int64_t sampling_period = 1;
+  std::atomic<uint64_t> sampling_tick{0};
+
+  // Per-thread sampling state for the EveryNCalls and OnTick modes
+  static thread_local int64_t calls_until_sample;
+  static thread_local uint64_t last_sampled_tick;
 
   static double sample_zero_one() {
     static thread_local auto gen =
@@ -90,6 +138,9 @@ class CallbackManager {
   }
 };
 
+thread_local int64_t CallbackManager::calls_until_sample = 0;
+thread_local uint64_t CallbackManager::last_sampled_tick = 0;
+
 thread_local RecordFunction* thread_local_func_ = nullptr;
 
 CallbackManager& manager() {
@@ -107,6 +158,18 @@ double getSamplingProbability() {
   return manager().getSamplingProbability();
 }
 
+void setSamplingEveryNCalls(int64_t n) {
+  manager().setSamplingEveryNCalls(n);
+}
+
+void setSamplingOnTick() {
+  manager().setSamplingOnTick();
+}
+
+void samplingTick() {
+  manager().samplingTick();
+}
+
 bool shouldRunSampledCallbacks() {
   return manager().shouldRunSampledCallbacks();
 }
@@ -127,6 +190,10 @@ void popCallback() {
   manager().popCallback();
 }
 
+const RecordFunction* currentRecordFunction() {
+  return thread_local_func_;
+}
+
 bool hasCallbacks() {
   return manager().hasCallbacks();
 }
@@ -94,6 +94,10 @@ struct TORCH_API RecordFunction {
   bool run_sampled_ = false;
 };
 
+// The innermost RecordFunction active on this thread, if any. Only tracked
+// while callbacks are registered.
+TORCH_API const RecordFunction* currentRecordFunction();
+
 TORCH_API bool hasCallbacks();
 TORCH_API bool needsInputs();
 TORCH_API bool hasNonSampledCallbacks();
@@ -101,6 +105,16 @@ TORCH_API bool hasNonSampledCallbacks();
 TORCH_API void setSamplingProbability(double);
 TORCH_API double getSamplingProbability();
 
+// Alternatives to sampling with a probability, which need no random number per
+// call. setSamplingEveryNCalls(n) runs the sampled callbacks for one in every
+// n calls on each thread. After setSamplingOnTick(), each thread runs them
+// only for its first call after each samplingTick(), which is meant to be
+// called from a timer. setSamplingProbability switches back to sampling with
+// a probability.
+TORCH_API void setSamplingEveryNCalls(int64_t n);
+TORCH_API void setSamplingOnTick();
+TORCH_API void samplingTick();
+
 TORCH_API bool shouldRunSampledCallbacks();
 
 // optional argument - function's seq_no
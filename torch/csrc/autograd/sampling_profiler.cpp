@@ -0,0 +1,277 @@
+#include <torch/csrc/autograd/sampling_profiler.h>
+
+#include <torch/csrc/autograd/profiler.h>
+#include <torch/csrc/autograd/record_function.h>
+#include <torch/csrc/utils/hash.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace torch { namespace autograd { namespace profiler {
+
+constexpr size_t SampledOpStats::kNumBuckets;
+
+namespace {
+
+struct Sample {
+  StringView name;
+  std::vector<std::vector<int64_t>> shapes;
+  int64_t duration_ns = 0;
+};
+
+// Single producer, single consumer ring buffer: the thread that owns it
+// pushes samples, the aggregator drains them.
+class SampleBuffer {
+ public:
+  explicit SampleBuffer(size_t capacity) : slots_(capacity) {}
+
+  bool push(Sample&& sample) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[head % slots_.size()] = std::move(sample);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <typename F>
+  void drain(const F& fn) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      fn(std::move(slots_[tail % slots_.size()]));
+    }
+    tail_.store(tail, std::memory_order_release);
+  }
+
+ private:
+  std::vector<Sample> slots_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+using StatsKey = std::tuple<std::string, std::vector<std::vector<int64_t>>>;
+
+size_t bucketFor(int64_t duration_ns) {
+  int64_t us = duration_ns / 1000;
+  size_t bucket = 0;
+  while (us > 0 && bucket + 1 < SampledOpStats::kNumBuckets) {
+    us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+struct SamplingProfilerState {
+  bool enabled = false;
+  SamplingProfilerConfig config;
+  double saved_sampling_probability = 1.0;
+  // Bumped on every enable so that threads allocate buffers of the new size
+  std::atomic<uint64_t> generation{0};
+  std::atomic<int64_t> dropped{0};
+
+  // Guards buffers and stats
+  std::mutex mutex;
+  std::vector<std::shared_ptr<SampleBuffer>> buffers;
+  std::unordered_map<StatsKey, SampledOpStats, torch::hash<StatsKey>> stats;
+
+  std::thread worker;
+  std::mutex worker_mutex;
+  std::condition_variable worker_cv;
+  bool stop_worker = false;
+
+  // Must be called with mutex held
+  void aggregate() {
+    for (auto& buffer : buffers) {
+      buffer->drain([this](Sample&& sample) {
+        auto& entry = stats[StatsKey(sample.name.str(), sample.shapes)];
+        if (entry.count == 0) {
+          entry.name = sample.name.str();
+          entry.shapes = std::move(sample.shapes);
+        }
+        ++entry.count;
+        entry.total_ns += sample.duration_ns;
+        entry.max_ns = std::max(entry.max_ns, sample.duration_ns);
+        ++entry.histogram[bucketFor(sample.duration_ns)];
+      });
+    }
+    // Drop the buffers of threads that have exited
+    buffers.erase(
+        std::remove_if(
+            buffers.begin(),
+            buffers.end(),
+            [](const std::shared_ptr<SampleBuffer>& buffer) {
+              return buffer.use_count() == 1;
+            }),
+        buffers.end());
+  }
+
+  void workerMain() {
+    auto tick_period = config.tick_period;
+    auto aggregation_period = config.aggregation_period;
+    std::chrono::microseconds wait_period = tick_period.count() > 0
+        ? std::min<std::chrono::microseconds>(tick_period, aggregation_period)
+        : aggregation_period;
+    auto last_aggregation = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(worker_mutex);
+    while (!worker_cv.wait_for(
+        lock, wait_period, [this] { return stop_worker; })) {
+      if (tick_period.count() > 0) {
+        samplingTick();
+      }
+      auto now = std::chrono::steady_clock::now();
+      if (now - last_aggregation >= aggregation_period) {
+        std::lock_guard<std::mutex> guard(mutex);
+        aggregate();
+        last_aggregation = now;
+      }
+    }
+  }
+};
+
+SamplingProfilerState& state() {
+  static SamplingProfilerState instance;
+  return instance;
+}
+
+struct ThreadState {
+  std::shared_ptr<SampleBuffer> buffer;
+  uint64_t generation = 0;
+  // Start times of the sampled calls in progress on this thread
+  std::vector<std::pair<const RecordFunction*, int64_t>> open_calls;
+};
+
+thread_local ThreadState thread_state;
+
+SampleBuffer& getThreadBuffer(uint64_t generation, size_t buffer_size) {
+  if (thread_state.generation != generation) {
+    thread_state.buffer = std::make_shared<SampleBuffer>(buffer_size);
+    thread_state.generation = generation;
+    std::lock_guard<std::mutex> guard(state().mutex);
+    state().buffers.push_back(thread_state.buffer);
+  }
+  return *thread_state.buffer;
+}
+
+std::vector<std::vector<int64_t>> inputShapes(const RecordFunction& fn) {
+  std::vector<std::vector<int64_t>> shapes;
+  shapes.reserve(fn.inputs().size());
+  for (const c10::IValue& input : fn.inputs()) {
+    if (input.isTensor() && input.toTensor().defined()) {
+      shapes.push_back(input.toTensor().sizes().vec());
+    } else {
+      shapes.emplace_back();
+    }
+  }
+  return shapes;
+}
+
+} // namespace
+
+void enableSamplingProfiler(const SamplingProfilerConfig& config) {
+  auto& s = state();
+  TORCH_CHECK(!s.enabled, "sampling profiler is already enabled");
+  TORCH_CHECK(config.buffer_size > 0, "buffer_size must be positive");
+  TORCH_CHECK(
+      config.aggregation_period.count() > 0,
+      "aggregation_period must be positive");
+
+  {
+    std::lock_guard<std::mutex> guard(s.mutex);
+    s.buffers.clear();
+  }
+  s.config = config;
+  uint64_t generation = ++s.generation;
+  s.saved_sampling_probability = getSamplingProbability();
+  if (config.tick_period.count() > 0) {
+    setSamplingOnTick();
+  } else {
+    setSamplingEveryNCalls(config.every_n_calls);
+  }
+
+  bool record_shapes = config.record_shapes;
+  size_t buffer_size = config.buffer_size;
+  pushCallback(
+      [](const RecordFunction& fn) {
+        thread_state.open_calls.emplace_back(&fn, getTime());
+      },
+      [record_shapes, generation, buffer_size](const RecordFunction& fn) {
+        auto& open_calls = thread_state.open_calls;
+        // The callback may have been pushed while fn was already running
+        if (open_calls.empty() || open_calls.back().first != &fn) {
+          return;
+        }
+        Sample sample;
+        sample.duration_ns = getTime() - open_calls.back().second;
+        open_calls.pop_back();
+        sample.name = fn.name();
+        if (record_shapes) {
+          sample.shapes = inputShapes(fn);
+        }
+        if (!getThreadBuffer(generation, buffer_size).push(std::move(sample))) {
+          state().dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+      },
+      /* needs_inputs */ record_shapes,
+      /* sampled */ true);
+
+  s.stop_worker = false;
+  s.worker = std::thread([&s] { s.workerMain(); });
+  s.enabled = true;
+}
+
+void disableSamplingProfiler() {
+  auto& s = state();
+  TORCH_CHECK(s.enabled, "sampling profiler is not enabled");
+  popCallback();
+  setSamplingProbability(s.saved_sampling_probability);
+  {
+    std::lock_guard<std::mutex> guard(s.worker_mutex);
+    s.stop_worker = true;
+  }
+  s.worker_cv.notify_all();
+  s.worker.join();
+
+  std::lock_guard<std::mutex> guard(s.mutex);
+  s.aggregate();
+  s.buffers.clear();
+  s.enabled = false;
+}
+
+bool isSamplingProfilerEnabled() {
+  return state().enabled;
+}
+
+std::vector<SampledOpStats> getSampledOpStats() {
+  auto& s = state();
+  std::lock_guard<std::mutex> guard(s.mutex);
+  s.aggregate();
+  std::vector<SampledOpStats> result;
+  result.reserve(s.stats.size());
+  for (const auto& entry : s.stats) {
+    result.push_back(entry.second);
+  }
+  return result;
+}
+
+void resetSampledOpStats() {
+  auto& s = state();
+  std::lock_guard<std::mutex> guard(s.mutex);
+  s.aggregate();
+  s.stats.clear();
+  s.dropped = 0;
+}
+
+int64_t getDroppedSampleCount() {
+  return state().dropped.load();
+}
+
+}}} // namespace torch::autograd::profiler
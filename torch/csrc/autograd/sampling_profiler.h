@@ -0,0 +1,68 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace torch { namespace autograd { namespace profiler {
+
+// Low-overhead profiler that can be left on in production.
+//
+// enableProfiler records an event for every op. The sampling profiler instead
+// registers a sampled RecordFunction callback, so only the sampled calls pay
+// for timing: one in every every_n_calls calls on each thread, or, with a
+// tick_period, the first call each thread makes after every tick of a timer.
+// Samples are written to a lock-free per-thread ring buffer, and a background
+// thread periodically folds them into duration histograms keyed by op name
+// and input shapes.
+struct TORCH_API SamplingProfilerConfig {
+  // Sample one in every every_n_calls calls on each thread. Ignored if
+  // tick_period is non-zero.
+  int64_t every_n_calls = 1000;
+  // If non-zero, sample the first call of each thread after every tick of a
+  // timer with this period instead.
+  std::chrono::microseconds tick_period{0};
+  // How often samples are moved from the ring buffers to the histograms
+  std::chrono::milliseconds aggregation_period{1000};
+  // Also key the histograms by input shapes. This makes RecordFunction copy
+  // the inputs of the sampled calls.
+  bool record_shapes = true;
+  // Capacity of each per-thread ring buffer. Samples are dropped when the
+  // buffer is full.
+  size_t buffer_size = 4096;
+};
+
+struct TORCH_API SampledOpStats {
+  // Bucket 0 counts the samples that took less than 1us, bucket i > 0 the
+  // ones that took [2^(i-1), 2^i) us; the last bucket also counts all longer
+  // samples.
+  static constexpr size_t kNumBuckets = 24;
+
+  std::string name;
+  std::vector<std::vector<int64_t>> shapes;
+  int64_t count = 0;
+  int64_t total_ns = 0;
+  int64_t max_ns = 0;
+  std::array<int64_t, kNumBuckets> histogram{};
+};
+
+// WARNING: like pushCallback/popCallback, enabling and disabling the sampling
+// profiler is not thread safe and must not overlap with other code execution.
+// The profiler's callback must be the last one pushed when it is disabled.
+TORCH_API void enableSamplingProfiler(
+    const SamplingProfilerConfig& config = SamplingProfilerConfig());
+TORCH_API void disableSamplingProfiler();
+TORCH_API bool isSamplingProfilerEnabled();
+
+// Aggregates the pending samples and returns the statistics gathered since
+// the profiler was enabled or the statistics were last reset
+TORCH_API std::vector<SampledOpStats> getSampledOpStats();
+TORCH_API void resetSampledOpStats();
+// Number of samples dropped because a ring buffer was full
+TORCH_API int64_t getDroppedSampleCount();
+
+}}} // namespace torch::autograd::profiler
@@ -0,0 +1,194 @@
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <ATen/CPUGenerator.h>
+#include <c10/util/Exception.h>
+
+namespace c10d {
+namespace {
+
+void checkSingleReplica(
+    const std::vector<at::Tensor>& tensors,
+    const char* hook_name) {
+  TORCH_CHECK(
+      tensors.size() == 1,
+      hook_name,
+      " only supports a single model replica per process, got ",
+      tensors.size());
+}
+
+// Orthonormalizes the columns of the specified matrix in place with the
+// Gram-Schmidt process. Columns that are (nearly) zero stay (nearly) zero.
+void orthogonalize(at::Tensor& matrix) {
+  const auto columns = matrix.size(1);
+  for (int64_t i = 0; i < columns; i++) {
+    auto column = matrix.select(1, i);
+    for (int64_t j = 0; j < i; j++) {
+      auto other = matrix.select(1, j);
+      column.sub_(other * at::dot(column, other));
+    }
+    column.div_(column.norm().clamp_min(1e-8));
+  }
+}
+
+} // namespace
+
+FP16CompressionHook::FP16CompressionHook(
+    std::shared_ptr<ProcessGroup> process_group)
+    : process_group_(std::move(process_group)) {}
+
+std::shared_ptr<ProcessGroup::Work> FP16CompressionHook::runHook(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  auto& compressed = compressed_[bucket_index];
+  compressed.clear();
+  compressed.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    compressed.push_back(tensor.to(at::kHalf));
+  }
+  return process_group_->allreduce(compressed);
+}
+
+void FP16CompressionHook::finalize(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  auto& compressed = compressed_.at(bucket_index);
+  AT_ASSERT(compressed.size() == tensors.size());
+  for (size_t i = 0; i < tensors.size(); i++) {
+    tensors[i].copy_(compressed[i]);
+  }
+  compressed.clear();
+}
+
+void FP16CompressionHook::reset() {
+  compressed_.clear();
+}
+
+TopKSparsificationHook::TopKSparsificationHook(
+    std::shared_ptr<ProcessGroup> process_group,
+    double ratio)
+    : process_group_(std::move(process_group)), ratio_(ratio) {
+  TORCH_CHECK(
+      ratio_ > 0 && ratio_ <= 1,
+      "Expected the ratio of values to send to be in (0, 1], got ",
+      ratio_);
+}
+
+std::shared_ptr<ProcessGroup::Work> TopKSparsificationHook::runHook(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  checkSingleReplica(tensors, "TopKSparsificationHook");
+  auto& contents = tensors[0];
+  const auto numel = contents.numel();
+  auto& state = states_[bucket_index];
+  if (!state.residual.defined() || state.residual.numel() != numel) {
+    state.residual = at::zeros_like(contents);
+  }
+
+  // Send the largest values of the contents plus what wasn't sent before,
+  // and keep the rest for the next iteration.
+  const auto k = std::min<int64_t>(
+      numel, std::max<int64_t>(1, std::ceil(ratio_ * numel)));
+  state.residual.add_(contents);
+  auto indices = std::get<1>(state.residual.abs().topk(k, 0, true, false));
+  state.indices = {indices};
+  state.values = {state.residual.index_select(0, indices)};
+  state.residual.index_fill_(0, indices, 0);
+
+  // All processes send the same number of values, so they can be gathered.
+  const auto world_size = process_group_->getSize();
+  state.gathered_indices = {std::vector<at::Tensor>(world_size)};
+  state.gathered_values = {std::vector<at::Tensor>(world_size)};
+  for (int i = 0; i < world_size; i++) {
+    state.gathered_indices[0][i] = at::empty_like(state.indices[0]);
+    state.gathered_values[0][i] = at::empty_like(state.values[0]);
+  }
+  state.values_work =
+      process_group_->allgather(state.gathered_values, state.values);
+  return process_group_->allgather(state.gathered_indices, state.indices);
+}
+
+void TopKSparsificationHook::finalize(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  checkSingleReplica(tensors, "TopKSparsificationHook");
+  auto& state = states_.at(bucket_index);
+  state.values_work->wait();
+  auto& contents = tensors[0];
+  contents.zero_();
+  for (size_t i = 0; i < state.gathered_indices[0].size(); i++) {
+    contents.index_add_(
+        0, state.gathered_indices[0][i], state.gathered_values[0][i]);
+  }
+  state.indices.clear();
+  state.values.clear();
+  state.gathered_indices.clear();
+  state.gathered_values.clear();
+  state.values_work.reset();
+}
+
+void TopKSparsificationHook::reset() {
+  states_.clear();
+}
+
+PowerSGDHook::PowerSGDHook(
+    std::shared_ptr<ProcessGroup> process_group,
+    int64_t rank,
+    uint64_t seed)
+    : process_group_(std::move(process_group)), rank_(rank), seed_(seed) {
+  TORCH_CHECK(rank_ > 0, "Expected a positive PowerSGD rank, got ", rank_);
+}
+
+std::shared_ptr<ProcessGroup::Work> PowerSGDHook::runHook(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  checkSingleReplica(tensors, "PowerSGDHook");
+  auto& contents = tensors[0];
+  const auto numel = contents.numel();
+  auto& state = states_[bucket_index];
+  if (!state.residual.defined() || state.residual.numel() != numel) {
+    const auto side =
+        static_cast<int64_t>(std::ceil(std::sqrt(static_cast<double>(numel))));
+    const auto rank = std::min(rank_, side);
+    auto generator = at::detail::createCPUGenerator(seed_);
+    state.residual = at::zeros_like(contents);
+    state.matrix = at::zeros({side, side}, contents.options());
+    state.q = at::randn({side, rank}, generator.get(), at::kFloat)
+                  .to(contents.options());
+  }
+
+  // The padding of the matrix stays zero.
+  state.residual.add_(contents);
+  state.matrix.view({-1}).narrow(0, 0, numel).copy_(state.residual);
+  state.p = at::mm(state.matrix, state.q);
+  std::vector<at::Tensor> p = {state.p};
+  return process_group_->allreduce(p);
+}
+
+void PowerSGDHook::finalize(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  checkSingleReplica(tensors, "PowerSGDHook");
+  auto& state = states_.at(bucket_index);
+  orthogonalize(state.p);
+  at::mm_out(state.q, state.matrix.t(), state.p);
+  std::vector<at::Tensor> q = {state.q};
+  process_group_->allreduce(q)->wait();
+
+  // The approximation is of the sum of the contents of all processes, so
+  // every process keeps its share of the error.
+  auto& contents = tensors[0];
+  auto approximation =
+      at::mm(state.p, state.q.t()).view({-1}).narrow(0, 0, contents.numel());
+  state.residual.sub_(approximation / process_group_->getSize());
+  contents.copy_(approximation);
+  state.p.reset();
+}
+
+void PowerSGDHook::reset() {
+  states_.clear();
+}
+
+} // namespace c10d
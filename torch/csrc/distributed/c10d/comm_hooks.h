@@ -0,0 +1,139 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <c10d/ProcessGroup.hpp>
+
+namespace c10d {
+
+// A communication hook replaces the full precision allreduce the reducer
+// runs on the flattened contents of every dense bucket, e.g. to trade
+// accuracy for bandwidth by compressing the gradients before they are sent.
+//
+// The contents of a bucket are passed as one tensor per model replica and
+// hold the gradients divided by the world size, so the sum of the bucket
+// contents across processes is the average gradient. Buckets are reduced in
+// the same order on all processes, and a hook may keep state per bucket
+// index across iterations (e.g. the error feedback of a lossy hook).
+class CommHook {
+ public:
+  virtual ~CommHook() = default;
+
+  // Kicks off the reduction of the contents of a bucket and returns the work
+  // to wait for before `finalize` is called.
+  virtual std::shared_ptr<ProcessGroup::Work> runHook(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) = 0;
+
+  // Called once the work returned by `runHook` has completed. Writes the
+  // (approximate) sum of the bucket contents across processes back to them.
+  virtual void finalize(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) = 0;
+
+  // Called when the buckets are (re-)initialized, after which bucket indices
+  // may refer to different variables than before.
+  virtual void reset() = 0;
+};
+
+// Casts the bucket contents to half precision and allreduces those, which
+// halves the number of bytes sent for float buckets.
+class FP16CompressionHook : public CommHook {
+ public:
+  explicit FP16CompressionHook(std::shared_ptr<ProcessGroup> process_group);
+
+  std::shared_ptr<ProcessGroup::Work> runHook(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalize(size_t bucket_index, std::vector<at::Tensor>& tensors)
+      override;
+
+  void reset() override;
+
+ protected:
+  std::shared_ptr<ProcessGroup> process_group_;
+  std::unordered_map<size_t, std::vector<at::Tensor>> compressed_;
+};
+
+// Sends only the `ratio` fraction of the bucket contents that is largest in
+// magnitude, as indices and values gathered from all processes.
+//
+// What isn't sent is kept as a residual and added to the contents of the
+// same bucket in the next iteration (error feedback), so that small
+// gradients are delayed rather than lost. Requires a single model replica.
+class TopKSparsificationHook : public CommHook {
+ public:
+  TopKSparsificationHook(
+      std::shared_ptr<ProcessGroup> process_group,
+      double ratio);
+
+  std::shared_ptr<ProcessGroup::Work> runHook(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalize(size_t bucket_index, std::vector<at::Tensor>& tensors)
+      override;
+
+  void reset() override;
+
+ protected:
+  struct State {
+    at::Tensor residual;
+    std::vector<at::Tensor> indices;
+    std::vector<at::Tensor> values;
+    std::vector<std::vector<at::Tensor>> gathered_indices;
+    std::vector<std::vector<at::Tensor>> gathered_values;
+    std::shared_ptr<ProcessGroup::Work> values_work;
+  };
+
+  std::shared_ptr<ProcessGroup> process_group_;
+  const double ratio_;
+  std::unordered_map<size_t, State> states_;
+};
+
+// PowerSGD (Vogels et al., 2019): approximates the bucket contents, viewed
+// as a square matrix M padded with zeros, by the rank `rank` product P Q^T
+// and allreduces the factors P = M Q and Q = M^T P instead of M.
+//
+// P is orthogonalized between the two allreduces, and Q is reused as the
+// starting point of the next iteration. It is initialized from the same seed
+// on all processes. Every process keeps its contents minus its share of the
+// approximation as a residual, which is added to the contents of the same
+// bucket in the next iteration. The allreduce of
+// Q depends on the result of the allreduce of P, so it runs in `finalize`.
+// Requires a single model replica.
+class PowerSGDHook : public CommHook {
+ public:
+  PowerSGDHook(
+      std::shared_ptr<ProcessGroup> process_group,
+      int64_t rank,
+      uint64_t seed = 0);
+
+  std::shared_ptr<ProcessGroup::Work> runHook(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalize(size_t bucket_index, std::vector<at::Tensor>& tensors)
+      override;
+
+  void reset() override;
+
+ protected:
+  struct State {
+    at::Tensor residual;
+    at::Tensor matrix;
+    at::Tensor p;
+    at::Tensor q;
+  };
+
+  std::shared_ptr<ProcessGroup> process_group_;
+  const int64_t rank_;
+  const uint64_t seed_;
+  std::unordered_map<size_t, State> states_;
+};
+
+} // namespace c10d
@@ -34,6 +34,7 @@ namespace {
 
 #ifdef USE_C10D_GLOO
 constexpr char* GLOO_SOCKET_IFNAME_ENV = "GLOO_SOCKET_IFNAME";
+constexpr char* GLOO_HIERARCHICAL_ALLREDUCE_ENV = "GLOO_HIERARCHICAL_ALLREDUCE";
 #endif
 
 std::vector<std::string> split(char separator, const std::string& string) {
@@ -82,7 +83,48 @@ PyObject* c10d_init(PyObject* _unused) {
           [](::c10d::Reducer& reducer, const torch::autograd::Variable& output)
               -> void { reducer.prepare_for_backward({output}); },
           py::call_guard<py::gil_scoped_release>())
-      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats);
+      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats)
+      .def(
+          "get_bucket_wait_stats",
+          &::c10d::Reducer::get_bucket_wait_stats,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "get_bucket_indices",
+          &::c10d::Reducer::get_bucket_indices,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "enable_bucket_rebuilding",
+          &::c10d::Reducer::enable_bucket_rebuilding,
+          py::arg("bucket_size_limits"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "_register_comm_hook",
+          &::c10d::Reducer::register_comm_hook,
+          py::arg("comm_hook"),
+          py::call_guard<py::gil_scoped_release>());
+
+  shared_ptr_class_<::c10d::CommHook>(module, "CommHook");
+
+  shared_ptr_class_<::c10d::FP16CompressionHook, ::c10d::CommHook>(
+      module, "FP16CompressionHook")
+      .def(
+          py::init<std::shared_ptr<::c10d::ProcessGroup>>(),
+          py::arg("process_group"));
+
+  shared_ptr_class_<::c10d::TopKSparsificationHook, ::c10d::CommHook>(
+      module, "TopKSparsificationHook")
+      .def(
+          py::init<std::shared_ptr<::c10d::ProcessGroup>, double>(),
+          py::arg("process_group"),
+          py::arg("ratio"));
+
+  shared_ptr_class_<::c10d::PowerSGDHook, ::c10d::CommHook>(
+      module, "PowerSGDHook")
+      .def(
+          py::init<std::shared_ptr<::c10d::ProcessGroup>, int64_t, uint64_t>(),
+          py::arg("process_group"),
+          py::arg("rank"),
+          py::arg("seed") = 0);
 
   py::enum_<::c10d::ReduceOp>(module, "ReduceOp", R"(
 An enum-like class of available reduce operations: ``SUM``, ``PRODUCT``,
@@ -165,10 +207,56 @@ They are used in specifying strategies for reduction collectives, e.g.,
                     reinterpret_cast<char*>(value.data()), value.size());
               },
               py::call_guard<py::gil_scoped_release>())
+          .def(
+              "multi_set",
+              [](::c10d::Store& store,
+                 const std::vector<std::string>& keys,
+                 const std::vector<std::string>& values) {
+                std::vector<std::vector<uint8_t>> values_;
+                values_.reserve(values.size());
+                for (const auto& value : values) {
+                  values_.emplace_back(value.begin(), value.end());
+                }
+                store.multiSet(keys, values_);
+              },
+              py::call_guard<py::gil_scoped_release>())
+          // Returns a list of py::bytes, so it needs the GIL once the values
+          // have been received.
+          .def(
+              "multi_get",
+              [](::c10d::Store& store, const std::vector<std::string>& keys) {
+                std::vector<std::vector<uint8_t>> values;
+                {
+                  py::gil_scoped_release release;
+                  values = store.multiGet(keys);
+                }
+                py::list result;
+                for (auto& value : values) {
+                  result.append(py::bytes(
+                      reinterpret_cast<char*>(value.data()), value.size()));
+                }
+                return result;
+              })
           .def(
               "add",
               &::c10d::Store::add,
               py::call_guard<py::gil_scoped_release>())
+          .def(
+              "compare_set",
+              [](::c10d::Store& store,
+                 const std::string& key,
+                 const std::string& expected_value,
+                 const std::string& desired_value) -> py::bytes {
+                std::vector<uint8_t> expected_value_(
+                    expected_value.begin(), expected_value.end());
+                std::vector<uint8_t> desired_value_(
+                    desired_value.begin(), desired_value.end());
+                auto value =
+                    store.compareSet(key, expected_value_, desired_value_);
+                return py::bytes(
+                    reinterpret_cast<char*>(value.data()), value.size());
+              },
+              py::call_guard<py::gil_scoped_release>())
           .def(
               "set_timeout",
               &::c10d::Store::setTimeout,
@@ -420,7 +508,13 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def(py::init<>())
       .def_readwrite("devices", &::c10d::ProcessGroupGloo::Options::devices)
       .def_readwrite("timeout", &::c10d::ProcessGroupGloo::Options::timeout)
-      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads);
+      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads)
+      .def_readwrite(
+          "hierarchical_allreduce",
+          &::c10d::ProcessGroupGloo::Options::hierarchicalAllreduce)
+      .def_readwrite(
+          "hierarchical_allreduce_host",
+          &::c10d::ProcessGroupGloo::Options::hierarchicalAllreduceHost);
 
   processGroupGloo.def_static(
       "create_device",
@@ -466,6 +560,13 @@ They are used in specifying strategies for reduction collectives, e.g.,
                   ::c10d::ProcessGroupGloo::createDeviceForHostname(""));
             }
 
+            // Allreduce hierarchically if "GLOO_HIERARCHICAL_ALLREDUCE" is
+            // set to 1.
+            char* hierarchicalEnv = getenv(GLOO_HIERARCHICAL_ALLREDUCE_ENV);
+            if (hierarchicalEnv && std::string(hierarchicalEnv) == "1") {
+              options.hierarchicalAllreduce = true;
+            }
+
             options.timeout = timeout;
             options.threads = options.devices.size() * 2;
             return std::make_shared<::c10d::ProcessGroupGloo>(
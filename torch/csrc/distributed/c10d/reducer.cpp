@@ -1,6 +1,8 @@
 #include <torch/csrc/distributed/c10d/reducer.h>
 
+#include <algorithm>
 #include <functional>
+#include <limits>
 
 #include <c10/util/Exception.h>
 #include <torch/csrc/autograd/engine.h>
@@ -279,6 +281,9 @@ void Reducer::mark_variable_ready(VariableIndex index) {
   const auto& bucket_index = variable_locators_[variable_index];
   auto& bucket = buckets_[bucket_index.bucket_index];
   auto& replica = bucket.replicas[replica_index];
+  if (bucket.first_ready_time < 0) {
+    bucket.first_ready_time = current_time_in_nanos();
+  }
 
   // Something is wrong if all variables contained in this bucket replica have
   // already been marked as ready.
@@ -310,6 +315,11 @@ void Reducer::mark_variable_ready(VariableIndex index) {
     mark_variable_ready_dense(index);
   }
 
+  // Record the order gradients are ready in to rebuild the buckets with.
+  if (!rebuild_bucket_size_limits_.empty() && replica_index == 0) {
+    ready_order_.push_back(variable_index);
+  }
+
   // TODO(@pietern): Make this work for both CPU/CUDA tensors.
   // When using CPU tensors we don't need to do this.
   // // Record event so that we can wait for all of them.
@@ -365,8 +375,142 @@ void Reducer::mark_bucket_ready(size_t bucket_index) {
       //
       tensors.push_back(replica.contents);
     }
-    bucket.work = process_group_->allreduce(tensors);
+    bucket.ready_wait_time =
+        current_time_in_nanos() - bucket.first_ready_time;
+    if (comm_hook_ && !bucket.expect_sparse_gradient) {
+      bucket.work = comm_hook_->runHook(next_bucket_, tensors);
+    } else {
+      bucket.work = process_group_->allreduce(tensors);
+    }
+  }
+}
+
+std::vector<std::vector<int64_t>> Reducer::get_bucket_wait_stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::vector<int64_t>> result;
+  result.reserve(buckets_.size());
+  for (const auto& bucket : buckets_) {
+    result.push_back({bucket.ready_wait_time, bucket.work_wait_time});
   }
+  return result;
+}
+
+std::vector<std::vector<size_t>> Reducer::get_bucket_indices() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::vector<size_t>> result(buckets_.size());
+  for (size_t i = 0; i < buckets_.size(); i++) {
+    result[i].resize(buckets_[i].replicas[0].variables.size());
+  }
+  for (size_t variable_index = 0; variable_index < variable_locators_.size();
+       variable_index++) {
+    const auto& locator = variable_locators_[variable_index];
+    result[locator.bucket_index][locator.intra_bucket_index] = variable_index;
+  }
+  return result;
+}
+
+void Reducer::enable_bucket_rebuilding(
+    std::vector<size_t> bucket_size_limits) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  AT_ASSERTM(
+      !bucket_size_limits.empty(), "Expected at least one bucket size limit.");
+  rebuild_bucket_size_limits_ = std::move(bucket_size_limits);
+  ready_order_.clear();
+}
+
+// Sizes all but the first bucket such that the fixed latency of an allreduce
+// is at most 10% of the time it takes to allreduce a bucket, within the
+// bounds of the first and the last bucket size limit. The allreduce time is
+// modeled as a fixed latency plus a time per byte, which are measured by
+// allreducing a single element and a bucket of the maximum size.
+// This must be called by all processes.
+std::vector<size_t> Reducer::adapt_bucket_size_limits() const {
+  auto limits = rebuild_bucket_size_limits_;
+  const auto& variable = replicas_[0][0];
+  const auto options =
+      at::TensorOptions().dtype(variable.dtype()).device(variable.device());
+  const auto element_size = variable.element_size();
+  const auto max_bytes = limits.back();
+  const auto min_bytes = std::min(limits.front(), max_bytes);
+
+  // The fastest of a few allreduces, the first of which may set up
+  // buffers for tensors of this size.
+  const auto time_allreduce = [&](size_t bytes) {
+    std::vector<at::Tensor> tensors = {at::zeros(
+        {static_cast<int64_t>(std::max<size_t>(1, bytes / element_size))},
+        options)};
+    auto fastest = std::numeric_limits<int64_t>::max();
+    for (int i = 0; i < 3; i++) {
+      const auto start = current_time_in_nanos();
+      process_group_->allreduce(tensors)->wait();
+      fastest = std::min(fastest, current_time_in_nanos() - start);
+    }
+    return fastest;
+  };
+  const auto latency = time_allreduce(element_size);
+  const auto max_bytes_time = time_allreduce(max_bytes);
+  if (max_bytes_time <= latency) {
+    return limits;
+  }
+
+  const auto time_per_byte =
+      static_cast<double>(max_bytes_time - latency) / max_bytes;
+  const auto bytes = static_cast<size_t>(9 * latency / time_per_byte);
+  limits.back() = std::min(max_bytes, std::max(min_bytes, bytes));
+  return limits;
+}
+
+// Rebuilds the buckets in the order gradients were ready in on the process
+// with rank 0. This must be called by all processes.
+void Reducer::rebuild_buckets() {
+  const auto variable_count = replicas_[0].size();
+  AT_ASSERT(ready_order_.size() == variable_count);
+  auto limits = adapt_bucket_size_limits();
+
+  // Broadcast the bucket size limits and the order of rank 0.
+  auto message = at::empty(
+      {static_cast<int64_t>(limits.size() + variable_count)}, at::kLong);
+  auto data = message.data_ptr<int64_t>();
+  std::copy(limits.begin(), limits.end(), data);
+  std::copy(ready_order_.begin(), ready_order_.end(), data + limits.size());
+  std::vector<at::Tensor> tensors = {message.to(replicas_[0][0].device())};
+  process_group_->broadcast(tensors)->wait();
+  message = tensors[0].cpu();
+  data = message.data_ptr<int64_t>();
+  std::copy(data, data + limits.size(), limits.begin());
+  std::copy(data + limits.size(), data + message.numel(), ready_order_.begin());
+
+  // Assign buckets as if the variables were specified in this order.
+  std::vector<at::Tensor> ordered_variables;
+  std::vector<bool> ordered_expect_sparse_gradients;
+  ordered_variables.reserve(variable_count);
+  ordered_expect_sparse_gradients.reserve(variable_count);
+  for (const auto variable_index : ready_order_) {
+    AT_ASSERTM(
+        variable_index < variable_count,
+        "Out of range variable index in bucket order.");
+    ordered_variables.push_back(replicas_[0][variable_index]);
+    ordered_expect_sparse_gradients.push_back(
+        expect_sparse_gradients_[0][variable_index]);
+  }
+  auto bucket_indices = compute_bucket_assignment_by_size(
+      ordered_variables, limits, ordered_expect_sparse_gradients);
+  for (auto& bucket : bucket_indices) {
+    for (auto& index : bucket) {
+      index = ready_order_[index];
+    }
+  }
+  initialize_buckets_locked(std::move(bucket_indices));
+}
+
+void Reducer::register_comm_hook(std::shared_ptr<CommHook> comm_hook) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // This shouldn't be called while buckets are being reduced.
+  AT_ASSERTM(
+      !expect_autograd_hooks_,
+      "`register_comm_hook` must NOT be called during autograd execution.");
+  comm_hook_ = std::move(comm_hook);
 }
 
 void Reducer::initialize_buckets(
@@ -378,6 +522,16 @@ void Reducer::initialize_buckets(
       !expect_autograd_hooks_,
       "`initialize_buckets` must NOT be called during autograd execution.");
 
+  initialize_buckets_locked(std::move(bucket_indices));
+}
+
+void Reducer::initialize_buckets_locked(
+    std::vector<std::vector<size_t>> bucket_indices) {
+  // Per-bucket state of the communication hook refers to the old buckets.
+  if (comm_hook_) {
+    comm_hook_->reset();
+  }
+
   // Clear current bucket assignment.
   buckets_.clear();
   variable_locators_.clear();
@@ -518,6 +672,15 @@ void Reducer::prepare_for_backward(
         "list, dict, iterable).");
   }
 
+  // Rebuild the buckets once gradients were ready for all variables.
+  if (!rebuild_bucket_size_limits_.empty()) {
+    if (ready_order_.size() == replicas_[0].size()) {
+      rebuild_buckets();
+      rebuild_bucket_size_limits_.clear();
+    }
+    ready_order_.clear();
+  }
+
   // Reset accounting.
   expect_autograd_hooks_ = true;
   next_bucket_ = 0;
@@ -527,6 +690,7 @@ void Reducer::prepare_for_backward(
       replica.pending = replica.variables.size();
     }
     bucket.pending = bucket.replicas.size();
+    bucket.first_ready_time = -1;
   }
 
   // Reset unused parameter accounting.
@@ -575,7 +739,17 @@ void Reducer::prepare_for_backward(
 }
 
 // A bucket with one or more dense tensors needs to be unflattened.
-void Reducer::finalize_bucket_dense(Bucket& bucket) {
+// If a communication hook reduced it, the hook writes its result back to
+// the bucket contents first.
+void Reducer::finalize_bucket_dense(size_t bucket_index, Bucket& bucket) {
+  if (comm_hook_) {
+    std::vector<at::Tensor> tensors;
+    tensors.reserve(bucket.replicas.size());
+    for (const auto& replica : bucket.replicas) {
+      tensors.push_back(replica.contents);
+    }
+    comm_hook_->finalize(bucket_index, tensors);
+  }
   for (auto& replica : bucket.replicas) {
     for (size_t intra_bucket_index = 0;
          intra_bucket_index < replica.variables.size();
@@ -622,13 +796,17 @@ void Reducer::finalize_backward() {
   AT_ASSERT(next_bucket_ == buckets_.size());
 
   // Wait for asynchronous reduction to complete and unflatten contents.
-  for (auto& bucket : buckets_) {
+  for (size_t bucket_index = 0; bucket_index < buckets_.size();
+       bucket_index++) {
+    auto& bucket = buckets_[bucket_index];
     AT_ASSERT(bucket.work);
+    const auto wait_start = current_time_in_nanos();
     bucket.work->wait();
+    bucket.work_wait_time = current_time_in_nanos() - wait_start;
     if (bucket.expect_sparse_gradient) {
       finalize_bucket_sparse(bucket);
     } else {
-      finalize_bucket_dense(bucket);
+      finalize_bucket_dense(bucket_index, bucket);
     }
   }
 }
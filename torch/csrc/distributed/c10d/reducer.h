@@ -9,6 +9,7 @@
 
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/autograd/function.h>
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
 #include <torch/csrc/autograd/variable.h>
 
 namespace c10d {
@@ -47,6 +48,38 @@ class Reducer {
     return backward_stats_;
   }
 
+  // Returns the time in nanoseconds every bucket spent waiting in the last
+  // backward pass. The outer vector is for buckets, in the order they are
+  // reduced. The inner vector holds the time from the first gradient in the
+  // bucket being ready to its reduction being kicked off (i.e. waiting for
+  // the other gradients in the bucket and for the buckets before it), and
+  // the time spent waiting for its reduction to complete at the end of the
+  // backward pass.
+  std::vector<std::vector<int64_t>> get_bucket_wait_stats();
+
+  // Returns the indices of the variables in every bucket, in the order the
+  // buckets are reduced. These change when the buckets are rebuilt, see
+  // `enable_bucket_rebuilding`.
+  std::vector<std::vector<size_t>> get_bucket_indices();
+
+  // Rebuilds the buckets once, at the start of the next iteration after a
+  // backward pass in which all gradients were reduced, such that they hold
+  // variables in the order in which their gradients became ready in that
+  // backward pass instead of the order they were specified in.
+  //
+  // The bucket size limits are used like in
+  // `compute_bucket_assignment_by_size`, except that the last limit is an
+  // upper bound: all but the first bucket are sized such that the fixed
+  // latency of an allreduce, as measured on this process group, is small
+  // compared to the time it takes to transfer the bucket. The order and the
+  // measurements of the process with rank 0 are used by all processes.
+  void enable_bucket_rebuilding(std::vector<size_t> bucket_size_limits);
+
+  // Replaces the allreduce of dense buckets with the specified hook.
+  // Buckets that expect a sparse gradient are always allreduced.
+  // This must be called before the first backward pass it should apply to.
+  void register_comm_hook(std::shared_ptr<CommHook> comm_hook);
+
  protected:
   // Forward declaration.
   struct Bucket;
@@ -61,6 +94,7 @@ class Reducer {
   std::vector<std::vector<torch::autograd::Variable>> replicas_;
   std::shared_ptr<c10d::ProcessGroup> process_group_;
   std::vector<std::vector<bool>> expect_sparse_gradients_;
+  std::shared_ptr<CommHook> comm_hook_;
 
   std::vector<std::vector<std::shared_ptr<torch::autograd::Node>>>
       grad_accumulators_;
@@ -85,7 +119,14 @@ class Reducer {
 
   void mark_bucket_ready(size_t bucket_index);
 
-  void finalize_bucket_dense(Bucket& replica);
+  void initialize_buckets_locked(
+      std::vector<std::vector<size_t>> bucket_indices);
+
+  std::vector<size_t> adapt_bucket_size_limits() const;
+
+  void rebuild_buckets();
+
+  void finalize_bucket_dense(size_t bucket_index, Bucket& replica);
 
   void finalize_bucket_sparse(Bucket& replica);
 
@@ -143,10 +184,26 @@ class Reducer {
     // If this bucket should expect a single sparse gradient.
     // Implies: replicas[i].variables.size() == 1.
     bool expect_sparse_gradient = false;
+
+    // Time the first gradient in this bucket was ready in this iteration,
+    // or -1 if none was yet.
+    int64_t first_ready_time = -1;
+
+    // See `get_bucket_wait_stats`.
+    int64_t ready_wait_time = 0;
+    int64_t work_wait_time = 0;
   };
 
   std::vector<Bucket> buckets_;
 
+  // Bucket size limits to rebuild the buckets with, or empty if they are
+  // not to be rebuilt (anymore). See `enable_bucket_rebuilding`.
+  std::vector<size_t> rebuild_bucket_size_limits_;
+
+  // Indices of the variables of the first model replica, in the order in
+  // which their gradients became ready in the last backward pass.
+  std::vector<size_t> ready_order_;
+
   // A variable locator locates a particular variable in the bucket
   // structure. The `bucket_index` field points to the bucket in the `buckets_`
   // vector. The `intra_bucket_index` field points to the index of the variable
@@ -9,46 +9,35 @@ namespace rpc {
 
 namespace {
 
-// Write the message into the given ostream
-void serialize(const Message& message, std::ostream& os) {
-  // We cast const void* to void* here because we need to create a tensor using
-  // that memory space. If is fine as that tensor stays function-local, and will
-  // not be modified during its lifetime.
-  auto payload = const_cast<void*>( // NOLINT
-      static_cast<const void*>(message.payload().data()));
-  auto payload_size = message.payload().size();
-
-  // getting tensor table from the message
-  std::vector<torch::Tensor> tensors = message.tensors();
-  // append payload as a tensor
-  tensors.push_back(torch::from_blob(payload, payload_size, {torch::kChar}));
-  // append id as a tensor
-  tensors.push_back(torch::tensor({message.id()}, {torch::kInt64}));
-
-  torch::save(tensors, os);
-}
-
-Message deserialize(MessageType type, std::istream& is) {
-  std::vector<torch::Tensor> tensors;
-
-  torch::load(tensors, is);
-
-  TORCH_CHECK(tensors.size() >= 2, "Failed to deserialize a message.");
-  auto idTensor = std::move(tensors.back());
-  tensors.pop_back();
-  auto payloadTensor = std::move(tensors.back());
-  tensors.pop_back();
-
-  int64_t id = idTensor.storage().data<int64_t>()[0];
-
-  std::vector<char> payload(payloadTensor.numel());
-
-  if (payloadTensor.numel() > 0) {
-    std::memcpy(
-        payload.data(), payloadTensor.storage().data(), payloadTensor.numel());
-  }
-
-  return Message(std::move(payload), std::move(tensors), type, id);
+// Wire format of a message. A message is sent as a series of tensors to the
+// same tag: a preamble, a table describing the tensors of the message, the
+// payload, and then the data of each of the tensors. The payload and the
+// tensors are sent from their own memory, and received straight into the
+// vector and the tensors that make up the received message, so messages are
+// never copied into an intermediate buffer. Empty parts are not sent.
+//
+// preamble (int64[kPreambleSize]):
+//   source rank, message type, message id, payload size in bytes, number of
+//   tensors, size of the tensor table
+// tensor table (int64[table size]), for each tensor:
+//   scalar type, requires_grad, device type, device index, number of
+//   dimensions, sizes
+//
+// The data of tensors on other devices is sent from a CPU copy, and the
+// receiver moves it back to the device.
+constexpr int64_t kPreambleSrcRank = 0;
+constexpr int64_t kPreambleType = 1;
+constexpr int64_t kPreambleId = 2;
+constexpr int64_t kPreamblePayloadSize = 3;
+constexpr int64_t kPreambleNumTensors = 4;
+constexpr int64_t kPreambleTableSize = 5;
+constexpr int64_t kPreambleSize = 6;
+
+// Views data as a tensor to send or receive it. It must not be modified
+// while it is being sent.
+torch::Tensor wrap(const void* data, int64_t size, torch::Dtype dtype) {
+  return torch::from_blob(
+      const_cast<void*>(data), {size}, torch::TensorOptions(dtype)); // NOLINT
 }
 
 } // namespace
@@ -183,6 +172,14 @@ std::shared_ptr<FutureMessage> ProcessGroupAgent::sendImpl(
       to.id_,
       ", but world size is ",
       pg_->getRank());
+  // checked here rather than when the message is sent by the thread pool, so
+  // that a message we can't send throws to the caller
+  for (const auto& tensor : message.tensors()) {
+    TORCH_CHECK(
+        tensor.layout() == torch::kStrided,
+        "ProcessGroupAgent can only send dense tensors, got ",
+        tensor.toString());
+  }
 
   auto requestId = nextId();
   auto future = std::make_shared<FutureMessage>();
@@ -213,36 +210,58 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
   // NB: this can be changed to use a native move capture when moved to C++14
   threadPool_.run(std::bind(
       [&](const SendWork& work) {
-        std::stringstream ss;
-        serialize(work.message_, ss);
-        std::string serializedPayload = ss.str();
-
-        std::vector<torch::Tensor> preamble = {torch::tensor(
-            {(int64_t)pg_->getRank(),
-             (int64_t)serializedPayload.length(),
-             (int64_t)work.message_.type()},
-            {torch::kLong})};
+        const Message& message = work.message_;
+        std::vector<torch::Tensor> tensors;
+        std::vector<int64_t> table;
+        tensors.reserve(message.tensors().size());
+        for (const auto& tensor : message.tensors()) {
+          tensors.push_back(tensor.cpu().contiguous());
+          table.push_back(static_cast<int64_t>(tensor.scalar_type()));
+          table.push_back(tensor.requires_grad());
+          table.push_back(static_cast<int64_t>(tensor.device().type()));
+          table.push_back(tensor.device().index());
+          table.push_back(tensor.dim());
+          for (int64_t size : tensor.sizes()) {
+            table.push_back(size);
+          }
+        }
+        std::vector<int64_t> preamble(kPreambleSize);
+        preamble[kPreambleSrcRank] = pg_->getRank();
+        preamble[kPreambleType] = message.type();
+        preamble[kPreambleId] = message.id();
+        preamble[kPreamblePayloadSize] = message.payload().size();
+        preamble[kPreambleNumTensors] = tensors.size();
+        preamble[kPreambleTableSize] = table.size();
+
+        std::vector<std::vector<torch::Tensor>> parts;
+        parts.push_back({wrap(preamble.data(), kPreambleSize, torch::kInt64)});
+        if (!table.empty()) {
+          parts.push_back({wrap(table.data(), table.size(), torch::kInt64)});
+        }
+        if (!message.payload().empty()) {
+          parts.push_back({wrap(
+              message.payload().data(),
+              message.payload().size(),
+              torch::kChar)});
+        }
+        for (const auto& tensor : tensors) {
+          if (tensor.numel() > 0) {
+            parts.push_back({tensor});
+          }
+        }
 
         // ProcessGroup is not thread-safe when sending with the same tag, hence
-        // the lock
+        // the lock, which also keeps the parts of different messages from
+        // interleaving
         std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingSends;
+        pendingSends.reserve(parts.size());
         const auto& dst = work.to_.id_;
-        if (work.message_.isShutdown()) {
-          pendingSends.reserve(1);
-          std::lock_guard<std::mutex> guard(sendMutexes_[dst]);
-          pendingSends.emplace_back(
-              pg_->send(preamble, dst, dst /* channelTag */));
-        } else {
-          std::vector<torch::Tensor> payload = {torch::from_blob(
-              (void*)serializedPayload.c_str(),
-              serializedPayload.length(),
-              {torch::kChar})};
-          pendingSends.reserve(2);
+        {
           std::lock_guard<std::mutex> guard(sendMutexes_[dst]);
-          pendingSends.emplace_back(
-              pg_->send(preamble, dst, dst /* channelTag */));
-          pendingSends.emplace_back(
-              pg_->send(payload, dst, dst /* channelTag */));
+          for (auto& part : parts) {
+            pendingSends.emplace_back(
+                pg_->send(part, dst, dst /* channelTag */));
+          }
         }
         for (auto& pendingSend : pendingSends) {
           pendingSend->wait();
@@ -254,11 +273,7 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
 void ProcessGroupAgent::enqueueRecv(RecvWork work) {
   threadPool_.run(std::bind(
       [&](RecvWork& work) {
-        torch::Tensor& payload = work.payload_;
-        std::stringstream ss(std::string(
-            (char*)payload.storage().data<signed char>(), payload.numel()));
-
-        Message message = deserialize(work.type_, ss);
+        Message& message = work.message_;
 
         if (message.requiresResponse()) {
           send(work.from_, cb_(std::move(message)));
@@ -281,14 +296,13 @@ void ProcessGroupAgent::enqueueRecv(RecvWork work) {
 
 void ProcessGroupAgent::listenLoop() {
   while (true) {
-    // rank, tensor size, message type
-    std::vector<torch::Tensor> preamble = {torch::empty({3}, {torch::kInt64})};
-    pg_->recvAnysource(preamble, pg_->getRank())->wait();
-    int64_t* preamble_items = preamble.front().storage().data<int64_t>();
+    std::vector<torch::Tensor> preambleTensor = {
+        torch::empty({kPreambleSize}, {torch::kInt64})};
+    pg_->recvAnysource(preambleTensor, pg_->getRank())->wait();
+    const int64_t* preamble = preambleTensor.front().data_ptr<int64_t>();
 
-    auto srcRank = preamble_items[0];
-    auto size = preamble_items[1];
-    MessageType type = MessageType(preamble_items[2]);
+    auto srcRank = preamble[kPreambleSrcRank];
+    MessageType type = MessageType(preamble[kPreambleType]);
 
     if (type == MessageType::SHUTDOWN) {
       // FIXME: This LOG also prints warnings no InitGoogleLogging() was invoked
@@ -299,10 +313,51 @@ void ProcessGroupAgent::listenLoop() {
       return;
     }
 
-    std::vector<torch::Tensor> tensors = {torch::empty({size}, {torch::kChar})};
-    pg_->recv(tensors, srcRank, pg_->getRank())->wait();
+    // the rest of the message follows from the same rank, received in the
+    // order it was sent
+    auto recv = [&](torch::Tensor tensor) {
+      std::vector<torch::Tensor> tensors = {std::move(tensor)};
+      pg_->recv(tensors, srcRank, pg_->getRank())->wait();
+    };
+
+    std::vector<int64_t> table(preamble[kPreambleTableSize]);
+    if (!table.empty()) {
+      recv(wrap(table.data(), table.size(), torch::kInt64));
+    }
+    std::vector<char> payload(preamble[kPreamblePayloadSize]);
+    if (!payload.empty()) {
+      recv(wrap(payload.data(), payload.size(), torch::kChar));
+    }
+    std::vector<torch::Tensor> tensors;
+    tensors.reserve(preamble[kPreambleNumTensors]);
+    size_t pos = 0;
+    for (int64_t i = 0; i < preamble[kPreambleNumTensors]; ++i) {
+      TORCH_CHECK(pos + 5 <= table.size(), "Failed to deserialize a message.");
+      auto scalarType = static_cast<torch::ScalarType>(table[pos++]);
+      bool requiresGrad = table[pos++];
+      auto deviceType = static_cast<c10::DeviceType>(table[pos++]);
+      auto deviceIndex = static_cast<c10::DeviceIndex>(table[pos++]);
+      int64_t dim = table[pos++];
+      TORCH_CHECK(
+          pos + dim <= table.size(), "Failed to deserialize a message.");
+      std::vector<int64_t> sizes(
+          table.begin() + pos, table.begin() + pos + dim);
+      pos += dim;
+      auto tensor = torch::empty(sizes, {scalarType});
+      if (tensor.numel() > 0) {
+        recv(tensor);
+      }
+      if (deviceType != torch::kCPU) {
+        tensor = tensor.to(torch::Device(deviceType, deviceIndex));
+      }
+      tensor.set_requires_grad(requiresGrad);
+      tensors.push_back(std::move(tensor));
+    }
 
-    enqueueRecv(RecvWork(workerIds_[srcRank], type, std::move(tensors[0])));
+    enqueueRecv(RecvWork(
+        workerIds_[srcRank],
+        Message(
+            std::move(payload), std::move(tensors), type, preamble[kPreambleId])));
   }
 }
 
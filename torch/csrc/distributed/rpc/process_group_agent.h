@@ -23,15 +23,15 @@ struct SendWork {
   Message message_;
 };
 
-// SendWork wraps a Message and RecvWork wraps a Tensor. The difference here is
-// to allow us to run serialization/deserialization in the worker threads.
+// RecvWork wraps a received Message, which the listener thread receives
+// straight into its payload and tensors, so only processing it is left to the
+// worker threads.
 struct RecvWork {
-  RecvWork(const WorkerId& from, MessageType type, torch::Tensor&& payload)
-      : from_(from), type_(type), payload_(payload) {}
+  RecvWork(const WorkerId& from, Message&& message)
+      : from_(from), message_(std::move(message)) {}
 
   const WorkerId& from_;
-  const MessageType type_;
-  torch::Tensor payload_;
+  Message message_;
 };
 
 class ProcessGroupAgent : public RpcAgent {
@@ -22,6 +22,7 @@
 #include <ATen/ATen.h>
 #include <c10/util/Optional.h>
 
+#include <atomic>
 #include <fstream>
 #include <memory>
 #include <set>
@@ -41,6 +42,11 @@ ExportModuleExtraFilesHook& GetExtraFilesHook() {
   static ExportModuleExtraFilesHook func = nullptr;
   return func;
 };
+
+std::atomic<bool>& GetTensorCompression() {
+  static std::atomic<bool> compress{false};
+  return compress;
+};
 }
 
 class ScriptModuleSerializer;
@@ -564,7 +570,12 @@ class ScriptModuleSerializer {
     for (const auto& td : data_pickle.tensorData()) {
       std::stringstream fname;
       fname << archive_name << "/" << i++;
-      writer_.writeRecord(fname.str(), td.data(), td.sizeInBytes());
+      if (GetTensorCompression()) {
+        writer_.writeBlockEncodedRecord(
+            fname.str(), td.data(), td.sizeInBytes(), td.elementSize());
+      } else {
+        writer_.writeRecord(fname.str(), td.data(), td.sizeInBytes());
+      }
     }
     std::stringstream fname;
     fname << archive_name << ".pkl";
@@ -877,6 +888,10 @@ void SetExportModuleExtraFilesHook(ExportModuleExtraFilesHook hook) {
   GetExtraFilesHook() = hook;
 }
 
+void SetExportModuleTensorCompression(bool compress) {
+  GetTensorCompression() = compress;
+}
+
 std::string pretty_print_onnx(
     const std::shared_ptr<Graph>& graph,
     const std::map<std::string, at::Tensor>& initializers,
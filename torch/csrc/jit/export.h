@@ -59,5 +59,11 @@ using ExportModuleExtraFilesHook =
     std::function<script::ExtraFilesMap(const script::Module&)>;
 TORCH_API void SetExportModuleExtraFilesHook(ExportModuleExtraFilesHook hook);
 
+// Makes modules serialize the data of their tensors compressed with the block
+// codec of caffe2/serialize/block_codec.h, which shrinks files of floating
+// point weights at the cost of slower saving. Loading such files needs no
+// option, and their records are decompressed in parallel.
+TORCH_API void SetExportModuleTensorCompression(bool compress);
+
 } // namespace jit
 } // namespace torch
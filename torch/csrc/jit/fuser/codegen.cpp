@@ -16,6 +16,8 @@
 #include <iostream>
 #include <sstream>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace torch {
@@ -286,15 +288,29 @@ static std::string encodeRHS(const Node* n) {
   }
 }
 
+// Writes RHS of prim::Constant
+static std::string encodeConstant(const Node* n) {
+  const auto val = toIValue(n->output()).value();
+  if (val.isDouble()) {
+    return scalarValue(val.toDouble());
+  } else if (val.isBool()) {
+    return scalarValue(val.toBool());
+  }
+  AT_ASSERT(val.isInt());
+  return scalarValue(val.toInt());
+}
+
 static void emitIndexingFor(
     std::ostream& out,
     const std::string& tensor,
     const int ndim,
-    const bool last_is_cont) {
+    const bool last_is_cont,
+    const std::string& index = "linearIndex") {
   TemplateEnv env;
   env.s("tensor", tensor);
+  env.s("index", index);
   out << format("IndexType ${tensor}_offset = 0;\n", env);
-  out << format("IndexType ${tensor}_linearIndex = linearIndex;\n", env);
+  out << format("IndexType ${tensor}_linearIndex = ${index};\n", env);
   for (int d = ndim - 1; d >= 0; --d) {
     env.d("d", d);
     env.s("mod_sizes", d > 0 ? format("% ${tensor}.sizes[${d}]", env) : "");
@@ -310,6 +326,240 @@ static void emitIndexingFor(
   }
 }
 
+// Note [Reductions in CPU fusion groups]
+// CPU fusion groups can contain sums and means along the last dimension of
+// the map size (see graph_fuser.cpp). Their kernels loop over the rows of the
+// map size, i.e. over its elements grouped by all but the last dimension, and
+// compute each row in passes over its elements:
+//  - A reduction is accumulated in the first pass in which its input can be
+//    computed, one pass after the last reduction that its input depends on.
+//    Layer norm, for example, accumulates the mean in the first pass and the
+//    variance in the second.
+//  - The values computed only from reductions hold one element per row (see
+//    findRowValues). They are computed once per row, between passes, and
+//    outputs among them are written once per row.
+//  - The last pass computes and writes the other outputs.
+// Passes recompute the elementwise values they need instead of storing them,
+// so each pass reads the inputs of the row once and nothing is written but
+// the outputs.
+//
+// The elements of a row are consecutive in the innermost compressed dimension
+// of all tensors, which is a multiple of the row size, so passes address them
+// by the offset of the row plus their index times the innermost stride. The
+// accumulation is split into REDUCTION_LANES independent sums, which the
+// compiler keeps in vector registers without reassociating floating point
+// additions.
+
+bool isFusedReduction(const Node* n) {
+  return n->kind() == aten::sum || n->kind() == aten::mean;
+}
+
+std::unordered_set<const Value*> findRowValues(const Graph& graph) {
+  std::unordered_set<const Value*> rows;
+  for (const Node* n : graph.nodes()) {
+    if (isFusedReduction(n)) {
+      rows.insert(n->output());
+      continue;
+    }
+    bool has_tensor_input = false;
+    bool all_rows = true;
+    for (const Value* input : n->inputs()) {
+      if (input->type()->isSubtypeOf(TensorType::get())) {
+        has_tensor_input = true;
+        all_rows &= rows.count(input) > 0;
+      }
+    }
+    if (has_tensor_input && all_rows) {
+      rows.insert(n->outputs().begin(), n->outputs().end());
+    }
+  }
+  return rows;
+}
+
+// Writes the body of a kernel with reductions, which computes the row at
+// rowIndex (see Note [Reductions in CPU fusion groups])
+static void emitReductionBody(
+    std::ostream& body,
+    const Graph& graph,
+    const std::vector<std::pair<const Value*, const c10::optional<TensorDesc>>>& inputs,
+    const std::vector<std::pair<const Value*, const TensorDesc>>& outputs,
+    const std::unordered_set<const Value*>& rows) {
+  TemplateEnv env;
+
+  // Addresses the element at elementIndex in the row of the formal
+  std::unordered_map<const Value*, std::string> input_access;
+  auto elementAccess = [&](size_t formal, const TensorDesc& desc) {
+    env.d("formal", formal);
+    env.d("last", desc.nDim() - 1);
+    return format(
+        desc.lastIsContiguous()
+            ? "t${formal}.data[t${formal}_offset + elementIndex]"
+            : "t${formal}.data[t${formal}_offset + elementIndex * t${formal}.strides[${last}]]",
+        env);
+  };
+
+  // Scalars and constants are the same for all elements
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const Value* input = inputs[i].first;
+    if (inputs[i].second) {
+      AT_ASSERT(inputs[i].second->nDim() > 0);
+      input_access[input] = elementAccess(i, *inputs[i].second);
+      continue;
+    }
+    env.s("node", valueName(input));
+    env.d("formal", i);
+    env.s("lhs_type", variableType(input->type()));
+    body << format("${lhs_type} ${node} = s${formal};\n", env);
+  }
+  // Note: the dim lists of reductions are not emitted
+  for (const Node* n : graph.nodes()) {
+    AT_ASSERT(
+        n->kind() != prim::FusedConcat && n->kind() != prim::ConstantChunk);
+    if (n->kind() == prim::Constant &&
+        (n->output()->type()->isSubtypeOf(NumberType::get()) ||
+         n->output()->type()->isSubtypeOf(BoolType::get()))) {
+      env.s("node", valueName(n->output()));
+      env.s("rhs", encodeConstant(n));
+      env.s("lhs_type", variableType(n->output()->type()));
+      body << format("${lhs_type} ${node} = ${rhs};\n", env);
+    }
+  }
+
+  // Assigns each reduction to the pass accumulating it
+  std::unordered_map<const Value*, size_t> depth;
+  std::vector<std::vector<const Node*>> passes;
+  for (const Node* n : graph.nodes()) {
+    size_t d = 0;
+    for (const Value* input : n->inputs()) {
+      auto it = depth.find(input);
+      if (it != depth.end()) {
+        d = std::max(d, it->second);
+      }
+    }
+    if (isFusedReduction(n)) {
+      if (passes.size() <= d) {
+        passes.resize(d + 1);
+      }
+      passes[d].push_back(n);
+      d++;
+    }
+    for (const Value* output : n->outputs()) {
+      depth[output] = d;
+    }
+  }
+
+  // Loads the inputs and computes the elementwise values that targets need,
+  // in graph order
+  auto emitElement = [&](const std::vector<const Value*>& targets) {
+    std::unordered_set<const Value*> needed;
+    std::vector<const Value*> stack = targets;
+    while (!stack.empty()) {
+      const Value* v = stack.back();
+      stack.pop_back();
+      if (rows.count(v) || !needed.insert(v).second) {
+        continue;
+      }
+      for (const Value* input : v->node()->inputs()) {
+        stack.push_back(input);
+      }
+    }
+    for (const Value* input : graph.inputs()) {
+      if (needed.count(input) && input_access.count(input)) {
+        env.s("node", valueName(input));
+        env.s("access", input_access.at(input));
+        env.s("lhs_type", variableType(input->type()));
+        body << format("${lhs_type} ${node} = ${access};\n", env);
+      }
+    }
+    for (const Node* n : graph.nodes()) {
+      if (n->kind() == prim::Constant || !needed.count(n->output())) {
+        continue;
+      }
+      env.s("node", valueName(n->output()));
+      env.s("rhs", encodeRHS(n));
+      env.s("lhs_type", variableType(n->output()->type()));
+      body << format("${lhs_type} ${node} = ${rhs};\n", env);
+    }
+  };
+
+  for (size_t pass = 0; pass < passes.size(); ++pass) {
+    std::vector<const Value*> targets;
+    for (const Node* n : passes[pass]) {
+      AT_ASSERT(rows.count(n->input(0)) == 0);
+      targets.push_back(n->input(0));
+      env.s("node", valueName(n->output()));
+      env.s("lhs_type", variableType(n->output()->type()));
+      body << format("${lhs_type} ${node}_lanes[REDUCTION_LANES] = {0};\n", env);
+    }
+    auto accumulate = [&](const std::string& lane) {
+      for (const Node* n : passes[pass]) {
+        env.s("node", valueName(n->output()));
+        env.s("input", valueName(n->input(0)));
+        env.s("lane", lane);
+        body << format("${node}_lanes[${lane}] += ${input};\n", env);
+      }
+    };
+    body << "for (IndexType laneStart = 0; laneStart + REDUCTION_LANES <= reductionSize; laneStart += REDUCTION_LANES) {\n";
+    body << "for (IndexType lane = 0; lane < REDUCTION_LANES; ++lane) {\n";
+    body << "IndexType elementIndex = laneStart + lane;\n";
+    emitElement(targets);
+    accumulate("lane");
+    body << "}\n}\n";
+    body << "for (IndexType elementIndex = reductionSize - reductionSize % REDUCTION_LANES; elementIndex < reductionSize; ++elementIndex) {\n";
+    emitElement(targets);
+    accumulate("0");
+    body << "}\n";
+
+    // Combines the lanes, then computes the row values that are now available
+    for (const Node* n : passes[pass]) {
+      env.s("node", valueName(n->output()));
+      env.s("lhs_type", variableType(n->output()->type()));
+      body << format("${lhs_type} ${node} = 0;\n", env);
+      body << format(
+          "for (IndexType lane = 0; lane < REDUCTION_LANES; ++lane) ${node} += ${node}_lanes[lane];\n",
+          env);
+      if (n->kind() == aten::mean) {
+        body << format("${node} /= reductionSize;\n", env);
+      }
+    }
+    for (const Node* n : graph.nodes()) {
+      if (isFusedReduction(n) || n->kind() == prim::Constant ||
+          !rows.count(n->output()) || depth.at(n->output()) != pass + 1) {
+        continue;
+      }
+      env.s("node", valueName(n->output()));
+      env.s("rhs", encodeRHS(n));
+      env.s("lhs_type", variableType(n->output()->type()));
+      body << format("${lhs_type} ${node} = ${rhs};\n", env);
+    }
+  }
+
+  // Writes the outputs
+  std::vector<const Value*> element_outputs;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    env.d("formal", inputs.size() + i);
+    env.s("node", valueName(outputs[i].first));
+    if (rows.count(outputs[i].first)) {
+      body << format("t${formal}.data[t${formal}_offset] = ${node};\n", env);
+    } else {
+      element_outputs.push_back(outputs[i].first);
+    }
+  }
+  if (!element_outputs.empty()) {
+    body << "for (IndexType elementIndex = 0; elementIndex < reductionSize; ++elementIndex) {\n";
+    emitElement(element_outputs);
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      if (rows.count(outputs[i].first)) {
+        continue;
+      }
+      env.s("access", elementAccess(inputs.size() + i, outputs[i].second));
+      env.s("node", valueName(outputs[i].first));
+      body << format("${access} = ${node};\n", env);
+    }
+    body << "}\n";
+  }
+}
+
 // TODO: handle cases where we need to generate > 2^32 element tensors
 std::string generateKernel(
     const std::string& name,
@@ -329,7 +579,9 @@ std::string generateKernel(
   std::vector<std::string> argument_loads;
 
   // Lambda for writing arguments
-  auto emitFormal = [&](const Value* n, const TensorDesc& desc) {
+  auto emitFormal = [&](const Value* n,
+                        const TensorDesc& desc,
+                        const std::string& index) {
     env.d(
         "formal_index",
         formals.size() +
@@ -339,7 +591,8 @@ std::string generateKernel(
           std::to_string(
               formals.size()); // can't be unique() because Param may be an output
       const auto nDim = desc.nDim();
-      emitIndexingFor(tensorOffsets, tensor, nDim, desc.lastIsContiguous());
+      emitIndexingFor(
+          tensorOffsets, tensor, nDim, desc.lastIsContiguous(), index);
       env.s("tensor", tensor);
       env.d("nDim", nDim);
       env.s("scalar_type", scalarTypeName(desc.scalar_type));
@@ -374,117 +627,120 @@ std::string generateKernel(
   // Writes input parameters
   for (const auto& input : inputs) {
     if (input.second.has_value()){
-      emitFormal(input.first, *input.second);
+      emitFormal(input.first, *input.second, "linearIndex");
     } else {
       emitScalarFormal(input.first);
     }
   }
 
   // Writes output parameters
+  // Note: in kernels with reductions, outputs computed only from reductions
+  //   are indexed by row
+  const bool has_reduction = std::any_of(
+      graph.nodes().begin(), graph.nodes().end(), isFusedReduction);
+  const auto rows = findRowValues(graph);
   for (const auto& output : outputs) {
-    emitFormal(output.first, output.second);
+    emitFormal(
+        output.first,
+        output.second,
+        rows.count(output.first) ? "rowIndex" : "linearIndex");
   }
 
-  // Acquires input values
   bool has_half_tensor = false;
-  size_t formal_count = 0;
-  for (const auto& input : inputs) {
-    auto p = input.first;
-    env.s("node", valueName(p));
-    env.d("formal", formal_count++);
-
-    // Acquires and converts (if needed) inputs
-    // Note: conversion from half is only supported for CUDA kernels.
-    //  The conversion immediately converts fp16 inputs to float.
-    //  Access for other types is common to CUDA and CPU kernels.
-    if (input.second.has_value()) {
-      const auto is_half = input.second.has_value() && ((*input.second).scalar_type == at::ScalarType::Half);
-      const auto is_bool = input.second.has_value() && ((*input.second).scalar_type == at::ScalarType::Bool);
-      if (is_half) {
-        AT_ASSERT(use_cuda);
-        env.s(
-            "access",
-            format("__half2float(t${formal}.data[t${formal}_offset])", env));
-        has_half_tensor = true;
-      } else if (use_cuda) {
-        // No __ldg overload for bool
-        if (is_bool) {
-          env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+  bool has_random = false;
+  if (has_reduction) {
+    AT_ASSERT(!use_cuda);
+    emitReductionBody(body, graph, inputs, outputs, rows);
+  } else {
+    // Acquires input values
+    size_t formal_count = 0;
+    for (const auto& input : inputs) {
+      auto p = input.first;
+      env.s("node", valueName(p));
+      env.d("formal", formal_count++);
+
+      // Acquires and converts (if needed) inputs
+      // Note: conversion from half is only supported for CUDA kernels.
+      //  The conversion immediately converts fp16 inputs to float.
+      //  Access for other types is common to CUDA and CPU kernels.
+      if (input.second.has_value()) {
+        const auto is_half = input.second.has_value() && ((*input.second).scalar_type == at::ScalarType::Half);
+        const auto is_bool = input.second.has_value() && ((*input.second).scalar_type == at::ScalarType::Bool);
+        if (is_half) {
+          AT_ASSERT(use_cuda);
+          env.s(
+              "access",
+              format("__half2float(t${formal}.data[t${formal}_offset])", env));
+          has_half_tensor = true;
+        } else if (use_cuda) {
+          // No __ldg overload for bool
+          if (is_bool) {
+            env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+          } else {
+            env.s("access", format("__ldg(&t${formal}.data[t${formal}_offset])", env));
+          }
         } else {
-          env.s("access", format("__ldg(&t${formal}.data[t${formal}_offset])", env));
+          env.s("access", format("t${formal}.data[t${formal}_offset]", env));
         }
+        env.s("lhs_type", calcScalarTypeName(input.second.value().scalar_type));
       } else {
-        env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+        env.s("access", format("s${formal}", env));
+        env.s("lhs_type", variableType(input.first->type()));
       }
-      env.s("lhs_type", calcScalarTypeName(input.second.value().scalar_type));
-    } else {
-      env.s("access", format("s${formal}", env));
-      env.s("lhs_type", variableType(input.first->type()));
+      body << format("${lhs_type} ${node} = ${access};\n", env);
     }
-    body << format("${lhs_type} ${node} = ${access};\n", env);
-  }
 
-  bool has_random = false;
-  // Generates code for intermediate nodes
-  // Note: Concat and Chunk are implicitly generated
-  // Note: Random number generation is only supported for CUDA kernels.
-  // Note: Constant None node is ignored and we will handle it in the
-  //       places where the constant None node is used
-  for (const auto& n : graph.nodes()) {
-    // Note: FusedConcat nodes work by narrowing the output Tensors before the
-    // kernel runs
-    if (n->kind() == prim::FusedConcat)
-      continue;
-    if (n->kind() == prim::ConstantChunk)
-      continue;
-    if (n->mustBeNone())
-      continue;
-    if (n->kind() == aten::rand_like) {
-      AT_ASSERT(use_cuda);
-      has_random = true;
-    }
-    // Always emit double for prim::Constant. This will be narrowed later based
-    // on either:
-    //  - Tensor-Scalar operator type rules
-    //  - Math function rules
-    if (n->kind() == prim::Constant) {
-      const auto val = toIValue(n->output()).value();
-      std::string rhs;
-      if (val.isDouble()) {
-        rhs = scalarValue(val.toDouble());
-      } else if (val.isBool()) {
-        rhs = scalarValue(val.toBool());
+    // Generates code for intermediate nodes
+    // Note: Concat and Chunk are implicitly generated
+    // Note: Random number generation is only supported for CUDA kernels.
+    // Note: Constant None node is ignored and we will handle it in the
+    //       places where the constant None node is used
+    for (const auto& n : graph.nodes()) {
+      // Note: FusedConcat nodes work by narrowing the output Tensors before the
+      // kernel runs
+      if (n->kind() == prim::FusedConcat)
+        continue;
+      if (n->kind() == prim::ConstantChunk)
+        continue;
+      if (n->mustBeNone())
+        continue;
+      if (n->kind() == aten::rand_like) {
+        AT_ASSERT(use_cuda);
+        has_random = true;
+      }
+      // Always emit double for prim::Constant. This will be narrowed later based
+      // on either:
+      //  - Tensor-Scalar operator type rules
+      //  - Math function rules
+      if (n->kind() == prim::Constant) {
+        env.s("node", valueName(n->output()));
+        env.s("rhs", encodeConstant(n));
+        env.s("lhs_type", variableType(n->output()->type()));
       } else {
-        AT_ASSERT(val.isInt());
-        rhs = scalarValue(val.toInt());
+        env.s("node", valueName(n->output()));
+        env.s("rhs", encodeRHS(n));
+        env.s("lhs_type", variableType(n->output()->type()));
       }
-      env.s("node", valueName(n->output()));
-      env.s("rhs", rhs);
-      env.s("lhs_type", variableType(n->output()->type()));
-    } else {
-      env.s("node", valueName(n->output()));
-      env.s("rhs", encodeRHS(n));
-      env.s("lhs_type", variableType(n->output()->type()));
+
+      body << format("${lhs_type} ${node} = ${rhs};\n", env);
     }
 
-    body << format("${lhs_type} ${node} = ${rhs};\n", env);
-  }
+    // Generates writes to output tensors
+    for (const auto& output : outputs) {
+      env.d("formal", formal_count++);
+      env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+      env.s("node", valueName(output.first));
 
-  // Generates writes to output tensors
-  for (const auto& output : outputs) {
-    env.d("formal", formal_count++);
-    env.s("access", format("t${formal}.data[t${formal}_offset]", env));
-    env.s("node", valueName(output.first));
-
-    // Acquires and converts (if needed) outputs
-    // Note: conversion to half is only supported for CUDA kernels.
-    const auto is_half = (output.second.scalar_type == at::ScalarType::Half);
-    if (is_half) {
-      AT_ASSERT(use_cuda);
-      body << format("${access} = __float2half(${node});\n", env);
-      has_half_tensor = true;
-    } else {
-      body << format("${access} = ${node};\n", env);
+      // Acquires and converts (if needed) outputs
+      // Note: conversion to half is only supported for CUDA kernels.
+      const auto is_half = (output.second.scalar_type == at::ScalarType::Half);
+      if (is_half) {
+        AT_ASSERT(use_cuda);
+        body << format("${access} = __float2half(${node});\n", env);
+        has_half_tensor = true;
+      } else {
+        body << format("${access} = ${node};\n", env);
+      }
     }
   }
 
@@ -507,6 +763,12 @@ std::string generateKernel(
   }
 
   // Insantiates the CUDA or CPU-specific templates
+  if (has_reduction) {
+    env.d("formal_index", formals.size() + 1);
+    argument_loads.push_back(
+        format("*static_cast<IndexType*>(args[${formal_index}])", env));
+  }
+
   env.s("tensorOffsets", tensorOffsets.str());
   env.s("kernelBody", body.str());
   env.v("formals", formals);
@@ -517,6 +779,10 @@ std::string generateKernel(
     code_string = cuda::cuda_compilation_unit_template.format(env);
   } else {
     env.s("type_declarations", cpu::type_declarations_template.format(env));
+    env.s(
+        "kernelFunction",
+        has_reduction ? cpu::cpu_reduction_kernel_template.format(env)
+                      : cpu::cpu_map_kernel_template.format(env));
     code_string = cpu::cpu_compilation_unit_template.format(env);
   }
 
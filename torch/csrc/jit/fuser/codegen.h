@@ -9,12 +9,23 @@
 #include <iostream>
 #include <string>
 #include <tuple>
+#include <unordered_set>
 #include <vector>
 
 namespace torch {
 namespace jit {
 namespace fuser {
 
+// Returns true if n is one of the reductions along the last dimension of the
+// map size that CPU fusion groups can contain
+// (see Note [Reductions in CPU fusion groups] in codegen.cpp)
+TORCH_API bool isFusedReduction(const Node* n);
+
+// Returns the values of a fusion group that hold one element per row of the
+// map size instead of one per element: the outputs of its reductions, and the
+// values computed only from them.
+TORCH_API std::unordered_set<const Value*> findRowValues(const Graph& graph);
+
 // Creates a CPU or CUDA kernel for the given graph.
 // Returns the C++ or CUDA string implementing the kernel.
 TORCH_API std::string generateKernel(
@@ -52,6 +52,28 @@ const FusedKernelConstructor& getConstructor(at::Device::Type backend_type) {
   return getFusionBackends().at(backend_type);
 }
 
+static std::unordered_map<at::Device::Type, GraphKernelConstructor>&
+getGraphFusionBackends() {
+  static std::unordered_map<at::Device::Type, GraphKernelConstructor>
+      graph_fusion_backends;
+  return graph_fusion_backends;
+}
+
+void registerGraphFusionBackend(
+    at::Device::Type backend_type,
+    GraphKernelConstructor ctor) {
+  std::lock_guard<std::mutex> guard(fusion_backends_lock_);
+  getGraphFusionBackends()[backend_type] = std::move(ctor);
+}
+
+static const GraphKernelConstructor* getGraphConstructor(
+    at::Device::Type backend_type) {
+  std::lock_guard<std::mutex> guard(fusion_backends_lock_);
+  auto& backends = getGraphFusionBackends();
+  auto it = backends.find(backend_type);
+  return it == backends.end() ? nullptr : &it->second;
+}
+
 // Counter for number of kernels compiled, used for debugging and
 // creating arbitrary kernel names.
 static std::atomic<size_t> next_kernel_id{0};
@@ -99,7 +121,11 @@ static void setInputChunkDescriptors(KernelSpec& spec) {
 }
 
 // Run a DFS traversal to find all inputs that affect a given output value
-static std::vector<int64_t> getInputDependencies(const Value* output) {
+// If elementwise_only is set, inputs that affect it only through reductions
+// are skipped.
+static std::vector<int64_t> getInputDependencies(
+    const Value* output,
+    bool elementwise_only = false) {
   std::vector<const Value*> queue{output};
   std::unordered_set<const Value*> inputs;
   std::unordered_set<const Value*> seen;
@@ -120,6 +146,9 @@ static std::vector<int64_t> getInputDependencies(const Value* output) {
       inputs.insert(val);
       continue;
     }
+    if (elementwise_only && isFusedReduction(producer)) {
+      continue;
+    }
     for (const Value* input : producer->inputs()) {
       if (/*bool inserted = */ seen.insert(input).second) {
         queue.push_back(input);
@@ -156,6 +185,41 @@ static void setInputBroadcastGroups(KernelSpec& spec) {
       std::back_inserter(spec.inputBroadcastGroups()));
 }
 
+// Inputs broadcast along the reduced dimension hold one element per row,
+// like the values computed from reductions, so the inputs of reductions and the
+// outputs that are not computed only from reductions must depend elementwise
+// on an input that isn't broadcast along it. Otherwise their sizes would
+// differ from the map size in its last dimension.
+static void setReductions(KernelSpec& spec) {
+  const Graph& graph = *spec.graph();
+  for (const Node* n : graph.nodes()) {
+    if (isFusedReduction(n)) {
+      spec.reductionDims().push_back(
+          n->get<c10::List<int64_t>>(attr::dim).value().get(0));
+      spec.reductionInputGroups().push_back(
+          getInputDependencies(n->input(0), /*elementwise_only=*/true));
+    }
+  }
+  if (!spec.hasReduction()) {
+    spec.outputReducedDims().assign(graph.outputs().size(), ReducedDim::None);
+    return;
+  }
+  const auto rows = findRowValues(graph);
+  for (const Value* output : graph.outputs()) {
+    const Node* n = output->node();
+    if (rows.count(output) == 0) {
+      spec.outputReducedDims().push_back(ReducedDim::None);
+      spec.reductionInputGroups().push_back(
+          getInputDependencies(output, /*elementwise_only=*/true));
+    } else if (
+        isFusedReduction(n) && !n->get<bool>(attr::keepdim).value()) {
+      spec.outputReducedDims().push_back(ReducedDim::Removed);
+    } else {
+      spec.outputReducedDims().push_back(ReducedDim::Kept);
+    }
+  }
+}
+
 // Performs "upfront" compilation where storage is known but shapes are not.
 // Currently identifies how to expand all tensors so that all intermediate
 // tensors are the same shape, simplifying code generation.
@@ -165,9 +229,12 @@ static void setInputBroadcastGroups(KernelSpec& spec) {
 // or their descendants are involved in, which means that in a DAG of
 // pointwise operations all tensors are expandable to the (single) output.
 // Note: The logic is slightly complicated by concatenation and chunking.
+// Reductions along the last dimension don't change the map size, only the
+// sizes of the outputs computed from them.
 static void upfrontCompilation(KernelSpec& spec) {
   setInputBroadcastGroups(spec);
   setInputChunkDescriptors(spec);
+  setReductions(spec);
 }
 
 int64_t registerFusion(const Node* fusion_group) {
@@ -219,7 +286,7 @@ std::shared_ptr<FusedKernel> compileKernel(
 
   // Creates chunk and flattened input descriptions
   std::vector<PartitionDesc> chunk_desc;
-  std::vector<std::pair<const Value*, const c10::optional<TensorDesc>>> flat_inputs;
+  FlatInputs flat_inputs;
   {
     size_t input_index = 0;
     for (const auto& p : graph->inputs()) {
@@ -246,13 +313,24 @@ std::shared_ptr<FusedKernel> compileKernel(
   // Creates output, concat, and flattened output descriptions
   std::vector<TensorDesc> output_desc;
   std::vector<PartitionDesc> concat_desc;
-  std::vector<std::pair<const Value*, const TensorDesc>> flat_outputs;
-  for (const Value* o : graph->outputs()) {
+  FlatOutputs flat_outputs;
+  for (size_t i = 0; i < graph->outputs().size(); i++) {
+    const Value* o = graph->outputs()[i];
     // Creates output description
     std::vector<int64_t> sizes = map_size;
     if (o->node()->kind() == prim::FusedConcat) {
       sizes.at(o->node()->i(attr::dim)) *= o->node()->inputs().size();
     }
+    switch (spec.outputReducedDims().at(i)) {
+      case ReducedDim::None:
+        break;
+      case ReducedDim::Kept:
+        sizes.back() = 1;
+        break;
+      case ReducedDim::Removed:
+        sizes.pop_back();
+        break;
+    }
 
     auto scalar_type = o->type()->expect<TensorType>()->scalarType();
     TORCH_INTERNAL_ASSERT(scalar_type);
@@ -275,6 +353,21 @@ std::shared_ptr<FusedKernel> compileKernel(
 
   const bool use_cuda = device.is_cuda();
   const std::string name = "kernel_" + std::to_string(next_kernel_id++);
+  if (const auto* graph_ctor = getGraphConstructor(device.type())) {
+    if (auto kernel = (*graph_ctor)(
+            device.index(),
+            name,
+            *graph,
+            flat_inputs,
+            flat_outputs,
+            input_desc,
+            output_desc,
+            chunk_desc,
+            concat_desc,
+            spec.hasRandom())) {
+      return kernel;
+    }
+  }
   std::string code =
       generateKernel(name, *graph, flat_inputs, flat_outputs, use_cuda);
   const FusedKernelConstructor& kernel_ctor =
@@ -9,6 +9,7 @@
 #include <ATen/core/stack.h>
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 namespace torch {
@@ -55,6 +56,39 @@ struct TORCH_API RegisterFusionBackend {
   }
 };
 
+// Flattened kernel arguments: chunked inputs and concatenated outputs are
+// split into their subtensors. Scalar inputs have no TensorDesc.
+using FlatInputs =
+    std::vector<std::pair<const Value*, const c10::optional<TensorDesc>>>;
+using FlatOutputs = std::vector<std::pair<const Value*, const TensorDesc>>;
+
+// In-process backends build kernels directly from the graph of the fusion
+// group instead of from generated source code, so compiling a kernel doesn't
+// spawn a compiler. They return nullptr for the graphs they can't handle,
+// which are then compiled by the FusedKernelConstructor of the device type.
+using GraphKernelConstructor = std::function<std::shared_ptr<FusedKernel>(
+    int16_t device,
+    const std::string& name,
+    const Graph& graph,
+    const FlatInputs& flat_inputs,
+    const FlatOutputs& flat_outputs,
+    std::vector<TensorDesc> input_desc,
+    std::vector<TensorDesc> output_desc,
+    std::vector<PartitionDesc> chunk_desc,
+    std::vector<PartitionDesc> concat_desc,
+    bool has_random)>;
+
+TORCH_API void registerGraphFusionBackend(
+    at::Device::Type backend_type,
+    GraphKernelConstructor ctor);
+struct TORCH_API RegisterGraphFusionBackend {
+  RegisterGraphFusionBackend(
+      at::Device::Type backend_type,
+      GraphKernelConstructor ctor) {
+    registerGraphFusionBackend(backend_type, std::move(ctor));
+  }
+};
+
 } // namespace fuser
 } // namespace jit
 } // namespace torch
@@ -5,8 +5,17 @@
 #include <torch/csrc/jit/fuser/cpu/temp_file.h>
 #include <torch/csrc/utils/memory.h>
 
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -40,12 +49,42 @@ struct CompilerConfig {
     if (!programExists(cxx)) {
       cxx = "";
     }
+
+    const char* cache_dir_env = getenv("PYTORCH_FUSION_CACHE_DIR");
+    if (cache_dir_env != nullptr && *cache_dir_env != '\0') {
+      cache_dir = cache_dir_env;
+      // Failures are detected when the cache is first used
+      mkdir(cache_dir.c_str(), 0755);
+    }
   }
 
   ~CompilerConfig() = default;
 
+  // Identifies the compiler in the keys of the kernel cache
+  const std::string& cxxVersion() {
+    std::call_once(cxx_version_flag, [this] {
+      std::string cmd = "\"" + cxx + "\" --version 2>/dev/null";
+      FILE* pipe = popen(cmd.c_str(), "r");
+      if (pipe == nullptr) {
+        return;
+      }
+      char buffer[256];
+      while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        cxx_version += buffer;
+      }
+      pclose(pipe);
+    });
+    return cxx_version;
+  }
+
   std::string cxx = "g++"; // compiler location
   bool openmp = true;
+  // Directory of the on-disk kernel cache, empty if it is disabled
+  std::string cache_dir;
+
+ private:
+  std::once_flag cxx_version_flag;
+  std::string cxx_version;
 };
 
 static CompilerConfig& getConfig() {
@@ -90,6 +129,118 @@ static void runCompiler(
   TORCH_CHECK(r == 0, "Failed to compile a fused CPU kernel");
 }
 
+// Returns the compiler invocation for the current config, with placeholders
+// for the file names
+static std::string compilerCommand() {
+  auto& config = getConfig();
+  TemplateEnv env;
+  env.s("cxx", config.cxx);
+  env.s("fopenmp", config.openmp ? "-fopenmp" : "");
+  env.s("cpp_file", "<cpp_file>");
+  env.s("so_file", "<so_file>");
+  return format(compile_string, env);
+}
+
+static void replaceAll(
+    std::string& str,
+    const std::string& from,
+    const std::string& to) {
+  for (size_t pos = str.find(from); pos != std::string::npos;
+       pos = str.find(from, pos + to.size())) {
+    str.replace(pos, from.size(), to);
+  }
+}
+
+static uint64_t fnv1a(const std::string& str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : str) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// On-disk cache of compiled kernels, shared by all the processes of a host
+// and enabled by setting PYTORCH_FUSION_CACHE_DIR.
+//
+// Entries are content addressed. The key is the generated source, which is a
+// function of the normalized graph and the ArgSpec, with the kernel name
+// replaced by a placeholder, together with the compiler command and version.
+// An entry <hash> consists of:
+//  - <hash>.so, the kernel, which exports the symbol kernel_<hash>
+//  - <hash>.key, the full key, compared on lookup to rule out collisions
+// Both files are written under temporary names and published with rename(),
+// the .so first, so that a .key file is only ever visible with its complete
+// .so. Processes that miss on the same entry serialize on an flock of
+// <hash>.lock, so that only the first one compiles the kernel.
+class DiskCacheEntry {
+ public:
+  DiskCacheEntry(const std::string& dir, const std::string& key)
+      : key_(key) {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << fnv1a(key);
+    symbol_ = "kernel_" + ss.str();
+    path_ = dir + "/" + ss.str();
+  }
+
+  ~DiskCacheEntry() {
+    if (lock_fd_ != -1) {
+      flock(lock_fd_, LOCK_UN);
+      close(lock_fd_);
+    }
+  }
+
+  const std::string& symbol() const {
+    return symbol_;
+  }
+  std::string soFile() const {
+    return path_ + ".so";
+  }
+
+  bool exists() const {
+    std::ifstream key_file(path_ + ".key", std::ios::binary);
+    if (!key_file) {
+      return false;
+    }
+    std::stringstream contents;
+    contents << key_file.rdbuf();
+    return contents.str() == key_;
+  }
+
+  // Blocks until no other process is populating the entry. Returns false
+  // if the cache directory is not usable.
+  bool lock() {
+    lock_fd_ = open((path_ + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (lock_fd_ == -1) {
+      return false;
+    }
+    if (flock(lock_fd_, LOCK_EX) != 0) {
+      close(lock_fd_);
+      lock_fd_ = -1;
+      return false;
+    }
+    return true;
+  }
+
+  // Takes ownership of so_file, a compiled kernel in the cache directory
+  void publish(const std::string& so_file) {
+    TempFile key_file(path_ + "XXXXXX.key", 4);
+    key_file.write(key_);
+    key_file.sync();
+    if (rename(so_file.c_str(), soFile().c_str()) != 0 ||
+        rename(key_file.name().c_str(), (path_ + ".key").c_str()) != 0) {
+      std::cerr << "warning: pytorch jit fuser failed to write "
+                << path_ << " to the kernel cache\n";
+    }
+  }
+
+ private:
+  std::string key_;
+  std::string symbol_;
+  std::string path_;
+  int lock_fd_ = -1;
+};
+
 static const std::string disas_string = "objdump -M  intel -d \"${so_file}\"";
 static void disas(const std::string& so_file) {
   TemplateEnv env;
@@ -115,6 +266,9 @@ FusedKernelCPU::FusedKernelCPU(
           std::move(chunk_desc),
           std::move(concat_desc),
           has_random) {
+  if (!getConfig().cache_dir.empty() && loadFromCache()) {
+    return;
+  }
   TempFile so_file(so_template, 3);
   TempFile cpp_file(cpp_template, 4);
   cpp_file.write(code_);
@@ -129,6 +283,54 @@ FusedKernelCPU::FusedKernelCPU(
 #pragma GCC diagnostic pop
 }
 
+bool FusedKernelCPU::loadFromCache() {
+  auto& config = getConfig();
+  static const std::string placeholder = "${kernel_name}";
+  std::string source = code_;
+  replaceAll(source, name_, placeholder);
+  std::string key =
+      source + "\n// " + compilerCommand() + "\n// " + config.cxxVersion();
+  DiskCacheEntry entry(config.cache_dir, key);
+
+  auto load = [&] {
+    try {
+      so_lib = make_unique<at::DynamicLibrary>(entry.soFile().c_str());
+#pragma GCC diagnostic ignored "-Wpedantic"
+      kernel = reinterpret_cast<void (*)(uint32_t, void**)>(
+          so_lib->sym(entry.symbol().c_str()));
+#pragma GCC diagnostic pop
+      return true;
+    } catch (const c10::Error&) {
+      so_lib.reset();
+      return false;
+    }
+  };
+
+  if (entry.exists() && load()) {
+    return true;
+  }
+  if (!entry.lock()) {
+    return false;
+  }
+  // Another process may have populated the entry while we were waiting
+  if (entry.exists() && load()) {
+    return true;
+  }
+
+  replaceAll(source, placeholder, entry.symbol());
+  TempFile so_file(config.cache_dir + "/tmpXXXXXX.so", 3);
+  TempFile cpp_file(cpp_template, 4);
+  cpp_file.write(source);
+  cpp_file.sync();
+  runCompiler(cpp_file.name(), so_file.name());
+  if (debugFuser() >= 2)
+    disas(so_file.name());
+  entry.publish(so_file.name());
+  // Note: if runCompiler fell back to compiling without OpenMP, the entry is
+  // keyed by the original flags but still holds a valid kernel
+  return load();
+}
+
 static std::shared_ptr<FusedKernel> createFusionKernel(
     int16_t device,
     std::string name,
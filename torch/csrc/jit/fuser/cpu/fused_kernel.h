@@ -35,6 +35,10 @@ struct TORCH_API FusedKernelCPU : public ::torch::jit::fuser::FusedKernel {
   }
 
  private:
+  // Loads the kernel from the on-disk kernel cache, compiling and adding it
+  // first if necessary. Returns false if the cache can't be used.
+  bool loadFromCache();
+
   std::unique_ptr<at::DynamicLibrary> so_lib;
   void (*kernel)(uint32_t, void**) = nullptr;
 };
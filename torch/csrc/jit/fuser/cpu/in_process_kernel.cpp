@@ -0,0 +1,519 @@
+#include <torch/csrc/jit/fuser/cpu/in_process_kernel.h>
+
+#include <ATen/native/TensorIterator.h>
+#include <c10/util/Exception.h>
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/fuser/tensor_info.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace cpu {
+
+using at::native::ElementwiseInstr;
+using at::native::ElementwiseProgram;
+using Op = ElementwiseInstr::Op;
+
+namespace {
+
+const std::unordered_map<NodeKind, Op>& unaryOps() {
+  static const std::unordered_map<NodeKind, Op> ops = {
+      {aten::neg, Op::Neg},
+      {aten::abs, Op::Abs},
+      {aten::relu, Op::Relu},
+      {aten::sigmoid, Op::Sigmoid},
+      {aten::exp, Op::Exp},
+      {aten::expm1, Op::Expm1},
+      {aten::log, Op::Log},
+      {aten::log10, Op::Log10},
+      {aten::log1p, Op::Log1p},
+      {aten::log2, Op::Log2},
+      {aten::sqrt, Op::Sqrt},
+      {aten::rsqrt, Op::Rsqrt},
+      {aten::reciprocal, Op::Reciprocal},
+      {aten::sin, Op::Sin},
+      {aten::cos, Op::Cos},
+      {aten::tan, Op::Tan},
+      {aten::asin, Op::Asin},
+      {aten::acos, Op::Acos},
+      {aten::atan, Op::Atan},
+      {aten::sinh, Op::Sinh},
+      {aten::cosh, Op::Cosh},
+      {aten::tanh, Op::Tanh},
+      {aten::erf, Op::Erf},
+      {aten::erfc, Op::Erfc},
+      {aten::floor, Op::Floor},
+      {aten::ceil, Op::Ceil},
+      {aten::trunc, Op::Trunc},
+      {aten::round, Op::Round},
+      {aten::frac, Op::Frac},
+  };
+  return ops;
+}
+
+const std::unordered_map<NodeKind, Op>& binaryOps() {
+  static const std::unordered_map<NodeKind, Op> ops = {
+      {aten::mul, Op::Mul},
+      {aten::div, Op::Div},
+      {aten::min, Op::Min},
+      {aten::max, Op::Max},
+      {aten::pow, Op::Pow},
+      {aten::atan2, Op::Atan2},
+      {aten::_sigmoid_backward, Op::SigmoidBackward},
+      {aten::_tanh_backward, Op::TanhBackward},
+  };
+  return ops;
+}
+
+const std::unordered_map<NodeKind, Op>& ternaryOps() {
+  static const std::unordered_map<NodeKind, Op> ops = {
+      {aten::lerp, Op::Lerp},
+      {aten::threshold, Op::Threshold},
+  };
+  return ops;
+}
+
+// Assigns registers to the values of a graph while emitting its program.
+// Temporary registers are reused once all the uses of their value have been
+// emitted, so that the tiles of the program stay small.
+class Lowering {
+ public:
+  explicit Lowering(ElementwiseProgram& program) : program_(program) {}
+
+  void addInput(const Value* v) {
+    int reg = program_.num_registers++;
+    program_.num_inputs++;
+    bind(v, reg);
+  }
+
+  void addScalarInput(const Value* v) {
+    scalar_inputs_.emplace(v, static_cast<int16_t>(scalar_inputs_.size()));
+  }
+
+  // Returns the register holding v, materializing scalar inputs and
+  // constants on first use
+  c10::optional<int> get(const Value* v) {
+    auto it = registers_.find(v);
+    if (it != registers_.end()) {
+      return it->second;
+    }
+    ElementwiseInstr instr{Op::Constant, 0, -1, -1, -1, 0.};
+    auto scalar = scalar_inputs_.find(v);
+    if (scalar != scalar_inputs_.end()) {
+      instr.op = Op::Scalar;
+      instr.a = scalar->second;
+    } else if (auto value = constantValue(v)) {
+      instr.alpha = *value;
+    } else {
+      return c10::nullopt;
+    }
+    instr.out = allocate();
+    program_.instrs.push_back(instr);
+    bind(v, instr.out);
+    return instr.out;
+  }
+
+  // The value of v if it is a numeric constant
+  static c10::optional<double> constantValue(const Value* v) {
+    if (v->node()->kind() != prim::Constant) {
+      return c10::nullopt;
+    }
+    auto ivalue = toIValue(v);
+    if (ivalue && ivalue->isDouble()) {
+      return ivalue->toDouble();
+    } else if (ivalue && ivalue->isInt()) {
+      return static_cast<double>(ivalue->toInt());
+    }
+    return c10::nullopt;
+  }
+
+  bool emit(
+      Op op,
+      const Node* n,
+      at::ArrayRef<const Value*> operands,
+      double alpha = 0.) {
+    int16_t regs[3] = {-1, -1, -1};
+    for (size_t i = 0; i < operands.size(); i++) {
+      auto reg = get(operands[i]);
+      if (!reg) {
+        return false;
+      }
+      regs[i] = *reg;
+    }
+    ElementwiseInstr instr{op, allocate(), regs[0], regs[1], regs[2], alpha};
+    program_.instrs.push_back(instr);
+    release(n);
+    bind(n->output(), instr.out);
+    return true;
+  }
+
+  // Makes out share the register of in
+  bool alias(const Node* n, const Value* in) {
+    auto reg = get(in);
+    if (!reg) {
+      return false;
+    }
+    bind(n->output(), *reg);
+    release(n);
+    return true;
+  }
+
+  bool setOutputs(const FlatOutputs& flat_outputs) {
+    for (const auto& output : flat_outputs) {
+      auto reg = get(output.first);
+      if (!reg) {
+        return false;
+      }
+      program_.outputs.push_back(*reg);
+    }
+    return true;
+  }
+
+ private:
+  int16_t allocate() {
+    if (!free_.empty()) {
+      int16_t reg = free_.back();
+      free_.pop_back();
+      return reg;
+    }
+    return static_cast<int16_t>(program_.num_registers++);
+  }
+
+  void bind(const Value* v, int reg) {
+    registers_[v] = reg;
+    // Uses by the return node or by FusedConcat are never released, which
+    // keeps output registers alive until the end of the program
+    uses_left_[reg] += v->uses().size();
+  }
+
+  // Releases one use of each of the inputs of n
+  void release(const Node* n) {
+    for (const Value* input : n->inputs()) {
+      auto it = registers_.find(input);
+      if (it == registers_.end()) {
+        continue;
+      }
+      int reg = it->second;
+      if (--uses_left_[reg] == 0 && reg >= program_.num_inputs) {
+        free_.push_back(reg);
+      }
+    }
+  }
+
+  ElementwiseProgram& program_;
+  std::unordered_map<const Value*, int> registers_;
+  std::unordered_map<const Value*, int16_t> scalar_inputs_;
+  std::unordered_map<int, size_t> uses_left_;
+  std::vector<int16_t> free_;
+};
+
+bool lowerNode(Lowering& lowering, const Node* n) {
+  const auto kind = n->kind();
+  if (kind == prim::Constant || kind == prim::ConstantChunk ||
+      kind == prim::FusedConcat) {
+    // Constants are emitted on first use; chunks and concats are handled by
+    // the flattened inputs and outputs
+    return true;
+  }
+  if (n->outputs().size() != 1 ||
+      !n->output()->type()->isSubtypeOf(TensorType::get())) {
+    return false;
+  }
+  auto it = unaryOps().find(kind);
+  if (it != unaryOps().end()) {
+    return lowering.emit(it->second, n, {n->input(0)});
+  }
+  it = binaryOps().find(kind);
+  if (it != binaryOps().end()) {
+    return lowering.emit(it->second, n, {n->input(0), n->input(1)});
+  }
+  it = ternaryOps().find(kind);
+  if (it != ternaryOps().end()) {
+    return lowering.emit(
+        it->second, n, {n->input(0), n->input(1), n->input(2)});
+  }
+  if (kind == aten::add || kind == aten::sub || kind == aten::addcmul) {
+    auto alpha = Lowering::constantValue(n->inputs().back());
+    if (!alpha) {
+      return false;
+    }
+    if (kind == aten::addcmul) {
+      return lowering.emit(
+          Op::Addcmul, n, {n->input(0), n->input(1), n->input(2)}, *alpha);
+    }
+    return lowering.emit(
+        kind == aten::add ? Op::Add : Op::Sub,
+        n,
+        {n->input(0), n->input(1)},
+        *alpha);
+  }
+  if (kind == aten::clamp) {
+    const Value* min = n->input(1);
+    const Value* max = n->input(2);
+    if (min->mustBeNone() && max->mustBeNone()) {
+      return false;
+    } else if (min->mustBeNone()) {
+      return lowering.emit(Op::Min, n, {n->input(0), max});
+    } else if (max->mustBeNone()) {
+      return lowering.emit(Op::Max, n, {n->input(0), min});
+    }
+    return lowering.emit(Op::Clamp, n, {n->input(0), min, max});
+  }
+  if (kind == aten::type_as || kind == aten::_cast_Float) {
+    // All values have the same dtype, so these are no-ops
+    return lowering.alias(n, n->input(0));
+  }
+  return false;
+}
+
+// Strides (in elements) of the operand described by info and desc in the
+// dimensions given by sizes, which must refine the operand's compressed
+// dimensions. Both are ordered from the innermost dimension.
+std::vector<int64_t> refineStrides(
+    TensorInfo* info,
+    const TensorDesc& desc,
+    const std::vector<int64_t>& sizes) {
+  const int64_t nDim = desc.nDim();
+  const uint32_t* op_sizes = info->sizes(nDim);
+  const uint32_t* op_strides = info->strides(nDim);
+  std::vector<int64_t> strides;
+  strides.reserve(sizes.size());
+  int64_t d = nDim - 1;
+  int64_t inner = 1;
+  for (int64_t size : sizes) {
+    while (inner == 1 && d >= 0 && op_sizes[d] == 1) {
+      d--;
+    }
+    TORCH_INTERNAL_ASSERT(d >= 0 && op_sizes[d] % (inner * size) == 0);
+    strides.push_back(op_strides[d] * inner);
+    inner *= size;
+    if (inner == op_sizes[d]) {
+      d--;
+      inner = 1;
+    }
+  }
+  return strides;
+}
+
+} // namespace
+
+c10::optional<ElementwiseProgram> lowerToElementwiseProgram(
+    const Graph& graph,
+    const FlatInputs& flat_inputs,
+    const FlatOutputs& flat_outputs) {
+  c10::optional<at::ScalarType> dtype;
+  auto checkDtype = [&](const TensorDesc& desc) {
+    if (!dtype) {
+      dtype = desc.scalar_type;
+    }
+    return desc.scalar_type == *dtype &&
+        (*dtype == at::kFloat || *dtype == at::kDouble);
+  };
+
+  ElementwiseProgram program;
+  Lowering lowering(program);
+  for (const auto& input : flat_inputs) {
+    if (!input.second) {
+      lowering.addScalarInput(input.first);
+      continue;
+    }
+    if (!checkDtype(*input.second)) {
+      return c10::nullopt;
+    }
+    lowering.addInput(input.first);
+  }
+  for (const auto& output : flat_outputs) {
+    if (!checkDtype(output.second)) {
+      return c10::nullopt;
+    }
+  }
+  for (const Node* n : graph.nodes()) {
+    if (n->outputs().size() == 1 &&
+        n->output()->type()->isSubtypeOf(TensorType::get())) {
+      auto scalar_type =
+          n->output()->type()->expect<TensorType>()->scalarType();
+      if (!scalar_type || *scalar_type != *dtype) {
+        return c10::nullopt;
+      }
+    }
+    if (!lowerNode(lowering, n)) {
+      return c10::nullopt;
+    }
+  }
+  if (!lowering.setOutputs(flat_outputs)) {
+    return c10::nullopt;
+  }
+  program.validate();
+  return program;
+}
+
+static std::string programToString(
+    const std::string& name,
+    const ElementwiseProgram& program) {
+  std::stringstream ss;
+  ss << "// " << name << "\n" << program;
+  return ss.str();
+}
+
+InProcessKernelCPU::InProcessKernelCPU(
+    std::string name,
+    ElementwiseProgram program,
+    std::vector<TensorDesc> flat_input_desc,
+    std::vector<TensorDesc> flat_output_desc,
+    size_t num_scalars,
+    std::vector<TensorDesc> input_desc,
+    std::vector<TensorDesc> output_desc,
+    std::vector<PartitionDesc> chunk_desc,
+    std::vector<PartitionDesc> concat_desc)
+    : FusedKernel(
+          name,
+          programToString(name, program),
+          std::move(input_desc),
+          std::move(output_desc),
+          std::move(chunk_desc),
+          std::move(concat_desc),
+          /*has_random=*/false),
+      program_(std::move(program)),
+      flat_input_desc_(std::move(flat_input_desc)),
+      flat_output_desc_(std::move(flat_output_desc)),
+      num_scalars_(num_scalars) {}
+
+void InProcessKernelCPU::launch_raw(
+    const uint32_t numel,
+    std::vector<void*>& arguments) const {
+  // arguments holds numel, the flattened inputs, the scalars and the
+  // flattened outputs (see launchFusion)
+  const size_t first_input = 1;
+  const size_t first_scalar = first_input + flat_input_desc_.size();
+  const size_t first_output = first_scalar + num_scalars_;
+  TORCH_INTERNAL_ASSERT(
+      arguments.size() == first_output + flat_output_desc_.size());
+
+  std::vector<std::pair<TensorInfo*, const TensorDesc*>> operands;
+  for (size_t i = 0; i < flat_output_desc_.size(); i++) {
+    operands.emplace_back(
+        static_cast<TensorInfo*>(arguments[first_output + i]),
+        &flat_output_desc_[i]);
+  }
+  for (size_t i = 0; i < flat_input_desc_.size(); i++) {
+    operands.emplace_back(
+        static_cast<TensorInfo*>(arguments[first_input + i]),
+        &flat_input_desc_[i]);
+  }
+
+  // Operands are compressed differently depending on their contiguity. The
+  // common refinement of their compressed dimensions lets all of them be
+  // viewed with the same sizes: it splits the iteration space wherever one
+  // of the operands has a dimension boundary.
+  std::set<int64_t> boundaries;
+  for (const auto& operand : operands) {
+    const auto nDim = operand.second->nDim();
+    int64_t inner_numel = 1;
+    for (int64_t d = nDim - 1; d >= 0; d--) {
+      inner_numel *= operand.first->sizes(nDim)[d];
+      boundaries.insert(inner_numel);
+    }
+  }
+  boundaries.erase(1);
+  std::vector<int64_t> sizes;
+  int64_t inner_numel = 1;
+  for (int64_t boundary : boundaries) {
+    sizes.push_back(boundary / inner_numel);
+    inner_numel = boundary;
+  }
+  TORCH_INTERNAL_ASSERT(inner_numel == numel);
+
+  const auto options =
+      at::TensorOptions().dtype(flat_output_desc_[0].scalar_type);
+  auto view = [&](const std::pair<TensorInfo*, const TensorDesc*>& operand) {
+    auto strides = refineStrides(operand.first, *operand.second, sizes);
+    std::vector<int64_t> outer_sizes(sizes.rbegin(), sizes.rend());
+    std::reverse(strides.begin(), strides.end());
+    return at::from_blob(operand.first->data, outer_sizes, strides, options);
+  };
+
+  auto iter = at::TensorIterator();
+  for (size_t i = 0; i < operands.size(); i++) {
+    if (i < flat_output_desc_.size()) {
+      iter.add_output(view(operands[i]));
+    } else {
+      iter.add_input(view(operands[i]));
+    }
+  }
+  iter.build();
+
+  std::vector<double> scalars(num_scalars_);
+  for (size_t i = 0; i < num_scalars_; i++) {
+    scalars[i] = *static_cast<double*>(arguments[first_scalar + i]);
+  }
+  at::native::run_elementwise_program(iter, program_, scalars);
+}
+
+// Setting PYTORCH_FUSION_CPU_CODEGEN to 1 compiles all CPU kernels with the
+// system compiler instead
+static bool useCodegen() {
+  static const bool use_codegen = [] {
+    const char* codegen_env = getenv("PYTORCH_FUSION_CPU_CODEGEN");
+    return codegen_env && std::string(codegen_env) == "1";
+  }();
+  return use_codegen;
+}
+
+static std::shared_ptr<FusedKernel> createInProcessKernel(
+    int16_t device,
+    const std::string& name,
+    const Graph& graph,
+    const FlatInputs& flat_inputs,
+    const FlatOutputs& flat_outputs,
+    std::vector<TensorDesc> input_desc,
+    std::vector<TensorDesc> output_desc,
+    std::vector<PartitionDesc> chunk_desc,
+    std::vector<PartitionDesc> concat_desc,
+    bool has_random) {
+  if (useCodegen() || has_random) {
+    return nullptr;
+  }
+  auto program = lowerToElementwiseProgram(graph, flat_inputs, flat_outputs);
+  if (!program) {
+    return nullptr;
+  }
+  std::vector<TensorDesc> flat_input_desc;
+  size_t num_scalars = 0;
+  for (const auto& input : flat_inputs) {
+    if (input.second) {
+      flat_input_desc.push_back(*input.second);
+    } else {
+      num_scalars++;
+    }
+  }
+  std::vector<TensorDesc> flat_output_desc;
+  for (const auto& output : flat_outputs) {
+    flat_output_desc.push_back(output.second);
+  }
+  return std::make_shared<InProcessKernelCPU>(
+      name,
+      std::move(*program),
+      std::move(flat_input_desc),
+      std::move(flat_output_desc),
+      num_scalars,
+      std::move(input_desc),
+      std::move(output_desc),
+      std::move(chunk_desc),
+      std::move(concat_desc));
+}
+
+RegisterGraphFusionBackend reg_in_process(
+    at::DeviceType::CPU,
+    createInProcessKernel);
+
+} // namespace cpu
+} // namespace fuser
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/ElementwiseProgram.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/fuser/compiler.h>
+#include <torch/csrc/jit/fuser/fused_kernel.h>
+#include <torch/csrc/jit/ir.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace cpu {
+
+// A CPU kernel that runs in-process, without generating and compiling C++.
+//
+// The fusion group is lowered to an at::native::ElementwiseProgram, which is
+// run by precompiled Vec256 kernels dispatched on the capabilities of the
+// host CPU. Building one takes microseconds, and the same graph always yields
+// the same kernel, so there are no compiler invocations, temporary files or
+// shared libraries involved.
+struct TORCH_API InProcessKernelCPU : public ::torch::jit::fuser::FusedKernel {
+  InProcessKernelCPU(
+      std::string name,
+      at::native::ElementwiseProgram program,
+      std::vector<TensorDesc> flat_input_desc,
+      std::vector<TensorDesc> flat_output_desc,
+      size_t num_scalars,
+      std::vector<TensorDesc> input_desc,
+      std::vector<TensorDesc> output_desc,
+      std::vector<PartitionDesc> chunk_desc,
+      std::vector<PartitionDesc> concat_desc);
+
+  at::Backend backend() const override {
+    return at::Backend::CPU;
+  }
+
+  void launch_raw(const uint32_t numel, std::vector<void*>& arguments)
+      const override;
+
+ private:
+  const at::native::ElementwiseProgram program_;
+  const std::vector<TensorDesc> flat_input_desc_;
+  const std::vector<TensorDesc> flat_output_desc_;
+  const size_t num_scalars_;
+};
+
+// Lowers graph to an ElementwiseProgram, or returns nullopt if it uses
+// operations or types that ElementwiseProgram doesn't support.
+TORCH_API c10::optional<at::native::ElementwiseProgram> lowerToElementwiseProgram(
+    const Graph& graph,
+    const FlatInputs& flat_inputs,
+    const FlatOutputs& flat_outputs);
+
+} // namespace cpu
+} // namespace fuser
+} // namespace jit
+} // namespace torch
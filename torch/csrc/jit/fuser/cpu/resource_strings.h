@@ -54,6 +54,15 @@ float fracf(float x) {
 ${type_declarations}
 
 #define OMP_THRESHOLD 100000
+${kernelFunction}
+
+extern "C"
+void ${kernelName}(IndexType totalElements, void ** args) {
+  ${kernelName}_kernel(totalElements ${,argument_loads});
+}
+)");
+
+static auto cpu_map_kernel_template = CodeTemplate(R"(
 static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
   #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
   for (IndexType linearIndex = 0;
@@ -65,10 +74,24 @@ static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
       ${kernelBody}
     }
 }
+)");
 
-extern "C"
-void ${kernelName}(IndexType totalElements, void ** args) {
-  ${kernelName}_kernel(totalElements ${,argument_loads});
+// Kernels with reductions loop over the rows of the map size, and take the
+// size of the reduced (last) dimension as their last argument
+static auto cpu_reduction_kernel_template = CodeTemplate(R"(
+#define REDUCTION_LANES 8
+static void ${kernelName}_kernel(IndexType totalElements, ${formals}, IndexType reductionSize) {
+  IndexType totalRows = totalElements / reductionSize;
+  #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
+  for (IndexType rowIndex = 0;
+        rowIndex < totalRows;
+        rowIndex += 1) {
+      IndexType linearIndex = rowIndex * reductionSize;
+      // Convert `linearIndex` or `rowIndex` into the offset of the row:
+      ${tensorOffsets}
+      // calculate the results
+      ${kernelBody}
+    }
 }
 )");
 
@@ -90,6 +90,25 @@ static c10::optional<std::vector<int64_t>> canRunKernel(
     }
   }
 
+  // Reductions must be along the last dimension of the map size, and reduce
+  // whole rows of it (see setReductions in compiler.cpp). Empty rows are left
+  // to the fallback, which fills in the empty reductions.
+  if (map_size && spec.hasReduction()) {
+    if (map_size->empty() || map_size->back() == 0)
+      return c10::nullopt;
+    const int64_t last_dim = map_size->size() - 1;
+    for (const auto dim : spec.reductionDims()) {
+      if (at::maybe_wrap_dim(dim, map_size->size()) != last_dim)
+        return c10::nullopt;
+    }
+    for (const auto& group : spec.reductionInputGroups()) {
+      if (std::none_of(group.begin(), group.end(), [&](int64_t i) {
+            return args[i].dim() > 0 && args[i].size(-1) == map_size->back();
+          }))
+        return c10::nullopt;
+    }
+  }
+
   return map_size;
 }
 
@@ -188,6 +207,7 @@ static void compressContiguous(
 // Launches the requested fusion on the given device with the given inputs.
 // Output pointers are stored in outputs (to be put on the stack later).
 void launchFusion(
+    const KernelSpec& spec,
     const FusedKernel& fusion,
     const at::Device device,
     const at::ArrayRef<at::Tensor>& inputs,
@@ -241,8 +261,9 @@ void launchFusion(
   char* buffer_next = buffer.data();
 
   // A vector of arguments to the kernel (numel, *input_desc_s, *output_desc_s)
+  // Kernels with reductions also take the size of the reduced dimension.
   std::vector<void*> arguments;
-  arguments.reserve(3 + scalar_inputs.size() + flat_inputs_size + flat_outputs_size);
+  arguments.reserve(4 + scalar_inputs.size() + flat_inputs_size + flat_outputs_size);
   arguments.push_back(&numel);
 
   auto addTensorInfoRaw = [&](const TensorDesc& desc,
@@ -293,8 +314,19 @@ void launchFusion(
   for (size_t i = 0; i < fusion.outputDesc().size(); ++i) {
     const auto& c = fusion.concatDesc()[i];
     if (c.isNoop()) {
+      std::vector<int64_t> output_size(map_size.begin(), map_size.end());
+      switch (spec.outputReducedDims().at(i)) {
+        case ReducedDim::None:
+          break;
+        case ReducedDim::Kept:
+          output_size.back() = 1;
+          break;
+        case ReducedDim::Removed:
+          output_size.pop_back();
+          break;
+      }
       outputs.push_back(at::empty(
-          map_size, ref_options.dtype(fusion.outputDesc()[i].scalar_type)));
+          output_size, ref_options.dtype(fusion.outputDesc()[i].scalar_type)));
       addTensorInfo(fusion.outputDesc()[i], outputs[i]);
     } else {
       size_t small_size = map_size[c.dim()];
@@ -313,6 +345,12 @@ void launchFusion(
       }
     }
   }
+  uint32_t reduction_size = 0;
+  if (spec.hasReduction()) {
+    reduction_size = map_size.back();
+    arguments.push_back(&reduction_size);
+  }
+
   // Skip launching the kernel for zero-element tensor inputs
   // launches are skipped, empty zero-sized output is returned
   if (numel > 0) {
@@ -385,7 +423,7 @@ bool runFusion(const int64_t key, Stack& stack, std::string* code_out) {
 
   // Launches fusion
   std::vector<at::Tensor> outputs;
-  launchFusion(*(*maybe_kernel), device, inputs, all_inputs, outputs);
+  launchFusion(spec, *(*maybe_kernel), device, inputs, all_inputs, outputs);
 
   // Updates stack
   drop(stack, spec.nInputs());
@@ -1,8 +1,12 @@
 #include <torch/csrc/jit/fuser/kernel_cache.h>
+#include <torch/csrc/jit/node_hashing.h>
 #include <torch/csrc/jit/passes/canonicalize.h>
 #include <torch/csrc/jit/passes/shape_analysis.h>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
@@ -11,19 +15,42 @@ namespace jit {
 namespace fuser {
 
 struct KernelCacheImpl {
-  // Note: std::unordered_map does not invalidate references even if rehashing
-  // occurs. This is a critical property for thread-safety.
+  // Keys are allocated densely, so KernelSpecs are stored in chunks of
+  // kChunkSize slots, indexed by key. Chunks and specs are never moved or
+  // freed while the cache is alive, so retrieve() reads them without taking
+  // the mutex: it is called on every launch of a fused kernel, by all the
+  // threads running the fusion.
+  static constexpr int64_t kChunkSize = 1024;
+  static constexpr int64_t kMaxChunks = 4096;
+  using Chunk = std::array<std::atomic<KernelSpec*>, kChunkSize>;
+
+  KernelCacheImpl() {
+    for (auto& chunk : chunks_) {
+      chunk.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~KernelCacheImpl() {
+    for (auto& chunk : chunks_) {
+      delete chunk.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Guards the writes to chunks_, specs_ and graphToKey_
   std::mutex mutex_;
   int64_t kernel_counter{0};
 
-  // Map of fusion key to KernelSpec
-  std::unordered_map<int64_t, KernelSpec> specMap_;
+  std::array<std::atomic<Chunk*>, kMaxChunks> chunks_;
+  std::vector<std::unique_ptr<KernelSpec>> specs_;
 
-  // Map of pretty-printed graph string to fusion key
-  // Used to check if a graph has already been cached in specMap_
-  std::unordered_map<std::string, int64_t> graphToKey_;
+  // Map of normalized graph to fusion key, compared structurally
+  // Used to check if a graph has already been cached in chunks_
+  std::unordered_map<const Graph*, int64_t, HashGraph, EqualGraph> graphToKey_;
 };
 
+constexpr int64_t KernelCacheImpl::kChunkSize;
+constexpr int64_t KernelCacheImpl::kMaxChunks;
+
 static KernelCacheImpl& getKernelCache() {
   static KernelCacheImpl cache;
   return cache;
@@ -32,7 +59,7 @@ static KernelCacheImpl& getKernelCache() {
 int64_t debugNumCachedKernelSpecs() {
   auto& cache = getKernelCache();
   std::lock_guard<std::mutex> guard{cache.mutex_};
-  return cache.specMap_.size();
+  return cache.specs_.size();
 }
 
 std::shared_ptr<Graph> normalizeGraphForCache(
@@ -42,49 +69,56 @@ std::shared_ptr<Graph> normalizeGraphForCache(
   return result;
 }
 
-// TODO: lookup by historic string key to start, then issue key
-// as appropriate for faster lookup in the future
 // precondition: graph has been normalized via normalizeGraphForCache
 int64_t store(std::shared_ptr<Graph> graph) {
   auto& cache = getKernelCache();
-  std::string repr = graph->toString(false);
 
   std::lock_guard<std::mutex> guard{cache.mutex_};
   const auto key = cache.kernel_counter++;
-  cache.specMap_.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(key),
-      std::forward_as_tuple(key, graph));
-  cache.graphToKey_.emplace(std::make_pair(std::move(repr), key));
+  const auto chunk_index = key / KernelCacheImpl::kChunkSize;
+  TORCH_CHECK(
+      chunk_index < KernelCacheImpl::kMaxChunks,
+      "Too many fusion groups were registered");
+  auto* chunk = cache.chunks_[chunk_index].load(std::memory_order_relaxed);
+  if (!chunk) {
+    chunk = new KernelCacheImpl::Chunk();
+    for (auto& slot : *chunk) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+    cache.chunks_[chunk_index].store(chunk, std::memory_order_release);
+  }
+  cache.specs_.emplace_back(new KernelSpec(key, graph));
+  auto* spec = cache.specs_.back().get();
+  (*chunk)[key % KernelCacheImpl::kChunkSize].store(
+      spec, std::memory_order_release);
+  cache.graphToKey_.emplace(spec->graph().get(), key);
   return key;
 }
 
-// XXX: Does not grab mutex
-static at::optional<KernelSpec*> nolock_retrieve(
-    KernelCacheImpl& cache,
-    const int64_t key) {
-  auto it = cache.specMap_.find(key);
-  if (it == cache.specMap_.end())
-    return at::nullopt;
-  return &(it->second);
-}
-
 at::optional<KernelSpec*> retrieve(const int64_t key) {
   auto& cache = getKernelCache();
-  std::lock_guard<std::mutex> guard{cache.mutex_};
-  return nolock_retrieve(cache, key);
+  const auto chunk_index = key / KernelCacheImpl::kChunkSize;
+  if (key < 0 || chunk_index >= KernelCacheImpl::kMaxChunks)
+    return at::nullopt;
+  const auto* chunk = cache.chunks_[chunk_index].load(std::memory_order_acquire);
+  if (!chunk)
+    return at::nullopt;
+  auto* spec = (*chunk)[key % KernelCacheImpl::kChunkSize].load(
+      std::memory_order_acquire);
+  if (!spec)
+    return at::nullopt;
+  return spec;
 }
 
 // precondition: graph has been normalized via normalizeGraphForCache
 at::optional<KernelSpec*> lookupGraph(std::shared_ptr<Graph> graph) {
   auto& cache = getKernelCache();
-  std::string repr = graph->toString(false);
 
   std::lock_guard<std::mutex> guard{cache.mutex_};
-  auto it = cache.graphToKey_.find(repr);
+  auto it = cache.graphToKey_.find(graph.get());
   if (it == cache.graphToKey_.end())
     return at::nullopt;
-  return nolock_retrieve(cache, it->second);
+  return retrieve(it->second);
 }
 
 } // namespace fuser
@@ -10,6 +10,7 @@
 #include <torch/csrc/jit/ir.h>
 #include <ATen/core/stack.h>
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -41,15 +42,19 @@ struct TORCH_API PartitionInfo {
   int64_t dim_;
 };
 
+// How the sizes of an output of a fusion group relate to the map size (see
+// executor.cpp). Outputs computed only from reductions along the last
+// dimension of the map size hold one element per row, and either keep the
+// reduced dimension with size 1 or remove it.
+enum class ReducedDim { None, Kept, Removed };
+
 // "Kernel Specification." - Contains device-independent fusion information.
 // Each kernel specification contains a map of instantiated generated functions
 // that implement some or most of its functionality. Multiple generated
 // functions are needed by each abstract specification because of different
 // devices (cpu vs gpu, different gpus) and different inputs (int vs float,
 // contiguous vs discontiguous).
-// Note: uses a mutex to control access to its kernel store
-// Note: unordered containers do not invalidate references/pointers on
-//   rehashing, which is critical for thread-safety.
+// Note: uses a mutex to serialize additions to its kernel store
 // TODO: allow abstract kernels to use multiple generated kernels
 // TODO: allow abstract kernels to reuse generated kernels from common pool
 struct TORCH_API KernelSpec {
@@ -64,8 +69,10 @@ struct TORCH_API KernelSpec {
         nTensorInputs_{},
         inputBroadcastGroups_{},
         inputChunks_{},
-        has_random_{false},
-        kernels_{} {
+        reductionDims_{},
+        reductionInputGroups_{},
+        outputReducedDims_{},
+        has_random_{false} {
     for (const auto& n : graph_->nodes()) {
       if (n->kind() == aten::rand_like) {
         has_random_ = true;
@@ -113,22 +120,78 @@ struct TORCH_API KernelSpec {
     return has_random_;
   }
 
+  // The dims of the reductions of the graph, which must all be the last
+  // dimension of the map size, and the shape of each output
+  // Note: created during upfront compilation
+  std::vector<int64_t>& reductionDims() {
+    return reductionDims_;
+  }
+  const std::vector<int64_t>& reductionDims() const {
+    return reductionDims_;
+  }
+  bool hasReduction() const {
+    return !reductionDims_.empty();
+  }
+
+  // Groups of tensor inputs in which at least one input must not be
+  // broadcast along the reduced dimension (see setReductions)
+  std::vector<std::vector<int64_t>>& reductionInputGroups() {
+    return reductionInputGroups_;
+  }
+  const std::vector<std::vector<int64_t>>& reductionInputGroups() const {
+    return reductionInputGroups_;
+  }
+
+  std::vector<ReducedDim>& outputReducedDims() {
+    return outputReducedDims_;
+  }
+  const std::vector<ReducedDim>& outputReducedDims() const {
+    return outputReducedDims_;
+  }
+
   // Cache functions
-  c10::optional<std::shared_ptr<FusedKernel>> findKernel(
-      const ArgSpec& arg_spec) const {
-    std::lock_guard<std::mutex> guard{mutex_};
-    const auto it = kernels_.find(arg_spec);
-    if (it == kernels_.end())
-      return c10::nullopt;
-    return it->second;
+  // Note: kernels are looked up on every launch by all the threads running
+  //   the fusion, so the lookup reads an append-only list without locking.
+  //   Kernels live as long as the spec.
+  c10::optional<FusedKernel*> findKernel(const ArgSpec& arg_spec) const {
+    for (const KernelEntry* entry = kernels_.load(std::memory_order_acquire);
+         entry != nullptr;
+         entry = entry->next) {
+      if (entry->arg_spec.hashCode() == arg_spec.hashCode() &&
+          entry->arg_spec == arg_spec) {
+        return entry->kernel.get();
+      }
+    }
+    return c10::nullopt;
   }
   void cacheKernel(const ArgSpec& arg_spec, std::shared_ptr<FusedKernel> kernel)
       const {
     std::lock_guard<std::mutex> guard{mutex_};
-    kernels_.emplace(arg_spec, kernel);
+    // Another thread may have compiled the same kernel concurrently
+    if (findKernel(arg_spec))
+      return;
+    kernels_.store(
+        new KernelEntry{
+            arg_spec, std::move(kernel), kernels_.load(std::memory_order_relaxed)},
+        std::memory_order_release);
+  }
+
+  ~KernelSpec() {
+    const KernelEntry* entry = kernels_.load(std::memory_order_relaxed);
+    while (entry != nullptr) {
+      const KernelEntry* next = entry->next;
+      delete entry;
+      entry = next;
+    }
   }
 
  private:
+  struct KernelEntry {
+    ArgSpec arg_spec;
+    std::shared_ptr<FusedKernel> kernel;
+    const KernelEntry* next;
+  };
+
   int64_t key_;
   std::shared_ptr<Graph> graph_;
   Code code_;
@@ -136,11 +199,13 @@ struct TORCH_API KernelSpec {
   uint64_t nTensorInputs_;
   std::vector<std::vector<int64_t>> inputBroadcastGroups_;
   std::vector<PartitionInfo> inputChunks_;
+  std::vector<int64_t> reductionDims_;
+  std::vector<std::vector<int64_t>> reductionInputGroups_;
+  std::vector<ReducedDim> outputReducedDims_;
   bool has_random_;
+  // Guards the writes to kernels_
   mutable std::mutex mutex_;
-  mutable std::
-      unordered_map<ArgSpec, std::shared_ptr<FusedKernel>, torch::hash<ArgSpec>>
-          kernels_;
+  mutable std::atomic<const KernelEntry*> kernels_{nullptr};
 };
 
 } // namespace fuser
@@ -25,6 +25,7 @@
 #include <torch/csrc/jit/passes/loop_unrolling.h>
 #include <torch/csrc/jit/passes/lower_grad_of.h>
 #include <torch/csrc/jit/passes/lower_tuples.h>
+#include <torch/csrc/jit/passes/out_variants.h>
 #include <torch/csrc/jit/passes/peephole.h>
 #include <torch/csrc/jit/passes/remove_expands.h>
 #include <torch/csrc/jit/passes/requires_grad_analysis.h>
@@ -58,6 +59,11 @@ bool getGraphExecutorOptimize() {
   return kOptimize;
 }
 
+thread_local bool out_variant_mode = false;
+bool& getOutVariantMode() {
+  return out_variant_mode;
+}
+
 namespace {
 c10::OperatorOptions aliasAnalysisInternalSpecialCase() {
   c10::OperatorOptions options;
@@ -602,6 +608,9 @@ struct GraphExecutorImpl : public GraphExecutorImplBase {
     }
     // Make sure there are no leftovers from any passes.
     EliminateDeadCode(opt_graph);
+    if (getOutVariantMode()) {
+      UseOutVariants(opt_graph);
+    }
     return ExecutionPlan(opt_graph);
   }
 
@@ -59,6 +59,15 @@ TORCH_API std::shared_ptr<Graph> lastExecutedOptimizedGraph();
 
 TORCH_API bool& getProfilingMode();
 
+// When set, the profiling executor places intermediate tensors whose sizes
+// were profiled in a preallocated arena (see PlanMemory)
+TORCH_API bool& getMemoryPlanningMode();
+
+// When set, graph executors rewrite ops whose inputs don't require grad to
+// their out= overloads, reusing their results' memory across runs (see
+// UseOutVariants)
+TORCH_API bool& getOutVariantMode();
+
 TORCH_API void setGraphExecutorOptimize(bool o);
 TORCH_API bool getGraphExecutorOptimize();
 
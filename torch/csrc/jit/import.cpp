@@ -17,6 +17,7 @@
 #include "caffe2/serialize/istream_adapter.h"
 
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 
 #include <fstream>
 #include <string>
@@ -33,6 +34,51 @@ using caffe2::serialize::ReadAdapterInterface;
 
 namespace {
 
+// Extracts the tensor records of an archive ahead of the unpickler. The
+// records are requested in the order they were written, so when one isn't
+// ready yet it and the next few records are extracted in parallel on the
+// intra-op pool, which overlaps their reads and crc checks while keeping at
+// most one batch of records alive besides those the unpickler has taken.
+class RecordPrefetcher final {
+ public:
+  RecordPrefetcher(PyTorchStreamReader& reader, const std::string& archive_name)
+      : reader_(reader) {
+    const std::string prefix = archive_name + "/";
+    for (const auto& name : reader_.getAllRecords()) {
+      if (name.compare(0, prefix.size(), prefix) == 0) {
+        index_[name] = names_.size();
+        names_.push_back(name);
+      }
+    }
+    records_.resize(names_.size());
+  }
+
+  at::DataPtr get(const std::string& name) {
+    auto it = index_.find(name);
+    if (it == index_.end()) {
+      return std::get<0>(reader_.getRecord(name));
+    }
+    size_t i = it->second;
+    if (!records_[i]) {
+      size_t batch_end = std::min(i + at::get_num_threads(), names_.size());
+      at::parallel_for(i, batch_end, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t j = begin; j < end; ++j) {
+          if (!records_[j]) {
+            records_[j] = std::get<0>(reader_.getRecord(names_[j]));
+          }
+        }
+      });
+    }
+    return std::move(records_[i]);
+  }
+
+ private:
+  PyTorchStreamReader& reader_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, size_t> index_;
+  std::vector<at::DataPtr> records_;
+};
+
 // this is a deserializer class which loads script modules from pt files. the
 // content of the file is written using PyTorchStreamWriter, for details please
 // check caffe2/serialize/inline_container.h. all the records except the last
@@ -88,10 +134,11 @@ IValue ScriptModuleDeserializer::readArchive(const std::string& archive_name) {
     return c10::StrongTypePtr(
         compilation_unit_, compilation_unit_->get_class(qn));
   };
+  RecordPrefetcher prefetcher(*reader_, archive_name);
   auto read_record = [&](const std::string& name) {
     std::stringstream ss;
     ss << archive_name << "/" << name;
-    return std::get<0>(reader_->getRecord(ss.str()));
+    return prefetcher.get(ss.str());
   };
   Unpickler unpickler(
       reader, std::move(class_resolver), std::move(read_record), device_);
@@ -58,6 +58,13 @@ TORCH_API script::Module load(
 /// The reader adapter, which is for customized input stream, must contain a
 /// serialized `script::Module`, exported either via `ScriptModule.save()` in
 /// Python or `torch::jit::ExportModule` in C++.
+///
+/// Passing a `caffe2::serialize::MmapFileAdapter` loads the module lazily:
+/// the storages of CPU tensors point into the mapped file, whose pages are
+/// read on first access, so weights that are never used are never read and
+/// processes that load the same file share one copy of it in the page cache.
+/// `MmapFileAdapter::residentBytes()` counts the bytes accessed so far. Tensors
+/// loaded to another device are copied, and so are read, while loading.
 TORCH_API script::Module load(
     std::unique_ptr<caffe2::serialize::ReadAdapterInterface> rai,
     c10::optional<c10::Device> device = c10::nullopt,
@@ -24,7 +24,9 @@
 #include <torch/csrc/jit/passes/inliner.h>
 #include <torch/csrc/jit/passes/loop_unrolling.h>
 #include <torch/csrc/jit/passes/lower_tuples.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
 #include <torch/csrc/jit/passes/onnx.h>
+#include <torch/csrc/jit/passes/out_variants.h>
 #include <torch/csrc/jit/passes/onnx/cast_all_constant_to_floating.h>
 #include <torch/csrc/jit/passes/onnx/constant_fold.h>
 #include <torch/csrc/jit/passes/onnx/fixup_onnx_loop.h>
@@ -210,6 +212,8 @@ void initJITBindings(PyObject* module) {
           "_jit_pass_canonicalize",
           [](const std::shared_ptr<Graph>& g) { return Canonicalize(g); })
       .def("_jit_pass_lint", LintGraph)
+      .def("_jit_pass_plan_memory", PlanMemory)
+      .def("_jit_pass_use_out_variants", UseOutVariants)
       .def(
           "_jit_pass_complete_shape_analysis",
           [](std::shared_ptr<Graph> graph, py::tuple inputs, bool with_grad) {
@@ -294,6 +298,15 @@ void initJITBindings(PyObject* module) {
       .def(
           "_jit_set_profiling_mode",
           [](bool profiling_flag) { getProfilingMode() = profiling_flag; })
+      .def(
+          "_jit_set_memory_planning_mode",
+          [](bool enabled) { getMemoryPlanningMode() = enabled; })
+      .def(
+          "_jit_set_out_variant_mode",
+          [](bool enabled) { getOutVariantMode() = enabled; })
+      .def(
+          "_jit_set_export_tensor_compression",
+          [](bool enabled) { SetExportModuleTensorCompression(enabled); })
       .def(
           "_jit_set_inline_everything_mode",
           [](bool enabled) { script::getInlineEverythingMode() = enabled; })
@@ -35,7 +35,13 @@ namespace jit {
   _(TAIL_CALL, "F") /* replace current frame with function F */             \
   _(INTERFACE_CALL, "CI") /* call method X on the first argument (of N) */  \
   _(GET_ATTR, "S") /* get attribute from slot X in an Object */             \
-  _(SET_ATTR, "S") /* set attribute to slot X in an Object */
+  _(SET_ATTR, "S") /* set attribute to slot X in an Object */               \
+  _(OP_STORE, "OR") /* OP X, then STORE N */                                \
+  _(LOAD_LOAD, "RR") /* LOAD X, then LOAD N */                              \
+  _(LOAD_MOVE, "RR") /* LOAD X, then MOVE N */                              \
+  _(MOVE_LOAD, "RR") /* MOVE X, then LOAD N */                              \
+  _(MOVE_MOVE, "RR") /* MOVE X, then MOVE N */                              \
+  _(INT_OP, "I") /* binary int operator X on the top 2 values, see IntOp */
 
 enum OpCode : uint8_t {
 #define DEFINE_OP(op, _) op,
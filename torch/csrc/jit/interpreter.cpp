@@ -19,6 +19,7 @@
 
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -296,6 +297,63 @@ struct PreprocessGraph {
   std::unordered_map<Node*, bool> can_emit_inline;
 };
 
+// Binary operators on ints that the interpreter evaluates itself (INT_OP)
+// instead of going through the Operation of the node.
+enum class IntOp : int32_t { Add, Sub, Mul, Lt, Le, Gt, Ge, Eq, Ne };
+
+static c10::optional<IntOp> intOpFor(Node* node) {
+  if (node->inputs().size() != 2 || node->outputs().size() != 1 ||
+      node->input(0)->type() != IntType::get() ||
+      node->input(1)->type() != IntType::get()) {
+    return c10::nullopt;
+  }
+  TypePtr result = IntType::get();
+  IntOp op;
+  switch (node->kind()) {
+    case aten::add:
+      op = IntOp::Add;
+      break;
+    case aten::sub:
+      op = IntOp::Sub;
+      break;
+    case aten::mul:
+      op = IntOp::Mul;
+      break;
+    case aten::lt:
+      op = IntOp::Lt;
+      result = BoolType::get();
+      break;
+    case aten::le:
+      op = IntOp::Le;
+      result = BoolType::get();
+      break;
+    case aten::gt:
+      op = IntOp::Gt;
+      result = BoolType::get();
+      break;
+    case aten::ge:
+      op = IntOp::Ge;
+      result = BoolType::get();
+      break;
+    case aten::eq:
+      op = IntOp::Eq;
+      result = BoolType::get();
+      break;
+    case aten::ne:
+      op = IntOp::Ne;
+      result = BoolType::get();
+      break;
+    default:
+      return c10::nullopt;
+  }
+  if (node->output()->type() != result) {
+    return c10::nullopt;
+  }
+  return op;
+}
+
+static bool interpreter_superinstructions = true;
+
 // for keeping track of the current node
 struct WithCurrentNode {
   WithCurrentNode(Node** loc, Node* new_value) : loc_(loc), old_value_(*loc_) {
@@ -362,8 +420,12 @@ struct CodeImpl {
   std::vector<BailoutBlock> bailout_blocks_;
   std::vector<std::unique_ptr<Function>> bailout_functions_;
 
+  bool superinstructions_;
+
   CodeImpl(const std::shared_ptr<Graph>& graph)
-      : preprocess_(*graph), current_node_(preprocess_.graph->return_node()) {
+      : preprocess_(*graph),
+        current_node_(preprocess_.graph->return_node()),
+        superinstructions_(getInterpreterSuperinstructions()) {
     graph_ = preprocess_.graph;
     n_outputs = graph_->outputs().size();
     n_inputs = graph_->inputs().size();
@@ -373,6 +435,9 @@ struct CodeImpl {
     // we deferred the emission of bailout blocks so they appear at the end
     // emit them now and patch up the jumps
     insertBailoutBlocks();
+    if (superinstructions_) {
+      fuseInstructions();
+    }
   }
 
   void insertInstruction(OpCode op, int64_t X = 0, uint64_t N = 0) {
@@ -460,6 +525,12 @@ struct CodeImpl {
 
   void emitOperator(Node* node) {
     emitLoadInputs(node->inputs());
+    if (superinstructions_) {
+      if (auto int_op = intOpFor(node)) {
+        insertInstruction(INT_OP, static_cast<int32_t>(*int_op));
+        return;
+      }
+    }
     insertInstruction(OP, operator_table_.size());
     operator_table_.emplace_back(getOperation(node));
   }
@@ -617,6 +688,75 @@ struct CodeImpl {
           instructions_source_[block.jf_instruction_index]);
     }
   }
+  static bool isJump(OpCode op) {
+    return op == JF || op == JMP || op == LOOP;
+  }
+
+  static bool fitsN(int32_t X) {
+    return X >= 0 && X <= std::numeric_limits<uint16_t>::max();
+  }
+
+  // If the pair a, b can be replaced by a single superinstruction, returns it.
+  static c10::optional<Instruction> fusePair(Instruction a, Instruction b) {
+    if (a.op == OP && b.op == STORE && fitsN(b.X)) {
+      return Instruction(OP_STORE, a.X, b.X);
+    }
+    if ((a.op == LOAD || a.op == MOVE) && (b.op == LOAD || b.op == MOVE) &&
+        fitsN(b.X)) {
+      OpCode op;
+      if (a.op == LOAD) {
+        op = b.op == LOAD ? LOAD_LOAD : LOAD_MOVE;
+      } else {
+        op = b.op == LOAD ? MOVE_LOAD : MOVE_MOVE;
+      }
+      return Instruction(op, a.X, b.X);
+    }
+    return c10::nullopt;
+  }
+
+  // Peephole pass over the finished instruction list that replaces common
+  // pairs of instructions with superinstructions, so that each pair costs a
+  // single trip through the dispatch loop. An instruction that is the target
+  // of a jump is never folded into its predecessor, and all jump offsets are
+  // rewritten for the shorter list.
+  void fuseInstructions() {
+    size_t n = instructions_.size();
+    std::vector<bool> is_target(n + 1, false);
+    for (size_t i = 0; i < n; ++i) {
+      if (isJump(instructions_[i].op)) {
+        is_target.at(i + instructions_[i].X) = true;
+      }
+    }
+
+    std::vector<Instruction> fused;
+    std::vector<Node*> fused_source;
+    std::vector<size_t> new_index(n + 1);
+    for (size_t i = 0; i < n; ++i) {
+      new_index[i] = fused.size();
+      if (i + 1 < n && !is_target[i + 1]) {
+        if (auto inst = fusePair(instructions_[i], instructions_[i + 1])) {
+          fused.push_back(*inst);
+          // the OP of OP_STORE is the one that can fail
+          fused_source.push_back(instructions_source_[i]);
+          new_index[++i] = fused.size() - 1;
+          continue;
+        }
+      }
+      fused.push_back(instructions_[i]);
+      fused_source.push_back(instructions_source_[i]);
+    }
+    new_index[n] = fused.size();
+
+    for (size_t i = 0; i < n; ++i) {
+      const Instruction& inst = instructions_[i];
+      if (isJump(inst.op)) {
+        fused[new_index[i]].X = new_index[i + inst.X] - new_index[i];
+      }
+    }
+    instructions_ = std::move(fused);
+    instructions_source_ = std::move(fused_source);
+  }
+
   void emitInterfaceCall(
       std::string method_name_str,
       c10::ArrayRef<Value*> inputs) {
@@ -693,7 +833,8 @@ struct CodeImpl {
 
   void dump(std::ostream& out, size_t i) const {
     out << i << " " << instructions_[i];
-    if (instructions_[i].op == OP || instructions_[i].op == CALL) {
+    if (instructions_[i].op == OP || instructions_[i].op == OP_STORE ||
+        instructions_[i].op == CALL) {
       out << " # " << *instructions_source_[i];
     } else {
       out << "\n";
@@ -825,10 +966,71 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             af.operators[inst.X](stack);
             ++af.pc;
             break;
+          case OP_STORE:
+            af.operators[inst.X](stack);
+            reg(inst.N) = pop(stack);
+            ++af.pc;
+            break;
           case LOAD:
             stack.emplace_back(reg(inst.X));
             ++af.pc;
             break;
+          case LOAD_LOAD:
+            stack.emplace_back(reg(inst.X));
+            stack.emplace_back(reg(inst.N));
+            ++af.pc;
+            break;
+          case LOAD_MOVE:
+            stack.emplace_back(reg(inst.X));
+            stack.emplace_back(std::move(reg(inst.N)));
+            ++af.pc;
+            break;
+          case MOVE_LOAD:
+            stack.emplace_back(std::move(reg(inst.X)));
+            stack.emplace_back(reg(inst.N));
+            ++af.pc;
+            break;
+          case MOVE_MOVE:
+            stack.emplace_back(std::move(reg(inst.X)));
+            stack.emplace_back(std::move(reg(inst.N)));
+            ++af.pc;
+            break;
+          case INT_OP: {
+            int64_t b = stack.back().toInt();
+            stack.pop_back();
+            IValue& top = stack.back();
+            int64_t a = top.toInt();
+            switch (static_cast<IntOp>(inst.X)) {
+              case IntOp::Add:
+                top = a + b;
+                break;
+              case IntOp::Sub:
+                top = a - b;
+                break;
+              case IntOp::Mul:
+                top = a * b;
+                break;
+              case IntOp::Lt:
+                top = a < b;
+                break;
+              case IntOp::Le:
+                top = a <= b;
+                break;
+              case IntOp::Gt:
+                top = a > b;
+                break;
+              case IntOp::Ge:
+                top = a >= b;
+                break;
+              case IntOp::Eq:
+                top = a == b;
+                break;
+              case IntOp::Ne:
+                top = a != b;
+                break;
+            }
+            ++af.pc;
+          } break;
           case MOVE:
             stack.emplace_back(std::move(reg(inst.X)));
             ++af.pc;
@@ -1075,6 +1277,10 @@ std::ostream& operator<<(std::ostream& out, const Code& code) {
   return out;
 }
 
+bool& getInterpreterSuperinstructions() {
+  return interpreter_superinstructions;
+}
+
 Code::Code(const std::shared_ptr<Graph>& graph) : pImpl(new CodeImpl(graph)) {}
 Code::~Code() = default;
 
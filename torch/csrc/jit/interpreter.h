@@ -28,6 +28,11 @@ struct Node;
 using Stack = std::vector<c10::IValue>;
 using c10::ivalue::Future;
 
+// If true (the default), Code fuses common instruction sequences into
+// superinstructions and evaluates binary int operators inline instead of
+// calling their Operation. Only affects Code created after it is changed.
+TORCH_API bool& getInterpreterSuperinstructions();
+
 struct TORCH_API Code {
   Code() : pImpl(nullptr) {}
   explicit Code(const std::shared_ptr<Graph>& graph);
@@ -85,6 +85,148 @@ bool attributesEqualCSE(const Node* lhs, const Node* rhs) {
   return true;
 }
 
+// Hashes the scalar attributes of a node. Tensor and graph attributes are
+// left to attributesEqualCSE.
+size_t hashAttributes(const Node* n) {
+  if (!n->hasAttributes()) {
+    return 0;
+  }
+  auto names = n->attributeNames();
+  std::sort(names.begin(), names.end());
+  size_t hash = 0;
+  for (auto name : names) {
+    hash = hash_combine(hash, get_hash(name, n->kindOf(name)));
+    switch (n->kindOf(name)) {
+      case AttributeKind::f:
+        hash = hash_combine(hash, get_hash(n->f(name)));
+        break;
+      case AttributeKind::i:
+        hash = hash_combine(hash, get_hash(n->i(name)));
+        break;
+      case AttributeKind::s:
+        hash = hash_combine(hash, get_hash(n->s(name)));
+        break;
+      case AttributeKind::is:
+        hash = hash_combine(hash, get_hash(n->is(name)));
+        break;
+      default:
+        break;
+    }
+  }
+  return hash;
+}
+
+// Numbers values in the order they are defined
+struct ValueNumbering {
+  size_t number(const Value* v) {
+    return numbers.emplace(v, numbers.size()).first->second;
+  }
+  // Values of enclosing graphs used by blocks are numbered on first use
+  std::unordered_map<const Value*, size_t> numbers;
+};
+
+size_t hashBlock(const Block* b, ValueNumbering& values) {
+  size_t hash = get_hash(b->inputs().size(), b->outputs().size());
+  for (const Value* input : b->inputs()) {
+    hash = hash_combine(
+        hash, get_hash(values.number(input), input->type()->kind()));
+  }
+  for (const Node* n : b->nodes()) {
+    hash = hash_combine(hash, get_hash(n->kind(), hashAttributes(n)));
+    for (const Value* input : n->inputs()) {
+      hash = hash_combine(hash, values.number(input));
+    }
+    for (const Block* sub_block : n->blocks()) {
+      hash = hash_combine(hash, hashBlock(sub_block, values));
+    }
+    for (const Value* output : n->outputs()) {
+      hash = hash_combine(
+          hash, get_hash(values.number(output), output->type()->kind()));
+    }
+  }
+  for (const Value* output : b->outputs()) {
+    hash = hash_combine(hash, values.number(output));
+  }
+  return hash;
+}
+
+// Maps the values of lhs to the values of rhs they correspond to
+using ValueMap = std::unordered_map<const Value*, const Value*>;
+
+bool equalValues(
+    at::ArrayRef<const Value*> lhs,
+    at::ArrayRef<const Value*> rhs,
+    ValueMap& values) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    auto it = values.find(lhs[i]);
+    if (it == values.end()) {
+      // A value of an enclosing graph, or a definition (which are compared
+      // through defineValues)
+      if (lhs[i]->owningGraph() == rhs[i]->owningGraph()) {
+        if (lhs[i] != rhs[i]) {
+          return false;
+        }
+        continue;
+      }
+      return false;
+    }
+    if (it->second != rhs[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool defineValues(
+    at::ArrayRef<const Value*> lhs,
+    at::ArrayRef<const Value*> rhs,
+    ValueMap& values) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    if (*lhs[i]->type() != *rhs[i]->type()) {
+      return false;
+    }
+    values[lhs[i]] = rhs[i];
+  }
+  return true;
+}
+
+bool equalBlocks(const Block* lhs, const Block* rhs, ValueMap& values) {
+  if (!defineValues(lhs->inputs(), rhs->inputs(), values)) {
+    return false;
+  }
+  auto lhs_it = lhs->nodes().begin();
+  auto rhs_it = rhs->nodes().begin();
+  for (; lhs_it != lhs->nodes().end() && rhs_it != rhs->nodes().end();
+       ++lhs_it, ++rhs_it) {
+    const Node* l = *lhs_it;
+    const Node* r = *rhs_it;
+    if (l->kind() != r->kind() ||
+        !equalValues(l->inputs(), r->inputs(), values) ||
+        !attributesEqualCSE(l, r) ||
+        l->blocks().size() != r->blocks().size()) {
+      return false;
+    }
+    for (size_t i = 0; i < l->blocks().size(); ++i) {
+      if (!equalBlocks(l->blocks()[i], r->blocks()[i], values)) {
+        return false;
+      }
+    }
+    if (!defineValues(l->outputs(), r->outputs(), values)) {
+      return false;
+    }
+  }
+  if (lhs_it != lhs->nodes().end() || rhs_it != rhs->nodes().end()) {
+    return false;
+  }
+  return equalValues(lhs->outputs(), rhs->outputs(), values);
+}
+
 } // anonymous namespace
 
 size_t HashNode::operator()(const Node* k) const {
@@ -130,5 +272,20 @@ bool EqualNode::operator()(const Node* lhs, const Node* rhs) const {
   return true;
 };
 
+size_t HashGraph::operator()(const Graph* k) const {
+  AT_ASSERT(k != nullptr);
+  ValueNumbering values;
+  return hashBlock(k->block(), values);
+}
+
+bool EqualGraph::operator()(const Graph* lhs, const Graph* rhs) const {
+  if (lhs == rhs)
+    return true;
+  if (lhs == nullptr || rhs == nullptr)
+    return false;
+  ValueMap values;
+  return equalBlocks(lhs->block(), rhs->block(), values);
+}
+
 } // namespace jit
 } // namespace torch
@@ -13,5 +13,16 @@ struct EqualNode {
   bool operator()(const Node* lhs, const Node* rhs) const;
 };
 
+// Structural hash and equality of graphs. Values are identified by their
+// position in the graph rather than by their unique or debug names, so graphs
+// that only differ in value names are equal.
+struct HashGraph {
+  size_t operator()(const Graph* k) const;
+};
+
+struct EqualGraph {
+  bool operator()(const Graph* lhs, const Graph* rhs) const;
+};
+
 } // namespace jit
 } // namespace torch
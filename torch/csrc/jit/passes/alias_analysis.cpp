@@ -329,6 +329,8 @@ void AliasDb::analyzeImpl(Node* node) {
     case prim::ChunkSizes:
     case prim::Function:
     case prim::CreateObject:
+    case prim::MemoryArena:
+    case prim::OutBuffer:
       return analyzeCreator(node);
     case prim::DictConstruct:
     case prim::ListConstruct:
@@ -341,6 +343,7 @@ void AliasDb::analyzeImpl(Node* node) {
     case prim::GetAttr:
       return analyzeExtractor(node);
     case prim::ConstantChunk:
+    case prim::ArenaSlice:
       return analyzeChunk(node);
     case prim::BroadcastingChunk:
       return analyzeBroadcastingChunk(node);
@@ -620,7 +623,8 @@ void AliasDb::analyzeExtractor(Node* node) {
   }
 }
 
-// For torch.chunk(), all returned tensors may alias the input tensor
+// For torch.chunk(), all returned tensors may alias the input tensor. Also
+// used for prim::ArenaSlice, whose output is a view of the arena
 void AliasDb::analyzeChunk(Node* node) {
   for (auto output : node->outputs()) {
     makePointerTo(output, node->input());
@@ -1228,6 +1232,9 @@ bool aliasAnalysisHasSpecialCaseFor(Symbol symbol) {
       prim::GradOf,
       prim::MMTreeReduce,
       prim::MMBatchSide,
+      prim::MemoryArena,
+      prim::ArenaSlice,
+      prim::OutBuffer,
       prim::BroadcastSizes,
       prim::ChunkSizes,
       prim::Function,
@@ -61,6 +61,10 @@ class AliasDb {
   // value in group `b`? i.e. may they overlap?
   TORCH_API bool mayAlias(const ValueSet& a, const ValueSet& b) const;
 
+  // Does `v` potentially share a memory location with a value we can't track,
+  // e.g. a graph input or a value passed to an unschematized op?
+  TORCH_API bool mayAliasWildcard(const Value* v) const;
+
   // Do any nodes write to an alias set input to `n`?
   TORCH_API bool hasInputWriters(const Node* n) const;
 
@@ -184,7 +188,6 @@ class AliasDb {
   std::map<TypeKind, Element*> wildcardIndex_;
   Element* getWildcard(const TypePtr& type) const;
   Element* getOrCreateWildcard(const TypePtr& type);
-  bool mayAliasWildcard(const Value* v) const;
 
   /**
    * State for tracking write info.
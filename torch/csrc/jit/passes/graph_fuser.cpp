@@ -14,6 +14,7 @@
 
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace torch {
 namespace jit {
@@ -119,6 +120,17 @@ bool isSimpleMap(Node* node) {
   return true;
 }
 
+// Reductions that CPU fusion groups can contain, when they are along the last
+// dimension and keep the dtype of their input (see Note [Reductions in CPU
+// fusion groups] in fuser/codegen.cpp)
+bool isReduction(Node* node) {
+  static OperatorSet reductions{{
+      "aten::sum(Tensor self, int[] dim, bool keepdim, *, int? dtype) -> Tensor",
+      "aten::mean(Tensor self, int[] dim, bool keepdim, *, int? dtype) -> Tensor",
+  }};
+  return reductions.find(node);
+}
+
 Value* broadcastSizes(at::ArrayRef<Value*> sizes) {
   AT_ASSERT(!sizes.empty());
   Graph* graph = sizes[0]->owningGraph();
@@ -207,7 +219,125 @@ struct GraphFuser {
     // are not necessarily correct.
     if (node->owningBlock() != block_)
       return false;
-    return node->kind() == prim::FusionGroup || isSimpleMap(node);
+    return node->kind() == prim::FusionGroup || isSimpleMap(node) ||
+        isFusableReduction(node);
+  }
+
+  // Only the CPU fuser generates code for reductions
+  bool isFusableReduction(Node* node) {
+    if (kind_ != prim::FusionGroup || !isReduction(node) ||
+        !node->is_constant(attr::dim) || !node->is_constant(attr::keepdim) ||
+        !node->namedInput(attr::dtype)->mustBeNone()) {
+      return false;
+    }
+    auto type = node->namedInput(attr::self)->type()->cast<TensorType>();
+    if (!type || !type->dim() || *type->dim() == 0 || !type->device() ||
+        !type->device()->is_cpu() || !canFuseOnCPU() || !type->scalarType() ||
+        (*type->scalarType() != at::kFloat &&
+         *type->scalarType() != at::kDouble)) {
+      return false;
+    }
+    auto dims = node->get<c10::List<int64_t>>(attr::dim).value();
+    if (dims.size() != 1) {
+      return false;
+    }
+    const int64_t dim = dims.get(0);
+    return dim == -1 || dim == static_cast<int64_t>(*type->dim()) - 1;
+  }
+
+  bool hasReduction(Node* group) {
+    for (Node* n : getSubgraph(group).nodes()) {
+      if (isReduction(n)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Fusion groups compute their reductions row by row, and the values
+  // computed only from reductions hold a single element per row. Moving
+  // producer into consumer must not make a reduction reduce such a row value,
+  // and the result of a reduction that removes the reduced dimension can't be
+  // broadcast against the other values of the group.
+  bool canFuseWithReductions(Node* consumer, Value* producer) {
+    std::unordered_set<Value*> rows;
+    auto propagateRows = [&](Node* n) {
+      if (isReduction(n)) {
+        if (rows.count(n->namedInput(attr::self))) {
+          return false;
+        }
+        rows.insert(n->output());
+        return true;
+      }
+      auto tensor_inputs = tensorInputs(n);
+      if (!tensor_inputs.empty() &&
+          std::all_of(
+              tensor_inputs.begin(), tensor_inputs.end(), [&](Value* v) {
+                return rows.count(v) > 0;
+              })) {
+        for (Value* output : n->outputs()) {
+          rows.insert(output);
+        }
+      }
+      return true;
+    };
+
+    // Finds the outputs of producer's node that hold rows
+    Node* producer_node = producer->node();
+    std::vector<Value*> producer_rows;
+    std::vector<Value*> removed_dims;
+    if (producer_node->kind() == kind_) {
+      auto& producer_subgraph = getSubgraph(producer_node);
+      for (Node* n : producer_subgraph.nodes()) {
+        propagateRows(n);
+      }
+      for (size_t i = 0; i < producer_node->outputs().size(); ++i) {
+        Value* output = producer_subgraph.outputs()[i];
+        if (rows.count(output)) {
+          producer_rows.push_back(producer_node->outputs()[i]);
+        }
+        if (isReduction(output->node()) &&
+            !output->node()->get<bool>(attr::keepdim).value()) {
+          removed_dims.push_back(producer_node->outputs()[i]);
+        }
+      }
+      rows.clear();
+    } else if (isReduction(producer_node)) {
+      producer_rows.push_back(producer);
+      if (!producer_node->get<bool>(attr::keepdim).value()) {
+        removed_dims.push_back(producer);
+      }
+    }
+    if (producer_rows.empty()) {
+      return true;
+    }
+    for (Value* v : removed_dims) {
+      if (std::find(
+              consumer->inputs().begin(), consumer->inputs().end(), v) !=
+          consumer->inputs().end()) {
+        return false;
+      }
+    }
+
+    // Propagates them through consumer
+    if (consumer->kind() != kind_) {
+      rows.insert(producer_rows.begin(), producer_rows.end());
+      return propagateRows(consumer);
+    }
+    auto& subgraph = getSubgraph(consumer);
+    for (size_t i = 0; i < consumer->inputs().size(); ++i) {
+      Value* input = consumer->inputs()[i];
+      if (std::find(producer_rows.begin(), producer_rows.end(), input) !=
+          producer_rows.end()) {
+        rows.insert(subgraph.inputs()[i]);
+      }
+    }
+    for (Node* n : subgraph.nodes()) {
+      if (!propagateRows(n)) {
+        return false;
+      }
+    }
+    return true;
   }
 
   bool isFusableCatNode(Node* node) {
@@ -421,7 +551,7 @@ struct GraphFuser {
         // an output of the fusion group.
         aliasDb_->moveBeforeTopologicallyValid(producer->node(), consumer);
 
-    if (!shouldFuse) {
+    if (!shouldFuse || !canFuseWithReductions(consumer, producer)) {
       return at::nullopt;
     }
 
@@ -457,7 +587,7 @@ struct GraphFuser {
   }
 
   bool canFuseChunk(Node* consumer, Value* producer) {
-    if (consumer->kind() != prim::FusionGroup) {
+    if (consumer->kind() != prim::FusionGroup || hasReduction(consumer)) {
       return false;
     }
     // Does the chunk have constant chunks/dim?
@@ -700,6 +830,7 @@ struct GraphFuser {
         chunk->inputs().end(),
         [&](Value* producer_for_chunk) {
           return isFusableMap(producer_for_chunk->node()) &&
+              !isReduction(producer_for_chunk->node()) &&
               allUsersAreThisConsumerOrCalcSizes(chunk, producer_for_chunk);
         });
     if (it == chunk->inputs().end()) {
@@ -941,6 +1072,11 @@ struct GraphFuser {
       if (n->kind() == prim::Constant) {
         continue;
       }
+      // Reductions change the shape of their input, so neither their outputs
+      // nor the values computed from them are broadcasts of the input shapes
+      if (isReduction(n)) {
+        continue;
+      }
       if (n->kind() == prim::ConstantChunk) {
         Node* sizes_node = graph->insertNode(
             graph->create(prim::ChunkSizes, shape_of.at(n->input()), 2));
@@ -960,6 +1096,12 @@ struct GraphFuser {
       auto tensor_inputs = filter(n->inputs(), [](Value* v) {
         return v->type()->isSubtypeOf(TensorType::get());
       });
+      if (std::any_of(
+              tensor_inputs.begin(), tensor_inputs.end(), [&](Value* v) {
+                return shape_of.count(v) == 0;
+              })) {
+        continue;
+      }
       auto shapes =
           fmap(tensor_inputs, [&](Value* v) { return shape_of.at(v); });
       AT_ASSERT(!shapes.empty());
@@ -1018,9 +1160,16 @@ struct GraphFuser {
       return false;
     }
 
+    if (isReduction(producer->node())) {
+      return false;
+    }
+
     // Fusion groups can be merged with concat's group if and only if
     // the value they produce isn't already coming from a concat
     if (producer->node()->kind() == prim::FusionGroup) {
+      if (hasReduction(producer->node())) {
+        return false;
+      }
       auto subgraph = producer->node()->g(attr::Subgraph);
       auto* node = subgraph->outputs().at(producer->offset())->node();
       return node->kind() != prim::FusedConcat;
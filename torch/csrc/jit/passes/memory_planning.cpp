@@ -0,0 +1,367 @@
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <ATen/ATen.h>
+#include <c10/util/Exception.h>
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/custom_operator.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+#include <torch/csrc/jit/passes/liveness.h>
+#include <torch/csrc/jit/passes/out_variants.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+c10::OperatorOptions aliasAnalysisIsSpecialCase() {
+  c10::OperatorOptions options;
+  options.setAliasAnalysis(AliasAnalysisKind::INTERNAL_SPECIAL_CASE);
+  return options;
+}
+
+// Byte offset of a prim::ArenaSlice in its arena
+const Symbol kOffset = Symbol::attr("offset");
+
+// Planned tensors start at multiples of the alignment of the CPU allocator
+constexpr int64_t kAlignment = 64;
+
+// Ops whose output dtype and sizes only depend on the dtypes and sizes of
+// their tensor inputs and on the values of their other inputs
+const std::unordered_set<Symbol>& shapeDeterminedOps() {
+  static const std::unordered_set<Symbol> ops = {
+      aten::abs,        aten::acos,      aten::add,       aten::addcdiv,
+      aten::addcmul,    aten::addmm,     aten::addmv,     aten::asin,
+      aten::atan,       aten::atan2,     aten::baddbmm,   aten::bmm,
+      aten::ceil,       aten::clamp,     aten::clamp_max, aten::clamp_min,
+      aten::cos,        aten::cosh,      aten::digamma,   aten::div,
+      aten::elu,        aten::erf,       aten::erfc,      aten::erfinv,
+      aten::exp,        aten::expm1,     aten::floor,     aten::frac,
+      aten::hardtanh,   aten::leaky_relu, aten::lgamma,   aten::log,
+      aten::log10,      aten::log1p,     aten::log2,      aten::matmul,
+      aten::mm,         aten::mul,       aten::mv,        aten::neg,
+      aten::reciprocal, aten::round,     aten::rsqrt,     aten::sigmoid,
+      aten::sign,       aten::sin,       aten::sinh,      aten::softplus,
+      aten::sqrt,       aten::sub,       aten::tan,       aten::tanh,
+      aten::threshold,  aten::trunc,
+  };
+  return ops;
+}
+
+TensorTypePtr completeType(const Value* v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type || !type->isComplete() ||
+      type->sizes().size() != type->strides().size()) {
+    return nullptr;
+  }
+  return type;
+}
+
+// Number of bytes spanned by a tensor of the given complete type
+int64_t storageBytes(const TensorType& type) {
+  const auto sizes = *type.sizes().concrete_sizes();
+  const auto strides = *type.strides().concrete_sizes();
+  int64_t extent = 1;
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (sizes[i] == 0) {
+      return 0;
+    }
+    extent += (sizes[i] - 1) * strides[i];
+  }
+  return extent * elementSize(*type.scalarType());
+}
+
+struct PlannedValue {
+  Value* value;
+  TensorTypePtr type;
+  const Operator* out_variant;
+  int64_t bytes;
+  // The planned value is live from the node at index begin to the node at
+  // index end, inclusively
+  size_t begin;
+  size_t end;
+  int64_t offset;
+};
+
+struct MemoryPlanner {
+  explicit MemoryPlanner(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)), aliasDb_(graph_) {}
+
+  void run() {
+    findPlannedValues();
+    if (planned_.empty()) {
+      return;
+    }
+    computeLifetimes();
+    assignOffsets();
+    rewrite();
+    GRAPH_DUMP("After PlanMemory: ", graph_);
+  }
+
+ private:
+  // The sizes of a tensor must be known when the graph runs: its memory is
+  // planned ahead, and an op writing to its slice of the arena must never
+  // resize it. Values whose sizes are known are the graph inputs with a
+  // complete type, the outputs of guards (which bail out when the sizes
+  // differ from the profiled ones) and constants, and the outputs of
+  // shapeDeterminedOps whose inputs all have known sizes.
+  //
+  // The type of the latter is their own if it is complete (e.g. after shape
+  // propagation), and otherwise the type of a guard of theirs, which is the
+  // profiled one.
+  TensorTypePtr knownType(const Value* v) {
+    if (auto type = completeType(v)) {
+      return type;
+    }
+    for (const Use& use : v->uses()) {
+      const auto kind = use.user->kind();
+      if ((kind == prim::Guard && use.offset == 0) ||
+          (kind == prim::BailOut && use.offset == 1)) {
+        return completeType(use.user->output());
+      }
+    }
+    return nullptr;
+  }
+
+  void findPlannedValues() {
+    std::unordered_map<const Value*, TensorTypePtr> known;
+    for (const Value* input : graph_->inputs()) {
+      if (auto type = completeType(input)) {
+        known.emplace(input, type);
+      }
+    }
+    size_t index = 0;
+    for (Node* n : graph_->nodes()) {
+      index_.emplace(n, index++);
+      const auto kind = n->kind();
+      if (kind == prim::Constant || kind == prim::Guard ||
+          kind == prim::BailOut) {
+        for (const Value* output : n->outputs()) {
+          if (auto type = completeType(output)) {
+            known.emplace(output, type);
+          }
+        }
+        continue;
+      }
+      if (!shapeDeterminedOps().count(kind) || n->outputs().size() != 1) {
+        continue;
+      }
+      bool inputs_known = true;
+      bool requires_grad = false;
+      for (const Value* input : n->inputs()) {
+        if (input->node()->kind() == prim::Constant) {
+          continue;
+        }
+        auto it = known.find(input);
+        if (it == known.end()) {
+          inputs_known = false;
+          break;
+        }
+        requires_grad |= it->second->requiresGrad() != false;
+      }
+      if (!inputs_known) {
+        continue;
+      }
+      auto type = knownType(n->output());
+      if (!type) {
+        continue;
+      }
+      known.emplace(n->output(), type);
+
+      // out= overloads don't support autograd, and the arena lives on the CPU
+      if (requires_grad || type->requiresGrad() != false ||
+          !type->device()->is_cpu()) {
+        continue;
+      }
+      // Values that may outlive the graph, or that may be retained by
+      // something we can't track, need memory of their own
+      if (aliasDb_.mayAliasWildcard(n->output()) ||
+          aliasDb_.mayContainAlias(n->outputs(), graph_->outputs())) {
+        continue;
+      }
+      const int64_t bytes = storageBytes(*type);
+      const Operator* out_variant = findOutVariant(n);
+      if (bytes == 0 || !out_variant) {
+        continue;
+      }
+      planned_.push_back(
+          {n->output(), type, out_variant, bytes, index_.at(n), 0, 0});
+    }
+  }
+
+  // A planned value is live until its last alias is dead. Uses in nested
+  // blocks keep values alive until the end of their top-level node.
+  void computeLifetimes() {
+    auto liveness = BuildLivenessSets(graph_);
+    std::vector<Node*> nodes(graph_->nodes().begin(), graph_->nodes().end());
+    for (auto& planned : planned_) {
+      std::unordered_set<const Value*> aliases;
+      for (size_t i = planned.begin; i < nodes.size(); i++) {
+        for (Value* output : nodes[i]->outputs()) {
+          if (aliasDb_.mayContainAlias(planned.value, output)) {
+            aliases.insert(output);
+          }
+        }
+      }
+      planned.end = planned.begin;
+      for (size_t i = planned.begin + 1; i < nodes.size(); i++) {
+        const auto& live = liveness.at(nodes[i]);
+        if (std::any_of(live.begin(), live.end(), [&](const Value* v) {
+              return aliases.count(v) > 0;
+            })) {
+          planned.end = i;
+        }
+      }
+    }
+  }
+
+  // Greedily places the largest values first, each at the lowest offset
+  // where it doesn't overlap with the values already placed that are live at
+  // the same time
+  void assignOffsets() {
+    std::vector<PlannedValue*> by_size;
+    for (auto& planned : planned_) {
+      by_size.push_back(&planned);
+    }
+    std::stable_sort(
+        by_size.begin(),
+        by_size.end(),
+        [](const PlannedValue* a, const PlannedValue* b) {
+          return a->bytes > b->bytes;
+        });
+    std::vector<const PlannedValue*> placed;
+    for (PlannedValue* planned : by_size) {
+      std::vector<const PlannedValue*> conflicts;
+      for (const PlannedValue* other : placed) {
+        if (other->begin <= planned->end && planned->begin <= other->end) {
+          conflicts.push_back(other);
+        }
+      }
+      std::sort(
+          conflicts.begin(),
+          conflicts.end(),
+          [](const PlannedValue* a, const PlannedValue* b) {
+            return a->offset < b->offset;
+          });
+      int64_t offset = 0;
+      for (const PlannedValue* other : conflicts) {
+        if (offset + planned->bytes <= other->offset) {
+          break;
+        }
+        offset = std::max(offset, alignedEnd(*other));
+      }
+      planned->offset = offset;
+      arena_bytes_ = std::max(arena_bytes_, alignedEnd(*planned));
+      placed.push_back(planned);
+    }
+  }
+
+  static int64_t alignedEnd(const PlannedValue& planned) {
+    return (planned.offset + planned.bytes + kAlignment - 1) / kAlignment *
+        kAlignment;
+  }
+
+  void rewrite() {
+    Node* arena = graph_->create(prim::MemoryArena);
+    arena->i_(attr::size, arena_bytes_);
+    arena->output()->setType(TensorType::get());
+    graph_->prependNode(arena);
+
+    for (const auto& planned : planned_) {
+      Node* n = planned.value->node();
+      WithInsertPoint guard(n);
+      Node* slice = graph_->insertNode(
+          graph_->create(prim::ArenaSlice, {arena->output()}));
+      slice->i_(kOffset, planned.offset)
+          ->is_(attr::size, *planned.type->sizes().concrete_sizes())
+          ->is_(attr::stride, *planned.type->strides().concrete_sizes())
+          ->i_(attr::dtype, static_cast<int64_t>(*planned.type->scalarType()));
+      slice->output()->setType(planned.type);
+
+      std::vector<Value*> inputs(n->inputs().begin(), n->inputs().end());
+      inputs.push_back(slice->output());
+      Node* out_node = graph_->insertNode(graph_->create(n->kind(), inputs));
+      out_node->output()->copyMetadata(n->output());
+      TORCH_INTERNAL_ASSERT(out_node->maybeOperator() == planned.out_variant);
+      n->output()->replaceAllUsesWith(out_node->output());
+      n->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+  std::unordered_map<const Node*, size_t> index_;
+  std::vector<PlannedValue> planned_;
+  int64_t arena_bytes_ = 0;
+};
+
+// The arena of a prim::MemoryArena node. Slices of the arena keep it alive,
+// so once a run is over and its planned tensors are freed, the arena is only
+// referenced from here and the next run can reuse it. Runs that overlap get
+// arenas of their own.
+struct ArenaCache {
+  at::Tensor get(int64_t bytes) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!arena_.defined() || arena_.use_count() > 1) {
+      arena_ = autograd::make_variable(
+          at::empty({bytes}, at::kByte), /*requires_grad=*/false);
+    }
+    return arena_;
+  }
+
+ private:
+  std::mutex mutex_;
+  at::Tensor arena_;
+};
+
+RegisterOperators memory_planning_reg({
+    Operator(
+        prim::MemoryArena,
+        [](const Node* node) {
+          const int64_t bytes = node->i(attr::size);
+          auto cache = std::make_shared<ArenaCache>();
+          return [bytes, cache](Stack& stack) {
+            push(stack, cache->get(bytes));
+            return 0;
+          };
+        },
+        aliasAnalysisIsSpecialCase()),
+    Operator(
+        prim::ArenaSlice,
+        [](const Node* node) {
+          const int64_t offset = node->i(kOffset);
+          const auto sizes = node->is(attr::size);
+          const auto strides = node->is(attr::stride);
+          const auto options = at::TensorOptions().dtype(
+              static_cast<at::ScalarType>(node->i(attr::dtype)));
+          return [offset, sizes, strides, options](Stack& stack) {
+            auto arena = pop(stack).toTensor();
+            auto data = static_cast<uint8_t*>(arena.data_ptr()) + offset;
+            // The storage of the slice can't be resized, so an op that would
+            // write more than was planned fails instead of overwriting the
+            // other slices
+            auto slice = at::from_blob(
+                data, sizes, strides, [arena](void*) {}, options);
+            push(
+                stack,
+                autograd::make_variable(
+                    std::move(slice), /*requires_grad=*/false));
+            return 0;
+          };
+        },
+        aliasAnalysisIsSpecialCase()),
+});
+
+} // namespace
+
+void PlanMemory(const std::shared_ptr<Graph>& graph) {
+  MemoryPlanner(graph).run();
+}
+
+} // namespace jit
+} // namespace torch
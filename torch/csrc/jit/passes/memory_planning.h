@@ -0,0 +1,23 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Places the intermediate tensors of graph in a single preallocated arena.
+//
+// Tensors whose sizes are known when the graph runs (they are computed by ops
+// whose output shapes are determined by the shapes of their inputs, from
+// inputs whose shapes are guarded or otherwise fixed) and whose op has an
+// out= overload are assigned offsets in the arena, using the liveness of
+// their aliases so that tensors that are never live at the same time share
+// memory. Their ops are then rewritten to write into a prim::ArenaSlice of
+// the prim::MemoryArena. The arena is allocated once and reused by later runs
+// of the graph, so planned tensors no longer go through the allocator.
+//
+// Only values of the graph's top-level block are planned.
+TORCH_API void PlanMemory(const std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
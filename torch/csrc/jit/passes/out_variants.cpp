@@ -0,0 +1,156 @@
+#include <torch/csrc/jit/passes/out_variants.h>
+
+#include <ATen/ATen.h>
+#include <c10/util/StringUtil.h>
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/custom_operator.h>
+#include <torch/csrc/jit/jit_log.h>
+
+#include <algorithm>
+#include <mutex>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+c10::OperatorOptions aliasAnalysisIsSpecialCase() {
+  c10::OperatorOptions options;
+  options.setAliasAnalysis(AliasAnalysisKind::INTERNAL_SPECIAL_CASE);
+  return options;
+}
+
+bool knownNotToRequireGrad(const Value* v) {
+  auto type = v->type()->cast<TensorType>();
+  return type && type->requiresGrad() == false;
+}
+
+bool shouldUseOutVariant(const Node* n) {
+  if (n->outputs().size() != 1 || !knownNotToRequireGrad(n->output())) {
+    return false;
+  }
+  auto type = n->output()->type()->expect<TensorType>();
+  if (!type->scalarType() || !type->device()) {
+    return false;
+  }
+  for (const Value* input : n->inputs()) {
+    const auto& input_type = input->type();
+    if (input_type->isSubtypeOf(TensorType::get())) {
+      if (!knownNotToRequireGrad(input)) {
+        return false;
+      }
+    } else if (
+        input_type->isSubtypeOf(ListType::ofTensors()) ||
+        input_type->isSubtypeOf(OptionalType::ofTensor())) {
+      // we don't know whether these tensors require grad
+      return false;
+    }
+  }
+  return findOutVariant(n) != nullptr;
+}
+
+void useOutVariants(Block* block) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node* n = *it++;
+    for (Block* sub_block : n->blocks()) {
+      useOutVariants(sub_block);
+    }
+    if (!shouldUseOutVariant(n)) {
+      continue;
+    }
+    auto type = n->output()->type()->expect<TensorType>();
+    Graph* graph = block->owningGraph();
+    WithInsertPoint guard(n);
+    Node* buffer = graph->insertNode(graph->create(prim::OutBuffer));
+    buffer->i_(attr::dtype, static_cast<int64_t>(*type->scalarType()))
+        ->s_(attr::device, c10::str(*type->device()));
+    buffer->output()->setType(TensorType::get());
+
+    std::vector<Value*> inputs(n->inputs().begin(), n->inputs().end());
+    inputs.push_back(buffer->output());
+    Node* out_node = graph->insertNode(graph->create(n->kind(), inputs));
+    out_node->output()->copyMetadata(n->output());
+    TORCH_INTERNAL_ASSERT(out_node->maybeOperator() == findOutVariant(n));
+    n->output()->replaceAllUsesWith(out_node->output());
+    n->destroy();
+  }
+}
+
+// The buffer of a prim::OutBuffer node. It is reused once the previous run
+// is done with it, i.e. once the only reference to it and to its storage is
+// ours, so results that escape the graph and views of them are never
+// overwritten. Runs that overlap get buffers of their own.
+struct BufferCache {
+  at::Tensor get(const at::TensorOptions& options) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!buffer_.defined() || buffer_.use_count() > 1 ||
+        buffer_.storage().use_count() > 1) {
+      buffer_ = autograd::make_variable(
+          at::empty({0}, options), /*requires_grad=*/false);
+    }
+    return buffer_;
+  }
+
+ private:
+  std::mutex mutex_;
+  at::Tensor buffer_;
+};
+
+RegisterOperators out_variants_reg({
+    Operator(
+        prim::OutBuffer,
+        [](const Node* node) {
+          const auto options =
+              at::TensorOptions()
+                  .dtype(static_cast<at::ScalarType>(node->i(attr::dtype)))
+                  .device(c10::Device(node->s(attr::device)));
+          auto cache = std::make_shared<BufferCache>();
+          return [options, cache](Stack& stack) {
+            push(stack, cache->get(options));
+            return 0;
+          };
+        },
+        aliasAnalysisIsSpecialCase()),
+});
+
+} // namespace
+
+const Operator* findOutVariant(const Node* n) {
+  const FunctionSchema* schema = n->maybeSchema();
+  if (!schema || schema->returns().size() != 1) {
+    return nullptr;
+  }
+  const auto& args = schema->arguments();
+  for (const auto& op : getAllOperatorsFor(n->kind())) {
+    const auto& out_schema = op->schema();
+    const auto& out_args = out_schema.arguments();
+    if (out_args.size() != args.size() + 1 ||
+        out_schema.returns().size() != 1) {
+      continue;
+    }
+    const auto& out = out_args.back();
+    if (out.name() != "out" || !out.alias_info() ||
+        !out.alias_info()->isWrite() ||
+        !out.type()->isSubtypeOf(TensorType::get())) {
+      continue;
+    }
+    if (std::equal(
+            args.begin(),
+            args.end(),
+            out_args.begin(),
+            [](const Argument& a, const Argument& b) {
+              return a.name() == b.name() && *a.type() == *b.type();
+            })) {
+      return op.get();
+    }
+  }
+  return nullptr;
+}
+
+void UseOutVariants(const std::shared_ptr<Graph>& graph) {
+  useOutVariants(graph->block());
+  GRAPH_DUMP("After UseOutVariants: ", graph);
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/operator.h>
+
+namespace torch {
+namespace jit {
+
+// Returns the out= overload of the operator of n, which takes the same
+// arguments followed by the tensor to write the result to, or nullptr if
+// there isn't one.
+TORCH_API const Operator* findOutVariant(const Node* n);
+
+// Rewrites ops to their out= overloads, writing to a prim::OutBuffer.
+//
+// Each prim::OutBuffer keeps the tensor it last returned, and returns it
+// again once nothing else refers to it or to its storage. Its op resizes it
+// to the size of its result, which doesn't allocate when the sizes are the
+// same as in the previous run, so graphs that run repeatedly on inputs of
+// the same sizes stop allocating their intermediate results.
+//
+// Only ops whose inputs and output are known not to require grad are
+// rewritten, since out= overloads don't support autograd, and only ops whose
+// output has a known dtype and device, which the buffer is created with.
+TORCH_API void UseOutVariants(const std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -1337,6 +1337,34 @@ class ShapePropagator {
               node, /*num_reduce_dim=*/*maybe_keepdim?0:1, /*integer_upcast=*/true, opt_dtype);
         }};
 
+    // Requirements:
+    //   dims           : preserved if keepdim == true, smaller by the number
+    //                    of reduced dims otherwise
+    //   scalar type    : dtype if specified. preserved if floating point, otherwise long/int64
+    //   device         : preserved
+    //   tensor inputs  : 1
+    //   tensor outputs : 1
+    // Additionally:
+    //   - First input should be the only tensor input
+    //   - has int[] dim and bool keepdim arguments
+    static const register_formula_for multidim_reduce_ops_with_integer_upcast{
+        {
+            "aten::sum(Tensor self, int[] dim, bool keepdim, *, int? dtype) -> Tensor",
+            "aten::mean(Tensor self, int[] dim, bool keepdim, *, int? dtype) -> Tensor",
+        },
+        [](Node* node) -> type_vec_t {
+          auto maybe_dims = node->get<c10::List<int64_t>>(attr::dim);
+          auto maybe_keepdim = node->get<bool>(attr::keepdim);
+          if (!maybe_dims || !maybe_keepdim)
+            return {};
+          at::optional<IValue> opt_dtype = node->get(attr::dtype);
+          return reduce_op_handler(
+              node,
+              /*num_reduced_dim=*/*maybe_keepdim ? 0 : maybe_dims->size(),
+              /*upcast_integer=*/true,
+              opt_dtype);
+        }};
+
     // Requirements:
     //   dims           : preserved
     //   scalar type    : dtype if specified, preserved if floating point,
@@ -114,6 +114,9 @@ struct WriteableTensorData {
   size_t numel() const {
     return tensor_.storage().numel();
   }
+  size_t elementSize() const {
+    return tensor_.element_size();
+  }
 
  private:
   friend WriteableTensorData getWriteableTensorData(const at::Tensor& tensor);
@@ -6,6 +6,8 @@
 #include <torch/csrc/jit/passes/guard_elimination.h>
 #include <torch/csrc/jit/passes/inline_autodiff_subgraphs.h>
 #include <torch/csrc/jit/passes/insert_guards.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <torch/csrc/jit/passes/out_variants.h>
 #include <torch/csrc/jit/passes/requires_grad_analysis.h>
 #include <torch/csrc/jit/passes/shape_analysis.h>
 #include <torch/csrc/jit/passes/specialize_autogradzero.h>
@@ -18,6 +20,11 @@ bool& getProfilingMode() {
   return profiling_mode;
 }
 
+thread_local bool memory_planning_mode = false;
+bool& getMemoryPlanningMode() {
+  return memory_planning_mode;
+}
+
 std::shared_ptr<Graph> ProfilingGraphExecutorImpl::prepareGraph(
     const std::shared_ptr<Graph>& graph,
     Stack& stack) {
@@ -74,6 +81,12 @@ ExecutionPlan ProfilingGraphExecutorImpl::getPlanFor(Stack& stack) {
   runOptimization(copy);
   runNondiffOptimization(copy);
   EliminateDeadCode(copy);
+  if (getMemoryPlanningMode()) {
+    PlanMemory(copy);
+  }
+  if (getOutVariantMode()) {
+    UseOutVariants(copy);
+  }
   // cache
   optimized_plan_ = ExecutionPlan(copy);
   return *optimized_plan_;
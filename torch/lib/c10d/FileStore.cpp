@@ -294,6 +294,29 @@ int64_t FileStore::add(const std::string& key, int64_t i) {
   return addHelper(regKey, i);
 }
 
+std::vector<uint8_t> FileStore::compareSet(
+    const std::string& key,
+    const std::vector<uint8_t>& expectedValue,
+    const std::vector<uint8_t>& desiredValue) {
+  std::string regKey = regularPrefix_ + key;
+  File file(path_, O_RDWR | O_CREAT, timeout_);
+  auto lock = file.lockExclusive();
+  pos_ = refresh(file, pos_, cache_);
+
+  auto it = cache_.find(regKey);
+  if (it == cache_.end() && !expectedValue.empty()) {
+    return expectedValue;
+  }
+  if (it != cache_.end() && it->second != expectedValue) {
+    return it->second;
+  }
+  // Always seek to the end to write
+  file.seek(0, SEEK_END);
+  file.write(regKey);
+  file.write(desiredValue);
+  return desiredValue;
+}
+
 bool FileStore::check(const std::vector<std::string>& keys) {
   File file(path_, O_RDONLY, timeout_);
   auto lock = file.lockShared();
@@ -29,10 +29,30 @@ std::vector<uint8_t> PrefixStore::get(const std::string& key) {
   return store_.get(joinKey(key));
 }
 
+std::vector<std::vector<uint8_t>> PrefixStore::multiGet(
+    const std::vector<std::string>& keys) {
+  auto joinedKeys = joinKeys(keys);
+  return store_.multiGet(joinedKeys);
+}
+
+void PrefixStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  auto joinedKeys = joinKeys(keys);
+  store_.multiSet(joinedKeys, values);
+}
+
 int64_t PrefixStore::add(const std::string& key, int64_t value) {
   return store_.add(joinKey(key), value);
 }
 
+std::vector<uint8_t> PrefixStore::compareSet(
+    const std::string& key,
+    const std::vector<uint8_t>& expectedValue,
+    const std::vector<uint8_t>& desiredValue) {
+  return store_.compareSet(joinKey(key), expectedValue, desiredValue);
+}
+
 bool PrefixStore::check(const std::vector<std::string>& keys) {
   auto joinedKeys = joinKeys(keys);
   return store_.check(joinedKeys);
@@ -2,6 +2,9 @@
 
 #include <unistd.h>
 
+#include <atomic>
+#include <cstring>
+
 #include <gloo/allgather.h>
 #include <gloo/allreduce.h>
 #include <gloo/barrier.h>
@@ -11,6 +14,7 @@
 #include <gloo/scatter.h>
 
 #include <ATen/SparseTensorUtils.h>
+#include <TH/THAllocator.h>
 
 #ifdef USE_CUDA
 #include <ATen/cuda/CUDAEvent.h>
@@ -298,7 +302,9 @@ void ProcessGroupGloo::RecvWork::wait() {
 }
 
 ProcessGroupGloo::Options::Options()
-    : timeout(std::chrono::milliseconds(10 * 1000)), threads(2) {}
+    : timeout(std::chrono::milliseconds(10 * 1000)),
+      threads(2),
+      hierarchicalAllreduce(false) {}
 
 #ifdef __linux__
 std::shared_ptr<::gloo::transport::Device> ProcessGroupGloo::
@@ -365,6 +371,270 @@ std::shared_ptr<::gloo::transport::Device> ProcessGroupGloo::
 }
 #endif
 
+// Allreduce among the processes on a host through a shared memory segment,
+// combined with an allreduce among one leader process per host.
+//
+// The segment holds a header followed by a slot for every process on the
+// host. Tensors are allreduced in chunks of at most a slot. Every process
+// copies its chunk to its slot, then reduces its share of the chunk across
+// all slots into the first one, then the leader allreduces the first slot
+// with the other leaders, and then every process copies the result back.
+// These steps are separated by barriers on counters in the header.
+class HierarchicalAllreduce {
+ public:
+  static constexpr size_t kHeaderBytes = 64;
+  static constexpr size_t kSlotBytes = 4 * 1024 * 1024;
+
+  HierarchicalAllreduce(
+      ::gloo::rendezvous::Store& store,
+      int rank,
+      int size,
+      const ProcessGroupGloo::Options& options);
+
+  // Returns if any processes share a host. If not, this is a plain
+  // allreduce among all processes.
+  bool sharesHost() const {
+    return sharesHost_;
+  }
+
+  // Allreduces a non-empty, dense, contiguous CPU tensor. The processes on
+  // a host run their allreduces in order of the sequence number, which
+  // must start at 0 and be incremented for every allreduce.
+  void run(uint64_t sequence, at::Tensor& tensor, ReduceOp reduceOp);
+
+ private:
+  struct Header {
+    // Sequence number of the allreduce using the segment.
+    std::atomic<uint64_t> sequence;
+    // Number of processes that arrived at the current barrier.
+    std::atomic<uint64_t> arrived;
+    // Incremented whenever all processes arrived at a barrier.
+    std::atomic<uint64_t> generation;
+  };
+
+  template <typename T>
+  void runTyped(uint64_t sequence, at::Tensor& tensor, ReduceOp reduceOp);
+
+  template <typename T>
+  T* slot(int localRank) {
+    return reinterpret_cast<T*>(
+        static_cast<char*>(segment_.get()) + kHeaderBytes +
+        localRank * kSlotBytes);
+  }
+
+  template <typename F>
+  void waitUntil(F&& condition);
+
+  void barrier();
+
+  const std::chrono::milliseconds timeout_;
+  bool sharesHost_;
+  int localRank_;
+  int localSize_;
+
+  // Context among the leaders, set on leaders if there are multiple hosts.
+  std::shared_ptr<::gloo::Context> leaders_;
+
+  at::DataPtr segment_;
+  Header* header_;
+};
+
+HierarchicalAllreduce::HierarchicalAllreduce(
+    ::gloo::rendezvous::Store& store,
+    int rank,
+    int size,
+    const ProcessGroupGloo::Options& options)
+    : timeout_(options.timeout),
+      sharesHost_(false),
+      localRank_(0),
+      localSize_(0),
+      header_(nullptr) {
+  static_assert(sizeof(Header) <= kHeaderBytes, "Header doesn't fit");
+  auto host = options.hierarchicalAllreduceHost;
+  if (host.empty()) {
+    std::array<char, 256> buffer{};
+    if (gethostname(buffer.data(), buffer.size() - 1) != 0) {
+      throw std::system_error(errno, std::system_category());
+    }
+    host = buffer.data();
+  }
+
+  // Find the processes on this host, and the leader (lowest rank) of every
+  // host.
+  const auto hostKey = [](int rank) {
+    return "hierarchy/host/" + std::to_string(rank);
+  };
+  store.set(hostKey(rank), std::vector<char>(host.begin(), host.end()));
+  std::unordered_map<std::string, int> leaderByHost;
+  std::vector<int> leaders;
+  std::vector<int> localRanks;
+  for (int i = 0; i < size; i++) {
+    const auto value = store.get(hostKey(i));
+    const auto result =
+        leaderByHost.emplace(std::string(value.begin(), value.end()), i);
+    if (result.second) {
+      leaders.push_back(i);
+    }
+    if (result.first->first == host) {
+      if (i == rank) {
+        localRank_ = localRanks.size();
+      }
+      localRanks.push_back(i);
+    }
+  }
+  localSize_ = localRanks.size();
+  sharesHost_ = leaders.size() < static_cast<size_t>(size);
+  if (!sharesHost_) {
+    return;
+  }
+
+  const auto leader = localRanks[0];
+  if (localRank_ == 0 && leaders.size() > 1) {
+    const auto leaderIndex =
+        std::find(leaders.begin(), leaders.end(), rank) - leaders.begin();
+    auto context = std::make_shared<::gloo::rendezvous::Context>(
+        leaderIndex, leaders.size());
+    auto prefixStore =
+        ::gloo::rendezvous::PrefixStore("hierarchy/leaders", store);
+    context->setTimeout(options.timeout);
+    context->connectFullMesh(prefixStore, options.devices[0]);
+    leaders_ = std::move(context);
+  }
+
+  // The leader creates the segment, and the last process to unmap it
+  // removes it.
+  const auto segmentKey = "hierarchy/segment/" + std::to_string(leader);
+  const auto segmentBytes = kHeaderBytes + localSize_ * kSlotBytes;
+  const auto mappedKey = [](int rank) {
+    return "hierarchy/mapped/" + std::to_string(rank);
+  };
+  if (localRank_ == 0) {
+    static std::atomic<int> segmentCounter(0);
+    const auto name = "/torch_c10d_" + std::to_string(getpid()) + "_" +
+        std::to_string(segmentCounter++);
+    segment_ = THRefcountedMapAllocator::makeDataPtr(
+        name.c_str(),
+        TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE,
+        segmentBytes,
+        nullptr);
+    header_ = new (segment_.get()) Header();
+    header_->sequence.store(0);
+    header_->arrived.store(0);
+    header_->generation.store(0);
+    store.set(segmentKey, std::vector<char>(name.begin(), name.end()));
+    std::vector<std::string> mappedKeys;
+    for (int i = 1; i < localSize_; i++) {
+      mappedKeys.push_back(mappedKey(localRanks[i]));
+    }
+    store.wait(mappedKeys, options.timeout);
+  } else {
+    const auto value = store.get(segmentKey);
+    const auto name = std::string(value.begin(), value.end());
+    segment_ = THRefcountedMapAllocator::makeDataPtr(
+        name.c_str(),
+        TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE,
+        segmentBytes,
+        nullptr);
+    header_ = static_cast<Header*>(segment_.get());
+    store.set(mappedKey(rank), std::vector<char>(1));
+  }
+}
+
+// Spins for a short while, since the other processes usually arrive within
+// microseconds, then sleeps for exponentially longer periods, so that waiting
+// for a straggler, e.g. a leader in its allreduce across hosts, doesn't take
+// up a core.
+template <typename F>
+void HierarchicalAllreduce::waitUntil(F&& condition) {
+  constexpr int kSpinIterations = 1000;
+  constexpr auto kMaxSleep = std::chrono::milliseconds(1);
+  for (int i = 0; i < kSpinIterations; i++) {
+    if (condition()) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+  const auto deadline = std::chrono::steady_clock::now() + timeout_;
+  std::chrono::microseconds sleep(1);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      throw std::runtime_error(
+          "Timed out waiting for the processes on this host "
+          "in hierarchical allreduce");
+    }
+    std::this_thread::sleep_for(sleep);
+    sleep = std::min<std::chrono::microseconds>(sleep * 2, kMaxSleep);
+  }
+}
+
+void HierarchicalAllreduce::barrier() {
+  const auto generation = header_->generation.load();
+  if (header_->arrived.fetch_add(1) + 1 ==
+      static_cast<uint64_t>(localSize_)) {
+    header_->arrived.store(0);
+    header_->generation.fetch_add(1);
+  } else {
+    waitUntil([&] { return header_->generation.load() != generation; });
+  }
+}
+
+void HierarchicalAllreduce::run(
+    uint64_t sequence,
+    at::Tensor& tensor,
+    ReduceOp reduceOp) {
+  GENERATE_ALL_TYPES(
+      tensor.scalar_type(), runTyped, sequence, tensor, reduceOp);
+}
+
+template <typename T>
+void HierarchicalAllreduce::runTyped(
+    uint64_t sequence,
+    at::Tensor& tensor,
+    ReduceOp reduceOp) {
+  const auto fn = toFunction<T>(reduceOp);
+  const auto data = getDataPointer<T>(tensor);
+  const size_t count = tensor.numel();
+  waitUntil([&] { return header_->sequence.load() == sequence; });
+
+  const size_t chunkElements = kSlotBytes / sizeof(T);
+  for (size_t offset = 0; offset < count; offset += chunkElements) {
+    const auto length = std::min(chunkElements, count - offset);
+    memcpy(slot<T>(localRank_), data + offset, length * sizeof(T));
+    barrier();
+
+    // Every process reduces its share of the chunk into the first slot.
+    const auto share = (length + localSize_ - 1) / localSize_;
+    const auto begin = std::min(length, localRank_ * share);
+    const auto end = std::min(length, begin + share);
+    if (begin < end) {
+      for (int i = 1; i < localSize_; i++) {
+        fn(slot<T>(0) + begin,
+           slot<T>(0) + begin,
+           slot<T>(i) + begin,
+           end - begin);
+      }
+    }
+    barrier();
+
+    if (leaders_) {
+      gloo::AllreduceOptions opts(leaders_);
+      opts.setReduceFunction(fn);
+      opts.setTag(static_cast<uint32_t>(sequence));
+      opts.setOutput(slot<T>(0), length);
+      gloo::allreduce(opts);
+    }
+    barrier();
+
+    memcpy(data + offset, slot<T>(0), length * sizeof(T));
+    barrier();
+  }
+
+  // Every process is done with the segment.
+  if (localRank_ == 0) {
+    header_->sequence.store(sequence + 1);
+  }
+}
+
 ProcessGroupGloo::ProcessGroupGloo(
     const std::shared_ptr<Store>& store,
     int rank,
@@ -373,6 +643,7 @@ ProcessGroupGloo::ProcessGroupGloo(
     : ProcessGroup(rank, size),
       store_(new GlooStore(store)),
       stop_(false),
+      hierarchicalAllreduceCounter_(0),
       collectiveCounter_(0) {
   auto& devices = options.devices;
   if (devices.empty()) {
@@ -400,6 +671,14 @@ ProcessGroupGloo::ProcessGroupGloo(
     contexts_.push_back(std::move(context));
   }
 
+  if (options.hierarchicalAllreduce) {
+    auto hierarchicalAllreduce = std::make_shared<HierarchicalAllreduce>(
+        *store_, rank_, size_, options);
+    if (hierarchicalAllreduce->sharesHost()) {
+      hierarchicalAllreduce_ = std::move(hierarchicalAllreduce);
+    }
+  }
+
   // Every worker thread stores the AsyncWork object it's currently
   // working on in the workInProgress_ vector. It must have size equal
   // to the number of workers such that they can simply index into it
@@ -670,6 +949,28 @@ class AsyncAllreduceWork : public ProcessGroupGloo::AsyncWork {
   }
 };
 
+class AsyncHierarchicalAllreduceWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncHierarchicalAllreduceWork(
+      std::shared_ptr<HierarchicalAllreduce> hierarchicalAllreduce,
+      at::Tensor& tensor,
+      ReduceOp reduceOp,
+      uint64_t sequence)
+      : hierarchicalAllreduce(std::move(hierarchicalAllreduce)),
+        tensor(tensor),
+        reduceOp(reduceOp),
+        sequence(sequence) {}
+
+  std::shared_ptr<HierarchicalAllreduce> hierarchicalAllreduce;
+  at::Tensor tensor;
+  const ReduceOp reduceOp;
+  const uint64_t sequence;
+
+  void run() override {
+    hierarchicalAllreduce->run(sequence, tensor, reduceOp);
+  }
+};
+
 class AsyncAllreduceCoalescedWork : public AsyncAllreduceWork {
  public:
   AsyncAllreduceCoalescedWork(
@@ -1093,7 +1394,15 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
   auto tag = nextTag();
   auto context = getContext(tag);
   if (device.type() == at::kCPU) {
-    if (layout == c10::kStrided) {
+    if (layout == c10::kStrided && hierarchicalAllreduce_ &&
+        inputs.size() == 1 && inputs[0].is_contiguous() &&
+        inputs[0].numel() > 0) {
+      work = std::make_shared<AsyncHierarchicalAllreduceWork>(
+          hierarchicalAllreduce_,
+          inputs[0],
+          opts.reduceOp,
+          hierarchicalAllreduceCounter_++);
+    } else if (layout == c10::kStrided) {
       work = std::make_shared<AsyncAllreduceWork>(
           std::move(context), inputs, opts.reduceOp, tag);
     } else if (layout == c10::kSparse) {
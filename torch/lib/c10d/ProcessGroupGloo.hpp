@@ -27,6 +27,9 @@
 
 namespace c10d {
 
+// See ProcessGroupGloo::Options::hierarchicalAllreduce.
+class HierarchicalAllreduce;
+
 // ProcessGroupGloo implements Gloo bindings for c10d.
 //
 // All functions on this class are expected to be called in the same
@@ -125,6 +128,18 @@ class ProcessGroupGloo : public ProcessGroup {
     std::vector<std::shared_ptr<::gloo::transport::Device>> devices;
     std::chrono::milliseconds timeout;
     int threads;
+
+    // Allreduce single dense CPU tensors hierarchically if some processes
+    // share a host: reduce within every host through shared memory, then
+    // allreduce across hosts among one leader process per host, and then
+    // copy the result back through shared memory. Only the leaders send
+    // over the network.
+    bool hierarchicalAllreduce;
+
+    // Identifies the host of this process for the hierarchical allreduce.
+    // Processes that specify the same host must be able to share memory.
+    // Defaults to the hostname.
+    std::string hierarchicalAllreduceHost;
   };
 
   // Helper functions to create a new device object.
@@ -212,6 +227,12 @@ class ProcessGroupGloo : public ProcessGroup {
   std::vector<std::thread> threads_;
   bool stop_;
 
+  // Set if the hierarchical allreduce is enabled and some processes share
+  // a host. Incremented for every hierarchical allreduce we kick off, to
+  // run them in identical order across the processes on a host.
+  std::shared_ptr<HierarchicalAllreduce> hierarchicalAllreduce_;
+  uint64_t hierarchicalAllreduceCounter_;
+
   // Incremented for every collective we kick off.
   // The value is used as tag for collective operations. Collectives are kicked
   // off in identical order across processes. Therefore the tag can be used
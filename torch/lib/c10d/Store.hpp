@@ -25,8 +25,28 @@ class Store {
 
   virtual std::vector<uint8_t> get(const std::string& key) = 0;
 
+  // Gets the values of all keys, waiting for them like `get`. Stores that
+  // can fetch several keys at once should override this, the default gets
+  // them one by one.
+  virtual std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys);
+
+  // Sets the value of every key, like calling `set` for each of them.
+  virtual void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values);
+
   virtual int64_t add(const std::string& key, int64_t value) = 0;
 
+  // Atomically sets the key to `desiredValue` if its current value is
+  // `expectedValue`, or if it doesn't exist and `expectedValue` is empty.
+  // Returns the value of the key after the operation, or `expectedValue` if
+  // the key doesn't exist and wasn't set.
+  virtual std::vector<uint8_t> compareSet(
+      const std::string& key,
+      const std::vector<uint8_t>& expectedValue,
+      const std::vector<uint8_t>& desiredValue) = 0;
+
   virtual bool check(const std::vector<std::string>& keys) = 0;
 
   virtual void wait(const std::vector<std::string>& keys) = 0;
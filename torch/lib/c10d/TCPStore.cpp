@@ -1,47 +1,146 @@
 #include <c10d/TCPStore.hpp>
 
 #include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
 #include <unistd.h>
 #include <algorithm>
+#include <cstring>
 #include <system_error>
 
 namespace c10d {
 
 namespace {
 
-enum class QueryType : uint8_t { SET, GET, ADD, CHECK, WAIT };
+enum class QueryType : uint8_t {
+  SET,
+  GET,
+  ADD,
+  CHECK,
+  WAIT,
+  MULTI_SET,
+  MULTI_GET,
+  COMPARE_SET
+};
 
 enum class CheckResponseType : uint8_t { READY, NOT_READY };
 
 enum class WaitResponseType : uint8_t { STOP_WAITING };
 
+// Beyond a handful of threads the daemon is limited by the socket I/O of
+// the clients rather than by the handlers.
+constexpr size_t kMaxDaemonThreads = 8;
+
+// Lists of keys and the values of a multi get are sent as the size and data
+// of each element, concatenated into one buffer, so that they take a single
+// send and recv no matter how many elements there are.
+template <typename T>
+void appendElement(std::vector<uint8_t>& buffer, const T& element) {
+  SizeType size = element.size();
+  auto sizeBytes = reinterpret_cast<const uint8_t*>(&size);
+  buffer.insert(buffer.end(), sizeBytes, sizeBytes + sizeof(size));
+  buffer.insert(buffer.end(), element.begin(), element.end());
+}
+
+template <typename T>
+T extractElement(const std::vector<uint8_t>& buffer, size_t& offset) {
+  SizeType size;
+  if (offset + sizeof(size) > buffer.size()) {
+    throw std::runtime_error("Truncated TCPStore message");
+  }
+  std::memcpy(&size, buffer.data() + offset, sizeof(size));
+  offset += sizeof(size);
+  if (size > buffer.size() - offset) {
+    throw std::runtime_error("Truncated TCPStore message");
+  }
+  T element(buffer.begin() + offset, buffer.begin() + offset + size);
+  offset += size;
+  return element;
+}
+
+void sendKeys(int socket, const std::vector<std::string>& keys) {
+  std::vector<uint8_t> buffer;
+  for (const auto& key : keys) {
+    appendElement(buffer, key);
+  }
+  SizeType nkeys = keys.size();
+  tcputil::sendBytes<SizeType>(socket, &nkeys, 1, true);
+  tcputil::sendVector<uint8_t>(socket, buffer);
+}
+
+std::vector<std::string> recvKeys(int socket) {
+  SizeType nkeys;
+  tcputil::recvBytes<SizeType>(socket, &nkeys, 1);
+  auto buffer = tcputil::recvVector<uint8_t>(socket);
+  std::vector<std::string> keys;
+  keys.reserve(nkeys);
+  size_t offset = 0;
+  for (size_t i = 0; i < nkeys; i++) {
+    keys.push_back(extractElement<std::string>(buffer, offset));
+  }
+  return keys;
+}
+
 } // anonymous namespace
 
+constexpr size_t TCPStoreDaemon::kNumShards;
+
 // TCPStoreDaemon class methods
-// Simply start the daemon thread
-TCPStoreDaemon::TCPStoreDaemon(int storeListenSocket)
+// Simply start the daemon threads
+TCPStoreDaemon::TCPStoreDaemon(int storeListenSocket, size_t numThreads)
     : storeListenSocket_(storeListenSocket) {
-  // Use control pipe to signal instance destruction to the daemon thread.
+  if (numThreads == 0) {
+    throw std::invalid_argument(
+        "TCPStoreDaemon needs at least one thread to serve the store");
+  }
+  // Use control pipe to signal instance destruction to the daemon threads.
   if (pipe(controlPipeFd_.data()) == -1) {
     throw std::runtime_error(
         "Failed to create the control pipe to start the "
         "TCPStoreDaemon run");
   }
-  daemonThread_ = std::thread(&TCPStoreDaemon::run, this);
+#ifdef __linux__
+  for (size_t i = 0; i < numThreads; i++) {
+    int epollFd;
+    SYSCHECK_ERR_RETURN_NEG1(epollFd = ::epoll_create1(EPOLL_CLOEXEC));
+    epollFds_.push_back(epollFd);
+    // The read end of the pipe signals all threads to stop
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = controlPipeFd_[0];
+    SYSCHECK_ERR_RETURN_NEG1(
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, controlPipeFd_[0], &event));
+  }
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = storeListenSocket_;
+  SYSCHECK_ERR_RETURN_NEG1(
+      ::epoll_ctl(epollFds_[0], EPOLL_CTL_ADD, storeListenSocket_, &event));
+#else
+  // Polling the sockets of one thread from another isn't supported.
+  numThreads = 1;
+#endif
+  for (size_t i = 0; i < numThreads; i++) {
+    daemonThreads_.emplace_back(&TCPStoreDaemon::run, this, i);
+  }
 }
 
 TCPStoreDaemon::~TCPStoreDaemon() {
   // Stop the run
   stop();
-  // Join the thread
+  // Join the threads
   join();
   // Close unclosed sockets
   for (auto socket : sockets_) {
-    if (socket != -1) {
-      ::close(socket);
-    }
+    ::close(socket);
+  }
+#ifdef __linux__
+  for (auto fd : epollFds_) {
+    ::close(fd);
   }
+#endif
   // Now close the rest control pipe
   for (auto fd : controlPipeFd_) {
     if (fd != -1) {
@@ -51,10 +150,121 @@ TCPStoreDaemon::~TCPStoreDaemon() {
 }
 
 void TCPStoreDaemon::join() {
-  daemonThread_.join();
+  for (auto& thread : daemonThreads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+size_t TCPStoreDaemon::defaultNumThreads() {
+  size_t numThreads = std::thread::hardware_concurrency();
+  return std::max<size_t>(1, std::min(numThreads, kMaxDaemonThreads));
 }
 
-void TCPStoreDaemon::run() {
+void TCPStoreDaemon::addSocket(int socket) {
+  {
+    std::lock_guard<std::mutex> lock(socketsMutex_);
+    sockets_.insert(socket);
+  }
+#ifdef __linux__
+  // Spread the connections over the threads
+  auto threadIdx = nextThread_++ % epollFds_.size();
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = socket;
+  SYSCHECK_ERR_RETURN_NEG1(
+      ::epoll_ctl(epollFds_[threadIdx], EPOLL_CTL_ADD, socket, &event));
+#endif
+}
+
+// There was an error when processing a query on the socket. Probably an
+// exception occurred in recv/send what would indicate that socket on the
+// other side has been closed. If the closing was due to normal exit, then the
+// store should continue executing. Otherwise, if it was different exception,
+// other connections will get an exception once they try to use the store. We
+// will go ahead and close this connection whenever we hit an exception here.
+void TCPStoreDaemon::removeSocket(int socket) {
+  // Remove all the tracking state of the socket before closing it, so that
+  // no other thread wakes up a reused socket.
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto it = shard.waitingSockets.begin();
+         it != shard.waitingSockets.end();) {
+      auto& waiting = it->second;
+      waiting.erase(
+          std::remove(waiting.begin(), waiting.end(), socket), waiting.end());
+      if (waiting.empty()) {
+        it = shard.waitingSockets.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(keysAwaitedMutex_);
+    keysAwaited_.erase(socket);
+  }
+  {
+    std::lock_guard<std::mutex> lock(socketsMutex_);
+    sockets_.erase(socket);
+  }
+  // Closing the socket also removes it from the epoll instance
+  ::close(socket);
+}
+
+#ifdef __linux__
+void TCPStoreDaemon::run(size_t threadIdx) {
+  constexpr int kMaxEvents = 64;
+  struct epoll_event events[kMaxEvents];
+  const int epollFd = epollFds_[threadIdx];
+
+  // receive the queries
+  while (true) {
+    int numEvents;
+    SYSCHECK_ERR_RETURN_NEG1(
+        numEvents = ::epoll_wait(epollFd, events, kMaxEvents, -1));
+    for (int i = 0; i < numEvents; i++) {
+      const int fd = events[i].data.fd;
+      const auto revents = events[i].events;
+
+      // The pipe receives an event which tells us to shutdown the daemon.
+      // It will be EPOLLHUP when the pipe is closed.
+      if (fd == controlPipeFd_[0]) {
+        if (revents ^ EPOLLHUP) {
+          throw std::system_error(
+              ECONNABORTED,
+              std::system_category(),
+              "Unexpected epoll event on the control pipe's reading fd: " +
+                  std::to_string(revents));
+        }
+        return;
+      }
+      // TCPStore's listening socket has an event and it should now be able
+      // to accept new connections.
+      if (fd == storeListenSocket_) {
+        if (revents ^ EPOLLIN) {
+          throw std::system_error(
+              ECONNABORTED,
+              std::system_category(),
+              "Unexpected epoll event on the master's listening socket: " +
+                  std::to_string(revents));
+        }
+        addSocket(std::get<0>(tcputil::accept(storeListenSocket_)));
+        continue;
+      }
+      // Now query the socket that has the event. A socket whose other side
+      // hung up is readable too, and fails in recv.
+      try {
+        query(fd);
+      } catch (...) {
+        removeSocket(fd);
+      }
+    }
+  }
+}
+#else
+void TCPStoreDaemon::run(size_t /* unused */) {
   std::vector<struct pollfd> fds;
   fds.push_back({.fd = storeListenSocket_, .events = POLLIN});
   // Push the read end of the pipe to signal the stopping of the daemon run
@@ -63,7 +273,7 @@ void TCPStoreDaemon::run() {
   // receive the queries
   bool finished = false;
   while (!finished) {
-    for (size_t i = 0; i < sockets_.size(); i++) {
+    for (size_t i = 0; i < fds.size(); i++) {
       fds[i].revents = 0;
     }
 
@@ -80,7 +290,7 @@ void TCPStoreDaemon::run() {
                 std::to_string(fds[0].revents));
       }
       int sockFd = std::get<0>(tcputil::accept(storeListenSocket_));
-      sockets_.push_back(sockFd);
+      addSocket(sockFd);
       fds.push_back({.fd = sockFd, .events = POLLIN});
     }
     // The pipe receives an event which tells us to shutdown the daemon
@@ -115,45 +325,15 @@ void TCPStoreDaemon::run() {
       try {
         query(fds[fdIdx].fd);
       } catch (...) {
-        // There was an error when processing query. Probably an exception
-        // occurred in recv/send what would indicate that socket on the other
-        // side has been closed. If the closing was due to normal exit, then
-        // the store should continue executing. Otherwise, if it was different
-        // exception, other connections will get an exception once they try to
-        // use the store. We will go ahead and close this connection whenever
-        // we hit an exception here.
-        ::close(fds[fdIdx].fd);
-
-        // Remove all the tracking state of the close FD
-        for (auto it = waitingSockets_.begin(); it != waitingSockets_.end();) {
-          for (auto vecIt = it->second.begin(); vecIt != it->second.end();) {
-            if (*vecIt == fds[fdIdx].fd) {
-              vecIt = it->second.erase(vecIt);
-            } else {
-              ++vecIt;
-            }
-          }
-          if (it->second.size() == 0) {
-            it = waitingSockets_.erase(it);
-          } else {
-            ++it;
-          }
-        }
-        for (auto it = keysAwaited_.begin(); it != keysAwaited_.end();) {
-          if (it->first == fds[fdIdx].fd) {
-            it = keysAwaited_.erase(it);
-          } else {
-            ++it;
-          }
-        }
+        removeSocket(fds[fdIdx].fd);
         fds.erase(fds.begin() + fdIdx);
-        sockets_.erase(sockets_.begin() + fdIdx - 2);
         --fdIdx;
         continue;
       }
     }
   }
 }
+#endif
 
 void TCPStoreDaemon::stop() {
   if (controlPipeFd_[1] != -1) {
@@ -166,8 +346,13 @@ void TCPStoreDaemon::stop() {
 // query communicates with the worker. The format
 // of the query is as follows:
 // type of query | size of arg1 | arg1 | size of arg2 | arg2 | ...
-// or, in the case of wait
-// type of query | number of args | size of arg1 | arg1 | ...
+// or, in the case of check, wait and multi get
+// type of query | number of args | size of buffer | size of arg1 | arg1 | ...
+// or, in the case of multi set
+// type of query | number of keys | size of buffer | size of key1 | key1 |
+// size of value1 | value1 | ...
+// The response to a multi get is all values in one buffer
+// size of buffer | size of value1 | value1 | size of value2 | value2 | ...
 void TCPStoreDaemon::query(int socket) {
   QueryType qt;
   tcputil::recvBytes<QueryType>(socket, &qt, 1);
@@ -175,12 +360,21 @@ void TCPStoreDaemon::query(int socket) {
   if (qt == QueryType::SET) {
     setHandler(socket);
 
+  } else if (qt == QueryType::MULTI_SET) {
+    multiSetHandler(socket);
+
   } else if (qt == QueryType::ADD) {
     addHandler(socket);
 
+  } else if (qt == QueryType::COMPARE_SET) {
+    compareSetHandler(socket);
+
   } else if (qt == QueryType::GET) {
     getHandler(socket);
 
+  } else if (qt == QueryType::MULTI_GET) {
+    multiGetHandler(socket);
+
   } else if (qt == QueryType::CHECK) {
     checkHandler(socket);
 
@@ -192,58 +386,168 @@ void TCPStoreDaemon::query(int socket) {
   }
 }
 
-void TCPStoreDaemon::wakeupWaitingClients(const std::string& key) {
-  auto socketsToWait = waitingSockets_.find(key);
-  if (socketsToWait != waitingSockets_.end()) {
-    for (int socket : socketsToWait->second) {
-      if (--keysAwaited_[socket] == 0) {
-        tcputil::sendValue<WaitResponseType>(
-            socket, WaitResponseType::STOP_WAITING);
-      }
+TCPStoreDaemon::Shard& TCPStoreDaemon::shardFor(const std::string& key) {
+  return shards_[std::hash<std::string>()(key) % kNumShards];
+}
+
+// Locks the shards of all keys, in the order of the shards to avoid
+// deadlocks between threads locking several of them.
+std::vector<std::unique_lock<std::mutex>> TCPStoreDaemon::lockShards(
+    const std::vector<std::string>& keys) {
+  std::vector<size_t> indices;
+  indices.reserve(keys.size());
+  for (const auto& key : keys) {
+    indices.push_back(&shardFor(key) - shards_.data());
+  }
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+  std::vector<std::unique_lock<std::mutex>> locks;
+  locks.reserve(indices.size());
+  for (auto index : indices) {
+    locks.emplace_back(shards_[index].mutex);
+  }
+  return locks;
+}
+
+void TCPStoreDaemon::setLocked(
+    Shard& shard,
+    const std::string& key,
+    std::vector<uint8_t> value) {
+  shard.tcpStore[key] = std::move(value);
+  // On "set", wake up all clients that have been waiting
+  wakeupWaitingClients(shard, key);
+}
+
+void TCPStoreDaemon::wakeupWaitingClients(
+    Shard& shard,
+    const std::string& key) {
+  auto socketsToWait = shard.waitingSockets.find(key);
+  if (socketsToWait == shard.waitingSockets.end()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(keysAwaitedMutex_);
+  for (int socket : socketsToWait->second) {
+    auto keysAwaited = keysAwaited_.find(socket);
+    if (keysAwaited == keysAwaited_.end() || --keysAwaited->second > 0) {
+      continue;
+    }
+    keysAwaited_.erase(keysAwaited);
+    // The socket may be served by another thread, which cleans it up if
+    // its other side has gone away.
+    try {
+      tcputil::sendValue<WaitResponseType>(
+          socket, WaitResponseType::STOP_WAITING);
+    } catch (const std::exception&) {
     }
-    waitingSockets_.erase(socketsToWait);
   }
+  shard.waitingSockets.erase(socketsToWait);
 }
 
 void TCPStoreDaemon::setHandler(int socket) {
   std::string key = tcputil::recvString(socket);
-  tcpStore_[key] = tcputil::recvVector<uint8_t>(socket);
-  // On "set", wake up all clients that have been waiting
-  wakeupWaitingClients(key);
+  auto value = tcputil::recvVector<uint8_t>(socket);
+  auto& shard = shardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  setLocked(shard, key, std::move(value));
+}
+
+void TCPStoreDaemon::multiSetHandler(int socket) {
+  SizeType nargs;
+  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  auto buffer = tcputil::recvVector<uint8_t>(socket);
+  std::vector<std::string> keys(nargs);
+  std::vector<std::vector<uint8_t>> values(nargs);
+  size_t offset = 0;
+  for (size_t i = 0; i < nargs; i++) {
+    keys[i] = extractElement<std::string>(buffer, offset);
+    values[i] = extractElement<std::vector<uint8_t>>(buffer, offset);
+  }
+  for (size_t i = 0; i < nargs; i++) {
+    auto& shard = shardFor(keys[i]);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    setLocked(shard, keys[i], std::move(values[i]));
+  }
 }
 
 void TCPStoreDaemon::addHandler(int socket) {
   std::string key = tcputil::recvString(socket);
   int64_t addVal = tcputil::recvValue<int64_t>(socket);
 
-  if (tcpStore_.find(key) != tcpStore_.end()) {
-    auto buf = reinterpret_cast<const char*>(tcpStore_[key].data());
-    auto len = tcpStore_[key].size();
-    addVal += std::stoll(std::string(buf, len));
+  auto& shard = shardFor(key);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.tcpStore.find(key);
+    if (it != shard.tcpStore.end()) {
+      auto buf = reinterpret_cast<const char*>(it->second.data());
+      auto len = it->second.size();
+      addVal += std::stoll(std::string(buf, len));
+    }
+    auto addValStr = std::to_string(addVal);
+    setLocked(
+        shard, key, std::vector<uint8_t>(addValStr.begin(), addValStr.end()));
   }
-  auto addValStr = std::to_string(addVal);
-  tcpStore_[key] = std::vector<uint8_t>(addValStr.begin(), addValStr.end());
   // Now send the new value
   tcputil::sendValue<int64_t>(socket, addVal);
-  // On "add", wake up all clients that have been waiting
-  wakeupWaitingClients(key);
 }
 
-void TCPStoreDaemon::getHandler(int socket) const {
+void TCPStoreDaemon::compareSetHandler(int socket) {
   std::string key = tcputil::recvString(socket);
-  auto data = tcpStore_.at(key);
+  auto expectedValue = tcputil::recvVector<uint8_t>(socket);
+  auto desiredValue = tcputil::recvVector<uint8_t>(socket);
+
+  std::vector<uint8_t> currentValue;
+  auto& shard = shardFor(key);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.tcpStore.find(key);
+    if (it == shard.tcpStore.end() && !expectedValue.empty()) {
+      currentValue = std::move(expectedValue);
+    } else if (it != shard.tcpStore.end() && it->second != expectedValue) {
+      currentValue = it->second;
+    } else {
+      currentValue = desiredValue;
+      setLocked(shard, key, std::move(desiredValue));
+    }
+  }
+  tcputil::sendVector<uint8_t>(socket, currentValue);
+}
+
+void TCPStoreDaemon::getHandler(int socket) {
+  std::string key = tcputil::recvString(socket);
+  std::vector<uint8_t> data;
+  {
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    data = shard.tcpStore.at(key);
+  }
   tcputil::sendVector<uint8_t>(socket, data);
 }
 
-void TCPStoreDaemon::checkHandler(int socket) const {
-  SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
-  std::vector<std::string> keys(nargs);
-  for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
+void TCPStoreDaemon::multiGetHandler(int socket) {
+  auto keys = recvKeys(socket);
+  // Send all values in one buffer, since they are usually small
+  std::vector<uint8_t> buffer;
+  {
+    auto locks = lockShards(keys);
+    for (const auto& key : keys) {
+      appendElement(buffer, shardFor(key).tcpStore.at(key));
+    }
   }
+  tcputil::sendVector<uint8_t>(socket, buffer);
+}
+
+void TCPStoreDaemon::checkHandler(int socket) {
+  auto keys = recvKeys(socket);
   // Now we have received all the keys
-  if (checkKeys(keys)) {
+  bool ready;
+  {
+    auto locks = lockShards(keys);
+    ready = std::all_of(keys.begin(), keys.end(), [this](const std::string& s) {
+      return shardFor(s).tcpStore.count(s) > 0;
+    });
+  }
+  if (ready) {
     tcputil::sendValue<CheckResponseType>(socket, CheckResponseType::READY);
   } else {
     tcputil::sendValue<CheckResponseType>(socket, CheckResponseType::NOT_READY);
@@ -251,27 +555,25 @@ void TCPStoreDaemon::checkHandler(int socket) const {
 }
 
 void TCPStoreDaemon::waitHandler(int socket) {
-  SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
-  std::vector<std::string> keys(nargs);
-  for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
-  }
-  if (checkKeys(keys)) {
-    tcputil::sendValue<WaitResponseType>(
-        socket, WaitResponseType::STOP_WAITING);
-  } else {
+  auto keys = recvKeys(socket);
+  {
+    // Keys can't be set between checking and registering the socket
+    auto locks = lockShards(keys);
+    size_t numKeysAwaited = 0;
     for (auto& key : keys) {
-      waitingSockets_[key].push_back(socket);
+      auto& shard = shardFor(key);
+      if (shard.tcpStore.count(key) == 0) {
+        shard.waitingSockets[key].push_back(socket);
+        numKeysAwaited++;
+      }
+    }
+    if (numKeysAwaited > 0) {
+      std::lock_guard<std::mutex> lock(keysAwaitedMutex_);
+      keysAwaited_[socket] = numKeysAwaited;
+      return;
     }
-    keysAwaited_[socket] = keys.size();
   }
-}
-
-bool TCPStoreDaemon::checkKeys(const std::vector<std::string>& keys) const {
-  return std::all_of(keys.begin(), keys.end(), [this](const std::string& s) {
-    return tcpStore_.count(s) > 0;
-  });
+  tcputil::sendValue<WaitResponseType>(socket, WaitResponseType::STOP_WAITING);
 }
 
 // TCPStore class methods
@@ -353,6 +655,46 @@ std::vector<uint8_t> TCPStore::getHelper_(const std::string& key) {
   return tcputil::recvVector<uint8_t>(storeSocket_);
 }
 
+std::vector<std::vector<uint8_t>> TCPStore::multiGet(
+    const std::vector<std::string>& keys) {
+  std::vector<std::string> regKeys;
+  regKeys.reserve(keys.size());
+  for (const auto& key : keys) {
+    regKeys.push_back(regularPrefix_ + key);
+  }
+  waitHelper_(regKeys, timeout_);
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::MULTI_GET, true);
+  sendKeys(storeSocket_, regKeys);
+  auto buffer = tcputil::recvVector<uint8_t>(storeSocket_);
+  std::vector<std::vector<uint8_t>> values;
+  values.reserve(keys.size());
+  size_t offset = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    values.push_back(extractElement<std::vector<uint8_t>>(buffer, offset));
+  }
+  return values;
+}
+
+void TCPStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument(
+        "multiSet expects as many values as keys, got " +
+        std::to_string(values.size()) + " values for " +
+        std::to_string(keys.size()) + " keys");
+  }
+  std::vector<uint8_t> buffer;
+  for (size_t i = 0; i < keys.size(); i++) {
+    appendElement(buffer, regularPrefix_ + keys[i]);
+    appendElement(buffer, values[i]);
+  }
+  SizeType nkeys = keys.size();
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::MULTI_SET, true);
+  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, true);
+  tcputil::sendVector<uint8_t>(storeSocket_, buffer);
+}
+
 int64_t TCPStore::add(const std::string& key, int64_t value) {
   std::string regKey = regularPrefix_ + key;
   return addHelper_(regKey, value);
@@ -365,14 +707,26 @@ int64_t TCPStore::addHelper_(const std::string& key, int64_t value) {
   return tcputil::recvValue<int64_t>(storeSocket_);
 }
 
+std::vector<uint8_t> TCPStore::compareSet(
+    const std::string& key,
+    const std::vector<uint8_t>& expectedValue,
+    const std::vector<uint8_t>& desiredValue) {
+  std::string regKey = regularPrefix_ + key;
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::COMPARE_SET, true);
+  tcputil::sendString(storeSocket_, regKey, true);
+  tcputil::sendVector<uint8_t>(storeSocket_, expectedValue, true);
+  tcputil::sendVector<uint8_t>(storeSocket_, desiredValue);
+  return tcputil::recvVector<uint8_t>(storeSocket_);
+}
+
 bool TCPStore::check(const std::vector<std::string>& keys) {
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::CHECK);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    std::string regKey = regularPrefix_ + keys[i];
-    tcputil::sendString(storeSocket_, regKey, (i != (nkeys - 1)));
+  std::vector<std::string> regKeys;
+  regKeys.reserve(keys.size());
+  for (const auto& key : keys) {
+    regKeys.push_back(regularPrefix_ + key);
   }
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::CHECK, true);
+  sendKeys(storeSocket_, regKeys);
   auto checkResponse = tcputil::recvValue<CheckResponseType>(storeSocket_);
   if (checkResponse == CheckResponseType::READY) {
     return true;
@@ -412,12 +766,8 @@ void TCPStore::waitHelper_(
         reinterpret_cast<char*>(&timeoutTV),
         sizeof(timeoutTV)));
   }
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::WAIT);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    tcputil::sendString(storeSocket_, keys[i], (i != (nkeys - 1)));
-  }
+  tcputil::sendValue<QueryType>(storeSocket_, QueryType::WAIT, true);
+  sendKeys(storeSocket_, keys);
   auto waitResponse = tcputil::recvValue<WaitResponseType>(storeSocket_);
   if (waitResponse != WaitResponseType::STOP_WAITING) {
     throw std::runtime_error("Stop_waiting response is expected");
@@ -1,46 +1,89 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <c10d/Store.hpp>
 #include <c10d/Utils.hpp>
 
 namespace c10d {
 
+// Serves the keys of a TCPStore to its clients.
+//
+// The keys are split over shards with a lock each, and the client sockets
+// are spread over `numThreads` threads. On Linux every thread waits for
+// queries on its own sockets with epoll, and the first thread also accepts
+// new connections. Elsewhere a single thread polls all sockets.
 class TCPStoreDaemon {
  public:
-  explicit TCPStoreDaemon(int storeListenSocket);
+  explicit TCPStoreDaemon(
+      int storeListenSocket,
+      size_t numThreads = defaultNumThreads());
   ~TCPStoreDaemon();
 
   void join();
 
+  static size_t defaultNumThreads();
+
  protected:
-  void run();
+  static constexpr size_t kNumShards = 64;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<uint8_t>> tcpStore;
+    // From key -> the list of sockets waiting on it
+    std::unordered_map<std::string, std::vector<int>> waitingSockets;
+  };
+
+  void run(size_t threadIdx);
   void stop();
 
+  void addSocket(int socket);
+  void removeSocket(int socket);
+
   void query(int socket);
 
   void setHandler(int socket);
+  void multiSetHandler(int socket);
   void addHandler(int socket);
-  void getHandler(int socket) const;
-  void checkHandler(int socket) const;
+  void compareSetHandler(int socket);
+  void getHandler(int socket);
+  void multiGetHandler(int socket);
+  void checkHandler(int socket);
   void waitHandler(int socket);
 
-  bool checkKeys(const std::vector<std::string>& keys) const;
-  void wakeupWaitingClients(const std::string& key);
+  Shard& shardFor(const std::string& key);
+  std::vector<std::unique_lock<std::mutex>> lockShards(
+      const std::vector<std::string>& keys);
+
+  // Must be called with the lock of the shard of the key held
+  void setLocked(
+      Shard& shard,
+      const std::string& key,
+      std::vector<uint8_t> value);
+  void wakeupWaitingClients(Shard& shard, const std::string& key);
+
+  std::vector<std::thread> daemonThreads_;
+  std::array<Shard, kNumShards> shards_;
 
-  std::thread daemonThread_;
-  std::unordered_map<std::string, std::vector<uint8_t>> tcpStore_;
-  // From key -> the list of sockets waiting on it
-  std::unordered_map<std::string, std::vector<int>> waitingSockets_;
   // From socket -> number of keys awaited
+  std::mutex keysAwaitedMutex_;
   std::unordered_map<int, size_t> keysAwaited_;
 
-  std::vector<int> sockets_;
+  std::mutex socketsMutex_;
+  std::unordered_set<int> sockets_;
   int storeListenSocket_;
   std::vector<int> controlPipeFd_{-1, -1};
+#ifdef __linux__
+  // One epoll instance per thread
+  std::vector<int> epollFds_;
+  std::atomic<size_t> nextThread_{0};
+#endif
 };
 
 class TCPStore : public Store {
@@ -57,8 +100,20 @@ class TCPStore : public Store {
 
   std::vector<uint8_t> get(const std::string& key) override;
 
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys) override;
+
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values) override;
+
   int64_t add(const std::string& key, int64_t value) override;
 
+  std::vector<uint8_t> compareSet(
+      const std::string& key,
+      const std::vector<uint8_t>& expectedValue,
+      const std::vector<uint8_t>& desiredValue) override;
+
   bool check(const std::vector<std::string>& keys) override;
 
   void wait(const std::vector<std::string>& keys) override;
@@ -0,0 +1,125 @@
+// Simulates the rendezvous of a large world against a TCPStore in a single
+// process: every client publishes its address and then fetches the addresses
+// of all clients, as e.g. a full mesh of connections would need.
+//
+// Configured through the environment:
+//   NUM_CLIENTS    number of simulated ranks (default 2000)
+//   NUM_THREADS    number of threads serving the store (default depends on
+//                  the number of cores)
+//   NUM_DRIVERS    number of threads driving the clients (default 64)
+//   BATCHED        fetch the addresses with one multiGet per client rather
+//                  than one get per address (default 1)
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <c10d/TCPStore.hpp>
+
+using namespace ::c10d;
+
+namespace {
+
+size_t getEnv(const char* name, size_t defaultValue) {
+  const char* value = getenv(name);
+  return value == nullptr ? defaultValue : std::stoul(value);
+}
+
+// Every client and its connection on the server side need a descriptor.
+void raiseFileLimit(size_t numClients) {
+  struct rlimit limit;
+  SYSCHECK_ERR_RETURN_NEG1(::getrlimit(RLIMIT_NOFILE, &limit));
+  limit.rlim_cur = limit.rlim_max;
+  SYSCHECK_ERR_RETURN_NEG1(::setrlimit(RLIMIT_NOFILE, &limit));
+  if (limit.rlim_cur < 2 * numClients + 64) {
+    throw std::runtime_error(
+        "Too many clients for the limit of " + std::to_string(limit.rlim_cur) +
+        " open files");
+  }
+}
+
+// Runs fn for all ranks, spread over numDrivers threads, and returns the
+// time it took in seconds.
+double runPhase(
+    size_t numClients,
+    size_t numDrivers,
+    const std::function<void(size_t)>& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> drivers;
+  for (size_t i = 0; i < numDrivers; i++) {
+    drivers.emplace_back([&, i] {
+      for (size_t rank = i; rank < numClients; rank += numDrivers) {
+        fn(rank);
+      }
+    });
+  }
+  for (auto& driver : drivers) {
+    driver.join();
+  }
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const auto numClients = getEnv("NUM_CLIENTS", 2000);
+  const auto numThreads =
+      getEnv("NUM_THREADS", TCPStoreDaemon::defaultNumThreads());
+  const auto numDrivers = getEnv("NUM_DRIVERS", 64);
+  const auto batched = getEnv("BATCHED", 1) != 0;
+  raiseFileLimit(numClients);
+
+  int listenSocket;
+  PortType port;
+  std::tie(listenSocket, port) = tcputil::listen(0);
+  std::unique_ptr<TCPStoreDaemon> daemon(
+      new TCPStoreDaemon(listenSocket, numThreads));
+
+  std::vector<std::unique_ptr<TCPStore>> clients(numClients);
+  std::vector<std::string> keys;
+  for (size_t rank = 0; rank < numClients; rank++) {
+    keys.push_back("addr/" + std::to_string(rank));
+  }
+
+  const auto connectTime = runPhase(numClients, numDrivers, [&](size_t rank) {
+    clients[rank].reset(new TCPStore("127.0.0.1", port, numClients, false));
+  });
+  const auto publishTime = runPhase(numClients, numDrivers, [&](size_t rank) {
+    const auto addr = "10.0.0." + std::to_string(rank % 256) + ":" +
+        std::to_string(30000 + rank);
+    clients[rank]->set(
+        keys[rank], std::vector<uint8_t>(addr.begin(), addr.end()));
+  });
+  const auto gatherTime = runPhase(numClients, numDrivers, [&](size_t rank) {
+    if (batched) {
+      clients[rank]->multiGet(keys);
+    } else {
+      for (const auto& key : keys) {
+        clients[rank]->get(key);
+      }
+    }
+  });
+
+  clients.clear();
+  daemon.reset();
+  ::close(listenSocket);
+
+  std::cout << "clients: " << numClients << ", server threads: " << numThreads
+            << ", " << (batched ? "multiGet" : "get") << std::endl;
+  std::cout << "connect: " << connectTime << "s" << std::endl;
+  std::cout << "publish: " << publishTime << "s" << std::endl;
+  std::cout << "gather: " << gatherTime << "s" << std::endl;
+  std::cout << "rendezvous: " << connectTime + publishTime + gatherTime << "s"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -90,7 +90,8 @@ class CollectiveTest {
  public:
   static std::vector<CollectiveTest> initialize(
       const std::string& path,
-      int num) {
+      int num,
+      bool hierarchicalAllreduce = false) {
     std::vector<CollectiveTest> tests;
     for (auto i = 0; i < num; i++) {
       tests.push_back(CollectiveTest(path));
@@ -99,7 +100,9 @@ class CollectiveTest {
     std::vector<std::thread> threads;
     for (auto i = 0; i < num; i++) {
       threads.push_back(
-          std::thread([i, &tests] { tests[i].start(i, tests.size()); }));
+          std::thread([i, &tests, hierarchicalAllreduce] {
+            tests[i].start(i, tests.size(), hierarchicalAllreduce);
+          }));
     }
     for (auto& thread : threads) {
       thread.join();
@@ -119,7 +122,7 @@ class CollectiveTest {
     return *pg_;
   }
 
-  void start(int rank, int size) {
+  void start(int rank, int size, bool hierarchicalAllreduce) {
     auto store = std::make_shared<::c10d::FileStore>(path_, size);
 
     // Use tiny timeout to make this test run fast
@@ -128,6 +131,15 @@ class CollectiveTest {
     options.devices.push_back(
         ::c10d::ProcessGroupGloo::createDeviceForHostname("127.0.0.1"));
 
+    // Pretend that every other process runs on a second host. The processes
+    // on a host wait for each other in the allreduce itself, so it needs a
+    // longer timeout.
+    if (hierarchicalAllreduce) {
+      options.timeout = std::chrono::milliseconds(5000);
+      options.hierarchicalAllreduce = true;
+      options.hierarchicalAllreduceHost = "host" + std::to_string(rank % 2);
+    }
+
     pg_ = std::unique_ptr<::c10d::ProcessGroupGloo>(
         new ::c10d::ProcessGroupGloo(store, rank, size, options));
   }
@@ -187,6 +199,39 @@ void testAllreduce(const std::string& path, const at::DeviceType b) {
   }
 }
 
+void testHierarchicalAllreduce(const std::string& path) {
+  const auto size = 6;
+  auto tests = CollectiveTest::initialize(path, size, true);
+
+  // Allreduce a tensor that spans multiple shared memory slots, and one that
+  // doesn't, twice so that the shared memory is reused.
+  for (auto numel : {5 * 1024 * 1024, 1000, 5 * 1024 * 1024, 1000}) {
+    std::vector<std::vector<at::Tensor>> inputs(size);
+    for (auto i = 0; i < size; i++) {
+      inputs[i] = {at::ones({numel}) * i};
+    }
+
+    std::vector<std::shared_ptr<::c10d::ProcessGroup::Work>> work(size);
+    for (auto i = 0; i < size; i++) {
+      work[i] = tests[i].getProcessGroup().allreduce(inputs[i]);
+    }
+    for (auto i = 0; i < size; i++) {
+      work[i]->wait();
+    }
+
+    const auto expected = (size * (size - 1)) / 2;
+    for (auto i = 0; i < size; i++) {
+      auto& tensor = inputs[i][0];
+      auto data = tensor.data_ptr<float>();
+      for (auto j = 0; j < tensor.numel(); j++) {
+        if (data[j] != expected) {
+          throw std::runtime_error("BOOM!");
+        }
+      }
+    }
+  }
+}
+
 void testBroadcast(const std::string& path, const at::DeviceType b) {
   const auto size = 2;
   const auto stride = 2;
@@ -292,6 +337,11 @@ int main(int argc, char** argv) {
   }
 #endif
 
+  {
+    TemporaryFile file;
+    testHierarchicalAllreduce(file.path);
+  }
+
   {
     TemporaryFile file;
     testBroadcast(file.path, at::DeviceType::CPU);
@@ -22,6 +22,24 @@ void testHelper(const std::string& prefix = "") {
   c10d::test::check(serverStore, "key1", "value1");
   c10d::test::check(serverStore, "key2", "value2");
 
+  // Batched set/get
+  auto toBytes = [](const std::string& s) {
+    return std::vector<uint8_t>(s.begin(), s.end());
+  };
+  serverStore.multiSet(
+      {"multi0", "multi1", "multi2"},
+      {toBytes("value0"), toBytes("value1"), toBytes("value2")});
+  c10d::test::check(serverStore, "multi1", "value1");
+  auto values = serverStore.multiGet({"multi2", "key0", "multi0"});
+  if (values !=
+      std::vector<std::vector<uint8_t>>{
+          toBytes("value2"), toBytes("value0"), toBytes("value0")}) {
+    throw std::runtime_error("Unexpected multiGet result");
+  }
+
+  // Waiting on keys of which some exist already
+  serverStore.wait({"key0", "multi0"});
+
   // Hammer on TCPStore
   std::vector<std::thread> threads;
   const auto numIterations = 1000;
@@ -45,6 +63,13 @@ void testHelper(const std::string& prefix = "") {
           for (auto j = 0; j < numIterations; j++) {
             clientStores[i]->add("counter", 1);
           }
+          // Only the first thread to get here becomes the leader
+          std::string name = "thread_" + std::to_string(i);
+          auto leader = clientStores[i]->compareSet(
+              "leader", {}, std::vector<uint8_t>(name.begin(), name.end()));
+          if (leader == std::vector<uint8_t>(name.begin(), name.end())) {
+            clientStores[i]->add("numLeaders", 1);
+          }
           // Let each thread set and get key on its client store
           std::string key = "thread_" + std::to_string(i);
           for (auto j = 0; j < numIterations; j++) {
@@ -82,6 +107,7 @@ void testHelper(const std::string& prefix = "") {
 
   // Check that the counter has the expected value
   c10d::test::check(serverStore, "counter", expectedCounterRes);
+  c10d::test::check(serverStore, "numLeaders", "1");
 
   // Check that each threads' written data from the main thread
   for (auto i = 0; i < numThreads; i++) {
@@ -376,6 +376,12 @@ class DistributedDataParallel(Module):
             self.process_group,
             expect_sparse_gradient)
 
+        # The order gradients are produced in is only known after the first
+        # backward pass. Let the reducer rebuild the buckets in that order,
+        # sizing them for the allreduce latency of the process group.
+        self.reducer.enable_bucket_rebuilding(
+            [1024 * 1024, self.bucket_bytes_cap])
+
         # passing a handle to torch.nn.SyncBatchNorm layer
         self._passing_sync_batchnorm_handle(self._module_copies)
 
@@ -432,6 +438,22 @@ class DistributedDataParallel(Module):
         finally:
             self.require_backward_grad_sync = old_require_backward_grad_sync
 
+    def register_comm_hook(self, hook):
+        r"""
+        Replaces the allreduce of dense gradient buckets with a communication
+        hook, e.g. to compress gradients before they are sent. The built-in
+        hooks are ``torch.distributed.FP16CompressionHook``,
+        ``torch.distributed.TopKSparsificationHook`` (with error feedback) and
+        ``torch.distributed.PowerSGDHook`` (with error feedback). The latter
+        two require a single device per process.
+
+        Example::
+
+            >>> ddp = torch.nn.DistributedDataParallel(model, pg)
+            >>> ddp.register_comm_hook(dist.PowerSGDHook(pg, rank=4))
+        """
+        self.reducer._register_comm_hook(hook)
+
     def forward(self, *inputs, **kwargs):
         if self.require_forward_param_sync:
             self._sync_params()